@@ -10,14 +10,17 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <algorithm>   // for sort, unique
 #include <functional>  // for mem_fn
 #include <limits>
 #include <type_traits>
 #include <unordered_set>  // for unordered_set::erase(), insert()
 #include <utility>
+#include <vector>
 
 #include <ffi.h>
 #include <girepository.h>
+#include <glib-object.h>
 #include <glib.h>
 
 #include <js/Conversions.h>
@@ -2964,25 +2967,76 @@ void ArgsCache::build_return(GICallableInfo* callable, bool* inc_counter_out) {
 
 namespace Arg {
 
-Enum::Enum(GIEnumInfo* enum_info) {
-    int64_t min = std::numeric_limits<int64_t>::max();
-    int64_t max = std::numeric_limits<int64_t>::min();
+EnumValues::EnumValues(GIEnumInfo* enum_info) {
     int n = g_enum_info_get_n_values(enum_info);
+    std::vector<int64_t> values;
+    values.reserve(n);
     for (int i = 0; i < n; i++) {
         GI::AutoValueInfo value_info{g_enum_info_get_value(enum_info, i)};
+        // From the docs for g_value_info_get_value(): "This will always be
+        // representable as a 32-bit signed or unsigned value. The use of
+        // gint64 as the return type is to allow both."
+        // The mask is an unsigned, int-sized field, matching the internal
+        // representation of flags in GLib (which uses guint).
         int64_t value = g_value_info_get_value(value_info);
+        m_mask |= static_cast<unsigned>(value);
+        values.push_back(value);
+    }
+
+    if (values.empty())
+        return;
+
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    m_min = values.front();
+    m_max = values.back();
+
+    if (uint64_t(m_max - m_min) + 1 != values.size())
+        m_sparse = std::move(values);
+}
+
+const EnumValues& EnumValues::get(GIEnumInfo* info, GType gtype,
+                                  Maybe<EnumValues>* storage) {
+    static GQuark quark = g_quark_from_static_string("gjs::enum-values");
+
+    if (gtype == G_TYPE_NONE) {
+        storage->emplace(info);
+        return storage->ref();
+    }
+
+    auto* values = static_cast<EnumValues*>(g_type_get_qdata(gtype, quark));
+    if (!values) {
+        // Enum and flags types are static, so the table is never freed
+        values = new EnumValues(info);
+        g_type_set_qdata(gtype, quark, values);
+    }
+    return *values;
+}
 
-        if (value > max)
-            max = value;
-        if (value < min)
-            min = value;
+unsigned flags_mask(GType gtype) {
+    static GQuark quark = g_quark_from_static_string("gjs::flags-mask");
+
+    // A flags type without any values has a mask of 0, which is
+    // indistinguishable from not being cached, but is cheap to look up again
+    unsigned mask = GPOINTER_TO_UINT(g_type_get_qdata(gtype, quark));
+    if (G_UNLIKELY(mask == 0)) {
+        Gjs::AutoTypeClass<GFlagsClass> gflags_class{gtype};
+        mask = gflags_class->mask;
+        g_type_set_qdata(gtype, quark, GUINT_TO_POINTER(mask));
     }
+    return mask;
+}
 
-    // From the docs for g_value_info_get_value(): "This will always be
-    // representable as a 32-bit signed or unsigned value. The use of gint64 as
-    // the return type is to allow both."
-    // We stuff them both into unsigned 32-bit fields, and use a flag to tell
-    // whether we have to compare them as signed.
+Enum::Enum(GIEnumInfo* enum_info) {
+    Maybe<EnumValues> storage;
+    const EnumValues& values = EnumValues::get(
+        enum_info, g_registered_type_info_get_g_type(enum_info), &storage);
+    int64_t min = values.min();
+    int64_t max = values.max();
+
+    // We stuff the minimum and maximum into unsigned 32-bit fields, and use a
+    // flag to tell whether we have to compare them as signed. See the note in
+    // EnumValues::EnumValues().
     m_min = static_cast<uint32_t>(min);
     m_max = static_cast<uint32_t>(max);
 
@@ -2990,20 +3044,11 @@ Enum::Enum(GIEnumInfo* enum_info) {
 }
 
 Flags::Flags(GIEnumInfo* enum_info) {
-    uint64_t mask = 0;
-    int n = g_enum_info_get_n_values(enum_info);
-    for (int i = 0; i < n; i++) {
-        GI::AutoValueInfo value_info{g_enum_info_get_value(enum_info, i)};
-        int64_t value = g_value_info_get_value(value_info);
-        // From the docs for g_value_info_get_value(): "This will always be
-        // representable as a 32-bit signed or unsigned value. The use of
-        // gint64 as the return type is to allow both."
-        // We stuff both into an unsigned, int-sized field, matching the
-        // internal representation of flags in GLib (which uses guint).
-        mask |= static_cast<unsigned>(value);
-    }
-
-    m_mask = mask;
+    Maybe<EnumValues> storage;
+    m_mask = EnumValues::get(enum_info,
+                             g_registered_type_info_get_g_type(enum_info),
+                             &storage)
+                 .mask();
 }
 
 }  // namespace Arg
@@ -10,7 +10,9 @@
 
 #include <stdint.h>
 
+#include <algorithm>  // for binary_search
 #include <limits>
+#include <vector>
 
 #include <girepository.h>
 #include <glib-object.h>
@@ -82,6 +84,42 @@ class ReturnTag {
     constexpr bool is_pointer() const { return m_is_pointer; }
 };
 
+// Table of the valid values of an enum or flags type, used to check values
+// coming from JS. Most enums have contiguous values, for which a range check is
+// enough; otherwise the values are kept in a sorted array.
+class EnumValues {
+    int64_t m_min = 0;
+    int64_t m_max = -1;
+    // Empty if the values are contiguous
+    std::vector<int64_t> m_sparse;
+    // All values OR'ed together, for flags
+    unsigned m_mask = 0;
+
+ public:
+    explicit EnumValues(GIEnumInfo* info);
+
+    // Returns the table for @info. The table of a registered type is built
+    // once and cached in the type's qdata. For a type without a GType, it is
+    // built into @storage.
+    [[nodiscard]] static const EnumValues& get(
+        GIEnumInfo* info, GType gtype, mozilla::Maybe<EnumValues>* storage);
+
+    [[nodiscard]] int64_t min() const { return m_min; }
+    [[nodiscard]] int64_t max() const { return m_max; }
+    [[nodiscard]] unsigned mask() const { return m_mask; }
+
+    [[nodiscard]] bool contains(int64_t value) const {
+        if (value < m_min || value > m_max)
+            return false;
+        return m_sparse.empty() ||
+               std::binary_search(m_sparse.begin(), m_sparse.end(), value);
+    }
+};
+
+// Returns the mask of the valid bits of the registered flags type @gtype,
+// cached in the type's qdata.
+[[nodiscard]] unsigned flags_mask(GType gtype);
+
 }  // namespace Arg
 
 // When creating an Argument, pass it directly to ArgsCache::set_argument() or
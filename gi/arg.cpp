@@ -34,8 +34,10 @@
 #include <js/ValueArray.h>
 #include <js/experimental/TypedData.h>
 #include <jsapi.h>  // for InformalValueTypeName, IdVector
+#include <mozilla/Maybe.h>
 #include <mozilla/Unused.h>
 
+#include "gi/arg-cache.h"
 #include "gi/arg-inl.h"
 #include "gi/arg-types-inl.h"
 #include "gi/arg.h"
@@ -62,6 +64,7 @@
 #include "gjs/gerror-result.h"
 #include "gjs/jsapi-util.h"
 #include "gjs/macros.h"
+#include "gjs/mem-private.h"
 #include "util/log.h"
 
 // This file contains marshalling functions for GIArgument. It is divided into
@@ -83,11 +86,10 @@ static void throw_invalid_argument(JSContext* cx, JS::HandleValue value,
 bool _gjs_flags_value_is_valid(JSContext* cx, GType gtype, int64_t value) {
     /* Do proper value check for flags with GType's */
     if (gtype != G_TYPE_NONE) {
-        Gjs::AutoTypeClass<GFlagsClass> gflags_class{gtype};
         uint32_t tmpval = static_cast<uint32_t>(value);
 
         /* check all bits are valid bits for the flag and is a 32 bit flag*/
-        if ((tmpval &= gflags_class->mask) != value) { /* Not a guint32 with invalid mask values*/
+        if ((tmpval &= Gjs::Arg::flags_mask(gtype)) != value) { /* Not a guint32 with invalid mask values*/
             gjs_throw(cx, "0x%" PRIx64 " is not a valid value for flags %s",
                       value, g_type_name(gtype));
             return false;
@@ -99,30 +101,16 @@ bool _gjs_flags_value_is_valid(JSContext* cx, GType gtype, int64_t value) {
 
 GJS_JSAPI_RETURN_CONVENTION
 static bool _gjs_enum_value_is_valid(JSContext* cx, GIEnumInfo* enum_info,
-                                     int64_t value) {
-    bool found;
-    int n_values;
-    int i;
-
-    n_values = g_enum_info_get_n_values(enum_info);
-    found = false;
-
-    for (i = 0; i < n_values; ++i) {
-        GI::AutoValueInfo value_info{g_enum_info_get_value(enum_info, i)};
-        int64_t enum_value = g_value_info_get_value(value_info);
-
-        if (enum_value == value) {
-            found = true;
-            break;
-        }
-    }
-
-    if (!found) {
+                                     GType gtype, int64_t value) {
+    mozilla::Maybe<Gjs::Arg::EnumValues> storage;
+    if (!Gjs::Arg::EnumValues::get(enum_info, gtype, &storage)
+             .contains(value)) {
         gjs_throw(cx, "%" PRId64 " is not a valid value for enumeration %s",
                   value, g_base_info_get_name(enum_info));
+        return false;
     }
 
-    return found;
+    return true;
 }
 
 [[nodiscard]] static bool _gjs_enum_uses_signed_type(GIEnumInfo* enum_info) {
@@ -1136,6 +1124,8 @@ bool gjs_array_to_basic_explicit_array(
                                       contents_out))
             return false;
 
+        GJS_ADD_STAT(marshalled_array_bytes,
+                     length * basic_type_element_size(element_tag));
         *length_out = length;
         return true;
     }
@@ -1207,6 +1197,10 @@ bool gjs_array_to_explicit_array(JSContext* context, JS::HandleValue value,
                                         contents))
                     return false;
 
+                GJS_ADD_STAT(marshalled_array_bytes,
+                             length * gjs_type_get_element_size(
+                                          g_type_info_get_tag(param_info),
+                                          param_info));
                 *length_p = length;
             }
         } else {
@@ -1487,7 +1481,8 @@ bool value_to_interface_gi_argument_internal(
                 if (!_gjs_flags_value_is_valid(cx, gtype, value_int64))
                     return false;
             } else {
-                if (!_gjs_enum_value_is_valid(cx, interface_info, value_int64))
+                if (!_gjs_enum_value_is_valid(cx, interface_info, gtype,
+                                              value_int64))
                     return false;
             }
 
@@ -2438,6 +2433,7 @@ static bool gjs_array_from_basic_c_array_internal(
         JSObject* u8array = gjs_byte_array_from_data_copy(cx, length, contents);
         if (!u8array)
             return false;
+        GJS_ADD_STAT(marshalled_array_bytes, length);
         value_out.setObject(*u8array);
         return true;
     }
@@ -2539,6 +2535,8 @@ static bool gjs_array_from_basic_c_array_internal(
     if (!array)
         return false;
 
+    GJS_ADD_STAT(marshalled_array_bytes,
+                 length * basic_type_element_size(element_tag));
     value_out.setObject(*array);
     return true;
 }
@@ -2622,6 +2620,8 @@ static bool gjs_array_from_carray_internal(
     if (!obj)
         return false;
 
+    GJS_ADD_STAT(marshalled_array_bytes,
+                 length * gjs_type_get_element_size(element_type, param_info));
     value_p.setObject(*obj);
 
     return true;
@@ -3336,10 +3336,10 @@ bool gjs_value_from_gi_argument(JSContext* context,
                 int64_t value_int64 = _gjs_enum_from_int(
                     interface_info, gjs_arg_get<Gjs::Tag::Enum>(arg));
 
-                if (interface_type == GI_INFO_TYPE_FLAGS) {
-                    GType gtype = g_registered_type_info_get_g_type(
-                        interface_info.as<GIRegisteredTypeInfo>());
+                GType gtype = g_registered_type_info_get_g_type(
+                    interface_info.as<GIRegisteredTypeInfo>());
 
+                if (interface_type == GI_INFO_TYPE_FLAGS) {
                     if (gtype != G_TYPE_NONE) {
                         // Check to make sure 32 bit flag
                         if (static_cast<uint32_t>(value_int64) != value_int64) {
@@ -3351,12 +3351,11 @@ bool gjs_value_from_gi_argument(JSContext* context,
                         }
 
                         // Pass only valid values
-                        Gjs::AutoTypeClass<GFlagsClass> gflags_class{gtype};
-                        value_int64 &= gflags_class->mask;
+                        value_int64 &= Gjs::Arg::flags_mask(gtype);
                     }
                 } else {
                     if (!_gjs_enum_value_is_valid(context, interface_info,
-                                                  value_int64))
+                                                  gtype, value_int64))
                         return false;
                 }
 
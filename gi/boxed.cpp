@@ -28,19 +28,24 @@
 #include <js/ValueArray.h>
 #include <jsapi.h>  // for IdVector
 #include <mozilla/HashTable.h>
+#include <mozilla/Maybe.h>
 
 #include "gi/arg-inl.h"
 #include "gi/arg.h"
 #include "gi/boxed.h"
 #include "gi/function.h"
 #include "gi/gerror.h"
+#include "gi/member-index.h"
 #include "gi/repo.h"
+#include "gi/variant.h"
+#include "gi/wrapper-stats.h"
 #include "gi/wrapperutils.h"
 #include "gjs/atoms.h"
 #include "gjs/auto.h"
 #include "gjs/context-private.h"
 #include "gjs/gerror-result.h"
 #include "gjs/jsapi-class.h"
+#include "gjs/jsapi-util-args.h"
 #include "gjs/jsapi-util.h"
 #include "gjs/macros.h"
 #include "gjs/mem-private.h"
@@ -58,38 +63,30 @@ BoxedInstance::BoxedInstance(BoxedPrototype* prototype, JS::HandleObject obj)
 // See GIWrapperBase::resolve().
 bool BoxedPrototype::resolve_impl(JSContext* cx, JS::HandleObject obj,
                                   JS::HandleId id, bool* resolved) {
-    JS::UniqueChars prop_name;
-    if (!gjs_get_string_id(cx, id, &prop_name))
+    if (!ensure_member_index(cx))
         return false;
-    if (!prop_name) {
-        *resolved = false;
-        return true;  // not resolved, but no error
-    }
 
     // Look for methods and other class properties
-    GI::AutoFunctionInfo method_info{
-        g_struct_info_find_method(info(), prop_name.get())};
-    if (!method_info) {
+    mozilla::Maybe<Gjs::MemberIndex::Entry> entry =
+        m_member_index->lookup(id);
+    if (!entry || entry->kind != Gjs::MemberIndex::Kind::METHOD) {
         *resolved = false;
         return true;
     }
+
+    GI::AutoFunctionInfo method_info{m_member_index->function_info(*entry)};
 #if GJS_VERBOSE_ENABLE_GI_USAGE
     _gjs_log_info_usage(method_info);
 #endif
 
-    if (g_function_info_get_flags(method_info) & GI_FUNCTION_IS_METHOD) {
-        gjs_debug(GJS_DEBUG_GBOXED, "Defining method %s in prototype for %s",
-                  method_info.name(), format_name().c_str());
-
-        /* obj is the Boxed prototype */
-        if (!gjs_define_function(cx, obj, gtype(), method_info))
-            return false;
+    gjs_debug(GJS_DEBUG_GBOXED, "Defining method %s in prototype for %s",
+              method_info.name(), format_name().c_str());
 
-        *resolved = true;
-    } else {
-        *resolved = false;
-    }
+    /* obj is the Boxed prototype */
+    if (!gjs_define_function(cx, obj, gtype(), method_info))
+        return false;
 
+    *resolved = true;
     return true;
 }
 
@@ -97,24 +94,9 @@ bool BoxedPrototype::resolve_impl(JSContext* cx, JS::HandleObject obj,
 bool BoxedPrototype::new_enumerate_impl(JSContext* cx, JS::HandleObject,
                                         JS::MutableHandleIdVector properties,
                                         bool only_enumerable [[maybe_unused]]) {
-    int n_methods = g_struct_info_get_n_methods(info());
-    for (int i = 0; i < n_methods; i++) {
-        GI::AutoFunctionInfo meth_info{g_struct_info_get_method(info(), i)};
-        GIFunctionInfoFlags flags = g_function_info_get_flags(meth_info);
-
-        if (flags & GI_FUNCTION_IS_METHOD) {
-            const char* name = meth_info.name();
-            jsid id = gjs_intern_string_to_id(cx, name);
-            if (id.isVoid())
-                return false;
-            if (!properties.append(id)) {
-                JS_ReportOutOfMemory(cx);
-                return false;
-            }
-        }
-    }
-
-    return true;
+    if (!ensure_member_index(cx))
+        return false;
+    return m_member_index->append_enumerable_ids(cx, properties);
 }
 
 /*
@@ -330,19 +312,20 @@ bool BoxedInstance::constructor_impl(JSContext* context, JS::HandleObject obj,
     }
 
     if (gtype() == G_TYPE_VARIANT) {
-        /* Short-circuit construction for GVariants by calling into the JS packing
-           function */
-        const GjsAtoms& atoms = GjsContextPrivate::atoms(context);
-        if (!boxed_invoke_constructor(context, obj, atoms.new_internal(), args))
+        // Short-circuit construction for GVariants by packing the value
+        // directly into this instance
+        JS::UniqueChars signature;
+        if (!gjs_parse_call_args(context, "GLib.Variant", args, "!s",
+                                 "signature", &signature))
             return false;
 
-        // The return value of GLib.Variant.new_internal() gets its own
-        // BoxedInstance, and the one we're setting up in this constructor is
-        // discarded.
-        debug_lifecycle(
-            "Boxed construction delegated to GVariant constructor, "
-            "boxed object discarded");
+        Gjs::AutoGVariant variant{
+            gjs_variant_pack(context, signature.get(), args.get(1))};
+        if (!variant)
+            return false;
 
+        own_ptr(variant.release());
+        debug_lifecycle("Boxed pointer created by packing GVariant");
         return true;
     }
 
@@ -768,6 +751,7 @@ void BoxedPrototype::trace_impl(JSTracer* trc) {
                         "Boxed::default_constructor_name");
     if (m_field_map)
         m_field_map->trace(trc);
+    trace_member_index(trc);
 }
 
 // clang-format off
@@ -1040,6 +1024,7 @@ JSObject* BoxedInstance::new_for_c_struct_impl(JSContext* cx,
     BoxedInstance* priv = BoxedInstance::new_for_js_object(cx, obj);
     if (!priv)
         return nullptr;
+    Gjs::WrapperStats::sample_creation_site(cx, priv->get_prototype()->stats());
 
     if (!priv->init_from_c_struct(cx, gboxed, std::forward<Args>(args)...))
         return nullptr;
@@ -0,0 +1,859 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#include <config.h>
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>
+#include <string.h>  // for strchr
+
+#include <memory>  // for shared_ptr, make_shared, unique_ptr, make_unique
+#include <string>
+#include <unordered_map>
+#include <utility>  // for move
+
+#include <gio/gio.h>
+#include <glib-object.h>
+#include <glib.h>
+
+#include <js/Array.h>  // for NewArrayObject, GetArrayLength, IsArrayObject
+#include <js/CallAndConstruct.h>
+#include <js/CallArgs.h>
+#include <js/CharacterEncoding.h>  // for JS_EncodeStringToUTF8
+#include <js/Conversions.h>        // for ToBoolean, ToString
+#include <js/ErrorReport.h>  // for JS_ReportOutOfMemory, JSEXN_TYPEERR
+#include <js/Exception.h>
+#include <js/GCVector.h>
+#include <js/Id.h>
+#include <js/Promise.h>
+#include <js/PropertyAndElement.h>  // for JS_GetElement, JS_GetPropertyById
+#include <js/PropertySpec.h>
+#include <js/RootingAPI.h>
+#include <js/String.h>  // for JS_NewStringCopyZ
+#include <js/TypeDecls.h>
+#include <js/Utility.h>  // for UniqueChars
+#include <js/Value.h>
+#include <js/ValueArray.h>
+#include <jsapi.h>  // for JS_NewPlainObject, JSAutoRealm
+
+#include "gi/boxed.h"
+#include "gi/closure.h"
+#include "gi/dbus.h"
+#include "gi/gerror.h"
+#include "gi/object.h"
+#include "gi/variant.h"
+#include "gi/wrapperutils.h"
+#include "gjs/auto.h"
+#include "gjs/context-private.h"
+#include "gjs/jsapi-util-args.h"
+#include "gjs/jsapi-util.h"
+#include "gjs/macros.h"
+#include "libgjs-private/gjs-gdbus-wrapper.h"
+#include "util/log.h"
+
+using AutoDBusMethodInfo =
+    Gjs::AutoPointer<GDBusMethodInfo, GDBusMethodInfo,
+                     g_dbus_method_info_unref, g_dbus_method_info_ref>;
+using AutoVariantType =
+    Gjs::AutoPointer<GVariantType, GVariantType, g_variant_type_free>;
+
+namespace {
+
+// The parsed input signature of a D-Bus method, built the first time a proxy
+// calls the method
+struct ProxyMethodSignature {
+    AutoDBusMethodInfo info;
+    // Tuple of the input argument types, or null if one of the argument types
+    // in the introspection data is not a valid single complete type
+    AutoVariantType in_type;
+    bool in_has_handles : 1;
+};
+
+}  // namespace
+
+// Builds the tuple type of the arguments described by @args, or returns null
+// if one of them is not a valid single complete type. The type string is left
+// in @type_string either way.
+[[nodiscard]] static AutoVariantType args_tuple_type(GDBusArgInfo** args,
+                                                     std::string* type_string) {
+    *type_string = "(";
+    bool valid = true;
+    for (GDBusArgInfo** arg = args; arg && *arg; arg++) {
+        valid = valid && g_variant_is_signature((*arg)->signature) &&
+                g_variant_type_string_is_valid((*arg)->signature);
+        *type_string += (*arg)->signature;
+    }
+    *type_string += ')';
+
+    if (!valid)
+        return nullptr;
+    return g_variant_type_new(type_string->c_str());
+}
+
+// Most programs use a handful of interfaces, but one that keeps parsing new
+// introspection data would otherwise keep all of its method infos alive
+static constexpr size_t PROXY_METHOD_SIGNATURE_CACHE_SIZE = 256;
+
+[[nodiscard]] static std::shared_ptr<const ProxyMethodSignature>
+proxy_method_signature(GDBusMethodInfo* info) {
+    // Each entry holds a reference on its method info, so the key cannot be
+    // reused by another method info while it is in the cache. Callers share
+    // ownership of the entry, since packing the arguments can run JS code that
+    // makes another call and evicts it.
+    static thread_local std::unordered_map<
+        GDBusMethodInfo*, std::shared_ptr<const ProxyMethodSignature>>
+        cache;
+
+    auto it = cache.find(info);
+    if (it != cache.end())
+        return it->second;
+
+    if (cache.size() >= PROXY_METHOD_SIGNATURE_CACHE_SIZE) {
+        gjs_debug(GJS_DEBUG_NATIVE, "Clearing D-Bus method signature cache");
+        cache.clear();
+    }
+
+    auto signature = std::make_shared<ProxyMethodSignature>(
+        ProxyMethodSignature{AutoDBusMethodInfo{info, Gjs::TakeOwnership{}},
+                             nullptr, false});
+
+    std::string in_type;
+    signature->in_type = args_tuple_type(info->in_args, &in_type);
+    signature->in_has_handles = in_type.find('h') != std::string::npos;
+
+    gjs_debug(GJS_DEBUG_NATIVE, "Cached input signature %s of D-Bus method %s",
+              in_type.c_str(), info->name);
+
+    cache.emplace(info, signature);
+    return signature;
+}
+
+// Returns the first handle in @variant that is not an index into a list of
+// @n_fds file descriptors, or -1 if they all are
+[[nodiscard]] static int32_t find_invalid_handle(GVariant* variant,
+                                                 int32_t n_fds) {
+    switch (g_variant_classify(variant)) {
+        case G_VARIANT_CLASS_HANDLE: {
+            int32_t handle = g_variant_get_handle(variant);
+            return handle >= n_fds ? handle : -1;
+        }
+        case G_VARIANT_CLASS_VARIANT:
+        case G_VARIANT_CLASS_MAYBE:
+        case G_VARIANT_CLASS_ARRAY:
+        case G_VARIANT_CLASS_TUPLE:
+        case G_VARIANT_CLASS_DICT_ENTRY: {
+            // Skip containers whose type cannot include handles
+            const char* type_string = g_variant_get_type_string(variant);
+            if (!strchr(type_string, 'h') && !strchr(type_string, 'v'))
+                return -1;
+
+            size_t n_children = g_variant_n_children(variant);
+            for (size_t ix = 0; ix < n_children; ix++) {
+                Gjs::AutoGVariant child{g_variant_get_child_value(variant, ix)};
+                int32_t handle = find_invalid_handle(child, n_fds);
+                if (handle >= 0)
+                    return handle;
+            }
+            return -1;
+        }
+        default:
+            return -1;
+    }
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool gobject_from_js(JSContext* cx, JS::HandleObject obj, GType gtype,
+                            GObject** out) {
+    if (!obj) {
+        *out = nullptr;
+        return true;
+    }
+    return ObjectBase::typecheck(cx, obj, gtype) &&
+           ObjectBase::to_c_ptr(cx, obj, out);
+}
+
+// The type of Gio.UnixFDList lives in gio-unix, so it is looked up by name. If
+// it was never registered, no object can have it.
+[[nodiscard]] static GType unix_fd_list_type() {
+    return g_type_from_name("GUnixFDList");
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool unix_fd_list_from_js(JSContext* cx, JS::HandleObject obj,
+                                 GUnixFDList** out) {
+    GType gtype = unix_fd_list_type();
+    if (obj && !gtype) {
+        gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr,
+                         "Object is not a Gio.UnixFDList");
+        return false;
+    }
+
+    GObject* gobj;
+    if (!gobject_from_js(cx, obj, gtype, &gobj))
+        return false;
+    *out = G_TYPE_CHECK_INSTANCE_CAST(gobj, gtype, GUnixFDList);
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool reply_to_js(JSContext* cx, GVariant* reply, GUnixFDList* fd_list,
+                        bool with_fd_list, JS::MutableHandleValue value_out) {
+    if (!gjs_variant_unpack(cx, reply, /* deep = */ true,
+                            /* recursive = */ false, value_out))
+        return false;
+
+    if (!with_fd_list)
+        return true;
+
+    JS::RootedValueArray<2> pair{cx};
+    pair[0].set(value_out);
+    if (fd_list) {
+        JSObject* fd_list_obj =
+            ObjectInstance::wrapper_from_gobject(cx, G_OBJECT(fd_list));
+        if (!fd_list_obj)
+            return false;
+        pair[1].setObject(*fd_list_obj);
+    } else {
+        pair[1].setNull();
+    }
+
+    JSObject* array = JS::NewArrayObject(cx, pair);
+    if (!array)
+        return false;
+    value_out.setObject(*array);
+    return true;
+}
+
+namespace {
+
+// An asynchronous method call in progress. The reply is either passed to a
+// callback, or settles a promise returned to the caller. The callback or the
+// promise is held by a closure, so that it is released, and the reply dropped,
+// if the context is disposed before the reply arrives.
+class PendingProxyCall {
+    Gjs::Closure::Ptr m_closure;
+    bool m_is_promise;
+
+    static void reject_with_pending_exception(JSContext* cx,
+                                              JS::HandleObject promise) {
+        JS::RootedValue exception{cx};
+        if (!JS_GetPendingException(cx, &exception)) {
+            gjs_log_exception_uncaught(cx);
+            return;
+        }
+        JS_ClearPendingException(cx);
+        if (!JS::RejectPromise(cx, promise, exception))
+            gjs_log_exception_uncaught(cx);
+    }
+
+    static void reply_to_promise(JSContext* cx, JS::HandleObject promise,
+                                 GVariant* reply, GUnixFDList* fd_list) {
+        // If converting the reply fails, the promise is rejected with the
+        // conversion error instead
+        JS::RootedValue result{cx};
+        if (!reply || !reply_to_js(cx, reply, fd_list, !!fd_list, &result) ||
+            !JS::ResolvePromise(cx, promise, result))
+            reject_with_pending_exception(cx, promise);
+    }
+
+    static void reply_to_callback(JSContext* cx, JS::HandleObject callback,
+                                  GVariant* reply, GUnixFDList* fd_list) {
+        JS::RootedValueArray<3> args{cx};
+        if (!reply || !reply_to_js(cx, reply, nullptr, false, args[0])) {
+            if (!JS_GetPendingException(cx, args[1])) {
+                gjs_log_exception_uncaught(cx);
+                return;
+            }
+            JS_ClearPendingException(cx);
+
+            JSObject* empty = JS::NewArrayObject(cx, 0);
+            if (!empty) {
+                gjs_log_exception_uncaught(cx);
+                return;
+            }
+            args[0].setObject(*empty);
+            args[2].setNull();
+        } else {
+            args[1].setNull();
+            if (fd_list) {
+                JSObject* fd_list_obj = ObjectInstance::wrapper_from_gobject(
+                    cx, G_OBJECT(fd_list));
+                if (!fd_list_obj) {
+                    gjs_log_exception_uncaught(cx);
+                    return;
+                }
+                args[2].setObject(*fd_list_obj);
+            } else {
+                args[2].setNull();
+            }
+        }
+
+        JS::RootedValue v_callback{cx, JS::ObjectValue(*callback)};
+        JS::RootedValue ignored{cx};
+        if (!JS::Call(cx, JS::UndefinedHandleValue, v_callback, args,
+                      &ignored))
+            gjs_log_exception_uncaught(cx);
+    }
+
+ public:
+    PendingProxyCall(JSContext* cx, JSObject* target, bool is_promise)
+        : m_closure(Gjs::Closure::create(cx, target, "D-Bus method reply",
+                                         /* root = */ true)),
+          m_is_promise(is_promise) {}
+
+    static void on_reply(GObject* proxy, GAsyncResult* result, void* data) {
+        std::unique_ptr<PendingProxyCall> self{
+            static_cast<PendingProxyCall*>(data)};
+
+        Gjs::AutoUnref<GUnixFDList> fd_list;
+        Gjs::AutoError error;
+        Gjs::AutoGVariant reply{g_dbus_proxy_call_with_unix_fd_list_finish(
+            G_DBUS_PROXY(proxy), fd_list.out(), result, &error)};
+
+        if (G_UNLIKELY(!self->m_closure->is_valid())) {
+            g_critical(
+                "Attempting to handle a D-Bus method reply during shutdown. "
+                "Because it would crash the application, it has been "
+                "dropped.");
+            return;
+        }
+
+        JSContext* cx = self->m_closure->context();
+        if (G_UNLIKELY(!GjsContextPrivate::from_cx(cx)->is_owner_thread())) {
+            g_critical(
+                "Attempting to handle a D-Bus method reply on a different "
+                "thread. Because it would crash the application, it has been "
+                "dropped.");
+            return;
+        }
+
+        JS::RootedObject target{cx, self->m_closure->callable()};
+        JSAutoRealm ar{cx, target};
+
+        if (!reply)
+            gjs_throw_gerror(cx, error);
+
+        if (self->m_is_promise)
+            reply_to_promise(cx, target, reply, fd_list);
+        else
+            reply_to_callback(cx, target, reply, fd_list);
+    }
+};
+
+}  // namespace
+
+// proxyCall(proxy, methodInfo, sync, args, flags, fdList, nFds, cancellable,
+//   replyFunc)
+// Packs @args according to the input signature of @methodInfo and calls the
+// method on @proxy. A sync call returns the deep-unpacked reply (paired with
+// the returned fd list if @fdList was given). Otherwise, the reply is passed to
+// @replyFunc if it is a function, or settles the returned promise if it is
+// null.
+GJS_JSAPI_RETURN_CONVENTION
+static bool proxy_call_func(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+    JS::RootedObject proxy_obj{cx}, info_obj{cx}, params{cx}, fd_list_obj{cx},
+        cancellable_obj{cx}, reply_func{cx};
+    bool sync;
+    int32_t flags, n_fds;
+    if (!gjs_parse_call_args(cx, "proxyCall", args, "ooboi?oi?o?o", "proxy",
+                             &proxy_obj, "methodInfo", &info_obj, "sync", &sync,
+                             "args", &params, "flags", &flags, "fdList",
+                             &fd_list_obj, "nFds", &n_fds, "cancellable",
+                             &cancellable_obj, "replyFunc", &reply_func))
+        return false;
+
+    GObject *proxy, *cancellable;
+    GUnixFDList* fd_list;
+    if (!gobject_from_js(cx, proxy_obj, G_TYPE_DBUS_PROXY, &proxy) ||
+        !unix_fd_list_from_js(cx, fd_list_obj, &fd_list) ||
+        !gobject_from_js(cx, cancellable_obj, G_TYPE_CANCELLABLE,
+                         &cancellable))
+        return false;
+    if (!proxy) {
+        gjs_throw(cx, "Cannot call a D-Bus method on a disposed proxy");
+        return false;
+    }
+
+    if (!BoxedBase::typecheck(cx, info_obj, G_TYPE_DBUS_METHOD_INFO))
+        return false;
+    auto* info = BoxedBase::to_c_ptr<GDBusMethodInfo>(cx, info_obj);
+    if (!info)
+        return false;
+
+    std::shared_ptr<const ProxyMethodSignature> signature =
+        proxy_method_signature(info);
+    if (!signature->in_type) {
+        gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr,
+                         "Invalid input signature for D-Bus method %s",
+                         info->name);
+        return false;
+    }
+
+    JS::RootedValue params_value{cx, JS::ObjectValue(*params)};
+    Gjs::AutoGVariant parameters{
+        gjs_variant_pack(cx, signature->in_type, params_value)};
+    if (!parameters)
+        return false;
+
+    if (signature->in_has_handles) {
+        if (!fd_list) {
+            gjs_throw(cx,
+                      "Method %s with input type containing 'h' must have a "
+                      "Gio.UnixFDList as an argument",
+                      info->name);
+            return false;
+        }
+        int32_t handle = find_invalid_handle(parameters, n_fds);
+        if (handle >= 0) {
+            gjs_throw(cx,
+                      "handle %d is out of range of Gio.UnixFDList "
+                      "containing %d FDs",
+                      handle, n_fds);
+            return false;
+        }
+    }
+
+    if (sync) {
+        Gjs::AutoUnref<GUnixFDList> out_fd_list;
+        Gjs::AutoError error;
+        Gjs::AutoGVariant reply{g_dbus_proxy_call_with_unix_fd_list_sync(
+            G_DBUS_PROXY(proxy), info->name, parameters,
+            GDBusCallFlags(flags), -1, fd_list,
+            out_fd_list.out(), G_CANCELLABLE(cancellable), &error)};
+        if (!reply)
+            return gjs_throw_gerror(cx, error);
+
+        return reply_to_js(cx, reply, out_fd_list, !!fd_list, args.rval());
+    }
+
+    JS::RootedObject target{cx, reply_func};
+    if (!target) {
+        target = JS::NewPromiseObject(cx, nullptr);
+        if (!target)
+            return false;
+        args.rval().setObject(*target);
+    } else {
+        args.rval().setUndefined();
+    }
+
+    g_dbus_proxy_call_with_unix_fd_list(
+        G_DBUS_PROXY(proxy), info->name, parameters, GDBusCallFlags(flags), -1,
+        fd_list, G_CANCELLABLE(cancellable),
+        &PendingProxyCall::on_reply,
+        new PendingProxyCall(cx, target, !reply_func));
+    return true;
+}
+
+// Returns whether @obj is a Gio.UnixFDList
+[[nodiscard]] static bool is_unix_fd_list(JSContext* cx, JS::HandleObject obj) {
+    GType gtype = unix_fd_list_type();
+    return gtype &&
+           ObjectBase::typecheck(cx, obj, gtype, GjsTypecheckNoThrow{});
+}
+
+namespace {
+
+// A method of an exported interface, with everything needed to dispatch a
+// call to it that does not depend on the call
+struct ExportedMethod {
+    // Both interned, so they don't need to be rooted
+    jsid name;
+    jsid async_name;
+    // Tuple of the output argument types, or null if invalid
+    AutoVariantType out_type;
+    unsigned n_out_args;
+    bool out_has_handles : 1;
+};
+
+// Dispatches the method calls of a GjsDBusImplementation to the handlers of a
+// JS object, in place of the handle-method-call signal. Owned by the
+// implementation. The JS object is held by a closure associated with the
+// implementation's wrapper, so it is traced along with the wrapper instead of
+// being rooted, the same as for a signal connection.
+class MethodDispatchTable {
+    Gjs::Closure::Ptr m_closure;
+    // Shared with the calls being dispatched, since a handler may free the
+    // table by exporting the object again or disposing of the implementation
+    std::unordered_map<GDBusMethodInfo*, std::shared_ptr<const ExportedMethod>>
+        m_methods;
+
+    GJS_JSAPI_RETURN_CONVENTION
+    static bool unix_fd_list_to_js(JSContext* cx,
+                                   GDBusMethodInvocation* invocation,
+                                   JS::MutableHandleValue value_out) {
+        GUnixFDList* fd_list = g_dbus_message_get_unix_fd_list(
+            g_dbus_method_invocation_get_message(invocation));
+        if (!fd_list) {
+            value_out.setNull();
+            return true;
+        }
+        JSObject* wrapper =
+            ObjectInstance::wrapper_from_gobject(cx, G_OBJECT(fd_list));
+        if (!wrapper)
+            return false;
+        value_out.setObject(*wrapper);
+        return true;
+    }
+
+    // Replies to @invocation with the pending exception, which is logged unless
+    // it is a GLib.Error. Takes over the reference to @invocation.
+    static void return_pending_exception(JSContext* cx,
+                                         GDBusMethodInvocation* invocation,
+                                         const char* method_name) {
+        JS::RootedValue exc{cx};
+        if (!JS_GetPendingException(cx, &exc)) {
+            // Uncatchable exception
+            g_dbus_method_invocation_return_dbus_error(
+                invocation, "org.gnome.gjs.JSError.Error",
+                "Method call was interrupted");
+            return;
+        }
+        JS_ClearPendingException(cx);
+
+        if (exc.isObject()) {
+            JS::RootedObject exc_obj{cx, &exc.toObject()};
+            if (ErrorBase::typecheck(cx, exc_obj, GjsTypecheckNoThrow{})) {
+                GError* error = ErrorBase::to_c_ptr(cx, exc_obj);
+                if (error) {
+                    g_dbus_method_invocation_return_gerror(invocation, error);
+                    return;
+                }
+                JS_ClearPendingException(cx);
+            }
+        }
+
+        Gjs::AutoChar log_message{
+            g_strdup_printf("Exception in method call: %s", method_name)};
+        JS::RootedString log_message_str{
+            cx, JS_NewStringCopyZ(cx, log_message)};
+        if (log_message_str)
+            gjs_log_exception_full(cx, exc, log_message_str,
+                                   G_LOG_LEVEL_WARNING);
+        JS_ClearPendingException(cx);
+
+        // Errors that do not have a D-Bus error name, which is most likely all
+        // of the JS error types, are given one under org.gnome.gjs.JSError
+        std::string name{"org.gnome.gjs.JSError.Error"};
+        JS::UniqueChars message;
+        JS::RootedValue v_name{cx}, v_message{cx, exc};
+        if (exc.isObject()) {
+            JS::RootedObject exc_obj{cx, &exc.toObject()};
+            if (!JS_GetProperty(cx, exc_obj, "name", &v_name) ||
+                !JS_GetProperty(cx, exc_obj, "message", &v_message))
+                JS_ClearPendingException(cx);
+        }
+        if (v_name.isString()) {
+            JS::UniqueChars exc_name = gjs_string_to_utf8(cx, v_name);
+            if (exc_name && strchr(exc_name.get(), '.'))
+                name = exc_name.get();
+            else if (exc_name)
+                name = std::string{"org.gnome.gjs.JSError."} + exc_name.get();
+        }
+        JS::RootedString message_str{cx, JS::ToString(cx, v_message)};
+        if (message_str)
+            message = JS_EncodeStringToUTF8(cx, message_str);
+        JS_ClearPendingException(cx);
+
+        g_dbus_method_invocation_return_dbus_error(
+            invocation, name.c_str(), message ? message.get() : "");
+    }
+
+    // Packs the value returned from a handler according to the method's output
+    // signature, and replies to @invocation with it. Takes over the reference
+    // to @invocation.
+    static void return_value(JSContext* cx, const ExportedMethod& method,
+                             GDBusMethodInvocation* invocation,
+                             JS::HandleValue retval) {
+        // A GLib.Variant is returned as it is, and undefined (no return value)
+        // is the empty tuple
+        if (retval.isUndefined()) {
+            g_dbus_method_invocation_return_value(
+                invocation, g_variant_new_tuple(nullptr, 0));
+            return;
+        }
+        if (retval.isObject()) {
+            JS::RootedObject obj{cx, &retval.toObject()};
+            if (BoxedBase::typecheck(cx, obj, G_TYPE_VARIANT,
+                                     GjsTypecheckNoThrow{})) {
+                auto* variant = BoxedBase::to_c_ptr<GVariant>(cx, obj);
+                if (variant) {
+                    g_dbus_method_invocation_return_value(invocation, variant);
+                    return;
+                }
+                JS_ClearPendingException(cx);
+            }
+        }
+
+        JS::RootedValue value{cx};
+        GObject* out_fd_list = nullptr;
+        Gjs::AutoGVariant reply;
+        if (!method.out_type ||
+            !pop_unix_fd_list(cx, method, retval, &out_fd_list, &value) ||
+            !(reply = gjs_variant_pack(cx, method.out_type, value))) {
+            // If we don't do this, the other side will never see a reply
+            JS_ClearPendingException(cx);
+            g_dbus_method_invocation_return_dbus_error(
+                invocation, "org.gnome.gjs.JSError.ValueError",
+                "Service implementation returned an incorrect value type");
+            return;
+        }
+
+        g_dbus_method_invocation_return_value_with_unix_fd_list(
+            invocation, reply, reinterpret_cast<GUnixFDList*>(out_fd_list));
+    }
+
+    // A handler for a method that returns handles may return a Gio.UnixFDList
+    // as the last element of its return value. If it only has one output
+    // argument, the handler doesn't need to wrap it into an array.
+    GJS_JSAPI_RETURN_CONVENTION
+    static bool pop_unix_fd_list(JSContext* cx, const ExportedMethod& method,
+                                 JS::HandleValue retval, GObject** fd_list_out,
+                                 JS::MutableHandleValue value_out) {
+        bool is_array = false;
+        if (method.out_has_handles && retval.isObject() &&
+            !JS::IsArrayObject(cx, retval, &is_array))
+            return false;
+
+        if (is_array) {
+            JS::RootedObject array{cx, &retval.toObject()};
+            uint32_t length;
+            JS::RootedValue last{cx};
+            if (!JS::GetArrayLength(cx, array, &length))
+                return false;
+            if (length > 0 && !JS_GetElement(cx, array, length - 1, &last))
+                return false;
+            if (last.isObject()) {
+                JS::RootedObject last_obj{cx, &last.toObject()};
+                if (is_unix_fd_list(cx, last_obj)) {
+                    if (!ObjectBase::to_c_ptr(cx, last_obj, fd_list_out) ||
+                        !JS::SetArrayLength(cx, array, length - 1))
+                        return false;
+                    value_out.set(retval);
+                    return true;
+                }
+            }
+        }
+
+        if (method.n_out_args != 1) {
+            value_out.set(retval);
+            return true;
+        }
+
+        JSObject* wrapped =
+            JS::NewArrayObject(cx, JS::HandleValueArray(retval));
+        if (!wrapped)
+            return false;
+        value_out.setObject(*wrapped);
+        return true;
+    }
+
+    // Calls the synchronous handler with the unpacked arguments followed by
+    // the Gio.UnixFDList sent with the call, or null. Takes over the reference
+    // to @invocation.
+    static void call_handler(JSContext* cx, const ExportedMethod& method,
+                             JS::HandleObject js_obj, JS::HandleValue handler,
+                             GVariant* parameters,
+                             GDBusMethodInvocation* invocation,
+                             const char* method_name) {
+        size_t n_args = g_variant_n_children(parameters);
+        JS::RootedValueVector args{cx};
+        if (!args.resize(n_args + 1)) {
+            JS_ReportOutOfMemory(cx);
+            return_pending_exception(cx, invocation, method_name);
+            return;
+        }
+        for (size_t ix = 0; ix < n_args; ix++) {
+            Gjs::AutoGVariant arg{g_variant_get_child_value(parameters, ix)};
+            if (!gjs_variant_unpack(cx, arg, /* deep = */ true,
+                                    /* recursive = */ false, args[ix])) {
+                return_pending_exception(cx, invocation, method_name);
+                return;
+            }
+        }
+
+        JS::RootedValue retval{cx};
+        if (!unix_fd_list_to_js(cx, invocation, args[n_args]) ||
+            !JS::Call(cx, js_obj, handler, args, &retval)) {
+            return_pending_exception(cx, invocation, method_name);
+            return;
+        }
+
+        return_value(cx, method, invocation, retval);
+    }
+
+    // Calls the asynchronous handler with the array of unpacked arguments, the
+    // invocation, and the Gio.UnixFDList sent with the call, or null. The
+    // handler is responsible for replying.
+    static void call_async_handler(JSContext* cx, JS::HandleObject js_obj,
+                                   JS::HandleValue handler,
+                                   GVariant* parameters,
+                                   GDBusMethodInvocation* invocation) {
+        JS::RootedValueArray<3> args{cx};
+        JSObject* invocation_obj =
+            ObjectInstance::wrapper_from_gobject(cx, G_OBJECT(invocation));
+        if (!invocation_obj ||
+            !gjs_variant_unpack(cx, parameters, /* deep = */ true,
+                                /* recursive = */ false, args[0])) {
+            gjs_log_exception_uncaught(cx);
+            return;
+        }
+        args[1].setObject(*invocation_obj);
+
+        JS::RootedValue ignored{cx};
+        if (!unix_fd_list_to_js(cx, invocation, args[2]) ||
+            !JS::Call(cx, js_obj, handler, args, &ignored))
+            gjs_log_exception_uncaught(cx);
+    }
+
+ public:
+    MethodDispatchTable(JSContext* cx, JSObject* js_obj)
+        : m_closure(Gjs::Closure::create(cx, js_obj, "D-Bus method dispatch",
+                                         /* root = */ false)) {}
+
+    [[nodiscard]] GClosure* closure() const { return m_closure; }
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool add_methods(JSContext* cx, GDBusInterfaceInfo* info) {
+        for (GDBusMethodInfo** method = info->methods; method && *method;
+             method++) {
+            Gjs::AutoChar async_name{
+                g_strdup_printf("%sAsync", (*method)->name)};
+            jsid name_id = gjs_intern_string_to_id(cx, (*method)->name);
+            jsid async_name_id = gjs_intern_string_to_id(cx, async_name);
+            if (name_id.isVoid() || async_name_id.isVoid())
+                return false;
+
+            std::string out_type;
+            AutoVariantType out_tuple_type =
+                args_tuple_type((*method)->out_args, &out_type);
+
+            unsigned n_out_args = 0;
+            for (GDBusArgInfo** arg = (*method)->out_args; arg && *arg; arg++)
+                n_out_args++;
+
+            m_methods.emplace(
+                *method, std::make_shared<const ExportedMethod>(ExportedMethod{
+                             name_id, async_name_id, std::move(out_tuple_type),
+                             n_out_args,
+                             out_type.find('h') != std::string::npos}));
+        }
+        return true;
+    }
+
+    static void method_call(GjsDBusImplementation*,
+                            GDBusMethodInfo* method_info, GVariant* parameters,
+                            GDBusMethodInvocation* invocation_ptr,
+                            void* data) {
+        auto* self = static_cast<MethodDispatchTable*>(data);
+        Gjs::AutoUnref<GDBusMethodInvocation> invocation{invocation_ptr};
+
+        if (!self->m_closure->is_valid()) {
+            g_dbus_method_invocation_return_error(
+                invocation.release(), G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_OBJECT,
+                "Object implementing %s is no longer available",
+                method_info->name);
+            return;
+        }
+
+        JSContext* cx = self->m_closure->context();
+        JS::RootedObject js_obj{cx, self->m_closure->callable()};
+        JSAutoRealm ar{cx, js_obj};
+
+        auto it = self->m_methods.find(method_info);
+        g_assert(it != self->m_methods.end() &&
+                 "Method info should come from the interface info");
+        // Nothing in the table may be used after calling into JS
+        std::shared_ptr<const ExportedMethod> method = it->second;
+
+        // Prefer a sync version if available
+        JS::RootedValue handler{cx};
+        JS::RootedId name{cx, method->name};
+        if (!JS_GetPropertyById(cx, js_obj, name, &handler)) {
+            return_pending_exception(cx, invocation.release(),
+                                     method_info->name);
+            return;
+        }
+        if (JS::ToBoolean(handler)) {
+            call_handler(cx, *method, js_obj, handler, parameters,
+                         invocation.release(), method_info->name);
+            GjsContextPrivate::from_cx(cx)->schedule_gc_if_needed();
+            return;
+        }
+
+        name = method->async_name;
+        if (!JS_GetPropertyById(cx, js_obj, name, &handler)) {
+            return_pending_exception(cx, invocation.release(),
+                                     method_info->name);
+            return;
+        }
+        if (JS::ToBoolean(handler)) {
+            call_async_handler(cx, js_obj, handler, parameters, invocation);
+            GjsContextPrivate::from_cx(cx)->schedule_gc_if_needed();
+            return;
+        }
+
+        g_message("Missing handler for DBus method %s", method_info->name);
+        g_dbus_method_invocation_return_error(
+            invocation.release(), G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD,
+            "Method %s is not implemented", method_info->name);
+    }
+};
+
+}  // namespace
+
+// setMethodDispatch(impl, jsObj)
+// Dispatches the method calls on @impl, a GjsPrivate.DBusImplementation, to
+// the handlers of @jsObj. For each method, the handler is @jsObj[name], called
+// with the unpacked arguments and returning the reply, or else
+// @jsObj[`${name}Async`], called with the invocation to reply to.
+GJS_JSAPI_RETURN_CONVENTION
+static bool set_method_dispatch_func(JSContext* cx, unsigned argc,
+                                     JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+    JS::RootedObject impl_obj{cx}, js_obj{cx};
+    if (!gjs_parse_call_args(cx, "setMethodDispatch", args, "oo", "impl",
+                             &impl_obj, "jsObj", &js_obj))
+        return false;
+
+    GObject* impl;
+    if (!gobject_from_js(cx, impl_obj, GJS_TYPE_DBUS_IMPLEMENTATION, &impl))
+        return false;
+    if (!impl) {
+        gjs_throw(cx, "Cannot export a disposed D-Bus implementation");
+        return false;
+    }
+
+    ObjectInstance* instance = ObjectInstance::for_js(cx, impl_obj);
+    if (!instance)
+        return false;
+
+    GDBusInterfaceInfo* info =
+        g_dbus_interface_skeleton_get_info(G_DBUS_INTERFACE_SKELETON(impl));
+    auto table = std::make_unique<MethodDispatchTable>(cx, js_obj);
+    if (!table->add_methods(cx, info) ||
+        !instance->associate_closure(cx, table->closure()))
+        return false;
+
+    gjs_debug(GJS_DEBUG_NATIVE,
+              "Dispatching method calls on %s to JS object %p", info->name,
+              js_obj.get());
+
+    gjs_dbus_implementation_set_method_call_func(
+        GJS_DBUS_IMPLEMENTATION(impl), &MethodDispatchTable::method_call,
+        table.release(),
+        [](void* data) { delete static_cast<MethodDispatchTable*>(data); });
+
+    args.rval().setUndefined();
+    return true;
+}
+
+static JSFunctionSpec gjs_dbus_module_funcs[] = {
+    JS_FN("proxyCall", proxy_call_func, 9, 0),
+    JS_FN("setMethodDispatch", set_method_dispatch_func, 2, 0), JS_FS_END};
+
+bool gjs_define_dbus_stuff(JSContext* cx, JS::MutableHandleObject module) {
+    module.set(JS_NewPlainObject(cx));
+    return JS_DefineFunctions(cx, module, gjs_dbus_module_funcs);
+}
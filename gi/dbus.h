@@ -0,0 +1,20 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#ifndef GI_DBUS_H_
+#define GI_DBUS_H_
+
+#include <config.h>
+
+#include <js/TypeDecls.h>
+
+#include "gjs/macros.h"
+
+// Native parts of the D-Bus convenience API in the Gio overrides, exposed to
+// them as imports._dbusNative
+
+GJS_JSAPI_RETURN_CONVENTION
+bool gjs_define_dbus_stuff(JSContext* cx, JS::MutableHandleObject module);
+
+#endif  // GI_DBUS_H_
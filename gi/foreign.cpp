@@ -6,6 +6,7 @@
 
 #include <stddef.h>  // for size_t
 
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>  // for pair
@@ -22,8 +23,10 @@
 #include "gjs/macros.h"
 
 enum LoadedStatus { NotLoaded, Loaded };
-static std::unordered_map<std::string, LoadedStatus> foreign_modules{
-    {"cairo", NotLoaded}};
+// Each thread runs its own context (workers), which has to import the foreign
+// module itself
+static thread_local std::unordered_map<std::string, LoadedStatus>
+    foreign_modules{{"cairo", NotLoaded}};
 
 using StructID = std::pair<std::string, std::string>;
 struct StructIDHash {
@@ -32,9 +35,17 @@ struct StructIDHash {
         return hasher(val.first) ^ hasher(val.second);
     }
 };
+// Shared by all threads; the registered infos are static and never removed
+static std::mutex foreign_structs_lock;
 static std::unordered_map<StructID, GjsForeignInfo*, StructIDHash>
     foreign_structs_table;
 
+[[nodiscard]] static GjsForeignInfo* find_foreign_struct(const StructID& key) {
+    std::lock_guard<std::mutex> lock{foreign_structs_lock};
+    auto entry = foreign_structs_table.find(key);
+    return entry == foreign_structs_table.end() ? nullptr : entry->second;
+}
+
 [[nodiscard]] static bool gjs_foreign_load_foreign_module(
     JSContext* cx, const char* gi_namespace) {
     auto entry = foreign_modules.find(gi_namespace);
@@ -60,6 +71,7 @@ static std::unordered_map<StructID, GjsForeignInfo*, StructIDHash>
 
 void gjs_struct_foreign_register(const char* gi_namespace,
                                  const char* type_name, GjsForeignInfo* info) {
+    std::lock_guard<std::mutex> lock{foreign_structs_lock};
     foreign_structs_table.insert({{gi_namespace, type_name}, info});
 }
 
@@ -68,19 +80,20 @@ static GjsForeignInfo* gjs_struct_foreign_lookup(JSContext* cx,
                                                  GIStructInfo* info) {
     const char* ns = g_base_info_get_namespace(info);
     StructID key{ns, g_base_info_get_name(info)};
-    auto entry = foreign_structs_table.find(key);
-    if (entry == foreign_structs_table.end()) {
-        if (gjs_foreign_load_foreign_module(cx, ns))
-            entry = foreign_structs_table.find(key);
-    }
-
-    if (entry == foreign_structs_table.end()) {
+    // Another thread may have registered the type already, but the module
+    // that implements it must also be imported in the calling thread's
+    // context. The lock is not held while importing, since that registers the
+    // module's types.
+    [[maybe_unused]] bool loaded = gjs_foreign_load_foreign_module(cx, ns);
+    GjsForeignInfo* foreign = find_foreign_struct(key);
+
+    if (!foreign) {
         gjs_throw(cx, "Unable to find module implementing foreign type %s.%s",
                   key.first.c_str(), key.second.c_str());
         return nullptr;
     }
 
-    return entry->second;
+    return foreign;
 }
 
 bool gjs_struct_foreign_convert_to_gi_argument(
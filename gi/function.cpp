@@ -6,11 +6,17 @@
 
 #include <stddef.h>  // for NULL, size_t
 #include <stdint.h>
+#include <string.h>  // for strcmp
 
+#include <algorithm>  // for max
+#include <condition_variable>
 #include <limits>
-#include <memory>  // for unique_ptr
+#include <memory>  // for shared_ptr, make_shared, unique_ptr
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <unordered_set>
+#include <utility>  // for move
 #include <vector>
 
 #include <ffi.h>
@@ -26,11 +32,14 @@
 #include <js/ErrorReport.h>  // for JS_ReportOutOfMemory
 #include <js/Exception.h>
 #include <js/HeapAPI.h>  // for RuntimeHeapIsCollecting
+#include <js/Promise.h>
 #include <js/PropertyAndElement.h>
 #include <js/PropertyDescriptor.h>  // for JSPROP_PERMANENT
 #include <js/PropertySpec.h>
 #include <js/Realm.h>  // for GetRealmFunctionPrototype
 #include <js/RootingAPI.h>
+#include <js/Stack.h>  // for CaptureCurrentStack, BuildStackString
+#include <js/String.h>
 #include <js/TypeDecls.h>
 #include <js/Value.h>
 #include <js/ValueArray.h>
@@ -49,6 +58,7 @@
 #include "gi/gerror.h"
 #include "gi/object.h"
 #include "gi/utils-inl.h"
+#include "gjs/atoms.h"
 #include "gjs/auto.h"
 #include "gjs/context-private.h"
 #include "gjs/gerror-result.h"
@@ -57,6 +67,7 @@
 #include "gjs/macros.h"
 #include "gjs/mem-private.h"
 #include "gjs/profiler-private.h"
+#include "gjs/promise.h"  // for AutoMainContext
 #include "util/log.h"
 
 using mozilla::Maybe, mozilla::Some;
@@ -68,9 +79,14 @@ using mozilla::Maybe, mozilla::Some;
 
 namespace Gjs {
 
+class AsyncCall;
+class AsyncReady;
+
 class Function : public CWrapper<Function> {
     friend CWrapperPointerOps<Function>;
     friend CWrapper<Function>;
+    friend AsyncCall;
+    friend AsyncReady;
 
     static constexpr auto PROTOTYPE_SLOT = GjsGlobalSlot::PROTOTYPE_function;
     static constexpr GjsDebugTopic DEBUG_TOPIC = GJS_DEBUG_GFUNCTION;
@@ -83,6 +99,32 @@ class Function : public CWrapper<Function> {
     uint8_t m_js_out_argc;
     GIFunctionInvoker m_invoker;
 
+    // Computed on the first callAsync(): the positions of the GObject
+    // arguments, which must not be implemented in JS, since their vfuncs
+    // could be called from the thread pool
+    std::unique_ptr<std::vector<uint8_t>> m_async_object_args;
+
+    // For functions whose last argument is a GAsyncReadyCallback: the
+    // function that finishes the operation. When called without the callback,
+    // such a function returns a promise, which is settled with the result of
+    // the finish function. Looked up on the first call without the callback.
+    // Gio._promisify() can replace it while operations are pending, so each
+    // operation keeps a reference to the one it started with.
+    struct AsyncFinish {
+        Function* finish = nullptr;  // null if there is no finish function
+        // Only depend on this function, so they are the same in every
+        // AsyncFinish of the function
+        uint8_t callback_pos = 0;
+        uint8_t closure_pos = 0;
+        uint8_t result_pos = 0;  // of the GAsyncResult argument of finish
+
+        AsyncFinish() = default;
+        AsyncFinish(const AsyncFinish&) = delete;
+        AsyncFinish& operator=(const AsyncFinish&) = delete;
+        ~AsyncFinish() { delete finish; }
+    };
+    std::shared_ptr<const AsyncFinish> m_async_finish;
+
     explicit Function(GICallableInfo* info)
         : m_info(info, Gjs::TakeOwnership{}),
           m_js_in_argc(0),
@@ -129,7 +171,39 @@ class Function : public CWrapper<Function> {
     bool to_string_impl(JSContext* cx, JS::MutableHandleValue rval);
 
     GJS_JSAPI_RETURN_CONVENTION
-    bool finish_invoke(JSContext* cx, const JS::CallArgs& args,
+    static bool call_async(JSContext* cx, unsigned argc, JS::Value* vp);
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool check_async_support(JSContext* cx);
+    GJS_JSAPI_RETURN_CONVENTION
+    bool check_async_instances(JSContext* cx, GjsFunctionCallState* state);
+
+    [[nodiscard]] GICallableInfo* find_finish_function();
+    GJS_JSAPI_RETURN_CONVENTION
+    bool init_finish_function(JSContext* cx, GICallableInfo* finish_info,
+                              AsyncFinish* async_finish);
+    GJS_JSAPI_RETURN_CONVENTION
+    bool set_finish_function(JSContext* cx, GICallableInfo* finish_info);
+    GJS_JSAPI_RETURN_CONVENTION
+    bool init_async_finish(JSContext* cx);
+    GJS_JSAPI_RETURN_CONVENTION
+    static bool invoke_finish(JSContext* cx, const AsyncFinish& async_finish,
+                              GObject* source, GAsyncResult* result,
+                              JS::MutableHandleValue rval);
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool invoke_internal(JSContext* cx, const JS::CallArgs& args,
+                         JS::HandleObject this_obj, GIArgument* r_value,
+                         AsyncCall* async_call);
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool complete_invoke(JSContext* cx, JS::MutableHandleValue rval,
+                         GjsFunctionCallState* state,
+                         GIFFIReturnValue* return_value,
+                         GIArgument* r_value = nullptr);
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool finish_invoke(JSContext* cx, JS::MutableHandleValue rval,
                        GjsFunctionCallState* state,
                        GIArgument* r_value = nullptr);
 
@@ -168,7 +242,15 @@ class Function : public CWrapper<Function> {
     GJS_JSAPI_RETURN_CONVENTION
     bool invoke(JSContext* cx, const JS::CallArgs& args,
                 JS::HandleObject this_obj = nullptr,
-                GIArgument* r_value = nullptr);
+                GIArgument* r_value = nullptr) {
+        return invoke_internal(cx, args, this_obj, r_value, nullptr);
+    }
+
+    // Implements Gio._promisify() for functions whose finish function does not
+    // follow the naming conventions
+    GJS_JSAPI_RETURN_CONVENTION
+    static bool set_finish_function(JSContext* cx, JS::HandleObject function,
+                                    JS::HandleObject finish, bool* found);
 
     GJS_JSAPI_RETURN_CONVENTION
     static bool invoke_constructor_uncached(JSContext* cx, GIFunctionInfo* info,
@@ -182,6 +264,94 @@ class Function : public CWrapper<Function> {
     }
 };
 
+/*
+ * AsyncCall:
+ *
+ * A call started with callAsync(). The arguments are marshalled in the owner
+ * thread, then the C function is called from the thread pool. Once it returns,
+ * an idle source in the main context of the owner thread marshals the results
+ * and settles the promise.
+ */
+class AsyncCall {
+    Function* m_function;
+    GjsContextPrivate* m_gjs;
+    // Keeps m_function alive
+    JS::PersistentRootedObject m_function_obj;
+    JS::PersistentRootedObject m_promise;
+    // Keeps the wrappers of the arguments alive, and with them the GObjects
+    // and boxed memory that the C function is using
+    JS::PersistentRootedObject m_args;
+
+    GjsFunctionCallState::CValues m_cvalues;
+    std::unique_ptr<void*[]> m_ffi_arg_pointers;
+    GError** m_errorp = nullptr;
+    GIFFIReturnValue m_return_value;
+
+    AutoMainContext m_main_context;
+    std::mutex m_lock;
+    std::condition_variable m_done_cond;
+    bool m_done = false;
+    GSource* m_completion_source = nullptr;
+
+    int64_t m_queued_time = 0;
+    int64_t m_start_time = 0;
+    int64_t m_end_time = 0;
+
+    static GThreadPool* thread_pool();
+    static void run(void* data, void*);
+    static gboolean on_completed(void* data);
+
+ public:
+    AsyncCall(JSContext* cx, Function* function, JS::HandleObject function_obj,
+              JS::HandleObject promise, JS::HandleObject args);
+    ~AsyncCall();
+
+    void dispatch(GjsFunctionCallState* state,
+                  std::unique_ptr<void*[]> ffi_arg_pointers);
+    void wait();
+    void complete();
+};
+
+/*
+ * AsyncReady:
+ *
+ * The user data of the native GAsyncReadyCallback passed to an async function
+ * that was called without its callback. When the operation is done, it calls
+ * the finish function directly with the GAsyncResult, and settles the promise
+ * that the async function returned.
+ */
+class AsyncReady {
+    // The finish function when the operation started
+    std::shared_ptr<const Function::AsyncFinish> m_async_finish;
+    GjsContextPrivate* m_gjs;
+    JS::PersistentRootedObject m_promise;
+    JS::PersistentRootedObject m_stack;
+
+    AsyncReady(JSContext* cx,
+               std::shared_ptr<const Function::AsyncFinish> async_finish,
+               JS::HandleObject promise, JS::HandleObject stack);
+
+    static void on_ready(GObject* source, GAsyncResult* result, void* data);
+    GJS_JSAPI_RETURN_CONVENTION
+    bool add_creation_stack(JSContext* cx, JS::HandleValue error);
+    void settle(GObject* source, GAsyncResult* result);
+
+ public:
+    [[nodiscard]] static void* callback() {
+        return reinterpret_cast<void*>(&AsyncReady::on_ready);
+    }
+
+    // Returns the promise, and sets @closure to the user data to pass along
+    // with callback()
+    GJS_JSAPI_RETURN_CONVENTION
+    static JSObject* create(
+        JSContext* cx,
+        std::shared_ptr<const Function::AsyncFinish> async_finish,
+        GIArgument* closure);
+
+    void abandon();
+};
+
 }  // namespace Gjs
 
 template <typename TAG>
@@ -384,6 +554,25 @@ void GjsCallbackTrampoline::callback_closure(GIArgument** args, void* result) {
 
     JS::RootedValue rval(context);
 
+    Gjs::AutoSlowCallMark slow_call_mark{
+        context, m_is_vfunc ? "Slow vfunc" : "Slow callback", [this, gobj]() {
+            std::string description{m_info.ns()};
+            GIBaseInfo* container = g_base_info_get_container(m_info);
+            if (container) {  // !owned
+                description += ".";
+                description += g_base_info_get_name(container);
+            }
+            description += ".";
+            description += m_info.name();
+            if (is_valid())
+                description += " (" + gjs_debug_callable(callable()) + ")";
+            if (gobj) {
+                description += " on ";
+                description += G_OBJECT_TYPE_NAME(gobj);
+            }
+            return description;
+        }};
+
     if (!callback_closure_inner(context, this_object, gobj, &rval, args,
                                 &ret_type, n_args, c_args_offset, result)) {
         if (!JS_IsExceptionPending(context)) {
@@ -692,7 +881,7 @@ GjsCallbackTrampoline* GjsCallbackTrampoline::create(
     return trampoline;
 }
 
-decltype(GjsCallbackTrampoline::s_forever_closure_list)
+thread_local decltype(GjsCallbackTrampoline::s_forever_closure_list)
     GjsCallbackTrampoline::s_forever_closure_list;
 
 GjsCallbackTrampoline::GjsCallbackTrampoline(
@@ -869,18 +1058,41 @@ static void* get_return_ffi_pointer_from_gi_argument(
     }
 }
 
+// Returns in @rval a promise rejected with the pending exception, for calls
+// that report all their errors through the promise that they return.
+GJS_JSAPI_RETURN_CONVENTION
+static bool reject_with_pending_exception(JSContext* cx,
+                                          JS::MutableHandleValue rval) {
+    JS::RootedValue exception{cx};
+    if (!JS_GetPendingException(cx, &exception))
+        return false;  // uncatchable exception
+    JS_ClearPendingException(cx);
+
+    JSObject* promise = JS::CallOriginalPromiseReject(cx, exception);
+    if (!promise)
+        return false;
+    rval.setObject(*promise);
+    return true;
+}
+
 // This function can be called in two different ways. You can either use it to
 // create JavaScript objects by calling it without @r_value, or you can decide
 // to keep the return values in GIArgument format by providing a @r_value
 // argument.
-bool Function::invoke(JSContext* context, const JS::CallArgs& args,
-                      JS::HandleObject this_obj /* = nullptr */,
-                      GIArgument* r_value /* = nullptr */) {
+//
+// With @async_call, the arguments are marshalled and the C function is then
+// called on the thread pool. The call is completed later in the owner thread,
+// by AsyncCall::complete().
+bool Function::invoke_internal(JSContext* context, const JS::CallArgs& args,
+                               JS::HandleObject this_obj, GIArgument* r_value,
+                               AsyncCall* async_call) {
     g_assert((args.isConstructing() || !this_obj) &&
              "If not a constructor, then pass the 'this' object via CallArgs");
 
     GIFFIReturnValue return_value;
 
+    GJS_ADD_STAT(gi_calls, 1);
+
     unsigned ffi_argc = m_invoker.cif.nargs;
     GjsFunctionCallState state(context, m_info);
 
@@ -896,12 +1108,23 @@ bool Function::invoke(JSContext* context, const JS::CallArgs& args,
     // of arguments we expect the JS function to take (which does not include
     // PARAM_SKIPPED args).
     // args.length() is the number of arguments that were actually passed.
+    // Async functions called without their callback return a promise
+    bool promise_mode = false;
+    std::shared_ptr<const AsyncFinish> async_finish;
+    if (!r_value && !async_call && args.length() + 1 == m_js_in_argc) {
+        if (!init_async_finish(context))
+            return false;
+        // Converting the arguments may replace the finish function
+        async_finish = m_async_finish;
+        promise_mode = !!async_finish->finish;
+    }
+
     if (args.length() > m_js_in_argc) {
         if (!JS::WarnUTF8(context,
                           "Too many arguments to %s: expected %u, got %u",
                           format_name().c_str(), m_js_in_argc, args.length()))
             return false;
-    } else if (args.length() < m_js_in_argc) {
+    } else if (args.length() + promise_mode < m_js_in_argc) {
         args.reportMoreArgsNeeded(context, format_name().c_str(), m_js_in_argc,
                                   args.length());
         return false;
@@ -965,6 +1188,19 @@ bool Function::invoke(JSContext* context, const JS::CallArgs& args,
     std::string full_name{GJS_PROFILER_DYNAMIC_STRING(
         context, dynamicString + "." + format_name())};
     AutoProfilerLabel label{context, "", full_name};
+    Gjs::AutoSlowCallMark slow_call_mark{
+        context, "Slow GI call", [this, context, &obj, &state]() {
+            std::string description{format_name()};
+            Maybe<GType> gtype = m_arguments.instance_type();
+            if (!state.is_method || !gtype)
+                return description;
+
+            if (g_type_is_a(*gtype, G_TYPE_OBJECT)) {
+                if (auto* o = ObjectBase::for_js(context, obj))
+                    gtype = Some(o->gtype());
+            }
+            return description + " on " + g_type_name(*gtype);
+        }};
 
     g_assert(ffi_arg_pos + state.gi_argc <
              std::numeric_limits<decltype(state.processed_c_args)>::max());
@@ -984,6 +1220,12 @@ bool Function::invoke(JSContext* context, const JS::CallArgs& args,
 
         ffi_arg_pointers[ffi_arg_pos] = in_value;
 
+        if (promise_mode && gi_arg_pos == async_finish->callback_pos) {
+            gjs_arg_set(in_value, AsyncReady::callback());
+            state.processed_c_args++;
+            continue;
+        }
+
         if (!gjs_arg) {
             GIArgInfo arg_info;
             g_callable_info_load_arg(m_info, gi_arg_pos, &arg_info);
@@ -1014,10 +1256,31 @@ bool Function::invoke(JSContext* context, const JS::CallArgs& args,
     // This pointer needs to exist on the stack across the ffi_call() call
     GError** errorp = &state.local_error;
 
+    if (async_call && !state.failed &&
+        !check_async_instances(context, &state))
+        state.failed = true;
+
+    JS::RootedObject promise(context);
+    if (promise_mode && !state.failed) {
+        promise = AsyncReady::create(
+            context, async_finish,
+            &state.in_cvalue(async_finish->closure_pos));
+        if (!promise)
+            state.failed = true;
+    }
+
     /* Did argument conversion fail?  In that case, skip invocation and jump to release
      * processing. */
-    if (state.failed)
-        return finish_invoke(context, args, &state, r_value);
+    if (state.failed) {
+        if (promise_mode) {
+            // Errors are reported through the promise, as for any async
+            // function
+            [[maybe_unused]] bool ok =
+                finish_invoke(context, args.rval(), &state);
+            return reject_with_pending_exception(context, args.rval());
+        }
+        return finish_invoke(context, args.rval(), &state, r_value);
+    }
 
     if (state.can_throw_gerror) {
         g_assert(ffi_arg_pos < ffi_argc && "GError** argument number mismatch");
@@ -1031,29 +1294,50 @@ bool Function::invoke(JSContext* context, const JS::CallArgs& args,
     g_assert_cmpuint(ffi_arg_pos, ==, ffi_argc);
     g_assert_cmpuint(gi_arg_pos, ==, state.gi_argc);
 
-    Maybe<Arg::ReturnTag> return_tag = m_arguments.return_tag();
+    if (async_call) {
+        async_call->dispatch(&state, std::move(ffi_arg_pointers));
+        return true;
+    }
+
     // return_value_p will point inside the return GIFFIReturnValue union if the
     // C function has a non-void return type
-    void* return_value_p =
-        get_return_ffi_pointer_from_gi_argument(return_tag, &return_value);
+    void* return_value_p = get_return_ffi_pointer_from_gi_argument(
+        m_arguments.return_tag(), &return_value);
     ffi_call(&m_invoker.cif, FFI_FN(m_invoker.native_address), return_value_p,
              ffi_arg_pointers.get());
 
+    if (!complete_invoke(context, args.rval(), &state, &return_value, r_value))
+        return false;
+    if (promise_mode)
+        args.rval().setObject(*promise);
+    return true;
+}
+
+// Marshals the return value and out arguments of a call after the C function
+// has returned, and releases the arguments.
+bool Function::complete_invoke(JSContext* context, JS::MutableHandleValue rval,
+                               GjsFunctionCallState* state_p,
+                               GIFFIReturnValue* return_value,
+                               GIArgument* r_value /* = nullptr */) {
+    GjsFunctionCallState& state = *state_p;
+
     /* Return value and out arguments are valid only if invocation doesn't
      * return error. In arguments need to be released always.
      */
     if (!r_value)
-        args.rval().setUndefined();
+        rval.setUndefined();
 
+    Maybe<Arg::ReturnTag> return_tag = m_arguments.return_tag();
     if (return_tag) {
         gi_type_tag_extract_ffi_return_value(
-            return_tag->tag(), return_tag->interface_type(), &return_value,
+            return_tag->tag(), return_tag->interface_type(), return_value,
             state.return_value());
     }
 
     // Process out arguments and return values. This loop is skipped if we fail
     // the type conversion above, or if state.did_throw_gerror is true.
-    js_arg_pos = 0;
+    unsigned js_arg_pos = 0;
+    int gi_arg_pos;
     for (gi_arg_pos = -1; gi_arg_pos < state.gi_argc; gi_arg_pos++) {
         Maybe<Argument*> gjs_arg;
         GIArgument* out_value;
@@ -1112,10 +1396,10 @@ bool Function::invoke(JSContext* context, const JS::CallArgs& args,
     // exception, then any GI_TRANSFER_EVERYTHING or GI_TRANSFER_CONTAINER
     // in-parameters were not transferred. Treat them as GI_TRANSFER_NOTHING so
     // that they are freed.
-    return finish_invoke(context, args, &state, r_value);
+    return finish_invoke(context, rval, &state, r_value);
 }
 
-bool Function::finish_invoke(JSContext* cx, const JS::CallArgs& args,
+bool Function::finish_invoke(JSContext* cx, JS::MutableHandleValue rval,
                              GjsFunctionCallState* state,
                              GIArgument* r_value /* = nullptr */) {
     // In this loop we use ffi_arg_pos just to ensure we don't release stuff
@@ -1148,6 +1432,12 @@ bool Function::finish_invoke(JSContext* cx, const JS::CallArgs& args,
         if (!gjs_arg)
             continue;
 
+        // The native callback passed when returning a promise is not a
+        // trampoline, there is nothing to release
+        if (m_async_finish && gi_arg_pos == m_async_finish->callback_pos &&
+            gjs_arg_get<void*>(in_value) == AsyncReady::callback())
+            continue;
+
         gjs_debug_marshal(
             GJS_DEBUG_GFUNCTION,
             "Releasing argument '%s', %d/%d GI args, %u/%u C args",
@@ -1180,13 +1470,13 @@ bool Function::finish_invoke(JSContext* cx, const JS::CallArgs& args,
         // own, otherwise return a JavaScript array with [return value,
         // out arg 1, out arg 2, ...]
         if (m_js_out_argc == 1) {
-            args.rval().set(state->return_values[0]);
+            rval.set(state->return_values[0]);
         } else {
             JSObject* array = JS::NewArrayObject(cx, state->return_values);
             if (!array) {
                 state->failed = true;
             } else {
-                args.rval().setObject(*array);
+                rval.setObject(*array);
             }
         }
     }
@@ -1200,6 +1490,645 @@ bool Function::finish_invoke(JSContext* cx, const JS::CallArgs& args,
     }
 }
 
+// Calls started from this thread, that have not been completed yet
+static thread_local std::unordered_set<AsyncCall*> pending_async_calls;
+
+AsyncCall::AsyncCall(JSContext* cx, Function* function,
+                     JS::HandleObject function_obj, JS::HandleObject promise,
+                     JS::HandleObject args)
+    : m_function(function),
+      m_gjs(GjsContextPrivate::from_cx(cx)),
+      m_function_obj(cx, function_obj),
+      m_promise(cx, promise),
+      m_args(cx, args),
+      m_main_context(g_main_context_ref_thread_default()) {}
+
+AsyncCall::~AsyncCall() {
+    if (m_completion_source) {
+        g_source_destroy(m_completion_source);
+        g_source_unref(m_completion_source);
+    }
+}
+
+// The limit is shared between all the contexts of the process. It can be set
+// with the GJS_ASYNC_CALL_THREADS environment variable, and defaults to the
+// number of processors.
+GThreadPool* AsyncCall::thread_pool() {
+    static GThreadPool* pool = nullptr;
+
+    if (g_once_init_enter(&pool)) {
+        int max_threads = -1;
+        const char* env = g_getenv("GJS_ASYNC_CALL_THREADS");
+        if (env)
+            max_threads = g_ascii_strtoll(env, nullptr, 10);
+        if (max_threads <= 0)
+            max_threads = std::max(g_get_num_processors(), 2u);
+
+        AutoError error;
+        GThreadPool* new_pool = g_thread_pool_new(&AsyncCall::run, nullptr,
+                                                  max_threads, false, &error);
+        if (!new_pool)
+            g_error("Could not create the GJS thread pool: %s", error->message);
+        g_once_init_leave(&pool, new_pool);
+    }
+
+    return pool;
+}
+
+void AsyncCall::dispatch(GjsFunctionCallState* state,
+                         std::unique_ptr<void*[]> ffi_arg_pointers) {
+    m_cvalues = state->take_cvalues();
+    m_ffi_arg_pointers = std::move(ffi_arg_pointers);
+
+    // The GError** argument points to the stack of the caller
+    if (state->can_throw_gerror) {
+        m_errorp = &m_cvalues.local_error;
+        m_ffi_arg_pointers[m_function->m_invoker.cif.nargs - 1] = &m_errorp;
+    }
+
+    pending_async_calls.insert(this);
+    m_gjs->main_loop_hold();
+
+    m_queued_time = g_get_monotonic_time() * 1000L;
+    g_thread_pool_push(thread_pool(), this, nullptr);
+}
+
+// Called in a thread of the pool
+void AsyncCall::run(void* data, void*) {
+    auto* self = static_cast<AsyncCall*>(data);
+    Function* function = self->m_function;
+
+    self->m_start_time = g_get_monotonic_time() * 1000L;
+
+    void* return_value_p = get_return_ffi_pointer_from_gi_argument(
+        function->m_arguments.return_tag(), &self->m_return_value);
+    ffi_call(&function->m_invoker.cif,
+             FFI_FN(function->m_invoker.native_address), return_value_p,
+             self->m_ffi_arg_pointers.get());
+
+    self->m_end_time = g_get_monotonic_time() * 1000L;
+
+    GSource* source = g_idle_source_new();
+    g_source_set_priority(source, G_PRIORITY_DEFAULT);
+    g_source_set_callback(source, &AsyncCall::on_completed, self, nullptr);
+#if GLIB_CHECK_VERSION(2, 70, 0)
+    g_source_set_static_name(source, "[gjs] Async call");
+#else
+    g_source_set_name(source, "[gjs] Async call");
+#endif
+
+    // The owner thread frees the call in complete(), which takes the lock
+    // first, so nothing here may touch the call after the lock is released.
+    // The source is attached while it is held, so that the call is not freed
+    // before the source is attached either.
+    std::lock_guard<std::mutex> lock{self->m_lock};
+    self->m_completion_source = source;
+    self->m_done = true;
+    self->m_done_cond.notify_one();
+    g_source_attach(source, self->m_main_context);
+}
+
+gboolean AsyncCall::on_completed(void* data) {
+    Gjs::AutoSourceDispatchMark mark;
+    static_cast<AsyncCall*>(data)->complete();
+    return G_SOURCE_REMOVE;
+}
+
+void AsyncCall::wait() {
+    std::unique_lock<std::mutex> lock{m_lock};
+    m_done_cond.wait(lock, [this] { return m_done; });
+}
+
+void AsyncCall::complete() {
+    // The completion source can be dispatched before run() has released the
+    // lock
+    wait();
+    pending_async_calls.erase(this);
+
+    JSContext* cx = m_gjs->context();
+    JSAutoRealm ar{cx, m_promise};
+
+    if (GjsProfiler* profiler = m_gjs->profiler()) {
+        std::string name{m_function->format_name()};
+        _gjs_profiler_add_mark(profiler, m_queued_time,
+                               m_start_time - m_queued_time, "GJS",
+                               "Async call queued", name.c_str());
+        _gjs_profiler_add_mark(profiler, m_start_time,
+                               m_end_time - m_start_time, "GJS", "Async call",
+                               name.c_str());
+    }
+
+    JS::RootedValue result{cx};
+    {
+        GjsFunctionCallState state{cx, m_function->m_info};
+        state.restore_cvalues(std::move(m_cvalues));
+        bool ok = m_function->complete_invoke(cx, &result, &state,
+                                              &m_return_value);
+        // An uncatchable exception leaves the promise pending
+        if (!ok && JS_GetPendingException(cx, &result)) {
+            JS_ClearPendingException(cx);
+            ok = JS::RejectPromise(cx, m_promise, result);
+        } else if (ok) {
+            ok = JS::ResolvePromise(cx, m_promise, result);
+        }
+        if (!ok)
+            gjs_log_exception(cx);
+    }
+
+    m_gjs->main_loop_release();
+    delete this;
+}
+
+// Operations started from this thread without a callback, that have not
+// called back yet
+static thread_local std::unordered_set<AsyncReady*> pending_async_ready;
+
+AsyncReady::AsyncReady(
+    JSContext* cx, std::shared_ptr<const Function::AsyncFinish> async_finish,
+    JS::HandleObject promise, JS::HandleObject stack)
+    : m_async_finish(std::move(async_finish)),
+      m_gjs(GjsContextPrivate::from_cx(cx)),
+      m_promise(cx, promise),
+      m_stack(cx, stack) {}
+
+JSObject* AsyncReady::create(
+    JSContext* cx, std::shared_ptr<const Function::AsyncFinish> async_finish,
+    GIArgument* closure) {
+    // Errors only happen after the caller has returned, so they are more
+    // useful with the stack of the call that created the promise
+    JS::RootedObject stack{cx};
+    if (!JS::CaptureCurrentStack(cx, &stack))
+        return nullptr;
+
+    JS::RootedObject promise{cx, JS::NewPromiseObject(cx, nullptr)};
+    if (!promise)
+        return nullptr;
+
+    auto* self =
+        new AsyncReady(cx, std::move(async_finish), promise, stack);
+    pending_async_ready.insert(self);
+    gjs_arg_set(closure, self);
+    return promise;
+}
+
+void AsyncReady::on_ready(GObject* source, GAsyncResult* result, void* data) {
+    auto* self = static_cast<AsyncReady*>(data);
+    pending_async_ready.erase(self);
+
+    // The context may have been disposed while the operation was running
+    if (self->m_gjs)
+        self->settle(source, result);
+    delete self;
+}
+
+bool AsyncReady::add_creation_stack(JSContext* cx, JS::HandleValue error) {
+    if (!error.isObject() || !m_stack)
+        return true;
+
+    JS::RootedString creation_stack{cx};
+    if (!JS::BuildStackString(cx, nullptr, m_stack, &creation_stack))
+        return false;
+
+    JS::RootedObject error_obj{cx, &error.toObject()};
+    const GjsAtoms& atoms = GjsContextPrivate::atoms(cx);
+    JS::RootedValue stack{cx};
+    if (!JS_GetPropertyById(cx, error_obj, atoms.stack(), &stack))
+        return false;
+
+    if (stack.isString()) {
+        JS::RootedString prefix{cx, stack.toString()};
+        JS::RootedString header{
+            cx, JS_NewStringCopyZ(cx, "### Promise created here: ###\n")};
+        if (!header)
+            return false;
+        prefix = JS_ConcatStrings(cx, prefix, header);
+        if (!prefix)
+            return false;
+        creation_stack = JS_ConcatStrings(cx, prefix, creation_stack);
+        if (!creation_stack)
+            return false;
+    }
+
+    stack.setString(creation_stack);
+    return JS_SetPropertyById(cx, error_obj, atoms.stack(), stack);
+}
+
+// Finish functions that return a success boolean along with out arguments
+// resolve to the out arguments only, as with Gio._promisify()
+GJS_JSAPI_RETURN_CONVENTION
+static bool strip_success_value(JSContext* cx, JS::MutableHandleValue value) {
+    if (!value.isObject())
+        return true;
+
+    bool is_array;
+    if (!JS::IsArrayObject(cx, value, &is_array))
+        return false;
+    if (!is_array)
+        return true;
+
+    JS::RootedObject array{cx, &value.toObject()};
+    uint32_t length;
+    JS::RootedValue first{cx};
+    if (!JS::GetArrayLength(cx, array, &length) ||
+        !JS_GetElement(cx, array, 0, &first))
+        return false;
+    if (length < 2 || !first.isTrue())
+        return true;
+
+    JS::RootedValueVector elements{cx};
+    JS::RootedValue element{cx};
+    for (uint32_t i = 1; i < length; i++) {
+        if (!JS_GetElement(cx, array, i, &element))
+            return false;
+        if (!elements.append(element)) {
+            JS_ReportOutOfMemory(cx);
+            return false;
+        }
+    }
+
+    JSObject* stripped = JS::NewArrayObject(cx, elements);
+    if (!stripped)
+        return false;
+    value.setObject(*stripped);
+    return true;
+}
+
+void AsyncReady::settle(GObject* source, GAsyncResult* result) {
+    JSContext* cx = m_gjs->context();
+    JSAutoRealm ar{cx, m_promise};
+
+    JS::RootedValue value{cx};
+    bool ok = Function::invoke_finish(cx, *m_async_finish, source, result,
+                                      &value);
+    if (ok) {
+        ok = strip_success_value(cx, &value) &&
+             JS::ResolvePromise(cx, m_promise, value);
+    } else if (JS_GetPendingException(cx, &value)) {
+        // An uncatchable exception leaves the promise pending
+        JS_ClearPendingException(cx);
+        ok = add_creation_stack(cx, value) &&
+             JS::RejectPromise(cx, m_promise, value);
+    }
+    if (!ok)
+        gjs_log_exception(cx);
+}
+
+// Called when the context is disposed. The operation will still call back,
+// but the promise is left pending.
+void AsyncReady::abandon() {
+    m_gjs = nullptr;
+    m_promise.reset();
+    m_stack.reset();
+}
+
+// Checks, from the introspection data, that the function can be called from
+// another thread. This excludes arguments that may run JS code, or that hold
+// values that only make sense in the owner thread.
+[[nodiscard]] static const char* async_unsupported_reason(GITypeInfo* type) {
+    switch (g_type_info_get_tag(type)) {
+        case GI_TYPE_TAG_ARRAY:
+        case GI_TYPE_TAG_GLIST:
+        case GI_TYPE_TAG_GSLIST:
+        case GI_TYPE_TAG_GHASH:
+            for (int i = 0; i < 2; i++) {
+                GI::AutoTypeInfo param_type{
+                    g_type_info_get_param_type(type, i)};
+                if (!param_type)
+                    break;
+                if (const char* reason = async_unsupported_reason(param_type))
+                    return reason;
+            }
+            return nullptr;
+
+        case GI_TYPE_TAG_INTERFACE: {
+            GI::AutoBaseInfo interface_info{g_type_info_get_interface(type)};
+            if (GI_IS_CALLBACK_INFO(interface_info))
+                return "a callback";
+            if (GI_IS_STRUCT_INFO(interface_info) &&
+                g_struct_info_is_foreign(interface_info))
+                return "a foreign struct";
+            if (!GI_IS_REGISTERED_TYPE_INFO(interface_info))
+                return nullptr;
+            GType gtype = g_registered_type_info_get_g_type(interface_info);
+            if (g_type_is_a(gtype, G_TYPE_CLOSURE))
+                return "a GClosure";
+            if (g_type_is_a(gtype, G_TYPE_VALUE))
+                return "a GValue";
+            return nullptr;
+        }
+
+        default:
+            return nullptr;
+    }
+}
+
+bool Function::check_async_support(JSContext* cx) {
+    if (m_async_object_args)
+        return true;
+
+    auto object_args = std::make_unique<std::vector<uint8_t>>();
+
+    uint8_t n_args = g_callable_info_get_n_args(m_info);
+    for (uint8_t i = 0; i < n_args; i++) {
+        GIArgInfo arg_info;
+        g_callable_info_load_arg(m_info, i, &arg_info);
+        if (g_arg_info_get_direction(&arg_info) == GI_DIRECTION_OUT)
+            continue;
+
+        GITypeInfo type_info;
+        g_arg_info_load_type(&arg_info, &type_info);
+        if (const char* reason = async_unsupported_reason(&type_info)) {
+            gjs_throw(cx,
+                      "Cannot call %s asynchronously: its '%s' argument is %s",
+                      format_name().c_str(), g_base_info_get_name(&arg_info),
+                      reason);
+            return false;
+        }
+
+        if (g_type_info_get_tag(&type_info) != GI_TYPE_TAG_INTERFACE)
+            continue;
+        GI::AutoBaseInfo interface_info{g_type_info_get_interface(&type_info)};
+        if (GI_IS_OBJECT_INFO(interface_info) ||
+            GI_IS_INTERFACE_INFO(interface_info))
+            object_args->push_back(i);
+    }
+
+    m_async_object_args = std::move(object_args);
+    return true;
+}
+
+[[nodiscard]] static bool is_js_implemented(GIArgument* arg) {
+    auto* gobj = gjs_arg_get<GObject*>(arg);
+    return gobj && G_IS_OBJECT(gobj) &&
+           g_type_get_qdata(G_TYPE_FROM_INSTANCE(gobj),
+                            ObjectBase::custom_type_quark());
+}
+
+bool Function::check_async_instances(JSContext* cx,
+                                     GjsFunctionCallState* state) {
+    GIArgument* instance = state->instance();
+    if (instance && is_js_implemented(instance)) {
+        gjs_throw(cx,
+                  "Cannot call %s asynchronously on an object implemented in "
+                  "JS",
+                  format_name().c_str());
+        return false;
+    }
+
+    for (uint8_t pos : *m_async_object_args) {
+        if (is_js_implemented(&state->in_cvalue(pos))) {
+            GIArgInfo arg_info;
+            g_callable_info_load_arg(m_info, pos, &arg_info);
+            gjs_throw(cx,
+                      "Cannot call %s asynchronously: its '%s' argument is an "
+                      "object implemented in JS",
+                      format_name().c_str(), g_base_info_get_name(&arg_info));
+            return false;
+        }
+    }
+    return true;
+}
+
+// callAsync(thisArg, ...args): Calls the function from the thread pool, and
+// returns a promise that resolves to what the function would return.
+bool Function::call_async(JSContext* cx, unsigned argc, JS::Value* vp) {
+    GJS_GET_THIS(cx, argc, vp, args, this_obj);
+    Function* priv;
+    if (!Function::for_js_instance(cx, this_obj, &priv, &args))
+        return false;
+
+    JS::RootedObject promise{cx, JS::NewPromiseObject(cx, nullptr)};
+    if (!promise)
+        return false;
+
+    if (!priv->check_async_support(cx))
+        return reject_with_pending_exception(cx, args.rval());
+
+    // Lay out the arguments as if the function was called with thisArg as
+    // its this object
+    JS::RootedValueVector vp_storage{cx};
+    if (!vp_storage.append(JS::ObjectValue(*this_obj)) ||
+        !vp_storage.append(args.get(0))) {
+        JS_ReportOutOfMemory(cx);
+        return false;
+    }
+    for (unsigned i = 1; i < args.length(); i++) {
+        if (!vp_storage.append(args[i])) {
+            JS_ReportOutOfMemory(cx);
+            return false;
+        }
+    }
+    JS::CallArgs call_args = JS::CallArgsFromVp(
+        args.length() > 0 ? args.length() - 1 : 0, vp_storage.begin());
+
+    JS::HandleValueArray this_and_args = JS::HandleValueArray::subarray(
+        JS::HandleValueArray{vp_storage}, 1, vp_storage.length() - 1);
+    JS::RootedObject args_array{cx, JS::NewArrayObject(cx, this_and_args)};
+    if (!args_array)
+        return false;
+
+    auto* async_call = new AsyncCall(cx, priv, this_obj, promise, args_array);
+    if (!priv->invoke_internal(cx, call_args, nullptr, nullptr, async_call)) {
+        delete async_call;
+        return reject_with_pending_exception(cx, args.rval());
+    }
+
+    args.rval().setObject(*promise);
+    return true;
+}
+
+[[nodiscard]] static bool is_gio_type(GITypeInfo* type, const char* name) {
+    if (g_type_info_get_tag(type) != GI_TYPE_TAG_INTERFACE)
+        return false;
+    GI::AutoBaseInfo interface_info{g_type_info_get_interface(type)};
+    return strcmp(g_base_info_get_namespace(interface_info), "Gio") == 0 &&
+           strcmp(g_base_info_get_name(interface_info), name) == 0;
+}
+
+// Looks up the finish function by the same naming conventions as
+// Gio._promisify(). The (finish-func) annotations are only available from
+// girepository-2.0.
+GICallableInfo* Function::find_finish_function() {
+    if (!GI_IS_FUNCTION_INFO(m_info))
+        return nullptr;
+
+    std::string name{g_base_info_get_name(m_info)};
+    if (g_str_has_suffix(name.c_str(), "_async") ||
+        g_str_has_suffix(name.c_str(), "_begin"))
+        name.replace(name.size() - 5, 5, "finish");
+    else
+        name += "_finish";
+
+    GIBaseInfo* container = g_base_info_get_container(m_info);  // !owned
+    if (!container) {
+        GIBaseInfo* info = g_irepository_find_by_name(
+            nullptr, g_base_info_get_namespace(m_info), name.c_str());
+        if (info && !GI_IS_FUNCTION_INFO(info)) {
+            g_base_info_unref(info);
+            return nullptr;
+        }
+        return info;
+    }
+    if (GI_IS_OBJECT_INFO(container))
+        return g_object_info_find_method(container, name.c_str());
+    if (GI_IS_INTERFACE_INFO(container))
+        return g_interface_info_find_method(container, name.c_str());
+    if (GI_IS_STRUCT_INFO(container))
+        return g_struct_info_find_method(container, name.c_str());
+    if (GI_IS_UNION_INFO(container))
+        return g_union_info_find_method(container, name.c_str());
+    return nullptr;
+}
+
+// Fills in @async_finish with @finish_info, if this function takes a
+// GAsyncReadyCallback as its last JS argument, and @finish_info takes the
+// GAsyncResult as its only JS argument.
+bool Function::init_finish_function(JSContext* cx, GICallableInfo* finish_info,
+                                    AsyncFinish* async_finish) {
+    if (!finish_info)
+        return true;
+
+    int callback_pos = -1;
+    for (int i = g_callable_info_get_n_args(m_info) - 1; i >= 0; i--) {
+        Argument* gjs_arg = m_arguments.argument(i);
+        if (gjs_arg && !gjs_arg->skip_in()) {
+            callback_pos = i;
+            break;
+        }
+    }
+    if (callback_pos < 0)
+        return true;
+
+    GIArgInfo arg_info;
+    g_callable_info_load_arg(m_info, callback_pos, &arg_info);
+    GITypeInfo type_info;
+    g_arg_info_load_type(&arg_info, &type_info);
+    int closure_pos = g_arg_info_get_closure(&arg_info);
+    if (!is_gio_type(&type_info, "AsyncReadyCallback") || closure_pos < 0)
+        return true;
+    async_finish->callback_pos = callback_pos;
+    async_finish->closure_pos = closure_pos;
+
+    auto* finish = new Function(finish_info);
+    if (!finish->init(cx)) {
+        delete finish;
+        return false;
+    }
+
+    int result_pos = -1;
+    for (int i = 0; i < g_callable_info_get_n_args(finish_info); i++) {
+        Argument* gjs_arg = finish->m_arguments.argument(i);
+        if (gjs_arg && gjs_arg->skip_in())
+            continue;
+
+        g_callable_info_load_arg(finish_info, i, &arg_info);
+        g_arg_info_load_type(&arg_info, &type_info);
+        if (!gjs_arg || result_pos >= 0 ||
+            !is_gio_type(&type_info, "AsyncResult")) {
+            delete finish;
+            return true;
+        }
+        result_pos = i;
+    }
+    if (result_pos < 0) {
+        delete finish;
+        return true;
+    }
+
+    async_finish->finish = finish;
+    async_finish->result_pos = result_pos;
+    return true;
+}
+
+// Replaces the finish function. Operations that are already running keep the
+// previous one.
+bool Function::set_finish_function(JSContext* cx,
+                                   GICallableInfo* finish_info) {
+    auto async_finish = std::make_shared<AsyncFinish>();
+    if (!init_finish_function(cx, finish_info, async_finish.get()))
+        return false;
+    m_async_finish = std::move(async_finish);
+    return true;
+}
+
+bool Function::init_async_finish(JSContext* cx) {
+    if (m_async_finish)
+        return true;
+
+    GI::AutoCallableInfo finish_info{find_finish_function()};
+    return set_finish_function(cx, finish_info);
+}
+
+bool Function::set_finish_function(JSContext* cx, JS::HandleObject function,
+                                   JS::HandleObject finish, bool* found) {
+    // Either may have been replaced with a JS function
+    Function* priv = Function::for_js(cx, function);
+    Function* finish_priv = Function::for_js(cx, finish);
+    if (!priv || !finish_priv) {
+        *found = false;
+        return true;
+    }
+
+    if (!priv->set_finish_function(cx, finish_priv->m_info))
+        return false;
+    *found = !!priv->m_async_finish->finish;
+    return true;
+}
+
+// Calls the finish function of the operation with its result. The other
+// arguments of the finish function are all out arguments.
+bool Function::invoke_finish(JSContext* cx, const AsyncFinish& async_finish,
+                             GObject* source, GAsyncResult* result,
+                             JS::MutableHandleValue rval) {
+    Function* finish = async_finish.finish;
+    GIFFIReturnValue return_value;
+
+    GjsFunctionCallState state(cx, finish->m_info);
+    unsigned ffi_argc = finish->m_invoker.cif.nargs;
+    auto ffi_arg_pointers = std::make_unique<void*[]>(ffi_argc);
+    unsigned ffi_arg_pos = 0;
+
+    if (state.is_method) {
+        if (!source) {
+            gjs_throw(cx, "%s was called without a source object",
+                      finish->format_name().c_str());
+            return false;
+        }
+        gjs_arg_set(state.instance(), source);
+        ffi_arg_pointers[ffi_arg_pos++] = state.instance();
+    }
+
+    state.processed_c_args = ffi_arg_pos;
+    JS::RootedValue undefined{cx};
+    for (int gi_arg_pos = 0; gi_arg_pos < state.gi_argc;
+         gi_arg_pos++, ffi_arg_pos++) {
+        GIArgument* in_value = &state.in_cvalue(gi_arg_pos);
+        ffi_arg_pointers[ffi_arg_pos] = in_value;
+
+        if (gi_arg_pos == async_finish.result_pos) {
+            gjs_arg_set(in_value, result);
+        } else if (!finish->m_arguments.argument(gi_arg_pos)->in(
+                       cx, &state, in_value, undefined)) {
+            state.failed = true;
+            return finish->finish_invoke(cx, rval, &state);
+        }
+        state.processed_c_args++;
+    }
+
+    // This pointer needs to exist on the stack across the ffi_call() call
+    GError** errorp = &state.local_error;
+    if (state.can_throw_gerror)
+        ffi_arg_pointers[ffi_arg_pos++] = &errorp;
+    g_assert_cmpuint(ffi_arg_pos, ==, ffi_argc);
+
+    void* return_value_p = get_return_ffi_pointer_from_gi_argument(
+        finish->m_arguments.return_tag(), &return_value);
+    ffi_call(&finish->m_invoker.cif, FFI_FN(finish->m_invoker.native_address),
+             return_value_p, ffi_arg_pointers.get());
+
+    return finish->complete_invoke(cx, rval, &state, &return_value);
+}
+
 bool Function::call(JSContext* context, unsigned js_argc, JS::Value* vp) {
     JS::CallArgs js_argv = JS::CallArgsFromVp(js_argc, vp);
     JS::RootedObject callee(context, &js_argv.callee());
@@ -1293,6 +2222,7 @@ const JSPropertySpec Function::proto_props[] = {
 // clang-format off
 const JSFunctionSpec Function::proto_funcs[] = {
     JS_FN("toString", &Function::to_string, 0, 0),
+    JS_FN("callAsync", &Function::call_async, 1, 0),
     JS_FS_END};
 // clang-format on
 
@@ -1424,6 +2354,25 @@ gjs_define_function(JSContext       *context,
     return function;
 }
 
+void gjs_function_finish_async_calls() {
+    while (!Gjs::pending_async_calls.empty()) {
+        Gjs::AsyncCall* async_call = *Gjs::pending_async_calls.begin();
+        async_call->wait();
+        // Removes the call from the set
+        async_call->complete();
+    }
+
+    // Freed when their operation calls back
+    for (Gjs::AsyncReady* async_ready : Gjs::pending_async_ready)
+        async_ready->abandon();
+    Gjs::pending_async_ready.clear();
+}
+
+bool gjs_function_set_finish_function(JSContext* cx, JS::HandleObject function,
+                                      JS::HandleObject finish, bool* found) {
+    return Gjs::Function::set_finish_function(cx, function, finish, found);
+}
+
 bool gjs_invoke_constructor_from_c(JSContext* context, GIFunctionInfo* info,
                                    JS::HandleObject obj,
                                    const JS::CallArgs& args,
@@ -11,6 +11,7 @@
 
 #include <memory>  // for unique_ptr
 #include <unordered_set>
+#include <utility>  // for move
 #include <vector>
 
 #include <ffi.h>
@@ -77,7 +78,8 @@ struct GjsCallbackTrampoline : public Gjs::Closure {
     void warn_about_illegal_js_callback(const char* when, const char* reason,
                                         bool dump_stack);
 
-    static std::vector<Gjs::AutoGClosure> s_forever_closure_list;
+    // Per thread, since each thread can run its own GjsContext
+    static thread_local std::vector<Gjs::AutoGClosure> s_forever_closure_list;
 
     GI::AutoCallableInfo m_info;
     ffi_closure* m_closure = nullptr;
@@ -123,6 +125,36 @@ class GjsFunctionCallState {
     GjsFunctionCallState(const GjsFunctionCallState&) = delete;
     GjsFunctionCallState& operator=(const GjsFunctionCallState&) = delete;
 
+    // The C side of a call. When the C function runs on another thread, it is
+    // moved out of the state, which can only live on the stack, and moved back
+    // into a new state once the call is done.
+    struct CValues {
+        Gjs::AutoCppPointer<GIArgument[]> in;
+        Gjs::AutoCppPointer<GIArgument[]> out;
+        Gjs::AutoCppPointer<GIArgument[]> inout_original;
+        std::unordered_set<GIArgument*> ignore_release;
+        Gjs::AutoError local_error;
+        uint8_t processed_c_args;
+    };
+
+    [[nodiscard]] CValues take_cvalues() {
+        return {std::move(m_in_cvalues),
+                std::move(m_out_cvalues),
+                std::move(m_inout_original_cvalues),
+                std::move(ignore_release),
+                std::move(local_error),
+                processed_c_args};
+    }
+
+    void restore_cvalues(CValues&& cvalues) {
+        m_in_cvalues = std::move(cvalues.in);
+        m_out_cvalues = std::move(cvalues.out);
+        m_inout_original_cvalues = std::move(cvalues.inout_original);
+        ignore_release = std::move(cvalues.ignore_release);
+        local_error = std::move(cvalues.local_error);
+        processed_c_args = cvalues.processed_c_args;
+    }
+
     constexpr int first_arg_offset() const { return is_method ? 2 : 1; }
 
     // The list always contains the return value, and the arguments
@@ -172,6 +204,19 @@ JSObject *gjs_define_function(JSContext       *context,
                               GType            gtype,
                               GICallableInfo  *info);
 
+// Waits for the calls started on the thread pool with callAsync() from the
+// current thread, and completes them. Promises returned by async functions
+// whose operation is still pending are left unsettled. Called when the context
+// is disposed.
+void gjs_function_finish_async_calls();
+
+// Makes @function, an async function, return a promise settled with the result
+// of @finish when it is called without its callback. @found is set to false if
+// the two functions cannot be paired that way.
+GJS_JSAPI_RETURN_CONVENTION
+bool gjs_function_set_finish_function(JSContext* cx, JS::HandleObject function,
+                                      JS::HandleObject finish, bool* found);
+
 GJS_JSAPI_RETURN_CONVENTION
 bool gjs_invoke_constructor_from_c(JSContext* cx, GIFunctionInfo* info,
                                    JS::HandleObject this_obj,
@@ -30,7 +30,8 @@
 #include "gjs/jsapi-util.h"
 #include "gjs/macros.h"
 
-static std::unordered_map<GType, AutoParamArray> class_init_properties;
+static thread_local std::unordered_map<GType, AutoParamArray>
+    class_init_properties;
 
 [[nodiscard]] static JSContext* current_js_context() {
     GjsContext* gjs = gjs_context_get_current();
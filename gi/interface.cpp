@@ -8,15 +8,15 @@
 #include <girepository.h>
 
 #include <js/Class.h>
-#include <js/ErrorReport.h>  // for JS_ReportOutOfMemory
-#include <js/GCVector.h>     // for MutableHandleIdVector
-#include <js/Id.h>           // for PropertyKey, jsid
+#include <js/GCVector.h>  // for MutableHandleIdVector
+#include <js/Id.h>        // for PropertyKey, jsid
 #include <js/TypeDecls.h>
-#include <js/Utility.h>  // for UniqueChars
+#include <mozilla/Maybe.h>
 
 #include "gi/function.h"
 #include "gi/info.h"
 #include "gi/interface.h"
+#include "gi/member-index.h"
 #include "gi/object.h"
 #include "gi/repo.h"
 #include "gjs/atoms.h"
@@ -42,26 +42,9 @@ bool InterfacePrototype::new_enumerate_impl(
     if (!info())
         return true;
 
-    int n_methods = g_interface_info_get_n_methods(info());
-    if (!properties.reserve(properties.length() + n_methods)) {
-        JS_ReportOutOfMemory(cx);
+    if (!ensure_member_index(cx))
         return false;
-    }
-
-    for (int i = 0; i < n_methods; i++) {
-        GI::AutoFunctionInfo meth_info{g_interface_info_get_method(info(), i)};
-        GIFunctionInfoFlags flags = g_function_info_get_flags(meth_info);
-
-        if (flags & GI_FUNCTION_IS_METHOD) {
-            const char* name = meth_info.name();
-            jsid id = gjs_intern_string_to_id(cx, name);
-            if (id.isVoid())
-                return false;
-            properties.infallibleAppend(id);
-        }
-    }
-
-    return true;
+    return m_member_index->append_enumerable_ids(cx, properties);
 }
 
 // See GIWrapperBase::resolve().
@@ -75,30 +58,21 @@ bool InterfacePrototype::resolve_impl(JSContext* context, JS::HandleObject obj,
         return true;
     }
 
-    JS::UniqueChars prop_name;
-    if (!gjs_get_string_id(context, id, &prop_name))
+    if (!ensure_member_index(context))
         return false;
-    if (!prop_name) {
-        *resolved = false;
-        return true;  // not resolved, but no error
-    }
-
-    GI::AutoFunctionInfo method_info{
-        g_interface_info_find_method(m_info, prop_name.get())};
-
-    if (method_info) {
-        if (g_function_info_get_flags (method_info) & GI_FUNCTION_IS_METHOD) {
-            if (!gjs_define_function(context, obj, m_gtype, method_info))
-                return false;
 
-            *resolved = true;
-        } else {
-            *resolved = false;
-        }
-    } else {
+    mozilla::Maybe<Gjs::MemberIndex::Entry> entry =
+        m_member_index->lookup(id);
+    if (!entry || entry->kind != Gjs::MemberIndex::Kind::METHOD) {
         *resolved = false;
+        return true;
     }
 
+    GI::AutoFunctionInfo method_info{m_member_index->function_info(*entry)};
+    if (!gjs_define_function(context, obj, m_gtype, method_info))
+        return false;
+
+    *resolved = true;
     return true;
 }
 
@@ -153,6 +127,9 @@ const struct JSClassOps InterfaceBase::class_ops = {
     &InterfaceBase::resolve,
     nullptr,  // mayResolve
     &InterfaceBase::finalize,
+    nullptr,  // call
+    nullptr,  // construct
+    &InterfaceBase::trace
 };
 
 const struct JSClass InterfaceBase::klass = {
@@ -0,0 +1,272 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#include <config.h>
+
+#include <stdint.h>
+
+#include <memory>  // for unique_ptr
+#include <string>
+
+#include <girepository.h>
+#include <glib.h>
+
+#include <js/ErrorReport.h>  // for JS_ReportOutOfMemory
+#include <js/GCVector.h>     // for MutableWrappedPtrOperations
+#include <js/Id.h>
+#include <js/TypeDecls.h>
+#include <mozilla/Maybe.h>
+
+#include "gi/info.h"
+#include "gi/member-index.h"
+#include "gjs/auto.h"
+#include "gjs/jsapi-util.h"
+#include "gjs/mem-private.h"
+#include "util/log.h"
+
+using mozilla::Maybe, mozilla::Nothing, mozilla::Some;
+
+namespace Gjs {
+
+[[nodiscard]] static int get_n_methods(GIBaseInfo* info) {
+    switch (g_base_info_get_type(info)) {
+        case GI_INFO_TYPE_OBJECT:
+            return g_object_info_get_n_methods(info);
+        case GI_INFO_TYPE_INTERFACE:
+            return g_interface_info_get_n_methods(info);
+        case GI_INFO_TYPE_STRUCT:
+            return g_struct_info_get_n_methods(info);
+        case GI_INFO_TYPE_UNION:
+            return g_union_info_get_n_methods(info);
+        default:
+            return 0;
+    }
+}
+
+[[nodiscard]] static GIFunctionInfo* get_method(GIBaseInfo* info, int ix) {
+    switch (g_base_info_get_type(info)) {
+        case GI_INFO_TYPE_OBJECT:
+            return g_object_info_get_method(info, ix);
+        case GI_INFO_TYPE_INTERFACE:
+            return g_interface_info_get_method(info, ix);
+        case GI_INFO_TYPE_STRUCT:
+            return g_struct_info_get_method(info, ix);
+        case GI_INFO_TYPE_UNION:
+            return g_union_info_get_method(info, ix);
+        default:
+            g_assert_not_reached();
+            return nullptr;
+    }
+}
+
+bool MemberIndex::add(JSContext* cx, const char* name, Entry entry) {
+    // The IDs are pinned, so the keys will be the same pointers as the IDs
+    // passed to the resolve hook
+    jsid id = gjs_intern_string_to_id(cx, name);
+    if (id.isVoid())
+        return false;
+
+    // If two members have the same JS name, the first one added wins. This
+    // follows the order in which the resolve hook used to search for them.
+    Map::AddPtr p = m_map.lookupForAdd(id);
+    if (p)
+        return true;
+
+    if (!m_map.add(p, id, entry)) {
+        JS_ReportOutOfMemory(cx);
+        return false;
+    }
+    return true;
+}
+
+bool MemberIndex::add_methods(JSContext* cx, GIBaseInfo* container,
+                              int16_t iface_ix) {
+    int n_methods = get_n_methods(container);
+    for (int ix = 0; ix < n_methods; ix++) {
+        GI::AutoFunctionInfo method_info{get_method(container, ix)};
+        bool is_method =
+            g_function_info_get_flags(method_info) & GI_FUNCTION_IS_METHOD;
+
+        Entry entry{is_method ? Kind::METHOD : Kind::FUNCTION,
+                    is_method && iface_ix < 0, iface_ix, uint16_t(ix)};
+        if (!add(cx, method_info.name(), entry))
+            return false;
+    }
+    return true;
+}
+
+bool MemberIndex::add_vfuncs(JSContext* cx, GIBaseInfo* container,
+                             int16_t iface_ix) {
+    int n_vfuncs = GI_IS_OBJECT_INFO(container)
+                       ? g_object_info_get_n_vfuncs(container)
+                       : g_interface_info_get_n_vfuncs(container);
+    for (int ix = 0; ix < n_vfuncs; ix++) {
+        GI::AutoVFuncInfo vfunc_info{
+            GI_IS_OBJECT_INFO(container)
+                ? g_object_info_get_vfunc(container, ix)
+                : g_interface_info_get_vfunc(container, ix)};
+
+        std::string js_name{std::string("vfunc_") + vfunc_info.name()};
+        if (!add(cx, js_name.c_str(),
+                 {Kind::VFUNC, false, iface_ix, uint16_t(ix)}))
+            return false;
+    }
+    return true;
+}
+
+bool MemberIndex::add_properties(JSContext* cx, GIBaseInfo* container,
+                                 int16_t iface_ix) {
+    int n_props = GI_IS_OBJECT_INFO(container)
+                      ? g_object_info_get_n_properties(container)
+                      : g_interface_info_get_n_properties(container);
+    for (int ix = 0; ix < n_props; ix++) {
+        GI::AutoPropertyInfo prop_info{
+            GI_IS_OBJECT_INFO(container)
+                ? g_object_info_get_property(container, ix)
+                : g_interface_info_get_property(container, ix)};
+
+        // Property names in the introspection info are already canonical.
+        // Only the underscore spelling is listed when enumerating.
+        Entry entry{Kind::PROPERTY, iface_ix < 0, iface_ix, uint16_t(ix)};
+        Gjs::AutoChar underscore_name{
+            gjs_hyphen_to_underscore(prop_info.name())};
+        if (!add(cx, underscore_name, entry))
+            return false;
+
+        entry.enumerable = false;
+        Gjs::AutoChar camel_name{gjs_hyphen_to_camel(prop_info.name())};
+        if (!add(cx, prop_info.name(), entry) || !add(cx, camel_name, entry))
+            return false;
+    }
+    return true;
+}
+
+bool MemberIndex::add_fields(JSContext* cx, GIObjectInfo* info) {
+    int n_fields = g_object_info_get_n_fields(info);
+    for (int ix = 0; ix < n_fields; ix++) {
+        GI::AutoFieldInfo field_info{g_object_info_get_field(info, ix)};
+        if (!(g_field_info_get_flags(field_info) & GI_FIELD_IS_READABLE))
+            continue;
+
+        if (!add(cx, field_info.name(), {Kind::FIELD, false, -1, uint16_t(ix)}))
+            return false;
+    }
+    return true;
+}
+
+bool MemberIndex::build(JSContext* cx) {
+    if (!GI_IS_OBJECT_INFO(m_info))
+        return add_methods(cx, m_info, -1);
+
+    // Same precedence as the linear search in ObjectPrototype's resolve hook:
+    // vfuncs, then properties, then fields, then methods. Members of the
+    // object itself come before those of its interfaces.
+    int n_interfaces = g_object_info_get_n_interfaces(m_info);
+    g_assert(n_interfaces <= INT16_MAX && "too many interfaces");
+
+    if (!add_vfuncs(cx, m_info, -1))
+        return false;
+    for (int16_t ix = 0; ix < n_interfaces; ix++) {
+        GI::AutoInterfaceInfo iface_info{
+            g_object_info_get_interface(m_info, ix)};
+        if (!add_vfuncs(cx, iface_info, ix))
+            return false;
+    }
+
+    if (!add_properties(cx, m_info, -1))
+        return false;
+    for (int16_t ix = 0; ix < n_interfaces; ix++) {
+        GI::AutoInterfaceInfo iface_info{
+            g_object_info_get_interface(m_info, ix)};
+        if (!add_properties(cx, iface_info, ix))
+            return false;
+    }
+
+    if (!add_fields(cx, m_info) || !add_methods(cx, m_info, -1))
+        return false;
+    for (int16_t ix = 0; ix < n_interfaces; ix++) {
+        GI::AutoInterfaceInfo iface_info{
+            g_object_info_get_interface(m_info, ix)};
+        if (!add_methods(cx, iface_info, ix))
+            return false;
+    }
+
+    return true;
+}
+
+std::unique_ptr<MemberIndex> MemberIndex::create(JSContext* cx,
+                                                 GIBaseInfo* info) {
+    std::unique_ptr<MemberIndex> index{new MemberIndex(info)};
+    bool ok = index->build(cx);
+    // Subtracted again by the destructor, also if building failed
+    GJS_ADD_STAT(member_index_entries, index->size());
+    if (!ok)
+        return nullptr;
+
+    gjs_debug(GJS_DEBUG_GREPO, "Indexed %zu members of %s.%s", index->size(),
+              index->m_info.ns(), index->m_info.name());
+    return index;
+}
+
+MemberIndex::~MemberIndex() {
+    GJS_ADD_STAT(member_index_entries, -int64_t(size()));
+}
+
+Maybe<MemberIndex::Entry> MemberIndex::lookup(jsid id) const {
+    GJS_ADD_STAT(member_index_lookups, 1);
+
+    Map::Ptr p = m_map.lookup(id);
+    if (!p) {
+        GJS_ADD_STAT(member_index_misses, 1);
+        return Nothing();
+    }
+    return Some(p->value());
+}
+
+GI::AutoInterfaceInfo MemberIndex::interface_info(const Entry& entry) const {
+    g_assert(entry.on_interface());
+    return g_object_info_get_interface(m_info, entry.iface_ix);
+}
+
+GI::AutoFunctionInfo MemberIndex::function_info(const Entry& entry) const {
+    g_assert(entry.kind == Kind::METHOD || entry.kind == Kind::FUNCTION);
+    if (entry.on_interface())
+        return g_interface_info_get_method(interface_info(entry), entry.ix);
+    return get_method(m_info, entry.ix);
+}
+
+GI::AutoVFuncInfo MemberIndex::vfunc_info(const Entry& entry) const {
+    g_assert(entry.kind == Kind::VFUNC);
+    if (entry.on_interface())
+        return g_interface_info_get_vfunc(interface_info(entry), entry.ix);
+    return g_object_info_get_vfunc(m_info, entry.ix);
+}
+
+GI::AutoPropertyInfo MemberIndex::property_info(const Entry& entry) const {
+    g_assert(entry.kind == Kind::PROPERTY);
+    if (entry.on_interface())
+        return g_interface_info_get_property(interface_info(entry), entry.ix);
+    return g_object_info_get_property(m_info, entry.ix);
+}
+
+GI::AutoFieldInfo MemberIndex::field_info(const Entry& entry) const {
+    g_assert(entry.kind == Kind::FIELD);
+    return g_object_info_get_field(m_info, entry.ix);
+}
+
+bool MemberIndex::append_enumerable_ids(
+    JSContext* cx, JS::MutableHandleIdVector properties) const {
+    if (!properties.reserve(properties.length() + m_map.count())) {
+        JS_ReportOutOfMemory(cx);
+        return false;
+    }
+
+    for (auto iter = m_map.iter(); !iter.done(); iter.next()) {
+        if (iter.get().value().enumerable)
+            properties.infallibleAppend(iter.get().key().get());
+    }
+    return true;
+}
+
+}  // namespace Gjs
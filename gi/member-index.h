@@ -0,0 +1,138 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#pragma once
+
+#include <config.h>
+
+#include <stdint.h>
+
+#include <memory>  // for unique_ptr
+
+#include <girepository.h>
+
+#include <js/AllocPolicy.h>
+#include <js/GCHashTable.h>  // for GCHashMap
+#include <js/GCPolicyAPI.h>  // for IgnoreGCPolicy
+#include <js/HashTable.h>    // for DefaultHasher
+#include <js/Id.h>
+#include <js/RootingAPI.h>
+#include <js/TypeDecls.h>
+#include <mozilla/HashFunctions.h>  // for HashGeneric, HashNumber
+#include <mozilla/Likely.h>         // for MOZ_LIKELY
+#include <mozilla/Maybe.h>
+
+#include "gi/info.h"
+#include "gjs/macros.h"
+
+class JSTracer;
+
+// See https://bugzilla.mozilla.org/show_bug.cgi?id=1614220
+struct IdHasher {
+    typedef jsid Lookup;
+    static mozilla::HashNumber hash(jsid id) {
+        if (MOZ_LIKELY(id.isString()))
+            return js::DefaultHasher<JSString*>::hash(id.toString());
+        if (id.isSymbol())
+            return js::DefaultHasher<JS::Symbol*>::hash(id.toSymbol());
+        return mozilla::HashGeneric(id.asRawBits());
+    }
+    static bool match(jsid id1, jsid id2) { return id1 == id2; }
+};
+
+namespace Gjs {
+
+/*
+ * Gjs::MemberIndex:
+ *
+ * Maps the JS names of the members of an introspected type (object, interface,
+ * struct or union) to their position in the introspection info, so that the
+ * resolve and enumerate hooks of the prototype can use a hash lookup instead of
+ * searching the introspection info linearly for each name.
+ *
+ * The index is built once per prototype, the first time it is needed. Methods
+ * and functions are indexed for all types. For objects, virtual functions
+ * (under their "vfunc_" name), GObject properties (under their canonical,
+ * underscore and camelCase names) and readable fields are indexed as well,
+ * including the methods, vfuncs and properties of the interfaces listed in the
+ * object's introspection info.
+ */
+class MemberIndex {
+ public:
+    enum class Kind : uint8_t {
+        METHOD,    // function with GI_FUNCTION_IS_METHOD
+        FUNCTION,  // static function or constructor
+        VFUNC,
+        PROPERTY,
+        FIELD,
+    };
+
+    struct Entry {
+        Kind kind;
+        // Whether this entry is to be listed in the enumerate hook
+        bool enumerable : 1;
+        // Index of the interface in the object info that defines this member,
+        // or -1 if it is defined in the indexed info itself
+        int16_t iface_ix;
+        // Index of the member in the defining info
+        uint16_t ix;
+
+        [[nodiscard]] bool on_interface() const { return iface_ix >= 0; }
+    };
+
+ private:
+    using Map = JS::GCHashMap<JS::Heap<jsid>, Entry, IdHasher,
+                              js::SystemAllocPolicy>;
+
+    GI::AutoBaseInfo m_info;
+    Map m_map;
+
+    explicit MemberIndex(GIBaseInfo* info)
+        : m_info(info, Gjs::TakeOwnership{}) {}
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool add(JSContext* cx, const char* name, Entry entry);
+    GJS_JSAPI_RETURN_CONVENTION
+    bool add_methods(JSContext* cx, GIBaseInfo* container, int16_t iface_ix);
+    GJS_JSAPI_RETURN_CONVENTION
+    bool add_vfuncs(JSContext* cx, GIBaseInfo* container, int16_t iface_ix);
+    GJS_JSAPI_RETURN_CONVENTION
+    bool add_properties(JSContext* cx, GIBaseInfo* container, int16_t iface_ix);
+    GJS_JSAPI_RETURN_CONVENTION
+    bool add_fields(JSContext* cx, GIObjectInfo* info);
+    GJS_JSAPI_RETURN_CONVENTION
+    bool build(JSContext* cx);
+
+ public:
+    GJS_JSAPI_RETURN_CONVENTION
+    static std::unique_ptr<MemberIndex> create(JSContext* cx, GIBaseInfo* info);
+    ~MemberIndex();
+
+    [[nodiscard]] mozilla::Maybe<Entry> lookup(jsid id) const;
+
+    // Retrieving the introspection info for an entry
+    [[nodiscard]] GI::AutoFunctionInfo function_info(const Entry& entry) const;
+    [[nodiscard]] GI::AutoVFuncInfo vfunc_info(const Entry& entry) const;
+    [[nodiscard]] GI::AutoPropertyInfo property_info(const Entry& entry) const;
+    [[nodiscard]] GI::AutoFieldInfo field_info(const Entry& entry) const;
+    // Returns the interface info for entries defined on an interface
+    [[nodiscard]] GI::AutoInterfaceInfo interface_info(
+        const Entry& entry) const;
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool append_enumerable_ids(JSContext* cx,
+                               JS::MutableHandleIdVector properties) const;
+
+    [[nodiscard]] size_t size() const { return m_map.count(); }
+
+    void trace(JSTracer* trc) { m_map.trace(trc); }
+};
+
+}  // namespace Gjs
+
+namespace JS {
+template <>
+struct GCPolicy<Gjs::MemberIndex::Entry>
+    : public IgnoreGCPolicy<Gjs::MemberIndex::Entry> {};
+}  // namespace JS
@@ -9,7 +9,6 @@
 #include <string.h>  // for memset, strcmp
 
 #include <algorithm>  // for find
-#include <array>
 #include <functional>  // for mem_fn
 #include <limits>
 #include <string>
@@ -23,6 +22,7 @@
 #include <glib-object.h>
 #include <glib.h>
 
+#include <js/Array.h>  // for GetArrayLength, IsArrayObject
 #include <js/CallAndConstruct.h>  // for IsCallable, JS_CallFunctionValue
 #include <js/CallArgs.h>
 #include <js/CharacterEncoding.h>
@@ -43,7 +43,7 @@
 #include <js/Value.h>
 #include <js/ValueArray.h>
 #include <js/Warnings.h>
-#include <jsapi.h>        // for JS_GetFunctionObject, IdVector
+#include <jsapi.h>  // for JS_GetFunctionObject, IdVector, JS_NewPlainObject
 #include <jsfriendapi.h>  // for JS_GetObjectFunction, GetFunctionNativeReserved
 #include <mozilla/Maybe.h>
 #include <mozilla/Result.h>
@@ -63,6 +63,7 @@
 #include "gi/toggle.h"
 #include "gi/utils-inl.h"  // for gjs_int_to_pointer
 #include "gi/value.h"
+#include "gi/wrapper-stats.h"
 #include "gi/wrapperutils.h"
 #include "gjs/atoms.h"
 #include "gjs/auto.h"
@@ -98,8 +99,8 @@ static_assert(sizeof(ObjectInstance) <= 64,
               "gnome-shell run.");
 #endif  // x86-64 clang
 
-bool ObjectInstance::s_weak_pointer_callback = false;
-decltype(ObjectInstance::s_wrapped_gobject_list)
+thread_local bool ObjectInstance::s_weak_pointer_callback = false;
+thread_local decltype(ObjectInstance::s_wrapped_gobject_list)
     ObjectInstance::s_wrapped_gobject_list;
 
 static const auto DISPOSED_OBJECT = std::numeric_limits<uintptr_t>::max();
@@ -248,6 +249,41 @@ GParamSpec* ObjectPrototype::find_param_spec_from_id(
     return pspec;
 }
 
+/*
+ * ObjectPrototype::find_param_spec_from_accessor:
+ *
+ * Like find_param_spec_from_id(), but for the property @id of the wrapper
+ * @obj. If it resolves to a GObject property accessor, the param spec is the
+ * one recorded when the accessor was defined, so the name doesn't need to be
+ * converted and looked up in the class again.
+ */
+GParamSpec* ObjectPrototype::find_param_spec_from_accessor(
+    JSContext* cx, Gjs::AutoTypeClass<GObjectClass> const& object_class,
+    JS::HandleObject obj, JS::HandleId id) {
+    if (!id.isString()) {
+        gjs_wrapper_throw_nonexistent_field(cx, m_gtype,
+                                            gjs_debug_id(id).c_str());
+        return nullptr;
+    }
+
+    JS::Rooted<Maybe<JS::PropertyDescriptor>> desc{cx};
+    JS::RootedObject holder{cx};
+    if (!JS_GetPropertyDescriptorById(cx, obj, id, &desc, &holder))
+        return nullptr;
+
+    if (desc.isSome() && desc->isAccessorDescriptor()) {
+        ObjectBase* holder_priv = ObjectBase::for_js(cx, holder);
+        if (holder_priv && holder_priv->is_prototype()) {
+            auto& cache = holder_priv->to_prototype()->m_param_spec_cache;
+            if (ParamSpecCache::Ptr p = cache.lookup(id))
+                return p->value();
+        }
+    }
+
+    JS::RootedString key{cx, id.toString()};
+    return find_param_spec_from_id(cx, object_class, key);
+}
+
 /* A hook on adding a property to an object. This is called during a set
  * property operation after all the resolve hooks on the prototype chain have
  * failed to resolve. We use this to mark an object as needing toggle refs when
@@ -341,13 +377,25 @@ bool ObjectBase::prop_getter_write_only(JSContext*, unsigned argc,
     return true;
 }
 
+// Everything that the accessor needs to know about the property and its
+// getter or setter is looked up once in init(), so that accessing the property
+// doesn't have to query the introspection info on every call.
 class ObjectPropertyInfoCaller {
  public:
     GI::AutoFunctionInfo func_info;
+    GI::AutoPropertyInfo property_info;
     void* native_address;
+    // Type and ownership transfer of the getter's return value, or of the
+    // setter's value argument
+    GITypeInfo type_info;
+    GITransfer transfer;
+    bool is_deprecated;
 
     explicit ObjectPropertyInfoCaller(GIFunctionInfo* info)
-        : func_info(info, Gjs::TakeOwnership{}), native_address(nullptr) {}
+        : func_info(info, Gjs::TakeOwnership{}),
+          native_address(nullptr),
+          transfer(GI_TRANSFER_NOTHING),
+          is_deprecated(false) {}
 
     Gjs::GErrorResult<> init() {
         GIFunctionInvoker invoker;
@@ -356,6 +404,24 @@ class ObjectPropertyInfoCaller {
             return Err(std::move(error));
         native_address = invoker.native_address;
         g_function_invoker_destroy(&invoker);
+
+        property_info = g_function_info_get_property(func_info);
+        g_assert(property_info && "accessor must be attached to a property");
+        is_deprecated =
+            g_property_info_get_flags(property_info) & G_PARAM_DEPRECATED ||
+            g_base_info_is_deprecated(property_info) ||
+            g_base_info_is_deprecated(func_info);
+
+        if (g_callable_info_get_n_args(func_info) == 0) {
+            g_callable_info_load_return_type(func_info, &type_info);
+            transfer = g_callable_info_get_caller_owns(func_info);
+        } else {
+            GIArgInfo arg_info;
+            g_callable_info_load_arg(func_info, 0, &arg_info);
+            g_arg_info_load_type(&arg_info, &type_info);
+            transfer = g_arg_info_get_ownership_transfer(&arg_info);
+        }
+
         return Ok{};
     }
 };
@@ -368,13 +434,12 @@ bool ObjectBase::prop_getter_func(JSContext* cx, unsigned argc, JS::Value* vp) {
     auto* info_caller =
         Gjs::SimpleWrapper::get<ObjectPropertyInfoCaller>(cx, pspec_obj);
 
-    const GI::AutoFunctionInfo& func_info = info_caller->func_info;
-    GI::AutoPropertyInfo property_info{g_function_info_get_property(func_info)};
+    const char* prop_name = info_caller->property_info.name();
     std::string full_name{GJS_PROFILER_DYNAMIC_STRING(
-        cx, priv->format_name() + "[\"" + property_info.name() + "\"]")};
+        cx, priv->format_name() + "[\"" + prop_name + "\"]")};
     AutoProfilerLabel label{cx, "property getter", full_name};
 
-    priv->debug_jsprop("Property getter", property_info.name(), obj);
+    priv->debug_jsprop("Property getter", prop_name, obj);
 
     // Ignore silently; note that this is different from what we do for
     // boxed types, for historical reasons
@@ -466,13 +531,8 @@ bool ObjectInstance::prop_getter_impl(JSContext* cx,
         return true;
     }
 
-    const GI::AutoFunctionInfo& getter = info_caller->func_info;
-    GI::AutoPropertyInfo property_info{g_function_info_get_property(getter)};
-    GParamFlags flags = g_property_info_get_flags(property_info);
-
-    if (flags & G_PARAM_DEPRECATED ||
-        g_base_info_is_deprecated(property_info) ||
-        g_base_info_is_deprecated(getter)) {
+    const GI::AutoPropertyInfo& property_info = info_caller->property_info;
+    if (info_caller->is_deprecated) {
         _gjs_warn_deprecated_once_per_callsite(
             cx, DeprecatedGObjectProperty,
             {format_name(), property_info.name()});
@@ -482,12 +542,8 @@ bool ObjectInstance::prop_getter_impl(JSContext* cx,
                      property_info.name());
 
     GIArgument ret;
-    std::array<GIArgument, 1> gi_args;
-    gjs_arg_set(&gi_args[0], m_ptr.get());
-
-    GITypeInfo type_info;
-    g_callable_info_load_return_type(getter, &type_info);
-    if (!simple_getters_caller(&type_info, m_ptr, info_caller->native_address,
+    GITypeInfo* type_info = &info_caller->type_info;
+    if (!simple_getters_caller(type_info, m_ptr, info_caller->native_address,
                                &ret)) {
         const std::string& class_name = format_name();
         gjs_throw(cx, "Wrong type for %s::%s getter", class_name.c_str(),
@@ -495,9 +551,9 @@ bool ObjectInstance::prop_getter_impl(JSContext* cx,
         return false;
     }
 
-    GITransfer transfer = g_callable_info_get_caller_owns(getter);
+    GITransfer transfer = info_caller->transfer;
 
-    if (!gjs_value_from_gi_argument(cx, args.rval(), &type_info,
+    if (!gjs_value_from_gi_argument(cx, args.rval(), type_info,
                                     GJS_ARGUMENT_RETURN_VALUE, transfer,
                                     &ret)) {
         // Unlikely to happen, but we fallback to gvalue mode, just in case
@@ -514,7 +570,7 @@ bool ObjectInstance::prop_getter_impl(JSContext* cx,
         return prop_getter_impl<void>(cx, pspec, args[0]);
     }
 
-    return gjs_gi_argument_release(cx, transfer, &type_info,
+    return gjs_gi_argument_release(cx, transfer, type_info,
                                    GjsArgumentFlags::ARG_OUT, &ret);
 }
 
@@ -551,8 +607,7 @@ bool ObjectBase::prop_getter_simple_type_func(JSContext* cx, unsigned argc,
         cx, priv->format_name() + "[\"" + caller->pspec->name + "\"]")};
     AutoProfilerLabel label{cx, "property getter", full_name};
 
-    priv->debug_jsprop("Property getter",
-                       gjs_intern_string_to_id(cx, caller->pspec->name), obj);
+    priv->debug_jsprop("Property getter", caller->pspec->name, obj);
 
     // Ignore silently; note that this is different from what we do for
     // boxed types, for historical reasons
@@ -596,25 +651,6 @@ bool ObjectInstance::prop_getter_impl(JSContext* cx,
     return true;
 }
 
-[[nodiscard]] static GI::AutoFieldInfo lookup_field_info(GIObjectInfo* info,
-                                                         const char* name) {
-    int n_fields = g_object_info_get_n_fields(info);
-    int ix;
-    GI::AutoFieldInfo retval;
-
-    for (ix = 0; ix < n_fields; ix++) {
-        retval = g_object_info_get_field(info, ix);
-        if (strcmp(name, retval.name()) == 0)
-            break;
-        retval.reset();
-    }
-
-    if (!retval || !(g_field_info_get_flags(retval) & GI_FIELD_IS_READABLE))
-        return nullptr;
-
-    return retval;
-}
-
 bool ObjectBase::field_getter(JSContext* cx, unsigned argc, JS::Value* vp) {
     GJS_CHECK_WRAPPER_PRIV(cx, argc, vp, args, obj, ObjectBase, priv);
 
@@ -788,13 +824,12 @@ bool ObjectBase::prop_setter_func(JSContext* cx, unsigned argc, JS::Value* vp) {
     auto* info_caller =
         Gjs::SimpleWrapper::get<ObjectPropertyInfoCaller>(cx, func_obj);
 
-    const GI::AutoFunctionInfo& func_info = info_caller->func_info;
-    GI::AutoPropertyInfo property_info{g_function_info_get_property(func_info)};
+    const char* prop_name = info_caller->property_info.name();
     std::string full_name{GJS_PROFILER_DYNAMIC_STRING(
-        cx, priv->format_name() + "[\"" + property_info.name() + "\"]")};
+        cx, priv->format_name() + "[\"" + prop_name + "\"]")};
     AutoProfilerLabel label{cx, "property setter", full_name};
 
-    priv->debug_jsprop("Property setter", property_info.name(), obj);
+    priv->debug_jsprop("Property setter", prop_name, obj);
 
     // Ignore silently; note that this is different from what we do for
     // boxed types, for historical reasons
@@ -882,13 +917,8 @@ bool ObjectInstance::prop_setter_impl(JSContext* cx,
     if (!check_gobject_finalized("set any property on"))
         return true;
 
-    const GI::AutoFunctionInfo& setter = info_caller->func_info;
-    GI::AutoPropertyInfo property_info{g_function_info_get_property(setter)};
-    GParamFlags flags = g_property_info_get_flags(property_info);
-
-    if (flags & G_PARAM_DEPRECATED ||
-        g_base_info_is_deprecated(property_info) ||
-        g_base_info_is_deprecated(setter)) {
+    const GI::AutoPropertyInfo& property_info = info_caller->property_info;
+    if (info_caller->is_deprecated) {
         _gjs_warn_deprecated_once_per_callsite(
             cx, DeprecatedGObjectProperty,
             {format_name(), property_info.name()});
@@ -897,15 +927,12 @@ bool ObjectInstance::prop_setter_impl(JSContext* cx,
     gjs_debug_jsprop(GJS_DEBUG_GOBJECT, "Setting GObject prop via setter %s",
                      property_info.name());
 
-    GIArgInfo arg_info;
-    g_callable_info_load_arg(setter, 0, &arg_info);
-    GITypeInfo type_info;
-    g_arg_info_load_type(&arg_info, &type_info);
-    GITransfer transfer = g_arg_info_get_ownership_transfer(&arg_info);
+    GITypeInfo* type_info = &info_caller->type_info;
+    GITransfer transfer = info_caller->transfer;
     JS::RootedValue value{cx, args[0]};
     GIArgument arg;
 
-    if (!gjs_value_to_gi_argument(cx, value, &type_info, property_info.name(),
+    if (!gjs_value_to_gi_argument(cx, value, type_info, property_info.name(),
                                   GJS_ARGUMENT_ARGUMENT, transfer,
                                   GjsArgumentFlags::ARG_IN, &arg)) {
         // Unlikely to happen, but we fallback to gvalue mode, just in case
@@ -922,7 +949,7 @@ bool ObjectInstance::prop_setter_impl(JSContext* cx,
         return prop_setter_impl<void>(cx, pspec, value);
     }
 
-    if (!simple_setters_caller(&type_info, &arg, m_ptr,
+    if (!simple_setters_caller(type_info, &arg, m_ptr,
                                info_caller->native_address)) {
         const std::string& class_name = format_name();
         gjs_throw(cx, "Wrong type for %s::%s setter", class_name.c_str(),
@@ -930,7 +957,7 @@ bool ObjectInstance::prop_setter_impl(JSContext* cx,
         return false;
     }
 
-    return gjs_gi_argument_release_in_arg(cx, transfer, &type_info, &arg);
+    return gjs_gi_argument_release_in_arg(cx, transfer, type_info, &arg);
 }
 
 template <typename TAG, GITransfer TRANSFER>
@@ -1128,26 +1155,6 @@ static Maybe<GI::AutoPropertyInfo> get_ginterface_property_by_name(
     return {};
 }
 
-[[nodiscard]]
-static Maybe<GI::AutoPropertyInfo> get_gobject_property_info(GIObjectInfo* info,
-                                                             const char* name) {
-    int n_props = g_object_info_get_n_properties(info);
-    for (int ix = 0; ix < n_props; ix++) {
-        GI::AutoPropertyInfo prop_info{g_object_info_get_property(info, ix)};
-        if (strcmp(name, prop_info.name()) == 0)
-            return Some(prop_info);
-    }
-
-    int n_ifaces = g_object_info_get_n_interfaces(info);
-    for (int ix = 0; ix < n_ifaces; ix++) {
-        GI::AutoInterfaceInfo iface_info{g_object_info_get_interface(info, ix)};
-        if (Maybe<GI::AutoPropertyInfo> prop_info =
-                get_ginterface_property_by_name(iface_info, name))
-            return prop_info;
-    }
-    return {};
-}
-
 [[nodiscard]]
 static JSNative get_getter_for_type(GITypeInfo* type_info,
                                     GITransfer transfer) {
@@ -1575,6 +1582,10 @@ bool ObjectPrototype::lazy_define_gobject_property(
             canonical_desc = *desc;
             if (!JS_DefinePropertyById(cx, obj, id, canonical_desc))
                 return false;
+            if (!m_param_spec_cache.put(id, pspec)) {
+                JS_ReportOutOfMemory(cx);
+                return false;
+            }
 
             *resolved = true;
             return true;
@@ -1620,6 +1631,10 @@ bool ObjectPrototype::lazy_define_gobject_property(
                                      js_getter, getter_priv, js_setter,
                                      setter_priv, flags))
         return false;
+    if (!m_param_spec_cache.put(id, pspec)) {
+        JS_ReportOutOfMemory(cx);
+        return false;
+    }
 
     if G_UNLIKELY (!canonical_id.isVoid()) {
         debug_jsprop("Defining alias GObject property", canonical_id, obj);
@@ -1888,19 +1903,6 @@ bool ObjectPrototype::resolve_no_info(JSContext* cx, JS::HandleObject obj,
     return true;
 }
 
-[[nodiscard]]
-static Maybe<GI::AutoPropertyInfo> find_gobject_property_info(
-    GIObjectInfo* info, const char* name) {
-    // Optimization: GObject property names must start with a letter
-    if (!g_ascii_isalpha(name[0]))
-        return {};
-
-    Gjs::AutoChar canonical_name{gjs_hyphen_from_camel(name)};
-    canonicalize_key(canonical_name);
-
-    return get_gobject_property_info(info, canonical_name);
-}
-
 // Override of GIWrapperBase::id_is_never_lazy()
 bool ObjectBase::id_is_never_lazy(jsid name, const GjsAtoms& atoms) {
     // Keep this list in sync with ObjectBase::proto_properties and
@@ -1959,6 +1961,11 @@ bool ObjectPrototype::uncached_resolve(JSContext* context, JS::HandleObject obj,
         return resolve_no_info(context, obj, id, resolved, name,
                                ConsiderMethodsAndProperties);
 
+    if (!ensure_member_index(context))
+        return false;
+
+    Maybe<Gjs::MemberIndex::Entry> entry = m_member_index->lookup(id);
+
     if (g_str_has_prefix(name, "vfunc_")) {
         /* The only time we find a vfunc info is when we're the base
          * class that defined the vfunc. If we let regular prototype
@@ -1974,10 +1981,17 @@ bool ObjectPrototype::uncached_resolve(JSContext* context, JS::HandleObject obj,
          * rest.
          */
 
-        const char *name_without_vfunc_ = &(name[6]);  /* lifetime tied to name */
-        bool defined_by_parent;
-        GI::AutoVFuncInfo vfunc{find_vfunc_on_parents(
-            m_info, name_without_vfunc_, &defined_by_parent)};
+        GI::AutoVFuncInfo vfunc;
+        bool defined_by_parent = false;
+        if (entry && entry->kind == Gjs::MemberIndex::Kind::VFUNC) {
+            vfunc = m_member_index->vfunc_info(*entry);
+        } else {
+            // Not in the index, so only the parents can define it
+            const char *name_without_vfunc_ = &(name[6]);  /* lifetime tied to name */
+            vfunc = find_vfunc_on_parents(m_info, name_without_vfunc_,
+                                          &defined_by_parent);
+        }
+
         if (vfunc) {
             /* In the event that the vfunc is unchanged, let regular
              * prototypal inheritance take over. */
@@ -1997,35 +2011,20 @@ bool ObjectPrototype::uncached_resolve(JSContext* context, JS::HandleObject obj,
          * method resolution. */
     }
 
-    if (Maybe<GI::AutoPropertyInfo> property_info =
-            find_gobject_property_info(m_info, name)) {
-        Gjs::AutoTypeClass<GObjectClass> gobj_class{m_gtype};
-        if (GParamSpec* pspec =
-                g_object_class_find_property(gobj_class, property_info->name()))
-            return lazy_define_gobject_property(context, obj, id, pspec,
-                                                resolved, name, property_info);
-    }
-
-    GI::AutoFieldInfo field_info{lookup_field_info(m_info, name)};
-    if (field_info) {
-        debug_jsprop("Defining lazy GObject field", id, obj);
-
-        unsigned flags = GJS_MODULE_PROP_FLAGS;
-        if (!(g_field_info_get_flags(field_info) & GI_FIELD_IS_WRITABLE))
-            flags |= JSPROP_READONLY;
-
-        JS::RootedObject rooted_field{
-            context, Gjs::SimpleWrapper::new_for_type<GI::AutoFieldInfo>(
-                         context, field_info)};
-        JS::RootedValue private_value{context, JS::ObjectValue(*rooted_field)};
-        if (!gjs_define_property_dynamic(
-                context, obj, name, id, "gobject_field",
-                &ObjectBase::field_getter, &ObjectBase::field_setter,
-                private_value, flags))
-            return false;
-
-        *resolved = true;
-        return true;
+    // The index contains the canonical, underscore, and camelCase spellings of
+    // property names. Other spellings that GObject accepts, such as mixed
+    // hyphens and underscores, need to be canonicalized first.
+    if (!entry && g_ascii_isalpha(name[0])) {
+        Gjs::AutoChar canonical_name{gjs_hyphen_from_camel(name)};
+        canonicalize_key(canonical_name);
+        if (strcmp(canonical_name, name) != 0) {
+            JSString* atom = JS_AtomizeString(context, canonical_name);
+            if (!atom)
+                return false;
+            entry = m_member_index->lookup(JS::PropertyKey::NonIntAtom(atom));
+            if (entry && entry->kind != Gjs::MemberIndex::Kind::PROPERTY)
+                entry.reset();
+        }
     }
 
     /* find_method does not look at methods on parent classes,
@@ -2037,21 +2036,77 @@ bool ObjectPrototype::uncached_resolve(JSContext* context, JS::HandleObject obj,
      * methods in the object prototype, which means there are many
      * copies of the iface methods (one per object class node that
      * introduces the iface)
-     */
-
-    GI::AutoBaseInfo implementor_info;
-    GI::AutoFunctionInfo method_info{g_object_info_find_method_using_interfaces(
-        m_info, name, implementor_info.out())};
-
-    /**
+     *
      * Search through any interfaces implemented by the GType;
      * See https://bugzilla.gnome.org/show_bug.cgi?id=632922
      * for background on why we need to do this.
      */
-    if (!method_info)
+    if (!entry)
         return resolve_no_info(context, obj, id, resolved, name,
                                ConsiderOnlyMethods);
 
+    GI::AutoBaseInfo implementor_info;
+    GI::AutoFunctionInfo method_info;
+
+    switch (entry->kind) {
+        case Gjs::MemberIndex::Kind::PROPERTY: {
+            GI::AutoPropertyInfo property_info{
+                m_member_index->property_info(*entry)};
+            Gjs::AutoTypeClass<GObjectClass> gobj_class{m_gtype};
+            if (GParamSpec* pspec = g_object_class_find_property(
+                    gobj_class, property_info.name()))
+                return lazy_define_gobject_property(context, obj, id, pspec,
+                                                    resolved, name,
+                                                    Some(property_info));
+
+            // The introspection info doesn't match the class; a method may
+            // still have the same name
+            method_info = g_object_info_find_method_using_interfaces(
+                m_info, name, implementor_info.out());
+            if (!method_info) {
+                *resolved = false;
+                return true;
+            }
+            break;
+        }
+
+        case Gjs::MemberIndex::Kind::FIELD: {
+            GI::AutoFieldInfo field_info{m_member_index->field_info(*entry)};
+            debug_jsprop("Defining lazy GObject field", id, obj);
+
+            unsigned flags = GJS_MODULE_PROP_FLAGS;
+            if (!(g_field_info_get_flags(field_info) & GI_FIELD_IS_WRITABLE))
+                flags |= JSPROP_READONLY;
+
+            JS::RootedObject rooted_field{
+                context, Gjs::SimpleWrapper::new_for_type<GI::AutoFieldInfo>(
+                             context, field_info)};
+            JS::RootedValue private_value{context,
+                                          JS::ObjectValue(*rooted_field)};
+            if (!gjs_define_property_dynamic(
+                    context, obj, name, id, "gobject_field",
+                    &ObjectBase::field_getter, &ObjectBase::field_setter,
+                    private_value, flags))
+                return false;
+
+            *resolved = true;
+            return true;
+        }
+
+        case Gjs::MemberIndex::Kind::METHOD:
+            method_info = m_member_index->function_info(*entry);
+            if (entry->on_interface())
+                implementor_info = m_member_index->interface_info(*entry);
+            break;
+
+        case Gjs::MemberIndex::Kind::FUNCTION:
+        case Gjs::MemberIndex::Kind::VFUNC:
+            // Static functions are not defined on the prototype, and vfuncs
+            // were already handled above
+            *resolved = false;
+            return true;
+    }
+
 #if GJS_VERBOSE_ENABLE_GI_USAGE
     _gjs_log_info_usage(method_info);
 #endif
@@ -2060,7 +2115,7 @@ bool ObjectPrototype::uncached_resolve(JSContext* context, JS::HandleObject obj,
         gjs_debug(GJS_DEBUG_GOBJECT,
                   "Defining method %s in prototype for %s (%s)",
                   method_info.name(), type_name(), format_name().c_str());
-        if (GI_IS_INTERFACE_INFO(implementor_info)) {
+        if (implementor_info && GI_IS_INTERFACE_INFO(implementor_info)) {
             bool found = false;
             if (!resolve_on_interface_prototype(context, implementor_info, id,
                                                 obj, &found))
@@ -2137,39 +2192,9 @@ bool ObjectPrototype::new_enumerate_impl(JSContext* cx, JS::HandleObject,
     g_free(interfaces);
 
     if (info()) {
-        int n_methods = g_object_info_get_n_methods(info());
-        int n_properties = g_object_info_get_n_properties(info());
-        if (!properties.reserve(properties.length() + n_methods +
-                                n_properties)) {
-            JS_ReportOutOfMemory(cx);
+        if (!ensure_member_index(cx))
             return false;
-        }
-
-        // Methods
-        for (int i = 0; i < n_methods; i++) {
-            GI::AutoFunctionInfo meth_info{g_object_info_get_method(info(), i)};
-            GIFunctionInfoFlags flags = g_function_info_get_flags(meth_info);
-
-            if (flags & GI_FUNCTION_IS_METHOD) {
-                const char* name = meth_info.name();
-                jsid id = gjs_intern_string_to_id(cx, name);
-                if (id.isVoid())
-                    return false;
-                properties.infallibleAppend(id);
-            }
-        }
-
-        // Properties
-        for (int i = 0; i < n_properties; i++) {
-            GI::AutoPropertyInfo prop_info{
-                g_object_info_get_property(info(), i)};
-
-            Gjs::AutoChar js_name{gjs_hyphen_to_underscore(prop_info.name())};
-            jsid id = gjs_intern_string_to_id(cx, js_name);
-            if (id.isVoid())
-                return false;
-            properties.infallibleAppend(id);
-        }
+        return m_member_index->append_enumerable_ids(cx, properties);
     }
 
     return true;
@@ -2179,8 +2204,8 @@ bool ObjectPrototype::new_enumerate_impl(JSContext* cx, JS::HandleObject,
  * a hash) */
 bool ObjectPrototype::props_to_g_parameters(
     JSContext* context, Gjs::AutoTypeClass<GObjectClass> const& object_class,
-    JS::HandleObject props, std::vector<const char*>* names,
-    AutoGValueVector* values) {
+    JS::HandleObject obj, JS::HandleObject props,
+    std::vector<const char*>* names, AutoGValueVector* values) {
     size_t ix, length;
     JS::RootedId prop_id(context);
     JS::RootedValue value(context);
@@ -2197,13 +2222,8 @@ bool ObjectPrototype::props_to_g_parameters(
          * doesn't know that */
         prop_id = ids[ix];
 
-        if (!prop_id.isString())
-            return gjs_wrapper_throw_nonexistent_field(
-                context, m_gtype, gjs_debug_id(prop_id).c_str());
-
-        JS::RootedString js_prop_name(context, prop_id.toString());
-        GParamSpec* param_spec =
-            find_param_spec_from_id(context, object_class, js_prop_name);
+        GParamSpec* param_spec = find_param_spec_from_accessor(
+            context, object_class, obj, prop_id);
         if (!param_spec)
             return false;
 
@@ -2273,7 +2293,7 @@ ObjectInstance::gobj_dispose_notify(void)
     if (m_uses_toggle_ref) {
         g_object_ref(m_ptr.get());
         g_object_remove_toggle_ref(m_ptr, wrapped_gobj_toggle_notify, this);
-        ToggleQueue::get_default()->cancel(this);
+        toggle_queue()->cancel(this);
         wrapped_gobj_toggle_notify(this, m_ptr, TRUE);
         m_uses_toggle_ref = false;
     }
@@ -2411,12 +2431,17 @@ static void toggle_handler(ObjectInstance* self,
 
 void ObjectInstance::wrapped_gobj_toggle_notify(void* instance, GObject*,
                                                 gboolean is_last_ref) {
-    bool is_main_thread;
+    bool is_owner_thread;
     bool toggle_up_queued, toggle_down_queued;
     auto* self = static_cast<ObjectInstance*>(instance);
 
-    GjsContextPrivate* gjs = GjsContextPrivate::from_current_context();
-    if (gjs->destroying()) {
+    // The current context is the one of the calling thread, which is only the
+    // context that owns the wrapper if this is the owner thread. Toggles from
+    // other threads are queued, and the owner's queue doesn't accept any more
+    // once the owner is being destroyed.
+    is_owner_thread = self->is_owned_by_current_thread();
+    if (is_owner_thread &&
+        GjsContextPrivate::from_current_context()->destroying()) {
         /* Do nothing here - we're in the process of disassociating
          * the objects.
          */
@@ -2451,9 +2476,7 @@ void ObjectInstance::wrapped_gobj_toggle_notify(void* instance, GObject*,
      * weak singletons like g_bus_get_sync() objects can see toggle-ups
      * from different threads too.
      */
-    is_main_thread = gjs->is_owner_thread();
-
-    auto toggle_queue = ToggleQueue::get_default();
+    auto toggle_queue = self->toggle_queue();
     std::tie(toggle_down_queued, toggle_up_queued) =
         toggle_queue->is_queued(self);
     bool anything_queued = toggle_up_queued || toggle_down_queued;
@@ -2463,7 +2486,7 @@ void ObjectInstance::wrapped_gobj_toggle_notify(void* instance, GObject*,
          * The JSObject is rooted and we need to unroot it so it
          * can be garbage collected
          */
-        if (is_main_thread && !anything_queued) {
+        if (is_owner_thread && !anything_queued) {
             self->toggle_down();
         } else {
             toggle_queue->enqueue(self, ToggleQueue::DOWN, toggle_handler);
@@ -2474,7 +2497,7 @@ void ObjectInstance::wrapped_gobj_toggle_notify(void* instance, GObject*,
          * The JSObject associated with the gobject is not rooted,
          * but it needs to be. We'll root it.
          */
-        if (is_main_thread && !anything_queued &&
+        if (is_owner_thread && !anything_queued &&
             !JS::RuntimeHeapIsCollecting()) {
             self->toggle_up();
         } else {
@@ -2591,7 +2614,8 @@ ObjectInstance::ObjectInstance(ObjectPrototype* prototype,
 }
 
 ObjectPrototype::ObjectPrototype(GIObjectInfo* info, GType gtype)
-    : GIWrapperPrototype(info, gtype) {
+    : GIWrapperPrototype(info, gtype),
+      m_toggle_queue(ToggleQueue::get_default_unlocked()) {
     g_type_class_ref(gtype);
 
     GJS_INC_COUNTER(object_prototype);
@@ -2625,9 +2649,9 @@ bool ObjectInstance::weak_pointer_was_finalized(JSTracer* trc) {
     if (has_wrapper() && !wrapper_is_rooted()) {
         bool toggle_down_queued, toggle_up_queued;
 
-        auto toggle_queue = ToggleQueue::get_default();
+        auto locked_queue = toggle_queue();
         std::tie(toggle_down_queued, toggle_up_queued) =
-            toggle_queue->is_queued(this);
+            locked_queue->is_queued(this);
 
         if (!toggle_down_queued && toggle_up_queued)
             return false;
@@ -2636,7 +2660,7 @@ bool ObjectInstance::weak_pointer_was_finalized(JSTracer* trc) {
             return false;
 
         if (toggle_down_queued)
-            toggle_queue->cancel(this);
+            locked_queue->cancel(this);
 
         /* Ouch, the JS object is dead already. Disassociate the
          * GObject and hope the GObject dies too. (Remove it from
@@ -2744,8 +2768,7 @@ ObjectInstance::disassociate_js_gobject(void)
 {
     bool had_toggle_down, had_toggle_up;
 
-    std::tie(had_toggle_down, had_toggle_up) =
-        ToggleQueue::get_default()->cancel(this);
+    std::tie(had_toggle_down, had_toggle_up) = toggle_queue()->cancel(this);
     if (had_toggle_up && !had_toggle_down) {
         g_error(
             "JS object wrapper for GObject %p (%s) is being released while "
@@ -2801,8 +2824,8 @@ bool ObjectInstance::init_impl(JSContext* context, const JS::CallArgs& args,
                       name());
             return false;
         }
-        if (!m_proto->props_to_g_parameters(context, object_class, props,
-                                            &names, &values))
+        if (!m_proto->props_to_g_parameters(context, object_class, object,
+                                            props, &names, &values))
             return false;
     }
 
@@ -2827,6 +2850,14 @@ bool ObjectInstance::init_impl(JSContext* context, const JS::CallArgs& args,
                                                  names.data(), values.data());
 
     ObjectInstance *other_priv = ObjectInstance::for_gobject(gobj);
+    if (other_priv && G_UNLIKELY(!other_priv->is_owned_by_current_thread())) {
+        gjs_throw(context,
+                  "Object %p (a %s) is already wrapped by a GJS context on "
+                  "another thread",
+                  gobj, g_type_name(G_TYPE_FROM_INSTANCE(gobj)));
+        g_object_unref(gobj);
+        return false;
+    }
     if (other_priv && other_priv->m_wrapper != object.get()) {
         /* g_object_new_with_properties() returned an object that's already
          * tracked by a JS object.
@@ -2915,6 +2946,8 @@ void ObjectInstance::trace_impl(JSTracer* tracer) {
 
 void ObjectPrototype::trace_impl(JSTracer* tracer) {
     m_unresolvable_cache.trace(tracer);
+    m_param_spec_cache.trace(tracer);
+    trace_member_index(tracer);
     for (GClosure* closure : m_vfuncs)
         Gjs::Closure::for_gclosure(closure)->trace(tracer);
 }
@@ -2940,8 +2973,7 @@ ObjectInstance::~ObjectInstance() {
     // sure that no other toggle event will target this (soon dead) wrapper.
     bool had_toggle_up;
     bool had_toggle_down;
-    std::tie(had_toggle_down, had_toggle_up) =
-        ToggleQueue::get_default()->cancel(this);
+    std::tie(had_toggle_down, had_toggle_up) = toggle_queue()->cancel(this);
 
     /* GObject is not already freed */
     if (m_ptr) {
@@ -2964,7 +2996,7 @@ ObjectInstance::~ObjectInstance() {
         if (was_using_toggle_refs) {
             // We need to cancel again, to be sure that no other thread added
             // another toggle reference before we were removing the last one.
-            ToggleQueue::get_default()->cancel(this);
+            toggle_queue()->cancel(this);
         }
     }
 
@@ -3514,6 +3546,186 @@ bool ObjectInstance::signals_action_impl(JSContext* cx,
     return true;
 }
 
+/*
+ * ObjectBase::set_properties:
+ *
+ * setProperties() in JS. Sets all the GObject properties given as keys of a
+ * plain JS object in one g_object_setv() call. Property notifications are
+ * frozen for the duration, so each changed property is notified only once,
+ * after all of them have been set.
+ */
+bool ObjectBase::set_properties(JSContext* cx, unsigned argc, JS::Value* vp) {
+    GJS_CHECK_WRAPPER_PRIV(cx, argc, vp, args, obj, ObjectBase, priv);
+    if (!priv->check_is_instance(cx, "set properties"))
+        return false;
+
+    std::string full_name{GJS_PROFILER_DYNAMIC_STRING(
+        cx, priv->format_name() + ".setProperties")};
+    AutoProfilerLabel label{cx, "", full_name};
+
+    return priv->to_instance()->set_properties_impl(cx, args, obj);
+}
+
+bool ObjectInstance::set_properties_impl(JSContext* cx,
+                                         const JS::CallArgs& args,
+                                         JS::HandleObject obj) {
+    JS::RootedObject props(cx);
+    if (!gjs_parse_call_args(cx, "setProperties", args, "o", "properties",
+                             &props))
+        return false;
+
+    args.rval().setUndefined();
+
+    if (!check_gobject_finalized("set any property on"))
+        return true;
+
+    Gjs::AutoTypeClass<GObjectClass> object_class{gtype()};
+    std::vector<const char*> names;
+    AutoGValueVector values;
+    if (!m_proto->props_to_g_parameters(cx, object_class, obj, props, &names,
+                                        &values))
+        return false;
+
+    if (names.empty())
+        return true;
+
+    gjs_debug_jsprop(GJS_DEBUG_GOBJECT, "Setting %zu GObject props at once",
+                     names.size());
+
+    g_assert(names.size() == values.size());
+    g_object_freeze_notify(m_ptr);
+    g_object_setv(m_ptr, names.size(), names.data(), values.data());
+    g_object_thaw_notify(m_ptr);
+
+    return true;
+}
+
+/*
+ * ObjectBase::get_properties:
+ *
+ * getProperties() in JS. Takes an array of GObject property names, fetches all
+ * of them in one g_object_getv() call, and returns a plain JS object with the
+ * values keyed by the names as they were passed in. Write-only properties come
+ * back as undefined, as they do when accessed one by one.
+ */
+bool ObjectBase::get_properties(JSContext* cx, unsigned argc, JS::Value* vp) {
+    GJS_CHECK_WRAPPER_PRIV(cx, argc, vp, args, obj, ObjectBase, priv);
+    if (!priv->check_is_instance(cx, "get properties"))
+        return false;
+
+    std::string full_name{GJS_PROFILER_DYNAMIC_STRING(
+        cx, priv->format_name() + ".getProperties")};
+    AutoProfilerLabel label{cx, "", full_name};
+
+    return priv->to_instance()->get_properties_impl(cx, args, obj);
+}
+
+bool ObjectInstance::get_properties_impl(JSContext* cx,
+                                         const JS::CallArgs& args,
+                                         JS::HandleObject obj) {
+    JS::RootedObject names_array(cx);
+    if (!gjs_parse_call_args(cx, "getProperties", args, "o", "names",
+                             &names_array))
+        return false;
+
+    bool is_array;
+    if (!JS::IsArrayObject(cx, names_array, &is_array))
+        return false;
+    if (!is_array) {
+        gjs_throw(cx, "Argument to getProperties() should be an array of "
+                  "property names");
+        return false;
+    }
+
+    uint32_t length;
+    if (!JS::GetArrayLength(cx, names_array, &length))
+        return false;
+
+    JS::RootedObject result(cx, JS_NewPlainObject(cx));
+    if (!result)
+        return false;
+
+    if (!check_gobject_finalized("get any property from")) {
+        args.rval().setObject(*result);
+        return true;
+    }
+
+    // Resolve all the param specs up front, so that a bad name throws before
+    // anything is fetched
+    Gjs::AutoTypeClass<GObjectClass> object_class{gtype()};
+    JS::RootedIdVector ids(cx);
+    std::vector<GParamSpec*> pspecs;
+    std::vector<const char*> names;
+    AutoGValueVector values;
+    if (!ids.reserve(length)) {
+        JS_ReportOutOfMemory(cx);
+        return false;
+    }
+    pspecs.reserve(length);
+    names.reserve(length);
+    values.reserve(length);
+
+    JS::RootedValue elem(cx);
+    JS::RootedString js_prop_name(cx);
+    JS::RootedId prop_id(cx);
+    for (uint32_t ix = 0; ix < length; ix++) {
+        if (!JS_GetElement(cx, names_array, ix, &elem))
+            return false;
+        if (!elem.isString()) {
+            gjs_throw(cx, "Property names passed to getProperties() must be "
+                      "strings, got %s", gjs_debug_value(elem).c_str());
+            return false;
+        }
+
+        js_prop_name = elem.toString();
+        if (!JS_StringToId(cx, js_prop_name, &prop_id))
+            return false;
+        GParamSpec* pspec = m_proto->find_param_spec_from_accessor(
+            cx, object_class, obj, prop_id);
+        if (!pspec)
+            return false;
+
+        ids.infallibleAppend(prop_id);
+        pspecs.push_back(pspec);
+        if (!(pspec->flags & G_PARAM_READABLE))
+            continue;
+
+        names.push_back(pspec->name);  // owned by GParamSpec
+        values.emplace_back(G_PARAM_SPEC_VALUE_TYPE(pspec));
+    }
+
+    gjs_debug_jsprop(GJS_DEBUG_GOBJECT, "Getting %zu GObject props at once",
+                     names.size());
+
+    g_assert(names.size() == values.size());
+    if (!names.empty())
+        g_object_getv(m_ptr, names.size(), names.data(), values.data());
+
+    JS::RootedValue value(cx);
+    size_t value_ix = 0;
+    for (size_t ix = 0; ix < pspecs.size(); ix++) {
+        GParamSpec* pspec = pspecs[ix];
+        if (!(pspec->flags & G_PARAM_READABLE)) {
+            value.setUndefined();
+        } else {
+            if (pspec->flags & G_PARAM_DEPRECATED) {
+                _gjs_warn_deprecated_once_per_callsite(
+                    cx, DeprecatedGObjectProperty,
+                    {format_name(), pspec->name});
+            }
+            if (!gjs_value_from_g_value(cx, &value, &values[value_ix++]))
+                return false;
+        }
+
+        if (!JS_DefinePropertyById(cx, result, ids[ix], value,
+                                   JSPROP_ENUMERATE))
+            return false;
+    }
+
+    args.rval().setObject(*result);
+    return true;
+}
+
 bool ObjectBase::to_string(JSContext* cx, unsigned argc, JS::Value* vp) {
     GJS_CHECK_WRAPPER_PRIV(cx, argc, vp, args, obj, ObjectBase, priv);
     const char* kind = ObjectBase::DEBUG_TAG;
@@ -3584,6 +3796,8 @@ JSFunctionSpec ObjectBase::proto_methods[] = {
     JS_FN("connect_after", &ObjectBase::connect_after, 0, 0),
     JS_FN("connect_object", &ObjectBase::connect_object, 0, 0),
     JS_FN("emit", &ObjectBase::emit, 0, 0),
+    JS_FN("setProperties", &ObjectBase::set_properties, 1, 0),
+    JS_FN("getProperties", &ObjectBase::get_properties, 1, 0),
     JS_FS_END
 };
 
@@ -3764,6 +3978,7 @@ ObjectInstance* ObjectInstance::new_for_gobject(JSContext* cx, GObject* gobj) {
     ObjectInstance* priv = new ObjectInstance(prototype, obj);
 
     ObjectBase::init_private(obj, priv);
+    Gjs::WrapperStats::sample_creation_site(cx, prototype->stats());
 
     g_object_ref_sink(gobj);
     priv->associate_js_gobject(cx, obj, gobj);
@@ -3790,6 +4005,14 @@ JSObject* ObjectInstance::wrapper_from_gobject(JSContext* cx, GObject* gobj) {
         priv = new_for_gobject(cx, gobj);
         if (!priv)
             return nullptr;
+    } else if (G_UNLIKELY(!priv->is_owned_by_current_thread())) {
+        // A GObject can only have one wrapper, and JS objects cannot be shared
+        // between the contexts of different threads
+        gjs_throw(cx,
+                  "Object %p (a %s) is already wrapped by a GJS context on "
+                  "another thread",
+                  gobj, g_type_name(G_TYPE_FROM_INSTANCE(gobj)));
+        return nullptr;
     }
 
     return priv->wrapper();
@@ -20,16 +20,15 @@
 
 #include <js/AllocPolicy.h>
 #include <js/GCHashTable.h>  // for GCHashMap
-#include <js/HashTable.h>    // for DefaultHasher
 #include <js/Id.h>
 #include <js/PropertySpec.h>
 #include <js/RootingAPI.h>
 #include <js/TypeDecls.h>
-#include <mozilla/HashFunctions.h>  // for HashGeneric, HashNumber
-#include <mozilla/Likely.h>         // for MOZ_LIKELY
 #include <mozilla/Maybe.h>
 
 #include "gi/info.h"
+#include "gi/member-index.h"  // for IdHasher
+#include "gi/toggle.h"
 #include "gi/value.h"
 #include "gi/wrapperutils.h"
 #include "gjs/auto.h"
@@ -182,6 +181,10 @@ class ObjectBase
                                                            unsigned argc,
                                                            JS::Value* vp);
     GJS_JSAPI_RETURN_CONVENTION
+    static bool set_properties(JSContext* cx, unsigned argc, JS::Value* vp);
+    GJS_JSAPI_RETURN_CONVENTION
+    static bool get_properties(JSContext* cx, unsigned argc, JS::Value* vp);
+    GJS_JSAPI_RETURN_CONVENTION
     static bool to_string(JSContext* cx, unsigned argc, JS::Value* vp);
     GJS_JSAPI_RETURN_CONVENTION
     static bool init_gobject(JSContext* cx, unsigned argc, JS::Value* vp);
@@ -199,19 +202,6 @@ class ObjectBase
     [[nodiscard]] static GQuark disposed_quark();
 };
 
-// See https://bugzilla.mozilla.org/show_bug.cgi?id=1614220
-struct IdHasher {
-    typedef jsid Lookup;
-    static mozilla::HashNumber hash(jsid id) {
-        if (MOZ_LIKELY(id.isString()))
-            return js::DefaultHasher<JSString*>::hash(id.toString());
-        if (id.isSymbol())
-            return js::DefaultHasher<JS::Symbol*>::hash(id.toSymbol());
-        return mozilla::HashGeneric(id.asRawBits());
-    }
-    static bool match(jsid id1, jsid id2) { return id1 == id2; }
-};
-
 class ObjectPrototype
     : public GIWrapperPrototype<ObjectBase, ObjectPrototype, ObjectInstance> {
     friend class GIWrapperPrototype<ObjectBase, ObjectPrototype,
@@ -220,13 +210,22 @@ class ObjectPrototype
 
     using NegativeLookupCache =
         JS::GCHashSet<JS::Heap<jsid>, IdHasher, js::SystemAllocPolicy>;
+    using ParamSpecCache = JS::GCHashMap<JS::Heap<jsid>, GParamSpec*, IdHasher,
+                                         js::SystemAllocPolicy>;
 
     NegativeLookupCache m_unresolvable_cache;
+    // The param specs of the GObject property accessors defined on this
+    // prototype, recorded when they are defined, so that setting properties in
+    // a batch doesn't look them up by name again
+    ParamSpecCache m_param_spec_cache;
     // a list of vfunc GClosures installed on this prototype, used when tracing
     std::unordered_set<GClosure*> m_vfuncs;
     // a list of interface types explicitly associated with this prototype,
     // by gjs_add_interface
     std::vector<GType> m_interface_gtypes;
+    // the toggle queue of the thread whose context owns this prototype and
+    // its instances
+    ToggleQueue* m_toggle_queue;
 
     ObjectPrototype(GIObjectInfo* info, GType gtype);
     ~ObjectPrototype();
@@ -236,6 +235,8 @@ class ObjectPrototype
  public:
     [[nodiscard]] static ObjectPrototype* for_gtype(GType gtype);
 
+    [[nodiscard]] ToggleQueue* toggle_queue() const { return m_toggle_queue; }
+
     /* Helper methods */
  private:
     GJS_JSAPI_RETURN_CONVENTION
@@ -270,9 +271,13 @@ class ObjectPrototype
                                         Gjs::AutoTypeClass<GObjectClass> const&,
                                         JS::HandleString key);
     GJS_JSAPI_RETURN_CONVENTION
+    GParamSpec* find_param_spec_from_accessor(
+        JSContext*, Gjs::AutoTypeClass<GObjectClass> const&,
+        JS::HandleObject obj, JS::HandleId id);
+    GJS_JSAPI_RETURN_CONVENTION
     bool props_to_g_parameters(JSContext*,
                                Gjs::AutoTypeClass<GObjectClass> const&,
-                               JS::HandleObject props,
+                               JS::HandleObject obj, JS::HandleObject props,
                                std::vector<const char*>* names,
                                AutoGValueVector* values);
 
@@ -335,7 +340,7 @@ class ObjectInstance : public GIWrapperInstance<ObjectBase, ObjectPrototype,
      * hard ref on the underlying GObject, and may be finalized at will. */
     bool m_uses_toggle_ref : 1;
 
-    static bool s_weak_pointer_callback;
+    static thread_local bool s_weak_pointer_callback;
 
     /* Constructors */
 
@@ -355,10 +360,35 @@ class ObjectInstance : public GIWrapperInstance<ObjectBase, ObjectPrototype,
 
  private:
     [[nodiscard]] bool has_wrapper() const { return !!m_wrapper; }
+    // Toggle notifications may come from any thread, so they always go to the
+    // queue of the thread that owns the wrapper
+    [[nodiscard]] ToggleQueue::Locked toggle_queue() const {
+        return ToggleQueue::Locked{get_prototype()->toggle_queue()};
+    }
+    [[nodiscard]] bool is_owned_by_current_thread() const {
+        return get_prototype()->toggle_queue() ==
+               ToggleQueue::get_default_unlocked();
+    }
 
  public:
     [[nodiscard]] JSObject* wrapper() const { return m_wrapper.get(); }
 
+    // The GObject may be finalized while its wrapper is still alive, in which
+    // case ptr() is dangling
+    [[nodiscard]] bool is_finalized() const { return m_gobj_finalized; }
+
+    // How the wrapper and the GObject keep each other alive, for heap
+    // snapshots
+    [[nodiscard]] const char* toggle_ref_state() const {
+        if (m_gobj_finalized)
+            return "finalized";
+        if (m_gobj_disposed)
+            return "disposed";
+        if (!m_uses_toggle_ref)
+            return "no toggle ref";
+        return wrapper_is_rooted() ? "toggled up" : "toggled down";
+    }
+
     /* Methods to manipulate the JS object wrapper */
 
  private:
@@ -431,7 +461,9 @@ class ObjectInstance : public GIWrapperInstance<ObjectBase, ObjectPrototype,
     /* Methods to manipulate the linked list of instances */
 
  private:
-    static std::unordered_set<ObjectInstance*> s_wrapped_gobject_list;
+    // Each thread running a GjsContext has its own list
+    static thread_local std::unordered_set<ObjectInstance*>
+        s_wrapped_gobject_list;
     void link(void);
     void unlink(void);
     [[nodiscard]] static size_t num_wrapped_gobjects() {
@@ -501,6 +533,12 @@ class ObjectInstance : public GIWrapperInstance<ObjectBase, ObjectPrototype,
     GJS_JSAPI_RETURN_CONVENTION bool signals_action_impl(
         JSContext* cx, const JS::CallArgs& args);
     GJS_JSAPI_RETURN_CONVENTION
+    bool set_properties_impl(JSContext* cx, const JS::CallArgs& args,
+                             JS::HandleObject obj);
+    GJS_JSAPI_RETURN_CONVENTION
+    bool get_properties_impl(JSContext* cx, const JS::CallArgs& args,
+                             JS::HandleObject obj);
+    GJS_JSAPI_RETURN_CONVENTION
     bool init_impl(JSContext* cx, const JS::CallArgs& args,
                    JS::HandleObject obj);
     [[nodiscard]] const char* to_string_kind() const;
@@ -23,6 +23,7 @@
 #include <jsapi.h>  // for JS_NewPlainObject
 
 #include "gi/closure.h"
+#include "gi/function.h"
 #include "gi/gobject.h"
 #include "gi/gtype.h"
 #include "gi/interface.h"
@@ -549,6 +550,24 @@ static bool gjs_lookup_constructor(JSContext* cx, unsigned argc,
     return gjs_lookup_object_constructor(cx, gtype, args.rval());
 }
 
+GJS_JSAPI_RETURN_CONVENTION
+static bool gjs_set_finish_function(JSContext* cx, unsigned argc,
+                                    JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    JS::RootedObject function(cx), finish(cx);
+    if (!gjs_parse_call_args(cx, "setFinishFunction", args, "oo", "function",
+                             &function, "finish", &finish))
+        return false;
+
+    bool found;
+    if (!gjs_function_set_finish_function(cx, function, finish, &found))
+        return false;
+
+    args.rval().setBoolean(found);
+    return true;
+}
+
 template <GjsSymbolAtom GjsAtoms::*member>
 GJS_JSAPI_RETURN_CONVENTION static bool symbol_getter(JSContext* cx,
                                                       unsigned argc,
@@ -602,6 +621,8 @@ static JSFunctionSpec private_module_funcs[] = {
     JS_FN("signal_new", gjs_signal_new, 6, GJS_MODULE_PROP_FLAGS),
     JS_FN("lookupConstructor", gjs_lookup_constructor, 1, 0),
     JS_FN("associateClosure", gjs_associate_closure, 2, GJS_MODULE_PROP_FLAGS),
+    JS_FN("setFinishFunction", gjs_set_finish_function, 2,
+          GJS_MODULE_PROP_FLAGS),
     JS_FS_END,
 };
 
@@ -0,0 +1,234 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#include <config.h>
+
+#include <stdint.h>
+
+#include <glib-object.h>
+#include <glib.h>
+
+#include <js/CallAndConstruct.h>  // for IsCallable
+#include <js/CallArgs.h>
+#include <js/Conversions.h>  // for ToBoolean
+#include <js/ErrorReport.h>  // for JSEXN_TYPEERR
+#include <js/Exception.h>
+#include <js/HeapAPI.h>  // for RuntimeHeapIsCollecting
+#include <js/PropertyAndElement.h>  // for JS_DefineFunctions
+#include <js/PropertySpec.h>
+#include <js/RootingAPI.h>
+#include <js/TypeDecls.h>
+#include <js/Value.h>
+#include <js/ValueArray.h>
+#include <jsapi.h>  // for JS_NewPlainObject
+
+#include "gi/boxed.h"
+#include "gi/closure.h"
+#include "gi/source.h"
+#include "gjs/context-private.h"
+#include "gjs/jsapi-util-args.h"
+#include "gjs/jsapi-util.h"
+#include "gjs/macros.h"
+#include "gjs/profiler-private.h"
+#include "util/log.h"
+
+// GLib.idle_add() and friends are the most common way of scheduling work from
+// JS. Going through the introspected functions would create a libffi closure
+// for each callback, and marshal every dispatch through it. Instead, the JS
+// function is kept rooted in a Gjs::Closure, which is passed as the user data
+// of a plain GSourceFunc. The GSource owns a reference to the closure, and
+// drops it when the source is destroyed.
+
+static gboolean source_func(void* data) {
+    Gjs::AutoSourceDispatchMark mark;
+    auto* closure = static_cast<Gjs::Closure*>(data);
+
+    // Same checks as GjsCallbackTrampoline::callback_closure()
+    if (G_UNLIKELY(!closure->is_valid())) {
+        g_critical(
+            "Attempting to run a JS source callback during shutdown. Because "
+            "it would crash the application, it has been blocked.");
+        return G_SOURCE_REMOVE;
+    }
+
+    if (G_UNLIKELY(JS::RuntimeHeapIsCollecting())) {
+        g_critical(
+            "Attempting to run a JS source callback during garbage "
+            "collection. Because it would crash the application, it has been "
+            "blocked.");
+        return G_SOURCE_REMOVE;
+    }
+
+    JSContext* cx = closure->context();
+    GjsContextPrivate* gjs = GjsContextPrivate::from_cx(cx);
+    if (G_UNLIKELY(!gjs->is_owner_thread())) {
+        g_critical(
+            "Attempting to run a JS source callback on a different thread. "
+            "This is most likely caused by attaching the source to a "
+            "GMainContext that is iterated on another thread. Because it "
+            "would crash the application, it has been blocked.");
+        return G_SOURCE_REMOVE;
+    }
+
+    JS::RootedValue rval{cx};
+    if (!closure->invoke(nullptr, JS::HandleValueArray::empty(), &rval)) {
+        if (!gjs_log_exception_uncaught(cx)) {
+            // "Uncatchable" exception thrown, we have to exit. This matches
+            // the closure exit handling in function.cpp
+            uint8_t code;
+            if (gjs->should_exit(&code))
+                gjs->exit_immediately(code);
+
+            // Some other uncatchable exception, e.g. out of memory
+            g_error("Source callback %s terminated with uncatchable exception",
+                    gjs_debug_callable(closure->callable()).c_str());
+        }
+
+        // Same as the neutral return value of a failed callback trampoline
+        return G_SOURCE_REMOVE;
+    }
+
+    return JS::ToBoolean(rval);
+}
+
+static void source_func_destroy(void* data) {
+    g_closure_unref(static_cast<Gjs::Closure*>(data));
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static Gjs::Closure* closure_for_callback(JSContext* cx, const char* func_name,
+                                          JS::HandleObject callback) {
+    if (!JS::IsCallable(callback)) {
+        gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr,
+                         "%s: the callback must be a function", func_name);
+        return nullptr;
+    }
+
+    // The reference is owned by the GSource, and released in
+    // source_func_destroy()
+    auto* closure = Gjs::Closure::create(cx, callback, func_name, true);
+    g_closure_ref(closure);
+    g_closure_sink(closure);
+    return closure;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool idle_add(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    int32_t priority;
+    JS::RootedObject callback{cx};
+    if (!gjs_parse_call_args(cx, "idle_add", args, "io", "priority", &priority,
+                             "function", &callback)) {
+        return false;
+    }
+
+    Gjs::Closure* closure = closure_for_callback(cx, "idle_add", callback);
+    if (!closure)
+        return false;
+
+    args.rval().setNumber(g_idle_add_full(priority, source_func, closure,
+                                          source_func_destroy));
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool timeout_add(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    int32_t priority;
+    uint32_t interval;
+    JS::RootedObject callback{cx};
+    if (!gjs_parse_call_args(cx, "timeout_add", args, "iuo", "priority",
+                             &priority, "interval", &interval, "function",
+                             &callback)) {
+        return false;
+    }
+
+    Gjs::Closure* closure = closure_for_callback(cx, "timeout_add", callback);
+    if (!closure)
+        return false;
+
+    args.rval().setNumber(g_timeout_add_full(priority, interval, source_func,
+                                             closure, source_func_destroy));
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool timeout_add_seconds(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    int32_t priority;
+    uint32_t interval;
+    JS::RootedObject callback{cx};
+    if (!gjs_parse_call_args(cx, "timeout_add_seconds", args, "iuo",
+                             "priority", &priority, "interval", &interval,
+                             "function", &callback)) {
+        return false;
+    }
+
+    Gjs::Closure* closure =
+        closure_for_callback(cx, "timeout_add_seconds", callback);
+    if (!closure)
+        return false;
+
+    args.rval().setNumber(g_timeout_add_seconds_full(
+        priority, interval, source_func, closure, source_func_destroy));
+    return true;
+}
+
+// Other kinds of sources, such as pollable stream, IO channel, child watch and
+// unix fd sources, call their callback with a different signature than
+// GSourceFunc, so they need the introspected set_callback()
+[[nodiscard]] static bool calls_source_func(GSource* source) {
+    return source->source_funcs == &g_idle_funcs ||
+           source->source_funcs == &g_timeout_funcs;
+}
+
+// Returns false in args.rval() if @source is not an idle or timeout source,
+// in which case the callback is not set
+GJS_JSAPI_RETURN_CONVENTION
+static bool set_callback(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    JS::RootedObject source_obj{cx}, callback{cx};
+    if (!gjs_parse_call_args(cx, "set_callback", args, "oo", "source",
+                             &source_obj, "func", &callback)) {
+        return false;
+    }
+
+    if (!BoxedBase::typecheck(cx, source_obj, G_TYPE_SOURCE))
+        return false;
+    auto* source = BoxedBase::to_c_ptr<GSource>(cx, source_obj);
+    if (!source)
+        return false;
+
+    if (!calls_source_func(source)) {
+        args.rval().setBoolean(false);
+        return true;
+    }
+
+    Gjs::Closure* closure = closure_for_callback(cx, "set_callback", callback);
+    if (!closure)
+        return false;
+
+    g_source_set_callback(source, source_func, closure, source_func_destroy);
+
+    args.rval().setBoolean(true);
+    return true;
+}
+
+static JSFunctionSpec gjs_source_module_funcs[] = {
+    JS_FN("idleAdd", idle_add, 2, 0),
+    JS_FN("timeoutAdd", timeout_add, 3, 0),
+    JS_FN("timeoutAddSeconds", timeout_add_seconds, 3, 0),
+    JS_FN("setCallback", set_callback, 2, 0),
+    JS_FS_END};
+
+bool gjs_define_source_stuff(JSContext* cx, JS::MutableHandleObject module) {
+    module.set(JS_NewPlainObject(cx));
+    if (!module)
+        return false;
+    return JS_DefineFunctions(cx, module, gjs_source_module_funcs);
+}
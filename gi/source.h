@@ -0,0 +1,21 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#ifndef GI_SOURCE_H_
+#define GI_SOURCE_H_
+
+#include <config.h>
+
+#include <js/TypeDecls.h>
+
+#include "gjs/macros.h"
+
+// Native replacements for GLib.idle_add(), GLib.timeout_add(),
+// GLib.timeout_add_seconds() and GLib.Source.prototype.set_callback(), used by
+// the GLib overrides as imports._sourceNative
+
+GJS_JSAPI_RETURN_CONVENTION
+bool gjs_define_source_stuff(JSContext* cx, JS::MutableHandleObject module);
+
+#endif  // GI_SOURCE_H_
@@ -13,8 +13,13 @@
 #include <deque>
 #include <utility>  // for pair
 
+#include <glib.h>
+
 #include "gi/object.h"
 #include "gi/toggle.h"
+#include "gjs/auto.h"
+#include "gjs/mem-private.h"
+#include "gjs/profiler-private.h"
 #include "util/log.h"
 
 /* No-op unless GJS_VERBOSE_ENABLE_LIFECYCLE is defined to 1. */
@@ -25,6 +30,18 @@ inline void debug(const char* did GJS_USED_VERBOSE_LIFECYCLE,
                         object ? object->ptr() : nullptr);
 }
 
+ToggleQueue::ToggleQueue()
+    : m_main_context(g_main_context_ref_thread_default()) {}
+
+ToggleQueue::~ToggleQueue() {
+    if (m_idle_id) {
+        GSource* source =
+            g_main_context_find_source_by_id(m_main_context, m_idle_id);
+        if (source)
+            g_source_destroy(source);
+    }
+}
+
 void ToggleQueue::lock() {
     auto holding_thread = std::thread::id();
     auto current_thread = std::this_thread::get_id();
@@ -73,6 +90,7 @@ void ToggleQueue::handle_all_toggles(Handler handler) {
 gboolean
 ToggleQueue::idle_handle_toggle(void *data)
 {
+    Gjs::AutoSourceDispatchMark mark;
     auto self = Locked(static_cast<ToggleQueue*>(data));
     self->handle_all_toggles(self->m_toggle_handler);
 
@@ -105,6 +123,7 @@ std::pair<bool, bool> ToggleQueue::cancel(ObjectInstance* obj) {
             had_toggle_down |= (it->direction == Direction::DOWN);
             had_toggle_up |= (it->direction == Direction::UP);
             it = q.erase(it);
+            GJS_ADD_STAT(toggle_queue_length, -1);
             continue;
         }
         it++;
@@ -134,6 +153,7 @@ bool ToggleQueue::handle_toggle(Handler handler) {
 
     handler(item.object, item.direction);
     q.pop_front();
+    GJS_ADD_STAT(toggle_queue_length, -1);
 
     return true;
 }
@@ -169,6 +189,7 @@ void ToggleQueue::enqueue(ObjectInstance* obj, ToggleQueue::Direction direction,
             debug("enqueue DOWN, dequeuing already UP object", obj);
         }
         q.erase(other_item);
+        GJS_ADD_STAT(toggle_queue_length, -1);
         return;
     }
 
@@ -181,6 +202,7 @@ void ToggleQueue::enqueue(ObjectInstance* obj, ToggleQueue::Direction direction,
      * finalized earlier than we've processed it.
      */
     q.emplace_back(obj, direction);
+    GJS_ADD_STAT(toggle_queue_length, 1);
 
     if (direction == UP) {
         debug("enqueue UP", obj);
@@ -195,6 +217,18 @@ void ToggleQueue::enqueue(ObjectInstance* obj, ToggleQueue::Direction direction,
     }
 
     m_toggle_handler = handler;
-    m_idle_id = g_idle_add_full(G_PRIORITY_HIGH, idle_handle_toggle, this,
-                                idle_destroy_notify);
+
+    // The toggle may have been queued from another thread, so the idle source
+    // must be explicitly attached to the main context of the owner thread
+    Gjs::AutoPointer<GSource, GSource, g_source_unref> source{
+        g_idle_source_new()};
+    g_source_set_priority(source, G_PRIORITY_HIGH);
+    g_source_set_callback(source, idle_handle_toggle, this,
+                          idle_destroy_notify);
+#if GLIB_CHECK_VERSION(2, 70, 0)
+    g_source_set_static_name(source, "GjsToggleQueueSource");
+#else
+    g_source_set_name(source, "GjsToggleQueueSource");
+#endif
+    m_idle_id = g_source_attach(source, m_main_context);
 }
@@ -18,6 +18,8 @@
 
 #include <glib.h>  // for gboolean
 
+#include "gjs/auto.h"
+
 class ObjectInstance;
 namespace Gjs {
 namespace Test {
@@ -27,7 +29,10 @@ struct ToggleQueue;
 
 /* Thread-safe queue for enqueueing toggle-up or toggle-down events on GObjects
  * from any thread. For more information, see object.cpp, comments near
- * wrapped_gobj_toggle_notify(). */
+ * wrapped_gobj_toggle_notify().
+ * Each thread running a GjsContext has its own queue, whose toggles are handled
+ * in the main context that was the thread-default one when the queue was
+ * created. */
 class ToggleQueue {
 public:
     enum Direction {
@@ -46,15 +51,11 @@ public:
         ToggleQueue::Direction direction;
     };
 
-    struct Locked {
-        explicit Locked(ToggleQueue* queue) { queue->lock(); }
-        ~Locked() { get_default_unlocked().maybe_unlock(); }
-        ToggleQueue* operator->() { return &get_default_unlocked(); }
-    };
-
     std::deque<Item> q;
     std::atomic_bool m_shutdown = ATOMIC_VAR_INIT(false);
 
+    Gjs::AutoPointer<GMainContext, GMainContext, g_main_context_unref>
+        m_main_context;
     unsigned m_idle_id = 0;
     Handler m_toggle_handler = nullptr;
     std::atomic<std::thread::id> m_holder = std::thread::id();
@@ -78,12 +79,28 @@ public:
     static gboolean idle_handle_toggle(void *data);
     static void idle_destroy_notify(void *data);
 
-    [[nodiscard]] static ToggleQueue& get_default_unlocked() {
-        static ToggleQueue the_singleton;
-        return the_singleton;
-    }
+    ToggleQueue();
+    ~ToggleQueue();
 
  public:
+    struct Locked {
+        explicit Locked(ToggleQueue* queue) : m_queue(queue) { queue->lock(); }
+        ~Locked() { m_queue->maybe_unlock(); }
+        ToggleQueue* operator->() { return m_queue; }
+
+     private:
+        ToggleQueue* m_queue;
+    };
+
+    /* Returns the queue of the calling thread, without locking it. Only use
+     * this to keep a pointer to the queue; toggle notifications can come from
+     * other threads, so they must be sent to the queue of the thread that owns
+     * the wrapper. */
+    [[nodiscard]] static ToggleQueue* get_default_unlocked() {
+        static thread_local ToggleQueue the_singleton;
+        return &the_singleton;
+    }
+
     /* These two functions return a pair DOWN, UP signifying whether toggles
      * are / were queued. is_queued() just checks and does not modify. */
     [[nodiscard]] std::pair<bool, bool> is_queued(ObjectInstance* obj) const;
@@ -105,7 +122,7 @@ public:
     void enqueue(ObjectInstance* obj, Direction direction, Handler handler);
 
     [[nodiscard]] static Locked get_default() {
-        return Locked(&get_default_unlocked());
+        return Locked(get_default_unlocked());
     }
 };
 
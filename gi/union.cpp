@@ -10,12 +10,13 @@
 #include <js/Class.h>
 #include <js/RootingAPI.h>
 #include <js/TypeDecls.h>
-#include <js/Utility.h>  // for UniqueChars
 #include <js/Warnings.h>
+#include <mozilla/Maybe.h>
 
 #include "gi/arg-inl.h"
 #include "gi/function.h"
 #include "gi/info.h"
+#include "gi/member-index.h"
 #include "gi/repo.h"
 #include "gi/union.h"
 #include "gjs/jsapi-util.h"
@@ -46,39 +47,29 @@ UnionInstance::~UnionInstance(void) {
 // See GIWrapperBase::resolve().
 bool UnionPrototype::resolve_impl(JSContext* context, JS::HandleObject obj,
                                   JS::HandleId id, bool* resolved) {
-    JS::UniqueChars prop_name;
-    if (!gjs_get_string_id(context, id, &prop_name))
+    if (!ensure_member_index(context))
         return false;
-    if (!prop_name) {
-        *resolved = false;
-        return true;  // not resolved, but no error
-    }
 
     // Look for methods and other class properties
-    GI::AutoFunctionInfo method_info{
-        g_union_info_find_method(info(), prop_name.get())};
+    mozilla::Maybe<Gjs::MemberIndex::Entry> entry =
+        m_member_index->lookup(id);
+    if (!entry || entry->kind != Gjs::MemberIndex::Kind::METHOD) {
+        *resolved = false;
+        return true;
+    }
 
-    if (method_info) {
+    GI::AutoFunctionInfo method_info{m_member_index->function_info(*entry)};
 #if GJS_VERBOSE_ENABLE_GI_USAGE
-        _gjs_log_info_usage(method_info);
+    _gjs_log_info_usage(method_info);
 #endif
-        if (g_function_info_get_flags (method_info) & GI_FUNCTION_IS_METHOD) {
-            gjs_debug(GJS_DEBUG_GBOXED,
-                      "Defining method %s in prototype for %s",
-                      method_info.name(), format_name().c_str());
-
-            /* obj is union proto */
-            if (!gjs_define_function(context, obj, gtype(), method_info))
-                return false;
-
-            *resolved = true; /* we defined the prop in object_proto */
-        } else {
-            *resolved = false;
-        }
-    } else {
-        *resolved = false;
-    }
+    gjs_debug(GJS_DEBUG_GBOXED, "Defining method %s in prototype for %s",
+              method_info.name(), format_name().c_str());
+
+    /* obj is union proto */
+    if (!gjs_define_function(context, obj, gtype(), method_info))
+        return false;
 
+    *resolved = true; /* we defined the prop in object_proto */
     return true;
 }
 
@@ -145,6 +136,9 @@ const struct JSClassOps UnionBase::class_ops = {
     &UnionBase::resolve,
     nullptr,  // mayResolve
     &UnionBase::finalize,
+    nullptr,  // call
+    nullptr,  // construct
+    &UnionBase::trace
 };
 
 const struct JSClass UnionBase::klass = {
@@ -51,7 +51,9 @@
 #include "gjs/context-private.h"
 #include "gjs/jsapi-util.h"
 #include "gjs/macros.h"
+#include "gjs/mem-private.h"
 #include "gjs/objectbox.h"
+#include "gjs/profiler-private.h"
 #include "util/log.h"
 
 GJS_JSAPI_RETURN_CONVENTION
@@ -272,10 +274,33 @@ void Gjs::Closure::marshal(GValue* return_value, unsigned n_param_values,
 
     JSAutoRealm ar(context, callable());
 
+    Gjs::AutoSlowCallMark slow_call_mark{
+        context, marshal_data ? "Slow signal handler" : "Slow closure",
+        [this, &signal_query, n_param_values, param_values]() {
+            // The handler may have disconnected itself
+            std::string description{is_valid()
+                                        ? gjs_debug_callable(callable())
+                                        : "disconnected function"};
+            if (!signal_query.signal_id)
+                return description;
+
+            description = std::string{signal_query.signal_name} + " (" +
+                          description + ")";
+            if (n_param_values > 0) {
+                auto* instance = static_cast<GTypeInstance*>(
+                    g_value_peek_pointer(&param_values[0]));
+                description += " on ";
+                description += g_type_name(G_TYPE_FROM_INSTANCE(instance));
+            }
+            return description;
+        }};
+
     if (marshal_data) {
         /* we are used for a signal handler */
         guint signal_id;
 
+        GJS_ADD_STAT(signal_emissions, 1);
+
         signal_id = GPOINTER_TO_UINT(marshal_data);
 
         g_signal_query(signal_id, &signal_query);
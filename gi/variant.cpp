@@ -0,0 +1,783 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#include <config.h>
+
+#include <stdint.h>
+
+#include <type_traits>  // for is_same_v
+#include <utility>      // for move
+#include <vector>
+
+#include <girepository.h>
+#include <glib-object.h>
+#include <glib.h>
+
+#include <js/Array.h>  // for GetArrayLength, NewArrayObject
+#include <js/CallArgs.h>
+#include <js/Conversions.h>  // for ToBoolean
+#include <js/ErrorReport.h>  // for JS_ReportOutOfMemory, JSEXN_TYPEERR
+#include <js/GCVector.h>     // for RootedVector
+#include <js/PropertyAndElement.h>
+#include <js/PropertySpec.h>
+#include <js/RootingAPI.h>
+#include <js/TypeDecls.h>
+#include <js/Utility.h>  // for UniqueChars
+#include <js/Value.h>
+#include <js/experimental/TypedData.h>
+#include <jsapi.h>  // for InformalValueTypeName, JS_NewPlainObject
+
+#include "gi/arg-inl.h"
+#include "gi/boxed.h"
+#include "gi/info.h"
+#include "gi/js-value-inl.h"
+#include "gi/variant.h"
+#include "gjs/auto.h"
+#include "gjs/byteArray.h"
+#include "gjs/jsapi-util-args.h"
+#include "gjs/jsapi-util.h"
+#include "gjs/macros.h"
+
+// Type strings inside a signature are not NUL-terminated, so they have to be
+// printed with "%.*s" and these two arguments
+#define TYPE_STRING_ARGS(type)                                \
+    static_cast<int>(g_variant_type_get_string_length(type)), \
+        g_variant_type_peek_string(type)
+
+GJS_JSAPI_RETURN_CONVENTION
+static Gjs::AutoGVariant pack(JSContext*, const GVariantType*,
+                              JS::HandleValue);
+
+static void throw_expected(JSContext* cx, const char* expected,
+                           const GVariantType* type, JS::HandleValue value) {
+    gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr,
+                     "Expected %s for GVariant type '%.*s', got type '%s'",
+                     expected, TYPE_STRING_ARGS(type),
+                     JS::InformalValueTypeName(value));
+}
+
+template <typename TAG>
+GJS_JSAPI_RETURN_CONVENTION static bool basic_from_js(
+    JSContext* cx, JS::HandleValue value, const GVariantType* type,
+    Gjs::Tag::RealT<TAG>* out) {
+    GIArgument arg;
+    bool out_of_range = false;
+    if (!gjs_arg_set_from_js_value<TAG>(cx, value, &arg, &out_of_range)) {
+        if (out_of_range) {
+            gjs_throw(cx, "Value is out of range for GVariant type '%.*s'",
+                      TYPE_STRING_ARGS(type));
+        }
+        return false;
+    }
+    *out = gjs_arg_get<TAG>(&arg);
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool string_from_js(JSContext* cx, JS::HandleValue value,
+                           const GVariantType* type, JS::UniqueChars* out) {
+    if (!value.isString()) {
+        throw_expected(cx, "a string", type, value);
+        return false;
+    }
+
+    JS::RootedString str{cx, value.toString()};
+    size_t len;
+    return gjs_string_to_utf8_n(cx, str, out, &len);
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool array_like_from_js(JSContext* cx, JS::HandleValue value,
+                               const GVariantType* type,
+                               JS::MutableHandleObject array_out,
+                               uint32_t* length_out) {
+    if (!value.isObject()) {
+        throw_expected(cx, "an array", type, value);
+        return false;
+    }
+
+    array_out.set(&value.toObject());
+    return JS::GetArrayLength(cx, array_out, length_out);
+}
+
+[[nodiscard]] static Gjs::AutoGVariant take_sunk(GVariant* variant) {
+    return g_variant_ref_sink(variant);
+}
+
+template <typename T, typename TAG = T>
+GJS_JSAPI_RETURN_CONVENTION static Gjs::AutoGVariant pack_fixed_array(
+    JSContext* cx, const GVariantType* array_type, JS::HandleObject array,
+    uint32_t length) {
+    const GVariantType* element_type = g_variant_type_element(array_type);
+    std::vector<T> elements(length);
+    JS::RootedValue elem{cx};
+
+    for (uint32_t ix = 0; ix < length; ix++) {
+        if (!JS_GetElement(cx, array, ix, &elem))
+            return nullptr;
+
+        if constexpr (std::is_same_v<TAG, bool>) {
+            elements[ix] = JS::ToBoolean(elem);
+        } else if (!basic_from_js<TAG>(cx, elem, element_type,
+                                       &elements[ix])) {
+            return nullptr;
+        }
+    }
+
+    return take_sunk(g_variant_new_fixed_array(element_type, elements.data(),
+                                               length, sizeof(T)));
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static Gjs::AutoGVariant pack_byte_array(JSContext* cx,
+                                         const GVariantType* array_type,
+                                         JS::HandleValue value) {
+    // Strings are encoded as UTF-8, with the terminating zero byte included
+    // so that the result can be read with g_variant_get_bytestring()
+    if (value.isString()) {
+        JS::RootedString str{cx, value.toString()};
+        JS::UniqueChars bytes;
+        size_t len;
+        if (!gjs_string_to_utf8_n(cx, str, &bytes, &len))
+            return nullptr;
+        return take_sunk(g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE,
+                                                   bytes.get(), len + 1, 1));
+    }
+
+    if (value.isObject() && JS_IsUint8Array(&value.toObject())) {
+        size_t len;
+        bool is_shared_memory;
+        uint8_t* data;
+        js::GetUint8ArrayLengthAndData(&value.toObject(), &len,
+                                       &is_shared_memory, &data);
+        return take_sunk(
+            g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, data, len, 1));
+    }
+
+    JS::RootedObject array{cx};
+    uint32_t length;
+    if (!array_like_from_js(cx, value, array_type, &array, &length))
+        return nullptr;
+    return pack_fixed_array<uint8_t>(cx, array_type, array, length);
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static Gjs::AutoGVariant pack_strv(JSContext* cx,
+                                   const GVariantType* array_type,
+                                   JS::HandleObject array, uint32_t length) {
+    const GVariantType* element_type = g_variant_type_element(array_type);
+    std::vector<JS::UniqueChars> strings(length);
+    std::vector<const char*> strv(length);
+    JS::RootedValue elem{cx};
+
+    for (uint32_t ix = 0; ix < length; ix++) {
+        if (!JS_GetElement(cx, array, ix, &elem) ||
+            !string_from_js(cx, elem, element_type, &strings[ix]))
+            return nullptr;
+        strv[ix] = strings[ix].get();
+    }
+
+    return take_sunk(g_variant_new_strv(strv.data(), length));
+}
+
+[[nodiscard]] static std::vector<GVariant*> borrow_all(
+    const std::vector<Gjs::AutoGVariant>& items) {
+    std::vector<GVariant*> children;
+    children.reserve(items.size());
+    for (const Gjs::AutoGVariant& item : items)
+        children.push_back(item.get());
+    return children;
+}
+
+[[nodiscard]] static Gjs::AutoGVariant new_array(
+    const GVariantType* element_type,
+    const std::vector<Gjs::AutoGVariant>& items) {
+    std::vector<GVariant*> children = borrow_all(items);
+    return take_sunk(
+        g_variant_new_array(element_type, children.data(), children.size()));
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static Gjs::AutoGVariant pack_dict(JSContext* cx,
+                                   const GVariantType* array_type,
+                                   JS::HandleValue value) {
+    if (!value.isObject()) {
+        throw_expected(cx, "an object", array_type, value);
+        return nullptr;
+    }
+
+    const GVariantType* entry_type = g_variant_type_element(array_type);
+    const GVariantType* key_type = g_variant_type_key(entry_type);
+    const GVariantType* value_type = g_variant_type_value(entry_type);
+
+    JS::RootedObject obj{cx, &value.toObject()};
+    JS::Rooted<JS::IdVector> ids{cx, cx};
+    if (!JS_Enumerate(cx, obj, &ids))
+        return nullptr;
+
+    std::vector<Gjs::AutoGVariant> entries;
+    entries.reserve(ids.length());
+    JS::RootedValue key{cx}, elem{cx};
+    for (size_t ix = 0; ix < ids.length(); ix++) {
+        // Keys are always strings in JS, integer-like ones included; they are
+        // converted to the key type like any other value
+        if (!JS_IdToValue(cx, ids[ix], &key))
+            return nullptr;
+        JSString* key_str = JS::ToString(cx, key);
+        if (!key_str)
+            return nullptr;
+        key.setString(key_str);
+
+        if (!JS_GetPropertyById(cx, obj, ids[ix], &elem))
+            return nullptr;
+
+        Gjs::AutoGVariant packed_key{pack(cx, key_type, key)};
+        if (!packed_key)
+            return nullptr;
+        Gjs::AutoGVariant packed_value{pack(cx, value_type, elem)};
+        if (!packed_value)
+            return nullptr;
+
+        entries.push_back(
+            take_sunk(g_variant_new_dict_entry(packed_key, packed_value)));
+    }
+
+    return new_array(entry_type, entries);
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static Gjs::AutoGVariant pack_array(JSContext* cx,
+                                    const GVariantType* array_type,
+                                    JS::HandleValue value) {
+    const GVariantType* element_type = g_variant_type_element(array_type);
+    char element_char = *g_variant_type_peek_string(element_type);
+
+    if (element_char == 'y')
+        return pack_byte_array(cx, array_type, value);
+    if (element_char == '{')
+        return pack_dict(cx, array_type, value);
+
+    JS::RootedObject array{cx};
+    uint32_t length;
+    if (!array_like_from_js(cx, value, array_type, &array, &length))
+        return nullptr;
+
+    // Arrays of fixed-width basic types are converted in bulk into a C array
+    switch (element_char) {
+        case 'b':
+            return pack_fixed_array<uint8_t, bool>(cx, array_type, array,
+                                                   length);
+        case 'n':
+            return pack_fixed_array<int16_t>(cx, array_type, array, length);
+        case 'q':
+            return pack_fixed_array<uint16_t>(cx, array_type, array, length);
+        case 'i':
+        case 'h':
+            return pack_fixed_array<int32_t>(cx, array_type, array, length);
+        case 'u':
+            return pack_fixed_array<uint32_t>(cx, array_type, array, length);
+        case 'x':
+            return pack_fixed_array<int64_t>(cx, array_type, array, length);
+        case 't':
+            return pack_fixed_array<uint64_t>(cx, array_type, array, length);
+        case 'd':
+            return pack_fixed_array<double>(cx, array_type, array, length);
+        case 's':
+            return pack_strv(cx, array_type, array, length);
+        default:
+            break;
+    }
+
+    std::vector<Gjs::AutoGVariant> items;
+    items.reserve(length);
+    JS::RootedValue elem{cx};
+    for (uint32_t ix = 0; ix < length; ix++) {
+        if (!JS_GetElement(cx, array, ix, &elem))
+            return nullptr;
+        Gjs::AutoGVariant item{pack(cx, element_type, elem)};
+        if (!item)
+            return nullptr;
+        items.push_back(std::move(item));
+    }
+
+    return new_array(element_type, items);
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static Gjs::AutoGVariant pack_tuple(JSContext* cx, const GVariantType* type,
+                                    JS::HandleValue value) {
+    JS::RootedObject array{cx};
+    uint32_t length;
+    if (!array_like_from_js(cx, value, type, &array, &length))
+        return nullptr;
+
+    size_t n_items = g_variant_type_n_items(type);
+    if (length < n_items) {
+        gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr,
+                         "Expected %zu elements for GVariant type '%.*s', "
+                         "got %u",
+                         n_items, TYPE_STRING_ARGS(type), length);
+        return nullptr;
+    }
+
+    std::vector<Gjs::AutoGVariant> items;
+    items.reserve(n_items);
+    JS::RootedValue elem{cx};
+    uint32_t ix = 0;
+    for (const GVariantType* item_type = g_variant_type_first(type); item_type;
+         item_type = g_variant_type_next(item_type), ix++) {
+        if (!JS_GetElement(cx, array, ix, &elem))
+            return nullptr;
+        Gjs::AutoGVariant item{pack(cx, item_type, elem)};
+        if (!item)
+            return nullptr;
+        items.push_back(std::move(item));
+    }
+
+    std::vector<GVariant*> children = borrow_all(items);
+    return take_sunk(g_variant_new_tuple(children.data(), children.size()));
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static Gjs::AutoGVariant pack_dict_entry(JSContext* cx,
+                                         const GVariantType* type,
+                                         JS::HandleValue value) {
+    JS::RootedObject array{cx};
+    uint32_t length;
+    if (!array_like_from_js(cx, value, type, &array, &length))
+        return nullptr;
+
+    JS::RootedValue elem{cx};
+    if (!JS_GetElement(cx, array, 0, &elem))
+        return nullptr;
+    Gjs::AutoGVariant key{pack(cx, g_variant_type_key(type), elem)};
+    if (!key || !JS_GetElement(cx, array, 1, &elem))
+        return nullptr;
+    Gjs::AutoGVariant child{pack(cx, g_variant_type_value(type), elem)};
+    if (!child)
+        return nullptr;
+
+    return take_sunk(g_variant_new_dict_entry(key, child));
+}
+
+template <typename TAG, typename F>
+GJS_JSAPI_RETURN_CONVENTION static Gjs::AutoGVariant pack_basic(
+    JSContext* cx, const GVariantType* type, JS::HandleValue value,
+    F new_func) {
+    Gjs::Tag::RealT<TAG> val;
+    if (!basic_from_js<TAG>(cx, value, type, &val))
+        return nullptr;
+    return take_sunk(new_func(val));
+}
+
+static Gjs::AutoGVariant pack(JSContext* cx, const GVariantType* type,
+                              JS::HandleValue value) {
+    switch (*g_variant_type_peek_string(type)) {
+        case 'b':
+            return take_sunk(g_variant_new_boolean(JS::ToBoolean(value)));
+        case 'y':
+            return pack_basic<uint8_t>(cx, type, value, g_variant_new_byte);
+        case 'n':
+            return pack_basic<int16_t>(cx, type, value, g_variant_new_int16);
+        case 'q':
+            return pack_basic<uint16_t>(cx, type, value, g_variant_new_uint16);
+        case 'i':
+            return pack_basic<int32_t>(cx, type, value, g_variant_new_int32);
+        case 'u':
+            return pack_basic<uint32_t>(cx, type, value, g_variant_new_uint32);
+        case 'x':
+            return pack_basic<int64_t>(cx, type, value, g_variant_new_int64);
+        case 't':
+            return pack_basic<uint64_t>(cx, type, value, g_variant_new_uint64);
+        case 'h':
+            return pack_basic<int32_t>(cx, type, value, g_variant_new_handle);
+        case 'd':
+            return pack_basic<double>(cx, type, value, g_variant_new_double);
+        case 's':
+        case 'o':
+        case 'g': {
+            JS::UniqueChars str;
+            if (!string_from_js(cx, value, type, &str))
+                return nullptr;
+
+            if (g_variant_type_equal(type, G_VARIANT_TYPE_STRING))
+                return take_sunk(g_variant_new_string(str.get()));
+
+            if (g_variant_type_equal(type, G_VARIANT_TYPE_OBJECT_PATH)) {
+                if (g_variant_is_object_path(str.get()))
+                    return take_sunk(g_variant_new_object_path(str.get()));
+                gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr,
+                                 "'%s' is not a valid D-Bus object path",
+                                 str.get());
+                return nullptr;
+            }
+
+            if (g_variant_is_signature(str.get()))
+                return take_sunk(g_variant_new_signature(str.get()));
+            gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr,
+                             "'%s' is not a valid D-Bus type signature",
+                             str.get());
+            return nullptr;
+        }
+        case 'v': {
+            if (!value.isObject()) {
+                throw_expected(cx, "a GLib.Variant", type, value);
+                return nullptr;
+            }
+
+            JS::RootedObject obj{cx, &value.toObject()};
+            if (!BoxedBase::typecheck(cx, obj, G_TYPE_VARIANT))
+                return nullptr;
+            GVariant* child = BoxedBase::to_c_ptr<GVariant>(cx, obj);
+            if (!child)
+                return nullptr;
+            return take_sunk(g_variant_new_variant(child));
+        }
+        case 'm': {
+            const GVariantType* element_type = g_variant_type_element(type);
+            if (value.isNull())
+                return take_sunk(g_variant_new_maybe(element_type, nullptr));
+
+            Gjs::AutoGVariant child{pack(cx, element_type, value)};
+            if (!child)
+                return nullptr;
+            return take_sunk(g_variant_new_maybe(element_type, child));
+        }
+        case 'a':
+            return pack_array(cx, type, value);
+        case '(':
+            return pack_tuple(cx, type, value);
+        case '{':
+            return pack_dict_entry(cx, type, value);
+        default:
+            g_assert_not_reached();
+            return nullptr;
+    }
+}
+
+Gjs::AutoGVariant gjs_variant_pack(JSContext* cx, const char* signature,
+                                   JS::HandleValue value) {
+    if (*signature == '\0') {
+        gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr,
+                         "GVariant signature cannot be empty");
+        return nullptr;
+    }
+
+    const char* end;
+    if (!g_variant_type_string_scan(signature, nullptr, &end)) {
+        gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr,
+                         "Invalid GVariant signature '%s'", signature);
+        return nullptr;
+    }
+    if (*end != '\0') {
+        gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr,
+                         "Invalid GVariant signature '%s' (more than one "
+                         "single complete type)",
+                         signature);
+        return nullptr;
+    }
+
+    // A validated type string is a GVariantType
+    auto* type = reinterpret_cast<const GVariantType*>(signature);
+    if (!g_variant_type_is_definite(type)) {
+        gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr,
+                         "Invalid GVariant signature '%s' (indefinite types "
+                         "cannot be packed)",
+                         signature);
+        return nullptr;
+    }
+
+    return pack(cx, type, value);
+}
+
+Gjs::AutoGVariant gjs_variant_pack(JSContext* cx, const GVariantType* type,
+                                   JS::HandleValue value) {
+    g_assert(g_variant_type_is_definite(type));
+    return pack(cx, type, value);
+}
+
+namespace {
+
+class VariantUnpacker {
+    JSContext* m_cx;
+    bool m_deep : 1;
+    bool m_recursive : 1;
+    GI::AutoStructInfo m_variant_info;
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool wrap(GVariant* variant, JS::MutableHandleValue value_out) {
+        if (!m_variant_info)
+            m_variant_info.reset(
+                g_irepository_find_by_gtype(nullptr, G_TYPE_VARIANT));
+        g_assert(m_variant_info && "GLib.Variant must have been imported");
+
+        JSObject* obj =
+            BoxedInstance::new_for_c_struct(m_cx, m_variant_info, variant);
+        if (!obj)
+            return false;
+        value_out.setObject(*obj);
+        return true;
+    }
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool unpack_or_wrap(GVariant* variant, bool should_unpack,
+                        JS::MutableHandleValue value_out) {
+        if (should_unpack)
+            return unpack(variant, value_out);
+        return wrap(variant, value_out);
+    }
+
+    template <typename T, typename TAG = T>
+    GJS_JSAPI_RETURN_CONVENTION bool unpack_fixed_array(
+        GVariant* variant, JS::MutableHandleValue value_out) {
+        size_t n_elements;
+        auto* elements = static_cast<const T*>(
+            g_variant_get_fixed_array(variant, &n_elements, sizeof(T)));
+
+        JS::RootedValueVector values{m_cx};
+        if (!values.resize(n_elements)) {
+            JS_ReportOutOfMemory(m_cx);
+            return false;
+        }
+        for (size_t ix = 0; ix < n_elements; ix++) {
+            if (!Gjs::c_value_to_js_checked<TAG>(
+                    m_cx, Gjs::Tag::RealT<TAG>(elements[ix]), values[ix]))
+                return false;
+        }
+
+        JSObject* array = JS::NewArrayObject(m_cx, values);
+        if (!array)
+            return false;
+        value_out.setObject(*array);
+        return true;
+    }
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool unpack_strv(GVariant* variant, JS::MutableHandleValue value_out) {
+        size_t n_elements;
+        Gjs::AutoPointer<const char*, void, g_free> strv{
+            g_variant_type_equal(g_variant_get_type(variant),
+                                 G_VARIANT_TYPE_STRING_ARRAY)
+                ? g_variant_get_strv(variant, &n_elements)
+                : g_variant_get_objv(variant, &n_elements)};
+
+        JS::RootedValueVector values{m_cx};
+        if (!values.resize(n_elements)) {
+            JS_ReportOutOfMemory(m_cx);
+            return false;
+        }
+        for (size_t ix = 0; ix < n_elements; ix++) {
+            if (!gjs_string_from_utf8(m_cx, strv.get()[ix], values[ix]))
+                return false;
+        }
+
+        JSObject* array = JS::NewArrayObject(m_cx, values);
+        if (!array)
+            return false;
+        value_out.setObject(*array);
+        return true;
+    }
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool unpack_dict(GVariant* variant, JS::MutableHandleValue value_out) {
+        JS::RootedObject obj{m_cx, JS_NewPlainObject(m_cx)};
+        if (!obj)
+            return false;
+
+        size_t n_entries = g_variant_n_children(variant);
+        JS::RootedValue key{m_cx}, value{m_cx};
+        JS::RootedId id{m_cx};
+        for (size_t ix = 0; ix < n_entries; ix++) {
+            Gjs::AutoGVariant entry{g_variant_get_child_value(variant, ix)};
+            Gjs::AutoGVariant key_variant{g_variant_get_child_value(entry, 0)};
+            Gjs::AutoGVariant value_variant{
+                g_variant_get_child_value(entry, 1)};
+
+            // Keys are basic types, and are always unpacked, otherwise they
+            // could not be used as property keys
+            if (!unpack(key_variant, &key) || !JS_ValueToId(m_cx, key, &id) ||
+                !unpack_or_wrap(value_variant, m_deep, &value) ||
+                !JS_DefinePropertyById(m_cx, obj, id, value, JSPROP_ENUMERATE))
+                return false;
+        }
+
+        value_out.setObject(*obj);
+        return true;
+    }
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool unpack_array(GVariant* variant, JS::MutableHandleValue value_out) {
+        const GVariantType* element_type =
+            g_variant_type_element(g_variant_get_type(variant));
+
+        // Byte arrays and dictionaries are unpacked even if not deep
+        switch (*g_variant_type_peek_string(element_type)) {
+            case 'y': {
+                size_t len;
+                const void* data = g_variant_get_fixed_array(variant, &len, 1);
+                JSObject* array = gjs_byte_array_from_data_copy(
+                    m_cx, len, const_cast<void*>(data));
+                if (!array)
+                    return false;
+                value_out.setObject(*array);
+                return true;
+            }
+            case '{':
+                return unpack_dict(variant, value_out);
+            default:
+                break;
+        }
+
+        if (!m_deep)
+            return unpack_children(variant, value_out);
+
+        switch (*g_variant_type_peek_string(element_type)) {
+            case 'b':
+                return unpack_fixed_array<uint8_t, bool>(variant, value_out);
+            case 'n':
+                return unpack_fixed_array<int16_t>(variant, value_out);
+            case 'q':
+                return unpack_fixed_array<uint16_t>(variant, value_out);
+            case 'i':
+            case 'h':
+                return unpack_fixed_array<int32_t>(variant, value_out);
+            case 'u':
+                return unpack_fixed_array<uint32_t>(variant, value_out);
+            case 'x':
+                return unpack_fixed_array<int64_t>(variant, value_out);
+            case 't':
+                return unpack_fixed_array<uint64_t>(variant, value_out);
+            case 'd':
+                return unpack_fixed_array<double>(variant, value_out);
+            case 's':
+            case 'o':
+                return unpack_strv(variant, value_out);
+            default:
+                return unpack_children(variant, value_out);
+        }
+    }
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool unpack_children(GVariant* variant, JS::MutableHandleValue value_out) {
+        size_t n_children = g_variant_n_children(variant);
+        JS::RootedValueVector values{m_cx};
+        if (!values.resize(n_children)) {
+            JS_ReportOutOfMemory(m_cx);
+            return false;
+        }
+        for (size_t ix = 0; ix < n_children; ix++) {
+            Gjs::AutoGVariant item{g_variant_get_child_value(variant, ix)};
+            if (!unpack_or_wrap(item, m_deep, values[ix]))
+                return false;
+        }
+
+        JSObject* array = JS::NewArrayObject(m_cx, values);
+        if (!array)
+            return false;
+        value_out.setObject(*array);
+        return true;
+    }
+
+ public:
+    VariantUnpacker(JSContext* cx, bool deep, bool recursive)
+        : m_cx(cx), m_deep(deep), m_recursive(deep && recursive) {}
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool unpack(GVariant* variant, JS::MutableHandleValue value_out) {
+        switch (g_variant_classify(variant)) {
+            case G_VARIANT_CLASS_BOOLEAN:
+                value_out.setBoolean(g_variant_get_boolean(variant));
+                return true;
+            case G_VARIANT_CLASS_BYTE:
+                value_out.setInt32(g_variant_get_byte(variant));
+                return true;
+            case G_VARIANT_CLASS_INT16:
+                value_out.setInt32(g_variant_get_int16(variant));
+                return true;
+            case G_VARIANT_CLASS_UINT16:
+                value_out.setInt32(g_variant_get_uint16(variant));
+                return true;
+            case G_VARIANT_CLASS_INT32:
+                value_out.setInt32(g_variant_get_int32(variant));
+                return true;
+            case G_VARIANT_CLASS_UINT32:
+                value_out.setNumber(g_variant_get_uint32(variant));
+                return true;
+            case G_VARIANT_CLASS_INT64:
+                return Gjs::c_value_to_js_checked<int64_t>(
+                    m_cx, g_variant_get_int64(variant), value_out);
+            case G_VARIANT_CLASS_UINT64:
+                return Gjs::c_value_to_js_checked<uint64_t>(
+                    m_cx, g_variant_get_uint64(variant), value_out);
+            case G_VARIANT_CLASS_HANDLE:
+                value_out.setInt32(g_variant_get_handle(variant));
+                return true;
+            case G_VARIANT_CLASS_DOUBLE:
+                return Gjs::c_value_to_js<double>(
+                    m_cx, g_variant_get_double(variant), value_out);
+            case G_VARIANT_CLASS_STRING:
+            case G_VARIANT_CLASS_OBJECT_PATH:
+            case G_VARIANT_CLASS_SIGNATURE: {
+                size_t len;
+                const char* str = g_variant_get_string(variant, &len);
+                return gjs_string_from_utf8_n(m_cx, str, len, value_out);
+            }
+            case G_VARIANT_CLASS_VARIANT: {
+                Gjs::AutoGVariant inner{g_variant_get_variant(variant)};
+                return unpack_or_wrap(inner, m_recursive, value_out);
+            }
+            case G_VARIANT_CLASS_MAYBE: {
+                Gjs::AutoGVariant inner{g_variant_get_maybe(variant)};
+                if (!inner) {
+                    value_out.setNull();
+                    return true;
+                }
+                return unpack_or_wrap(inner, m_deep, value_out);
+            }
+            case G_VARIANT_CLASS_ARRAY:
+                return unpack_array(variant, value_out);
+            case G_VARIANT_CLASS_TUPLE:
+            case G_VARIANT_CLASS_DICT_ENTRY:
+                return unpack_children(variant, value_out);
+        }
+
+        g_assert_not_reached();
+        return false;
+    }
+};
+
+}  // namespace
+
+bool gjs_variant_unpack(JSContext* cx, GVariant* variant, bool deep,
+                        bool recursive, JS::MutableHandleValue value_out) {
+    VariantUnpacker unpacker{cx, deep, recursive};
+    return unpacker.unpack(variant, value_out);
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool unpack_func(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+    JS::RootedObject variant_obj{cx};
+    bool deep, recursive;
+    if (!gjs_parse_call_args(cx, "unpack", args, "obb", "variant",
+                             &variant_obj, "deep", &deep, "recursive",
+                             &recursive))
+        return false;
+
+    if (!BoxedBase::typecheck(cx, variant_obj, G_TYPE_VARIANT))
+        return false;
+    GVariant* variant = BoxedBase::to_c_ptr<GVariant>(cx, variant_obj);
+    if (!variant)
+        return false;
+
+    return gjs_variant_unpack(cx, variant, deep, recursive, args.rval());
+}
+
+static JSFunctionSpec gjs_variant_module_funcs[] = {
+    JS_FN("unpack", unpack_func, 3, 0), JS_FS_END};
+
+bool gjs_define_variant_stuff(JSContext* cx, JS::MutableHandleObject module) {
+    module.set(JS_NewPlainObject(cx));
+    return JS_DefineFunctions(cx, module, gjs_variant_module_funcs);
+}
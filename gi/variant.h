@@ -0,0 +1,60 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#ifndef GI_VARIANT_H_
+#define GI_VARIANT_H_
+
+#include <config.h>
+
+#include <glib.h>
+
+#include <js/TypeDecls.h>
+
+#include "gjs/auto.h"
+#include "gjs/macros.h"
+
+/*
+ * gjs_variant_pack:
+ * @signature: a GVariant type string describing exactly one definite type
+ * @value: the JS value to pack
+ *
+ * Converts @value into a GVariant of type @signature, following the rules of
+ * the GLib.Variant constructor. The signature is validated once, and the type
+ * is then walked in place, so no intermediate GLib.Variant wrapper objects or
+ * GVariantTypes are created for the members of containers.
+ *
+ * Returns: a new (non-floating) reference to the GVariant, or null with an
+ * exception pending.
+ */
+GJS_JSAPI_RETURN_CONVENTION
+Gjs::AutoGVariant gjs_variant_pack(JSContext* cx, const char* signature,
+                                   JS::HandleValue value);
+
+/*
+ * gjs_variant_pack:
+ * @type: a definite GVariantType, which has already been validated
+ *
+ * Same as above, for callers that keep parsed types around.
+ */
+GJS_JSAPI_RETURN_CONVENTION
+Gjs::AutoGVariant gjs_variant_pack(JSContext* cx, const GVariantType* type,
+                                   JS::HandleValue value);
+
+/*
+ * gjs_variant_unpack:
+ * @deep: whether to unpack the members of containers as well
+ * @recursive: whether to unpack the contents of variants nested in @variant;
+ *   only taken into account if @deep is true
+ *
+ * Converts @variant into a JS value, following the rules of the unpack(),
+ * deepUnpack() and recursiveUnpack() methods of GLib.Variant.
+ */
+GJS_JSAPI_RETURN_CONVENTION
+bool gjs_variant_unpack(JSContext* cx, GVariant* variant, bool deep,
+                        bool recursive, JS::MutableHandleValue value_out);
+
+GJS_JSAPI_RETURN_CONVENTION
+bool gjs_define_variant_stuff(JSContext* cx, JS::MutableHandleObject module);
+
+#endif  // GI_VARIANT_H_
@@ -0,0 +1,310 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#include <config.h>
+
+#include <stdint.h>
+#include <stdlib.h>  // for strtoul
+
+#include <algorithm>  // for sort
+#include <atomic>
+#include <memory>  // for unique_ptr, make_unique
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>  // for move, pair
+#include <vector>
+
+#include <girepository.h>
+#include <glib-object.h>
+#include <glib.h>
+
+#include <js/Array.h>  // for NewArrayObject
+#include <js/Exception.h>
+#include <js/PropertyAndElement.h>
+#include <js/RootingAPI.h>
+#include <js/Stack.h>  // for CaptureCurrentStack, BuildStackString, MaxFrames
+#include <js/TypeDecls.h>
+#include <js/Utility.h>  // for UniqueChars
+#include <js/Value.h>
+#include <js/ValueArray.h>  // for RootedValueVector
+#include <jsapi.h>  // for JS_NewPlainObject
+
+#include "gi/wrapper-stats.h"
+#include "gjs/jsapi-util.h"
+
+namespace Gjs {
+namespace WrapperStats {
+
+// Frames of JS stack recorded per creation site, and distinct sites recorded
+// per type; creations from further sites are only counted
+static constexpr unsigned MAX_SITE_FRAMES = 8;
+static constexpr size_t MAX_SITES = 32;
+
+struct Entry {
+    // Set when the entry is added
+    std::string name;
+    size_t instance_size = 0;
+
+    // Updated from any thread without taking the lock
+    std::atomic_int64_t live = 0;
+    std::atomic_int64_t peak = 0;
+    std::atomic_uint64_t n_created = 0;
+    std::atomic_uint64_t n_finalized = 0;
+
+    // Only used when sampling, with stats_lock held
+    unsigned sample_countdown = 0;
+    std::unordered_map<std::string, uint64_t> sites;
+    uint64_t n_other_sites = 0;
+};
+
+// A copy of an entry, to convert without holding the lock
+struct EntryValues {
+    std::string name;
+    size_t instance_size;
+    int64_t live;
+    int64_t peak;
+    uint64_t n_created;
+    uint64_t n_finalized;
+    std::unordered_map<std::string, uint64_t> sites;
+    uint64_t n_other_sites;
+};
+
+static std::mutex stats_lock;
+static std::unordered_map<uintptr_t, std::unique_ptr<Entry>> stats;
+
+[[nodiscard]] static unsigned sample_interval() {
+    static const unsigned interval = []() -> unsigned {
+        const char* env = g_getenv("GJS_WRAPPER_STATS_SAMPLE");
+        return env ? strtoul(env, nullptr, 10) : 0;
+    }();
+    return interval;
+}
+
+// Plain structs and unions have no GType, so they are told apart by the name
+// in their typelib, which stays at the same address
+[[nodiscard]] static uintptr_t key_for(GType gtype, GIBaseInfo* info) {
+    if (gtype != G_TYPE_NONE || !info)
+        return gtype;
+    return reinterpret_cast<uintptr_t>(g_base_info_get_name(info));
+}
+
+Entry* entry_for(GType gtype, GIBaseInfo* info) {
+    std::lock_guard<std::mutex> lock{stats_lock};
+    auto [it, inserted] = stats.try_emplace(key_for(gtype, info));
+    if (!inserted)
+        return it->second.get();
+
+    it->second = std::make_unique<Entry>();
+    Entry& entry = *it->second;
+
+    if (gtype != G_TYPE_NONE) {
+        entry.name = g_type_name(gtype);
+    } else if (info) {
+        entry.name = std::string{g_base_info_get_namespace(info)} + "." +
+                     g_base_info_get_name(info);
+    } else {
+        entry.name = "(unknown)";
+    }
+
+    // This only counts the C struct itself, not any memory it points to
+    if (G_TYPE_IS_INSTANTIATABLE(gtype)) {
+        GTypeQuery query;
+        g_type_query(gtype, &query);
+        entry.instance_size = query.instance_size;
+    } else if (info && GI_IS_STRUCT_INFO(info)) {
+        entry.instance_size = g_struct_info_get_size(info);
+    } else if (info && GI_IS_UNION_INFO(info)) {
+        entry.instance_size = g_union_info_get_size(info);
+    }
+
+    entry.sample_countdown = sample_interval();
+    return &entry;
+}
+
+void created(Entry* entry) {
+    entry->n_created.fetch_add(1, std::memory_order_relaxed);
+    int64_t live = entry->live.fetch_add(1, std::memory_order_relaxed) + 1;
+    int64_t peak = entry->peak.load(std::memory_order_relaxed);
+    while (live > peak && !entry->peak.compare_exchange_weak(
+                              peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+void finalized(Entry* entry) {
+    entry->n_finalized.fetch_add(1, std::memory_order_relaxed);
+    entry->live.fetch_sub(1, std::memory_order_relaxed);
+}
+
+[[nodiscard]] static std::string capture_site(JSContext* cx) {
+    JS::RootedObject frame{cx};
+    JS::RootedString stack{cx};
+    JS::StackCapture capture{JS::MaxFrames{MAX_SITE_FRAMES}};
+    if (!JS::CaptureCurrentStack(cx, &frame, std::move(capture)) ||
+        !JS::BuildStackString(cx, nullptr, frame, &stack)) {
+        // Statistics are not worth an exception in the code being profiled
+        JS_ClearPendingException(cx);
+        return {};
+    }
+
+    JS::UniqueChars chars{JS_EncodeStringToUTF8(cx, stack)};
+    if (!chars) {
+        JS_ClearPendingException(cx);
+        return {};
+    }
+    return chars.get();
+}
+
+void sample_creation_site(JSContext* cx, Entry* entry) {
+    if (sample_interval() == 0 || JS_IsExceptionPending(cx))
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock{stats_lock};
+        if (entry->sample_countdown > 1) {
+            entry->sample_countdown--;
+            return;
+        }
+        entry->sample_countdown = sample_interval();
+    }
+
+    // Capturing the stack may run a GC, which finalizes wrappers, so it must
+    // not be done with the lock held
+    std::string site{capture_site(cx)};
+    if (site.empty())
+        site = "(no JS stack)";
+
+    std::lock_guard<std::mutex> lock{stats_lock};
+    auto it = entry->sites.find(site);
+    if (it != entry->sites.end())
+        it->second++;
+    else if (entry->sites.size() < MAX_SITES)
+        entry->sites.emplace(std::move(site), 1);
+    else
+        entry->n_other_sites++;
+}
+
+// Copies the entries so that they can be converted without holding the lock,
+// which could deadlock if converting them finalizes wrappers
+[[nodiscard]] static std::vector<EntryValues> snapshot() {
+    std::vector<EntryValues> retval;
+    {
+        std::lock_guard<std::mutex> lock{stats_lock};
+        retval.reserve(stats.size());
+        for (const auto& [key, entry] : stats) {
+            retval.push_back({entry->name, entry->instance_size,
+                              entry->live.load(), entry->peak.load(),
+                              entry->n_created.load(),
+                              entry->n_finalized.load(), entry->sites,
+                              entry->n_other_sites});
+        }
+    }
+
+    std::sort(retval.begin(), retval.end(),
+              [](const EntryValues& a, const EntryValues& b) {
+                  return a.live > b.live;
+              });
+    return retval;
+}
+
+using SiteCount = std::pair<std::string, uint64_t>;
+
+[[nodiscard]] static std::vector<SiteCount> sorted_sites(
+    const EntryValues& entry) {
+    std::vector<SiteCount> retval{entry.sites.begin(), entry.sites.end()};
+    std::sort(retval.begin(), retval.end(),
+              [](const auto& a, const auto& b) { return a.second > b.second; });
+    return retval;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static JSObject* entry_to_js(JSContext* cx, const EntryValues& entry) {
+    JS::RootedObject obj{cx, JS_NewPlainObject(cx)};
+    if (!obj || !gjs_define_string_property(cx, obj, "name", entry.name,
+                                            JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, obj, "live", double(entry.live),
+                           JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, obj, "peak", double(entry.peak),
+                           JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, obj, "created", double(entry.n_created),
+                           JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, obj, "finalized", double(entry.n_finalized),
+                           JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, obj, "estimatedBytes",
+                           double(std::max(entry.live, int64_t(0)) *
+                                  entry.instance_size),
+                           JSPROP_ENUMERATE))
+        return nullptr;
+
+    if (sample_interval() == 0)
+        return obj;
+
+    JS::RootedValueVector sites{cx};
+    JS::RootedObject site{cx};
+    for (const auto& [stack, count] : sorted_sites(entry)) {
+        site = JS_NewPlainObject(cx);
+        if (!site || !gjs_define_string_property(cx, site, "stack", stack,
+                                                 JSPROP_ENUMERATE) ||
+            !JS_DefineProperty(cx, site, "count", double(count),
+                               JSPROP_ENUMERATE) ||
+            !sites.append(JS::ObjectValue(*site)))
+            return nullptr;
+    }
+
+    JS::RootedObject sites_array{cx, JS::NewArrayObject(cx, sites)};
+    if (!sites_array ||
+        !JS_DefineProperty(cx, obj, "creationSites", sites_array,
+                           JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, obj, "otherCreationSites",
+                           double(entry.n_other_sites), JSPROP_ENUMERATE))
+        return nullptr;
+
+    return obj;
+}
+
+JSObject* to_js(JSContext* cx) {
+    JS::RootedValueVector elems{cx};
+    JS::RootedObject elem{cx};
+    for (const EntryValues& entry : snapshot()) {
+        elem = entry_to_js(cx, entry);
+        if (!elem || !elems.append(JS::ObjectValue(*elem)))
+            return nullptr;
+    }
+    return JS::NewArrayObject(cx, elems);
+}
+
+std::string to_json() {
+    std::ostringstream out;
+    out << "[";
+    bool first = true;
+    for (const EntryValues& entry : snapshot()) {
+        out << (first ? "\n" : ",\n") << "  {\"name\": ";
+        first = false;
+        out << gjs_json_quote(entry.name);
+        out << ", \"live\": " << entry.live << ", \"peak\": " << entry.peak
+            << ", \"created\": " << entry.n_created
+            << ", \"finalized\": " << entry.n_finalized
+            << ", \"estimatedBytes\": "
+            << std::max(entry.live, int64_t(0)) * entry.instance_size;
+
+        if (sample_interval() != 0) {
+            out << ", \"creationSites\": [";
+            bool first_site = true;
+            for (const auto& [stack, count] : sorted_sites(entry)) {
+                out << (first_site ? "" : ", ") << "{\"stack\": ";
+                first_site = false;
+                out << gjs_json_quote(stack);
+                out << ", \"count\": " << count << "}";
+            }
+            out << "], \"otherCreationSites\": " << entry.n_other_sites;
+        }
+        out << "}";
+    }
+    out << "\n]\n";
+    return out.str();
+}
+
+}  // namespace WrapperStats
+}  // namespace Gjs
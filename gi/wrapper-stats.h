@@ -0,0 +1,49 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#pragma once
+
+#include <config.h>
+
+#include <string>
+
+#include <girepository.h>
+#include <glib-object.h>
+
+#include <js/TypeDecls.h>
+
+#include "gjs/macros.h"
+
+namespace Gjs {
+namespace WrapperStats {
+
+// Statistics of the GI wrapper objects of each type, shared by all contexts in
+// the process. The global object_instance, boxed_instance, etc. counters say
+// how many wrappers there are; these say of which types.
+//
+// With GJS_WRAPPER_STATS_SAMPLE=N, the JS stack is captured for one in every N
+// wrappers created of each type, and the distinct stacks are counted, so that
+// the code creating the most wrappers of a leaking type can be found.
+
+struct Entry;
+
+// Returns the statistics of a type, adding them the first time. Entries are
+// never freed, so wrapper prototypes look up theirs once and keep it, and
+// counting wrappers takes no lock.
+[[nodiscard]] Entry* entry_for(GType gtype, GIBaseInfo* info);
+
+void created(Entry* entry);
+void finalized(Entry* entry);
+
+// Call where the wrapper is created from JS code, after created()
+void sample_creation_site(JSContext* cx, Entry* entry);
+
+// Returns an array of objects, one per type, ordered by number of live
+// wrappers, most first
+GJS_JSAPI_RETURN_CONVENTION JSObject* to_js(JSContext* cx);
+
+[[nodiscard]] std::string to_json();
+
+}  // namespace WrapperStats
+}  // namespace Gjs
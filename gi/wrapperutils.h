@@ -10,6 +10,7 @@
 
 #include <stdint.h>
 
+#include <memory>  // for unique_ptr
 #include <new>
 #include <string>
 
@@ -33,12 +34,15 @@
 #include "gi/arg-inl.h"
 #include "gi/cwrapper.h"
 #include "gi/info.h"
+#include "gi/member-index.h"
+#include "gi/wrapper-stats.h"
 #include "gjs/atoms.h"
 #include "gjs/auto.h"
 #include "gjs/context-private.h"
 #include "gjs/jsapi-class.h"
 #include "gjs/jsapi-util.h"
 #include "gjs/macros.h"
+#include "gjs/mem-private.h"
 #include "gjs/profiler-private.h"
 #include "util/log.h"
 
@@ -481,6 +485,7 @@ class GIWrapperBase : public CWrapperPointerOps<Base> {
         args.rval().setUndefined();
 
         Instance* priv = Instance::new_for_js_object(prototype, obj);
+        Gjs::WrapperStats::sample_creation_site(cx, prototype->stats());
 
         {
             std::string full_name{
@@ -703,9 +708,17 @@ class GIWrapperPrototype : public Base {
     // any case.
     GI::AutoBaseInfo m_info;
     GType m_gtype;
+    // Index of the members in m_info, created the first time it is needed by
+    // ensure_member_index(). Always null if m_info is null.
+    std::unique_ptr<Gjs::MemberIndex> m_member_index;
+    // Counts the instances, looked up once so that creating one takes no lock
+    Gjs::WrapperStats::Entry* m_stats;
 
     explicit GIWrapperPrototype(Info* info, GType gtype)
-        : Base(), m_info(info, Gjs::TakeOwnership{}), m_gtype(gtype) {
+        : Base(),
+          m_info(info, Gjs::TakeOwnership{}),
+          m_gtype(gtype),
+          m_stats(Gjs::WrapperStats::entry_for(gtype, info)) {
         Base::debug_lifecycle("Prototype constructor");
     }
 
@@ -1006,9 +1019,25 @@ class GIWrapperPrototype : public Base {
 
     [[nodiscard]] Info* info() const { return m_info; }
     [[nodiscard]] GType gtype() const { return m_gtype; }
+    [[nodiscard]] Gjs::WrapperStats::Entry* stats() const { return m_stats; }
 
     // Helper methods
 
+ protected:
+    /*
+     * GIWrapperPrototype::ensure_member_index:
+     *
+     * Builds the index of members of the introspection info, if it hasn't been
+     * built yet. Must not be called if there is no introspection info.
+     */
+    GJS_JSAPI_RETURN_CONVENTION
+    bool ensure_member_index(JSContext* cx) {
+        g_assert(m_info && "Can't index members without introspection info");
+        if (!m_member_index)
+            m_member_index = Gjs::MemberIndex::create(cx, m_info);
+        return !!m_member_index;
+    }
+
  private:
     static void destroy_notify(void* ptr) {
         static_cast<Prototype*>(ptr)->~Prototype();
@@ -1027,8 +1056,13 @@ class GIWrapperPrototype : public Base {
  protected:
     void finalize_impl(JS::GCContext*, JSObject*) { release(); }
 
-    // Override if necessary
-    void trace_impl(JSTracer*) {}
+    // Override if necessary. Overrides must call trace_member_index().
+    void trace_impl(JSTracer* trc) { trace_member_index(trc); }
+
+    void trace_member_index(JSTracer* trc) {
+        if (m_member_index)
+            m_member_index->trace(trc);
+    }
 };
 
 using GIWrappedUnowned = void;
@@ -1061,9 +1095,15 @@ class GIWrapperInstance : public Base {
         : Base(prototype), m_ptr(nullptr) {
         Base::m_proto->acquire();
         Base::GIWrapperBase::debug_lifecycle(obj, "Instance constructor");
+        GJS_ADD_STAT(wrappers_created, 1);
+        Gjs::WrapperStats::created(prototype->stats());
     }
 
-    ~GIWrapperInstance(void) { Base::m_proto->release(); }
+    ~GIWrapperInstance(void) {
+        Gjs::WrapperStats::finalized(Base::m_proto->stats());
+        Base::m_proto->release();
+        GJS_ADD_STAT(wrappers_finalized, 1);
+    }
 
  public:
     /*
@@ -51,7 +51,6 @@ class JSTracer;
     macro(module_path, "__modulePath__") \
     macro(name, "name") \
     macro(new_, "new") \
-    macro(new_internal, "_new_internal") \
     macro(override, "override") \
     macro(overrides, "overrides") \
     macro(param_spec, "ParamSpec") \
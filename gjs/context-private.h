@@ -41,17 +41,17 @@
 #include "gjs/auto.h"
 #include "gjs/context.h"
 #include "gjs/gerror-result.h"
+#include "gjs/job-queue.h"
 #include "gjs/jsapi-util-root.h"
 #include "gjs/macros.h"
 #include "gjs/mainloop.h"
 #include "gjs/profiler.h"
 #include "gjs/promise.h"
+#include "gjs/timers.h"
 
 class GjsAtoms;
 class JSTracer;
 
-using JobQueueStorage =
-    JS::GCVector<JS::Heap<JSObject*>, 0, js::SystemAllocPolicy>;
 using ObjectInitList =
     JS::GCVector<JS::Heap<JSObject*>, 0, js::SystemAllocPolicy>;
 using FundamentalTable =
@@ -67,6 +67,10 @@ class GjsContextPrivate : public JS::JobQueue {
     using DestroyNotify = void (*)(JSContext*, void* data);
 
  private:
+    // Maximum number of FinalizationRegistry cleanup tasks to run between two
+    // promise jobs
+    static constexpr size_t FINALIZATION_REGISTRY_BUDGET = 32;
+
     struct destroy_data_hash {
         size_t operator()(const std::pair<DestroyNotify, void*>& p) const {
             return std::hash<size_t>()(reinterpret_cast<size_t>(p.second));
@@ -93,8 +97,9 @@ class GjsContextPrivate : public JS::JobQueue {
 
     std::vector<std::string> m_args;
 
-    JobQueueStorage m_job_queue;
+    Gjs::JobQueueStorage m_job_queue;
     Gjs::PromiseJobDispatcher m_dispatcher;
+    Gjs::TimerQueue m_timers;
     Gjs::MainLoop m_main_loop;
     Gjs::AutoUnref<GMemoryMonitor> m_memory_monitor;
 
@@ -197,6 +202,7 @@ class GjsContextPrivate : public JS::JobQueue {
     }
     void main_loop_hold() { m_main_loop.hold(); }
     void main_loop_release() { m_main_loop.release(); }
+    [[nodiscard]] Gjs::TimerQueue& timers() { return m_timers; }
     [[nodiscard]] GjsProfiler* profiler() const { return m_profiler; }
     [[nodiscard]] const GjsAtoms& atoms() const { return *m_atoms; }
     [[nodiscard]] bool destroying() const { return m_destroying.load(); }
@@ -283,7 +289,8 @@ class GjsContextPrivate : public JS::JobQueue {
     void unregister_unhandled_promise_rejection(uint64_t id);
     GJS_JSAPI_RETURN_CONVENTION bool queue_finalization_registry_cleanup(
         JSFunction* cleanup_task);
-    GJS_JSAPI_RETURN_CONVENTION bool run_finalization_registry_cleanup();
+    GJS_JSAPI_RETURN_CONVENTION bool run_finalization_registry_cleanup(
+        size_t budget = SIZE_MAX);
 
     void register_notifier(DestroyNotify notify_func, void* data);
     void unregister_notifier(DestroyNotify notify_func, void* data);
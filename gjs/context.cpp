@@ -4,6 +4,7 @@
 
 #include <config.h>
 
+#include <errno.h>
 #include <signal.h>  // for sigaction, SIGUSR1, sa_handler
 #include <stdint.h>
 #include <stdio.h>   // for FILE, fclose, size_t
@@ -73,10 +74,14 @@
 #include <mozilla/UniquePtr.h>  // for UniquePtr::get
 
 #include "gi/closure.h"  // for Closure::Ptr, Closure
+#include "gi/dbus.h"
 #include "gi/function.h"
 #include "gi/object.h"
 #include "gi/private.h"
 #include "gi/repo.h"
+#include "gi/source.h"
+#include "gi/variant.h"
+#include "gi/wrapper-stats.h"
 #include "gjs/atoms.h"
 #include "gjs/auto.h"
 #include "gjs/byteArray.h"
@@ -86,10 +91,12 @@
 #include "gjs/error-types.h"
 #include "gjs/gerror-result.h"
 #include "gjs/global.h"
+#include "gjs/heap-snapshot.h"
 #include "gjs/importer.h"
 #include "gjs/internal.h"
 #include "gjs/jsapi-util.h"
 #include "gjs/mainloop.h"
+#include "gjs/mem-private.h"
 #include "gjs/mem.h"
 #include "gjs/module.h"
 #include "gjs/native.h"
@@ -98,6 +105,8 @@
 #include "gjs/profiler.h"
 #include "gjs/promise.h"
 #include "gjs/text-encoding.h"
+#include "gjs/timers.h"
+#include "gjs/worker.h"
 #include "modules/cairo-module.h"
 #include "modules/console.h"
 #include "modules/print.h"
@@ -172,6 +181,60 @@ static Gjs::AutoChar dump_heap_output;
 static unsigned dump_heap_idle_id = 0;
 
 #ifdef G_OS_UNIX
+// One file per context, since a .heapsnapshot file holds only one heap
+static void gjs_context_dump_heap_snapshots(const char* filename) {
+    unsigned n_contexts = 0;
+
+    g_mutex_lock(&contexts_lock);
+    for (GList *l = all_contexts; l; l = g_list_next(l)) {
+        GjsContextPrivate* gjs =
+            GjsContextPrivate::from_object(static_cast<GjsContext*>(l->data));
+        if (!gjs->is_owner_thread())
+            continue;
+
+        Gjs::AutoChar snapshot_filename{
+            n_contexts == 0
+                ? g_strdup_printf("%s.heapsnapshot", filename)
+                : g_strdup_printf("%s.%u.heapsnapshot", filename, n_contexts)};
+        ++n_contexts;
+
+        FILE* fp = fopen(snapshot_filename, "w");
+        if (!fp) {
+            g_warning("Could not open %s to write a heap snapshot: %s",
+                      snapshot_filename.get(), g_strerror(errno));
+            continue;
+        }
+        if (!Gjs::write_heap_snapshot(gjs->context(), fp))
+            g_warning("Could not write heap snapshot to %s",
+                      snapshot_filename.get());
+        fclose(fp);
+    }
+    g_mutex_unlock(&contexts_lock);
+}
+
+static void gjs_context_dump_js_heaps(const char* filename) {
+    FILE *fp = fopen(filename, "w");
+    if (!fp) {
+        g_warning("Could not open %s to dump the heap: %s", filename,
+                  g_strerror(errno));
+        return;
+    }
+
+    // Workers may create and destroy contexts concurrently
+    g_mutex_lock(&contexts_lock);
+    for (GList *l = all_contexts; l; l = g_list_next(l)) {
+        GjsContextPrivate* gjs =
+            GjsContextPrivate::from_object(static_cast<GjsContext*>(l->data));
+        // Contexts running on other threads (workers) can't be touched here
+        if (!gjs->is_owner_thread())
+            continue;
+        js::DumpHeap(gjs->context(), fp, js::CollectNurseryBeforeDump);
+    }
+    g_mutex_unlock(&contexts_lock);
+
+    fclose(fp);
+}
+
 // Currently heap dumping via SIGUSR1 is only supported on UNIX platforms!
 // This can reduce performance. See note in system.cpp on System.dumpHeap().
 static void
@@ -186,16 +249,20 @@ gjs_context_dump_heaps(void)
                                            intmax_t(getpid()), counter)};
     ++counter;
 
-    FILE *fp = fopen(filename, "w");
-    if (!fp)
-        return;
-
-    for (GList *l = all_contexts; l; l = g_list_next(l)) {
-        auto* gjs = static_cast<GjsContextPrivate*>(l->data);
-        js::DumpHeap(gjs->context(), fp, js::CollectNurseryBeforeDump);
-    }
+    if (g_strcmp0(g_getenv("GJS_DEBUG_HEAP_FORMAT"), "heapsnapshot") == 0)
+        gjs_context_dump_heap_snapshots(filename);
+    else
+        gjs_context_dump_js_heaps(filename);
 
-    fclose(fp);
+    // Which types the wrappers in the heap dump belong to, and where they were
+    // created
+    Gjs::AutoChar stats_filename{
+        g_strdup_printf("%s.wrappers.json", filename.get())};
+    std::string stats{Gjs::WrapperStats::to_json()};
+    Gjs::AutoError error;
+    if (!g_file_set_contents(stats_filename, stats.c_str(), stats.size(),
+                             &error))
+        g_warning("Could not write wrapper statistics: %s", error->message);
 }
 
 static gboolean dump_heap_idle(void*) {
@@ -363,8 +430,13 @@ gjs_context_class_init(GjsContextClass *klass)
     }
     auto& registry = Gjs::NativeModuleDefineFuncs::get();
     registry.add("_promiseNative", gjs_define_native_promise_stuff);
+    registry.add("_timersNative", gjs_define_timers_stuff);
     registry.add("_byteArrayNative", gjs_define_byte_array_stuff);
     registry.add("_encodingNative", gjs_define_text_encoding_stuff);
+    registry.add("_variantNative", gjs_define_variant_stuff);
+    registry.add("_dbusNative", gjs_define_dbus_stuff);
+    registry.add("_sourceNative", gjs_define_source_stuff);
+    registry.add("_workerNative", gjs_define_worker_stuff);
     registry.add("_gi", gjs_define_private_gi_stuff);
     registry.add("gi", gjs_define_repo);
     registry.add("cairoNative", gjs_js_define_cairo_stuff);
@@ -381,6 +453,7 @@ void GjsContextPrivate::trace(JSTracer* trc, void* data) {
     JS::TraceEdge<JSObject*>(trc, &gjs->m_main_loop_hook, "GJS main loop hook");
     gjs->m_atoms->trace(trc);
     gjs->m_job_queue.trace(trc);
+    gjs->m_timers.trace(trc);
     gjs->m_cleanup_tasks.trace(trc);
     gjs->m_object_init_list.trace(trc);
 }
@@ -449,6 +522,15 @@ void GjsContextPrivate::dispose(void) {
     if (m_cx) {
         stop_draining_job_queue();
 
+        gjs_debug(GJS_DEBUG_CONTEXT, "Cancelling pending timers");
+        m_timers.clear();
+
+        gjs_debug(GJS_DEBUG_CONTEXT, "Waiting for workers to exit");
+        Gjs::Worker::terminate_all();
+
+        gjs_debug(GJS_DEBUG_CONTEXT, "Waiting for async calls to finish");
+        gjs_function_finish_async_calls();
+
         gjs_debug(GJS_DEBUG_CONTEXT,
                   "Notifying reference holders of GjsContext dispose");
 
@@ -483,7 +565,10 @@ void GjsContextPrivate::dispose(void) {
 
         gjs_debug(GJS_DEBUG_CONTEXT, "Disabling auto GC");
         if (m_auto_gc_id > 0) {
-            g_source_remove(m_auto_gc_id);
+            GSource* source = g_main_context_find_source_by_id(
+                g_main_context_get_thread_default(), m_auto_gc_id);
+            if (source)
+                g_source_destroy(source);
             m_auto_gc_id = 0;
         }
 
@@ -498,7 +583,10 @@ void GjsContextPrivate::dispose(void) {
         delete m_gtype_table;
         delete m_atoms;
 
+        GJS_ADD_STAT(microtask_queue_length, -int64_t(m_job_queue.length()));
         m_job_queue.clear();
+        GJS_ADD_STAT(pending_cleanup_tasks, -int64_t(m_cleanup_tasks.length()));
+        m_cleanup_tasks.clear();
         m_object_init_list.clear();
 
         /* Tear down JS */
@@ -680,6 +768,7 @@ GjsContextPrivate::GjsContextPrivate(JSContext* cx, GjsContext* public_context)
       m_cx(cx),
       m_owner_thread(std::this_thread::get_id()),
       m_dispatcher(this),
+      m_timers(this),
       m_memory_monitor(g_memory_monitor_dup_default()),
       m_environment_preparer(cx) {
     JS_SetGCCallback(
@@ -928,14 +1017,20 @@ void GjsContextPrivate::schedule_gc_internal(bool force_gc) {
     if (force_gc)
         gjs_debug_lifecycle(GJS_DEBUG_CONTEXT, "Big Hammer scheduled");
 
-    m_auto_gc_id = g_timeout_add_seconds_full(G_PRIORITY_LOW, 10,
-                                              trigger_gc_if_needed, this,
-                                              nullptr);
+    // Attach to the thread-default main context rather than the global default
+    // one, since the context may be running in a worker thread
+    Gjs::AutoPointer<GSource, GSource, g_source_unref> source{
+        g_timeout_source_new_seconds(10)};
+    g_source_set_priority(source, G_PRIORITY_LOW);
+    g_source_set_callback(source, trigger_gc_if_needed, this, nullptr);
 
     if (force_gc)
-        g_source_set_name_by_id(m_auto_gc_id, "[gjs] Garbage Collection (Big Hammer)");
+        g_source_set_name(source, "[gjs] Garbage Collection (Big Hammer)");
     else
-        g_source_set_name_by_id(m_auto_gc_id, "[gjs] Garbage Collection");
+        g_source_set_name(source, "[gjs] Garbage Collection");
+
+    Gjs::AutoMainContext main_context{g_main_context_ref_thread_default()};
+    m_auto_gc_id = g_source_attach(source, main_context);
 }
 
 /*
@@ -968,6 +1063,7 @@ void GjsContextPrivate::on_garbage_collection(JSGCStatus status, JS::GCReason re
             // up queued when they are garbage collected.
             gjs_object_clear_toggles();
 
+            GJS_ADD_STAT(async_closures, -int64_t(m_async_closures.size()));
             m_async_closures.clear();
             m_async_closures.shrink_to_fit();
             break;
@@ -1024,10 +1120,8 @@ bool GjsContextPrivate::enqueuePromiseJob(JSContext* cx [[maybe_unused]],
               gjs_debug_object(job).c_str(), gjs_debug_object(promise).c_str(),
               gjs_debug_object(allocation_site).c_str());
 
-    if (!m_job_queue.append(job)) {
-        JS_ReportOutOfMemory(m_cx);
-        return false;
-    }
+    m_job_queue.append(job);
+    GJS_ADD_STAT(microtask_queue_length, 1);
 
     JS::JobQueueMayNotBeEmpty(m_cx);
     m_dispatcher.start();
@@ -1067,7 +1161,7 @@ bool GjsContextPrivate::run_jobs_fallible() {
     JS::HandleValueArray args(JS::HandleValueArray::empty());
     JS::RootedValue rval(m_cx);
 
-    if (m_job_queue.length() == 0) {
+    if (m_job_queue.empty()) {
         // Check FinalizationRegistry cleanup tasks at least once if there are
         // no microtasks queued. This may enqueue more microtasks, which will be
         // appended to m_job_queue.
@@ -1075,27 +1169,21 @@ bool GjsContextPrivate::run_jobs_fallible() {
             retval = false;
     }
 
-    /* Execute jobs in a loop until we've reached the end of the queue.
-     * Since executing a job can trigger enqueueing of additional jobs,
-     * it's crucial to recheck the queue length during each iteration. */
-    for (size_t ix = 0; ix < m_job_queue.length(); ix++) {
+    /* Execute jobs in a loop until the queue is empty. Executing a job can
+     * trigger enqueueing of additional jobs, which are run in the same loop. */
+    for (size_t ix = 0; !m_job_queue.empty(); ix++) {
         /* A previous job might have set this flag. e.g., System.exit(). */
         if (m_should_exit || !m_dispatcher.is_running()) {
             gjs_debug(GJS_DEBUG_MAINLOOP, "Stopping jobs because of %s",
                       m_should_exit ? "exit" : "main loop cancel");
+            GJS_ADD_STAT(microtask_queue_length,
+                         -int64_t(m_job_queue.length()));
+            m_job_queue.clear();
             break;
         }
 
-        job = m_job_queue[ix];
-
-        /* It's possible that job draining was interrupted prematurely,
-         * leaving the queue partly processed. In that case, slots for
-         * already-executed entries will contain nullptrs, which we should
-         * just skip. */
-        if (!job)
-            continue;
-
-        m_job_queue[ix] = nullptr;
+        job = m_job_queue.take_first();
+        GJS_ADD_STAT(microtask_queue_length, -1);
         {
             JSAutoRealm ar(m_cx, job);
             gjs_debug(GJS_DEBUG_MAINLOOP, "handling job %zu, %s", ix,
@@ -1119,25 +1207,54 @@ bool GjsContextPrivate::run_jobs_fallible() {
         }
         gjs_debug(GJS_DEBUG_MAINLOOP, "Completed job %zu", ix);
 
-        // Run FinalizationRegistry cleanup tasks after each job. Cleanup tasks
-        // may enqueue more microtasks, which will be appended to m_job_queue.
-        if (!run_finalization_registry_cleanup())
-            retval = false;
+        // Run FinalizationRegistry cleanup tasks queued by a garbage collection
+        // during the job. Cleanup tasks may enqueue more microtasks, which will
+        // be appended to m_job_queue. While other jobs are pending, only a
+        // limited batch is run, so that a collection that queued many of them
+        // doesn't hold up the microtasks; the rest are picked up after the
+        // following jobs.
+        if (!m_cleanup_tasks.empty()) {
+            size_t budget = m_job_queue.empty() ? SIZE_MAX
+                                                : FINALIZATION_REGISTRY_BUDGET;
+            if (!run_finalization_registry_cleanup(budget))
+                retval = false;
+        }
     }
 
     m_draining_job_queue = false;
-    m_job_queue.clear();
     warn_about_unhandled_promise_rejections();
     JS::JobQueueIsEmpty(m_cx);
     return retval;
 }
 
-bool GjsContextPrivate::run_finalization_registry_cleanup() {
+/*
+ * GjsContext::run_finalization_registry_cleanup:
+ * @budget: the maximum number of cleanup tasks to run
+ *
+ * Runs the FinalizationRegistry cleanup tasks that the JS engine has queued
+ * since the last call, oldest first, up to @budget of them. Any others are left
+ * queued.
+ *
+ * Returns: false if one of the tasks threw an uncatchable exception; otherwise
+ * true.
+ */
+bool GjsContextPrivate::run_finalization_registry_cleanup(size_t budget) {
     bool retval = true;
 
     JS::Rooted<FunctionVector> tasks{m_cx};
-    std::swap(tasks.get(), m_cleanup_tasks);
-    g_assert(m_cleanup_tasks.empty());
+    if (m_cleanup_tasks.length() <= budget) {
+        std::swap(tasks.get(), m_cleanup_tasks);
+        g_assert(m_cleanup_tasks.empty());
+        GJS_ADD_STAT(pending_cleanup_tasks, -int64_t(tasks.length()));
+    } else {
+        JSFunction** batch_end = m_cleanup_tasks.begin() + budget;
+        if (!tasks.append(m_cleanup_tasks.begin(), batch_end)) {
+            JS_ReportOutOfMemory(m_cx);
+            return false;
+        }
+        m_cleanup_tasks.erase(m_cleanup_tasks.begin(), batch_end);
+        GJS_ADD_STAT(pending_cleanup_tasks, -int64_t(budget));
+    }
 
     JS::RootedFunction task{m_cx};
     JS::RootedValue unused_rval{m_cx};
@@ -1173,7 +1290,7 @@ bool GjsContextPrivate::run_finalization_registry_cleanup() {
 class GjsContextPrivate::SavedQueue : public JS::JobQueue::SavedJobQueue {
  private:
     GjsContextPrivate* m_gjs;
-    JS::PersistentRooted<JobQueueStorage> m_queue;
+    JS::PersistentRooted<Gjs::JobQueueStorage> m_queue;
     bool m_was_draining : 1;
 
  public:
@@ -1226,7 +1343,10 @@ void GjsContextPrivate::unregister_unhandled_promise_rejection(uint64_t id) {
 
 bool GjsContextPrivate::queue_finalization_registry_cleanup(
     JSFunction* cleanup_task) {
-    return m_cleanup_tasks.append(cleanup_task);
+    if (!m_cleanup_tasks.append(cleanup_task))
+        return false;
+    GJS_ADD_STAT(pending_cleanup_tasks, 1);
+    return true;
 }
 
 void GjsContextPrivate::async_closure_enqueue_for_gc(Gjs::Closure* trampoline) {
@@ -1235,6 +1355,7 @@ void GjsContextPrivate::async_closure_enqueue_for_gc(Gjs::Closure* trampoline) {
     //  will be freed the next time gc happens
     g_assert(!trampoline->context() || trampoline->context() == m_cx);
     m_async_closures.emplace_back(trampoline);
+    GJS_ADD_STAT(async_closures, 1);
 }
 
 /**
@@ -1840,12 +1961,18 @@ void gjs_context_set_argv(GjsContext* js_context, ssize_t array_length,
     gjs->set_args(std::move(args));
 }
 
-static GjsContext *current_context;
+// Each thread can run one GjsContext (see gjs/worker.cpp.) Threads that don't
+// have a context of their own, such as GLib's worker threads emitting toggle
+// notifications, get the context that was made current first.
+static GjsContext* default_context;
+static thread_local GjsContext* current_context;
 
 GjsContext *
 gjs_context_get_current (void)
 {
-    return current_context;
+    if (current_context)
+        return current_context;
+    return static_cast<GjsContext*>(g_atomic_pointer_get(&default_context));
 }
 
 void
@@ -1853,6 +1980,14 @@ gjs_context_make_current (GjsContext *context)
 {
     g_assert (context == NULL || current_context == NULL);
 
+    if (context) {
+        g_atomic_pointer_compare_and_exchange(&default_context, nullptr,
+                                              context);
+    } else if (current_context) {
+        g_atomic_pointer_compare_and_exchange(&default_context,
+                                              current_context, nullptr);
+    }
+
     current_context = context;
 }
 
@@ -6,6 +6,7 @@
 
 #include <cstddef>        // for size_t
 #include <functional>     // for hash<int>
+#include <mutex>
 #include <sstream>
 #include <string>         // for string
 #include <string_view>
@@ -78,6 +79,9 @@ struct hash<DeprecationEntry> {
 };
 };  // namespace std
 
+// Shared by the contexts of all threads, so that each message is only logged
+// once per process
+static std::mutex logged_messages_lock;
 static std::unordered_set<DeprecationEntry> logged_messages;
 
 GJS_JSAPI_RETURN_CONVENTION
@@ -101,11 +105,15 @@ static void warn_deprecated_unsafe_internal(JSContext* cx,
                                             const char* msg) {
     JS::UniqueChars callsite(get_callsite(cx));
     DeprecationEntry entry(id, callsite.get());
-    if (!logged_messages.count(entry)) {
+    bool inserted;
+    {
+        std::lock_guard<std::mutex> lock{logged_messages_lock};
+        inserted = logged_messages.insert(std::move(entry)).second;
+    }
+    if (inserted) {
         JS::UniqueChars stack_dump =
             JS::FormatStackDump(cx, false, false, false);
         g_warning("%s\n%s", msg, stack_dump.get());
-        logged_messages.insert(std::move(entry));
     }
 }
 
@@ -0,0 +1,318 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#include <config.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>  // for strcmp
+
+#include <algorithm>  // for stable_sort
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>  // for pair
+#include <vector>
+
+#include <glib-object.h>
+#include <glib.h>
+
+#include <js/Class.h>
+#include <js/GCAPI.h>  // for AutoCheckCannotGC
+#include <js/TypeDecls.h>
+#include <js/UbiNode.h>
+#include <js/UbiNodeBreadthFirst.h>
+#include <jsapi.h>  // for JS_GC, JS_ObjectIsFunction
+
+#include "gi/object.h"
+#include "gjs/auto.h"
+#include "gjs/heap-snapshot.h"
+#include "gjs/jsapi-util.h"
+#include "gjs/mem-private.h"
+
+namespace Gjs {
+
+/*
+ * HeapSnapshotWriter:
+ *
+ * Handler for a breadth-first traversal of the heap with JS::ubi::Node, which
+ * records each node and edge, to write them in the .heapsnapshot format once
+ * the traversal is done. No GC can happen during the traversal, so this must
+ * not call anything that could run JS or allocate GC things.
+ */
+class HeapSnapshotWriter {
+ public:
+    struct NodeData {};
+    using Traversal = JS::ubi::BreadthFirst<HeapSnapshotWriter>;
+
+ private:
+    // Indices in the node_types and edge_types of the snapshot's metadata
+    enum NodeType : uint8_t {
+        HIDDEN = 0,
+        ARRAY = 1,
+        STRING = 2,
+        OBJECT = 3,
+        CODE = 4,
+        CLOSURE = 5,
+        REGEXP = 6,
+        NATIVE = 8,
+        SYNTHETIC = 9,
+        SYMBOL = 12,
+        BIGINT = 13,
+        OBJECT_SHAPE = 14,
+    };
+    enum EdgeType : uint8_t { PROPERTY = 2, INTERNAL = 3 };
+
+    struct Node {
+        uint64_t id;
+        uint64_t self_size;
+        uint32_t name;
+        uint32_t edge_count;
+        NodeType type;
+    };
+    struct Edge {
+        uint32_t from;
+        uint32_t to;
+        uint32_t name;
+        EdgeType type;
+    };
+    struct Kind {
+        NodeType type;
+        uint32_t name;
+    };
+
+    std::vector<Node> m_nodes;
+    std::vector<Edge> m_edges;
+    std::unordered_map<JS::ubi::Node::Id, uint32_t> m_node_indices;
+    std::unordered_map<std::string, uint32_t> m_string_indices;
+    // typeName() returns one static string for each kind of GC thing
+    std::unordered_map<const char16_t*, Kind> m_kinds;
+
+    [[nodiscard]] uint32_t string_index(const std::string& str);
+    [[nodiscard]] Kind kind_of(const JS::ubi::Node& node);
+    uint32_t add_node(uint64_t id, NodeType type, uint32_t name,
+                      uint64_t self_size);
+    void add_object(uint32_t index, JSObject* obj);
+
+ public:
+    // The first string must be the empty string, for unnamed edges
+    HeapSnapshotWriter() { (void)string_index(""); }
+
+    void add_ubi_node(const JS::ubi::Node& node);
+    bool operator()(Traversal&, JS::ubi::Node origin,
+                    const JS::ubi::Edge& edge, NodeData*, bool first);
+    [[nodiscard]] bool write(FILE* fp);
+};
+
+uint32_t HeapSnapshotWriter::string_index(const std::string& str) {
+    return m_string_indices.try_emplace(str, m_string_indices.size())
+        .first->second;
+}
+
+HeapSnapshotWriter::Kind HeapSnapshotWriter::kind_of(
+    const JS::ubi::Node& node) {
+    const char16_t* type_name = node.typeName();
+    auto it = m_kinds.find(type_name);
+    if (it != m_kinds.end())
+        return it->second;
+
+    std::u16string_view type{type_name};
+    NodeType type_id = HIDDEN;
+    if (type == u"JSObject")
+        type_id = OBJECT;
+    else if (type == u"JSString")
+        type_id = STRING;
+    else if (type == u"JS::Symbol")
+        type_id = SYMBOL;
+    else if (type == u"JS::BigInt")
+        type_id = BIGINT;
+    else if (type == u"js::BaseScript" || type == u"js::jit::JitCode")
+        type_id = CODE;
+    else if (type == u"js::Shape" || type == u"js::BaseShape")
+        type_id = OBJECT_SHAPE;
+
+    AutoChar name{
+        g_utf16_to_utf8(reinterpret_cast<const gunichar2*>(type_name), -1,
+                        nullptr, nullptr, nullptr)};
+    Kind kind{type_id, string_index(name ? name.get() : "(unknown)")};
+    m_kinds.emplace(type_name, kind);
+    return kind;
+}
+
+uint32_t HeapSnapshotWriter::add_node(uint64_t id, NodeType type,
+                                      uint32_t name, uint64_t self_size) {
+    uint32_t index = m_nodes.size();
+    m_nodes.push_back({id, self_size, name, 0, type});
+    m_node_indices.emplace(id, index);
+    return index;
+}
+
+void HeapSnapshotWriter::add_ubi_node(const JS::ubi::Node& node) {
+    Kind kind = kind_of(node);
+    uint32_t index =
+        add_node(node.identifier(), kind.type, kind.name,
+                 node.size(Memory::malloc_size_of));
+
+    if (node.is<JSObject>())
+        add_object(index, node.as<JSObject>());
+    else if (node.is<JS::ubi::RootList>())
+        m_nodes[index] = {0, 0, string_index("(GC roots)"), 0, SYNTHETIC};
+}
+
+// Objects are named after their class, except for the wrappers of GObjects,
+// which are named after their GType, and point to a node for the GObject
+void HeapSnapshotWriter::add_object(uint32_t index, JSObject* obj) {
+    const JSClass* klass = JS::GetClass(obj);
+    m_nodes[index].name = string_index(klass->name);
+    if (JS_ObjectIsFunction(obj))
+        m_nodes[index].type = CLOSURE;
+    else if (strcmp(klass->name, "Array") == 0)
+        m_nodes[index].type = ARRAY;
+    else if (strcmp(klass->name, "RegExp") == 0)
+        m_nodes[index].type = REGEXP;
+
+    if (klass != &ObjectBase::klass)
+        return;
+    ObjectBase* priv = ObjectBase::for_js_nocheck(obj);
+    if (!priv || priv->is_prototype())
+        return;
+
+    ObjectInstance* instance = priv->to_instance();
+    m_nodes[index].name = string_index(instance->type_name());
+
+    GObject* gobj = instance->ptr();
+    if (!gobj)
+        return;
+
+    // A finalized GObject must not be read, and its address may have been
+    // reused by another GObject, so give it an ID that no live GObject has;
+    // the low bit of a GObject's address is always 0
+    bool finalized = instance->is_finalized();
+    auto gobj_id = uint64_t(reinterpret_cast<uintptr_t>(gobj)) |
+                   uint64_t(finalized);
+    if (m_node_indices.count(gobj_id))
+        return;
+
+    GTypeQuery query;
+    g_type_query(instance->gtype(), &query);
+    AutoChar name{g_strdup_printf("[GObject] %s%s", instance->type_name(),
+                                  finalized ? " (finalized)" : "")};
+    uint32_t gobj_index = add_node(gobj_id, NATIVE, string_index(name.get()),
+                                   query.instance_size);
+
+    AutoChar edge_name{
+        finalized ? g_strdup("gobject (finalized)")
+                  : g_strdup_printf("gobject (refcount %u, %s)",
+                                    gobj->ref_count,
+                                    instance->toggle_ref_state())};
+    m_edges.push_back(
+        {index, gobj_index, string_index(edge_name.get()), INTERNAL});
+}
+
+bool HeapSnapshotWriter::operator()(Traversal&, JS::ubi::Node origin,
+                                    const JS::ubi::Edge& edge, NodeData*,
+                                    bool first) {
+    if (first)
+        add_ubi_node(edge.referent);
+
+    uint32_t name = 0;  // the empty string
+    if (edge.name) {
+        AutoChar utf8{g_utf16_to_utf8(
+            reinterpret_cast<const gunichar2*>(edge.name.get()), -1, nullptr,
+            nullptr, nullptr)};
+        if (utf8)
+            name = string_index(utf8.get());
+    }
+
+    m_edges.push_back({m_node_indices.at(origin.identifier()),
+                       m_node_indices.at(edge.referent.identifier()), name,
+                       edge.name ? PROPERTY : INTERNAL});
+    return true;
+}
+
+bool HeapSnapshotWriter::write(FILE* fp) {
+    // The edges of each node must follow each other, in the order of the nodes
+    std::stable_sort(
+        m_edges.begin(), m_edges.end(),
+        [](const Edge& a, const Edge& b) { return a.from < b.from; });
+    for (const Edge& edge : m_edges)
+        m_nodes[edge.from].edge_count++;
+
+    constexpr unsigned N_NODE_FIELDS = 7;
+    fprintf(fp,
+            "{\"snapshot\":{\"meta\":{"
+            "\"node_fields\":[\"type\",\"name\",\"id\",\"self_size\","
+            "\"edge_count\",\"trace_node_id\",\"detachedness\"],"
+            "\"node_types\":[[\"hidden\",\"array\",\"string\",\"object\","
+            "\"code\",\"closure\",\"regexp\",\"number\",\"native\","
+            "\"synthetic\",\"concatenated string\",\"sliced string\","
+            "\"symbol\",\"bigint\",\"object shape\"],\"string\",\"number\","
+            "\"number\",\"number\",\"number\",\"number\"],"
+            "\"edge_fields\":[\"type\",\"name_or_index\",\"to_node\"],"
+            "\"edge_types\":[[\"context\",\"element\",\"property\","
+            "\"internal\",\"hidden\",\"shortcut\",\"weak\"],"
+            "\"string_or_number\",\"node\"],"
+            "\"trace_function_info_fields\":[],\"trace_node_fields\":[],"
+            "\"sample_fields\":[],\"location_fields\":[]},"
+            "\"node_count\":%zu,\"edge_count\":%zu,"
+            "\"trace_function_count\":0},\n\"nodes\":[",
+            m_nodes.size(), m_edges.size());
+
+    bool first = true;
+    for (const Node& node : m_nodes) {
+        fprintf(fp,
+                "%s%u,%u,%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT ",%u,0,0",
+                first ? "\n" : ",\n", unsigned(node.type), node.name,
+                node.id, node.self_size, node.edge_count);
+        first = false;
+    }
+
+    fputs("],\n\"edges\":[", fp);
+    first = true;
+    for (const Edge& edge : m_edges) {
+        fprintf(fp, "%s%u,%u,%u", first ? "\n" : ",\n", unsigned(edge.type),
+                edge.name, edge.to * N_NODE_FIELDS);
+        first = false;
+    }
+
+    fputs(
+        "],\n\"trace_function_infos\":[],\"trace_tree\":[],\"samples\":[],"
+        "\"locations\":[],\n\"strings\":[",
+        fp);
+    std::vector<const std::string*> strings(m_string_indices.size());
+    for (const auto& [str, index] : m_string_indices)
+        strings[index] = &str;
+    first = true;
+    for (const std::string* str : strings) {
+        fputs(first ? "\n" : ",\n", fp);
+        first = false;
+        std::string quoted{gjs_json_quote(*str)};
+        fwrite(quoted.data(), 1, quoted.size(), fp);
+    }
+    fputs("]}\n", fp);
+
+    return !ferror(fp) && fflush(fp) == 0;
+}
+
+bool write_heap_snapshot(JSContext* cx, FILE* fp) {
+    JS_GC(cx);
+
+    HeapSnapshotWriter writer;
+    JS::ubi::RootList roots{cx, /* wantNames = */ true};
+    auto [ok, nogc] = roots.init();
+    if (!ok)
+        return false;
+
+    JS::ubi::Node root{&roots};
+    writer.add_ubi_node(root);
+
+    HeapSnapshotWriter::Traversal traversal{cx, writer, nogc};
+    traversal.wantNames = true;
+    if (!traversal.addStartVisited(root) || !traversal.traverse())
+        return false;
+
+    return writer.write(fp);
+}
+
+}  // namespace Gjs
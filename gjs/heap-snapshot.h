@@ -0,0 +1,24 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#pragma once
+
+#include <config.h>
+
+#include <stdio.h>  // for FILE
+
+#include <js/TypeDecls.h>
+
+namespace Gjs {
+
+// Writes a snapshot of the JS heap of @cx to @fp, in the .heapsnapshot format
+// of the Chrome DevTools. The wrappers of GObjects point to a node for the
+// GObject itself, with the GObject's size, reference count, and toggle
+// reference state. This runs a full garbage collection first, so that only
+// live objects are in the snapshot.
+//
+// Returns false on out of memory, or if writing to @fp failed.
+[[nodiscard]] bool write_heap_snapshot(JSContext* cx, FILE* fp);
+
+}  // namespace Gjs
@@ -0,0 +1,115 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#include <config.h>
+
+#include <stddef.h>  // for size_t
+
+#include <memory>
+#include <utility>  // for exchange, move
+
+#include <glib.h>
+
+#include <js/RootingAPI.h>
+#include <js/TracingAPI.h>
+#include <js/TypeDecls.h>
+
+#include "gjs/job-queue.h"
+
+namespace Gjs {
+
+JobQueueStorage::JobQueueStorage(JobQueueStorage&& other) noexcept
+    : m_first(std::move(other.m_first)),
+      m_last(std::exchange(other.m_last, nullptr)),
+      m_spare(std::move(other.m_spare)),
+      m_head(std::exchange(other.m_head, 0)),
+      m_tail(std::exchange(other.m_tail, 0)),
+      m_length(std::exchange(other.m_length, 0)) {}
+
+JobQueueStorage& JobQueueStorage::operator=(JobQueueStorage&& other) noexcept {
+    if (this != &other) {
+        clear();
+        m_first = std::move(other.m_first);
+        m_last = std::exchange(other.m_last, nullptr);
+        m_spare = std::move(other.m_spare);
+        m_head = std::exchange(other.m_head, 0);
+        m_tail = std::exchange(other.m_tail, 0);
+        m_length = std::exchange(other.m_length, 0);
+    }
+    return *this;
+}
+
+void JobQueueStorage::append(JSObject* job) {
+    if (!m_last || m_tail == CHUNK_SIZE) {
+        std::unique_ptr<Chunk> chunk =
+            m_spare ? std::move(m_spare) : std::make_unique<Chunk>();
+        Chunk* new_last = chunk.get();
+
+        if (m_last) {
+            m_last->next = std::move(chunk);
+        } else {
+            m_first = std::move(chunk);
+            m_head = 0;
+        }
+        m_last = new_last;
+        m_tail = 0;
+    }
+
+    m_last->jobs[m_tail++] = job;
+    m_length++;
+}
+
+// All the slots of the first chunk have already been cleared by take_first(),
+// so it can be reused as it is
+void JobQueueStorage::release_first_chunk() {
+    std::unique_ptr<Chunk> chunk = std::exchange(m_first, nullptr);
+    m_first = std::move(chunk->next);
+    m_head = 0;
+    if (!m_first)
+        m_last = nullptr;
+
+    if (!m_spare)
+        m_spare = std::move(chunk);
+}
+
+JSObject* JobQueueStorage::take_first() {
+    g_assert(m_length > 0 && "taking a job from an empty queue");
+
+    JS::Heap<JSObject*>& slot = m_first->jobs[m_head++];
+    JSObject* job = slot;
+    slot = nullptr;
+    m_length--;
+
+    if (m_head == CHUNK_SIZE) {
+        release_first_chunk();
+    } else if (m_length == 0) {
+        // The first chunk is also the last one; start filling it over
+        m_head = m_tail = 0;
+    }
+
+    return job;
+}
+
+void JobQueueStorage::clear() {
+    // Release the chunks one by one, rather than recursively through the
+    // destructors of Chunk::next, to avoid deep recursion on long queues
+    while (m_first) {
+        std::unique_ptr<Chunk> chunk = std::exchange(m_first, nullptr);
+        m_first = std::move(chunk->next);
+    }
+    m_last = nullptr;
+    m_spare.reset();
+    m_head = m_tail = m_length = 0;
+}
+
+void JobQueueStorage::trace(JSTracer* trc) {
+    for (Chunk* chunk = m_first.get(); chunk; chunk = chunk->next.get()) {
+        size_t begin = chunk == m_first.get() ? m_head : 0;
+        size_t end = chunk == m_last ? m_tail : CHUNK_SIZE;
+        for (size_t ix = begin; ix < end; ix++)
+            JS::TraceEdge(trc, &chunk->jobs[ix], "job queue");
+    }
+}
+
+};  // namespace Gjs
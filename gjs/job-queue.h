@@ -0,0 +1,73 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#pragma once
+
+#include <config.h>
+
+#include <stddef.h>  // for size_t
+
+#include <memory>
+
+#include <js/RootingAPI.h>
+#include <js/TypeDecls.h>
+
+class JSTracer;
+
+namespace Gjs {
+
+/**
+ * JobQueueStorage:
+ *
+ * First-in, first-out storage for pending promise jobs. Jobs are stored in
+ * fixed-size chunks, and a chunk is released as soon as all of its jobs have
+ * been taken. So a chain of promises that keeps enqueueing jobs while the
+ * queue is being drained runs in constant memory, instead of growing the queue
+ * until it is completely empty. One released chunk is kept for reuse, so a
+ * queue that repeatedly fills up and empties does not allocate.
+ */
+class JobQueueStorage {
+    static constexpr size_t CHUNK_SIZE = 256;
+
+    struct Chunk {
+        std::unique_ptr<Chunk> next;
+        JS::Heap<JSObject*> jobs[CHUNK_SIZE];
+    };
+
+    std::unique_ptr<Chunk> m_first;
+    Chunk* m_last = nullptr;
+    std::unique_ptr<Chunk> m_spare;
+    // Index of the next job to take, in m_first
+    size_t m_head = 0;
+    // Index of the next free slot, in m_last
+    size_t m_tail = 0;
+    size_t m_length = 0;
+
+    void release_first_chunk();
+
+ public:
+    JobQueueStorage() = default;
+    ~JobQueueStorage() { clear(); }
+    JobQueueStorage(JobQueueStorage&& other) noexcept;
+    JobQueueStorage& operator=(JobQueueStorage&& other) noexcept;
+
+    [[nodiscard]] bool empty() const { return m_length == 0; }
+    [[nodiscard]] size_t length() const { return m_length; }
+
+    void append(JSObject* job);
+
+    /**
+     * JobQueueStorage::take_first:
+     *
+     * Removes the job at the front of the queue, which must not be empty.
+     *
+     * Returns: the job. The caller must root it.
+     */
+    [[nodiscard]] JSObject* take_first();
+
+    void clear();
+    void trace(JSTracer* trc);
+};
+
+};  // namespace Gjs
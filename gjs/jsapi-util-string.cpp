@@ -12,6 +12,7 @@
 #include <iomanip>    // for operator<<, setfill, setw
 #include <sstream>    // for operator<<, basic_ostream, ostring...
 #include <string>     // for allocator, char_traits
+#include <string_view>
 
 #include <glib.h>
 
@@ -38,6 +39,7 @@
 #include "gjs/gerror-result.h"
 #include "gjs/jsapi-util.h"
 #include "gjs/macros.h"
+#include "gjs/mem-private.h"
 
 class JSLinearString;
 
@@ -71,6 +73,42 @@ Gjs::AutoChar gjs_hyphen_to_camel(const char* str) {
     return retval;
 }
 
+/**
+ * gjs_json_quote:
+ * @str: a UTF-8 string
+ *
+ * Returns: @str as a JSON string literal, in double quotes, for the JSON
+ *   files that GJS writes by hand, such as heap snapshots and profiles.
+ */
+std::string gjs_json_quote(std::string_view str) {
+    std::string retval;
+    retval.reserve(str.size() + 2);
+    retval += '"';
+    for (char ch : str) {
+        switch (ch) {
+            case '"':
+                retval += "\\\"";
+                break;
+            case '\\':
+                retval += "\\\\";
+                break;
+            case '\n':
+                retval += "\\n";
+                break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20) {
+                    char escape[7];
+                    g_snprintf(escape, sizeof escape, "\\u%04x", ch);
+                    retval += escape;
+                } else {
+                    retval += ch;
+                }
+        }
+    }
+    retval += '"';
+    return retval;
+}
+
 /**
  * gjs_string_to_utf8:
  * @cx: JSContext
@@ -92,7 +130,10 @@ JS::UniqueChars gjs_string_to_utf8(JSContext* cx, const JS::Value value) {
     }
 
     JS::RootedString str(cx, value.toString());
-    return JS_EncodeStringToUTF8(cx, str);
+    JS::UniqueChars retval = JS_EncodeStringToUTF8(cx, str);
+    if (retval)
+        GJS_ADD_STAT(marshalled_string_bytes, strlen(retval.get()));
+    return retval;
 }
 
 /**
@@ -132,6 +173,7 @@ bool gjs_string_to_utf8_n(JSContext* cx, JS::HandleString str, JS::UniqueChars*
 
     *output_len = length;
     *output = JS::UniqueChars(bytes);
+    GJS_ADD_STAT(marshalled_string_bytes, length);
     return true;
 }
 
@@ -188,11 +230,13 @@ gjs_string_from_utf8(JSContext             *context,
                      const char            *utf8_string,
                      JS::MutableHandleValue value_p)
 {
-    JS::ConstUTF8CharsZ chars(utf8_string, strlen(utf8_string));
+    size_t length = strlen(utf8_string);
+    JS::ConstUTF8CharsZ chars(utf8_string, length);
     JS::RootedString str(context, JS_NewStringCopyUTF8Z(context, chars));
     if (!str)
         return false;
 
+    GJS_ADD_STAT(marshalled_string_bytes, length);
     value_p.setString(str);
     return true;
 }
@@ -205,10 +249,12 @@ gjs_string_from_utf8_n(JSContext             *cx,
 {
     JS::UTF8Chars chars(utf8_chars, len);
     JS::RootedString str(cx, JS_NewStringCopyUTF8N(cx, chars));
-    if (str)
-        out.setString(str);
+    if (!str)
+        return false;
 
-    return !!str;
+    GJS_ADD_STAT(marshalled_string_bytes, len);
+    out.setString(str);
+    return true;
 }
 
 bool gjs_string_to_filename(JSContext* context, const JS::Value filename_val,
@@ -14,6 +14,7 @@
 
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <utility>  // for move
 #include <vector>
 
@@ -250,6 +251,14 @@ JSObject* gjs_define_string_array(JSContext* context,
     return array;
 }
 
+bool gjs_define_string_property(JSContext* cx, JS::HandleObject obj,
+                                const char* prop, std::string_view str,
+                                unsigned attrs) {
+    JS::RootedValue v_str{cx};
+    return gjs_string_from_utf8_n(cx, str.data(), str.size(), &v_str) &&
+           JS_DefineProperty(cx, obj, prop, v_str, attrs);
+}
+
 // Helper function: perform ToString on an exception (which may not even be an
 // object), except if it is an InternalError, which would throw in ToString.
 GJS_JSAPI_RETURN_CONVENTION
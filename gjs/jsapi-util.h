@@ -14,6 +14,7 @@
 
 #include <limits>
 #include <string>  // for string, u16string
+#include <string_view>
 #include <type_traits>  // for enable_if_t, add_pointer_t, add_const_t
 #include <utility>      // IWYU pragma: keep
 #include <vector>
@@ -91,6 +92,11 @@ GJS_JSAPI_RETURN_CONVENTION
 JSObject* gjs_build_string_array(JSContext* cx,
                                  const std::vector<std::string>& strings);
 
+GJS_JSAPI_RETURN_CONVENTION
+bool gjs_define_string_property(JSContext* cx, JS::HandleObject obj,
+                                const char* prop, std::string_view str,
+                                unsigned attrs);
+
 GJS_JSAPI_RETURN_CONVENTION
 JSObject* gjs_define_string_array(JSContext* cx, JS::HandleObject obj,
                                   const char* array_name,
@@ -237,6 +243,7 @@ bool gjs_object_require_converted_property(JSContext       *context,
 
 [[nodiscard]] Gjs::AutoChar gjs_hyphen_to_underscore(const char* str);
 [[nodiscard]] Gjs::AutoChar gjs_hyphen_to_camel(const char* str);
+[[nodiscard]] std::string gjs_json_quote(std::string_view str);
 
 #if defined(G_OS_WIN32) && (defined(_MSC_VER) && (_MSC_VER >= 1900))
 [[nodiscard]] std::wstring gjs_win32_vc140_utf8_to_utf16(const char* str);
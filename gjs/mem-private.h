@@ -9,6 +9,7 @@
 #include <config.h>
 
 #include <stddef.h>  // for size_t
+#include <stdint.h>
 
 #include <atomic>
 
@@ -30,6 +31,32 @@
     macro(param, 13)                \
     macro(union_instance, 14)       \
     macro(union_prototype, 15)
+
+// Statistics about the runtime, as opposed to counts of live objects. These
+// are not included in the "everything" count and are not checked for leaks.
+// Some are totals that only go up, and some are current queue lengths.
+#define GJS_FOR_EACH_STAT_COUNTER(macro) \
+    macro(member_index_lookups, 0)       \
+    macro(member_index_misses, 1)        \
+    macro(member_index_entries, 2)       \
+    macro(toggle_queue_length, 3)        \
+    macro(microtask_queue_length, 4)     \
+    macro(pending_cleanup_tasks, 5)      \
+    macro(async_closures, 6)             \
+    macro(wrappers_created, 7)           \
+    macro(wrappers_finalized, 8)         \
+    macro(gi_calls, 9)                   \
+    macro(signal_emissions, 10)          \
+    macro(marshalled_string_bytes, 11)   \
+    macro(marshalled_array_bytes, 12)
+
+// Totals from the above that are also exported to the profiler as a rate per
+// second, computed between samples
+#define GJS_FOR_EACH_RATE_COUNTER(macro)                        \
+    macro(wrappers_created_per_second, 0, wrappers_created)     \
+    macro(wrappers_finalized_per_second, 1, wrappers_finalized) \
+    macro(gi_calls_per_second, 2, gi_calls)                     \
+    macro(signal_emissions_per_second, 3, signal_emissions)
 // clang-format on
 
 namespace Gjs {
@@ -45,6 +72,7 @@ namespace Counters {
 #define GJS_DECLARE_COUNTER(name, ix) extern Counter name;
 GJS_DECLARE_COUNTER(everything, -1)
 GJS_FOR_EACH_COUNTER(GJS_DECLARE_COUNTER)
+GJS_FOR_EACH_STAT_COUNTER(GJS_DECLARE_COUNTER)
 #undef GJS_DECLARE_COUNTER
 
 template <Counter* counter>
@@ -59,12 +87,29 @@ constexpr void dec() {
     everything.value--;
 }
 
+template <Counter* counter>
+constexpr void add(int64_t amount) {
+    counter->value.fetch_add(amount, std::memory_order_relaxed);
+}
+
 }  // namespace Counters
+
+// The usable size of a block allocated with malloc(), for measuring memory
+// with JS::ubi::Node and JS::RuntimeStats. Returns 0 if the C library can't
+// tell.
+[[nodiscard]] size_t malloc_size_of(const void* ptr);
+
 }  // namespace Memory
 }  // namespace Gjs
 
 #define COUNT(name, ix) +1
 static constexpr size_t GJS_N_COUNTERS = 0 GJS_FOR_EACH_COUNTER(COUNT);
+static constexpr size_t GJS_N_STAT_COUNTERS =
+    0 GJS_FOR_EACH_STAT_COUNTER(COUNT);
+#undef COUNT
+#define COUNT(name, ix, total) +1
+static constexpr size_t GJS_N_RATE_COUNTERS =
+    0 GJS_FOR_EACH_RATE_COUNTER(COUNT);
 #undef COUNT
 
 static constexpr const char GJS_COUNTER_DESCRIPTIONS[GJS_N_COUNTERS][52] = {
@@ -87,12 +132,42 @@ static constexpr const char GJS_COUNTER_DESCRIPTIONS[GJS_N_COUNTERS][52] = {
     "Number of C union prototype objects",
 };
 
+static constexpr const char
+    GJS_STAT_COUNTER_DESCRIPTIONS[GJS_N_STAT_COUNTERS][52] = {
+        // max length of description string ---------------v
+        "Lookups in prototype member indices",
+        "Lookups not found in prototype member indices",
+        "Entries in prototype member indices",
+        "Toggle references waiting to be handled",
+        "Promise jobs waiting to run",
+        "FinalizationRegistry callbacks waiting to run",
+        "Callback trampolines waiting for garbage collection",
+        "Total GI wrapper objects created",
+        "Total GI wrapper objects finalized",
+        "Total calls to introspected functions",
+        "Total signal emissions handled in JS",
+        "Total bytes of strings converted between JS and C",
+        "Total bytes of C arrays converted to or from JS",
+};
+
+static constexpr const char
+    GJS_RATE_COUNTER_DESCRIPTIONS[GJS_N_RATE_COUNTERS][52] = {
+        // max length of description string ---------------v
+        "GI wrapper objects created per second",
+        "GI wrapper objects finalized per second",
+        "Calls to introspected functions per second",
+        "Signal emissions handled in JS per second",
+};
+
 #define GJS_INC_COUNTER(name) \
     (Gjs::Memory::Counters::inc<&Gjs::Memory::Counters::name>());
 
 #define GJS_DEC_COUNTER(name) \
     (Gjs::Memory::Counters::dec<&Gjs::Memory::Counters::name>());
 
+#define GJS_ADD_STAT(name, amount) \
+    (Gjs::Memory::Counters::add<&Gjs::Memory::Counters::name>(amount));
+
 #define GJS_GET_COUNTER(name) (Gjs::Memory::Counters::name.value.load())
 
 #endif  // GJS_MEM_PRIVATE_H_
@@ -4,8 +4,13 @@
 
 #include <config.h>
 
+#include <stddef.h>  // for size_t
 #include <stdint.h>
 
+#ifdef __GLIBC__
+#    include <malloc.h>  // for malloc_usable_size
+#endif
+
 #include <glib.h>
 
 #include "gjs/mem-private.h"
@@ -19,7 +24,18 @@ namespace Counters {
 
 GJS_DEFINE_COUNTER(everything, -1)
 GJS_FOR_EACH_COUNTER(GJS_DEFINE_COUNTER)
+GJS_FOR_EACH_STAT_COUNTER(GJS_DEFINE_COUNTER)
 }  // namespace Counters
+
+size_t malloc_size_of(const void* ptr) {
+#ifdef __GLIBC__
+    return malloc_usable_size(const_cast<void*>(ptr));
+#else
+    (void)ptr;
+    return 0;
+#endif
+}
+
 }  // namespace Memory
 }  // namespace Gjs
 
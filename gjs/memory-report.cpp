@@ -0,0 +1,310 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#include <config.h>
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>
+
+#include <algorithm>  // for sort
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glib.h>
+
+#include <js/Array.h>  // for NewArrayObject
+#include <js/Class.h>
+#include <js/ErrorReport.h>  // for JS_ReportOutOfMemory
+#include <js/GCAPI.h>      // for JS_GC, AutoRequireNoGC
+#include <js/MapAndSet.h>  // for MapHas
+#include <js/MemoryMetrics.h>
+#include <js/PropertyAndElement.h>
+#include <js/Realm.h>  // for GetRealmGlobalOrNull
+#include <js/RootingAPI.h>
+#include <js/TypeDecls.h>
+#include <js/UbiNode.h>
+#include <js/UbiNodeBreadthFirst.h>
+#include <js/Value.h>
+#include <js/ValueArray.h>  // for RootedValueVector
+#include <jsapi.h>          // for JS_NewPlainObject, JSAutoRealm
+
+#include "gjs/auto.h"
+#include "gjs/context-private.h"
+#include "gjs/jsapi-util.h"
+#include "gjs/mem-private.h"
+#include "gjs/memory-report.h"
+#include "gjs/module.h"
+#include "gjs/profiler-private.h"
+
+namespace Gjs {
+namespace MemoryReport {
+
+struct Entry {
+    std::string name;
+    size_t count = 0;
+    size_t bytes = 0;
+};
+
+struct RealmEntry {
+    std::string name;
+    size_t gc_bytes;
+    size_t object_bytes;
+    size_t script_bytes;
+    size_t jit_bytes;
+};
+
+// JS::RuntimeStats doesn't name the realms, so name them after the class of
+// their global object, which tells GJS's main, internal, and debugger globals
+// apart
+class NamedRuntimeStats : public JS::RuntimeStats {
+ public:
+    // In the same order as realmStatsVector
+    std::vector<std::string> realm_names;
+
+    NamedRuntimeStats() : JS::RuntimeStats(Memory::malloc_size_of) {}
+
+    void initExtraZoneStats(JS::Zone*, JS::ZoneStats*,
+                            const JS::AutoRequireNoGC&) override {}
+
+    void initExtraRealmStats(JS::Realm* realm, JS::RealmStats*,
+                             const JS::AutoRequireNoGC&) override {
+        JSObject* global = JS::GetRealmGlobalOrNull(realm);
+        realm_names.emplace_back(global ? JS::GetClass(global)->name
+                                        : "(no global)");
+    }
+};
+
+/*
+ * HeapCensus:
+ *
+ * Handler for a breadth-first traversal of the live heap with JS::ubi::Node,
+ * which adds up the size of objects by class, and the size of scripts by the
+ * URL they were compiled from. No GC can happen during the traversal.
+ */
+class HeapCensus {
+ public:
+    struct NodeData {};
+    using Traversal = JS::ubi::BreadthFirst<HeapCensus>;
+
+    // JSClass names are static strings
+    std::unordered_map<const char*, Entry> classes;
+    std::unordered_map<std::string, Entry> scripts;
+
+    bool operator()(Traversal&, JS::ubi::Node, const JS::ubi::Edge& edge,
+                    NodeData*, bool first) {
+        if (!first)
+            return true;
+
+        const JS::ubi::Node& node = edge.referent;
+        Entry* entry;
+        if (node.is<JSObject>()) {
+            entry = &classes[JS::GetClass(node.as<JSObject>())->name];
+        } else if (const char* filename = node.scriptFilename()) {
+            entry = &scripts[filename];
+        } else {
+            return true;
+        }
+
+        entry->count++;
+        entry->bytes += node.size(Memory::malloc_size_of);
+        return true;
+    }
+};
+
+template <typename Key>
+[[nodiscard]] static std::vector<Entry> sorted_entries(
+    const std::unordered_map<Key, Entry>& map) {
+    std::vector<Entry> entries;
+    entries.reserve(map.size());
+    for (const auto& [name, entry] : map)
+        entries.push_back({name, entry.count, entry.bytes});
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.bytes > b.bytes; });
+    return entries;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool define_size(JSContext* cx, JS::HandleObject obj, const char* prop,
+                        size_t size) {
+    return JS_DefineProperty(cx, obj, prop, double(size), JSPROP_ENUMERATE);
+}
+
+// Whether @url is the URL of a module in the module registry of @global, as
+// opposed to a script loaded with the legacy importer or evaluated directly
+GJS_JSAPI_RETURN_CONVENTION
+static bool is_registered_module(JSContext* cx, JSObject* global,
+                                 const std::string& url, bool* found) {
+    *found = false;
+    if (!global)
+        return true;
+
+    JSAutoRealm ar{cx, global};
+    JS::RootedObject registry{cx, gjs_get_module_registry(global)};
+    JS::RootedValue v_url{cx};
+    return gjs_string_from_utf8_n(cx, url.c_str(), url.size(), &v_url) &&
+           JS::MapHas(cx, registry, v_url, found);
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static JSObject* realms_to_js(JSContext* cx,
+                              const std::vector<RealmEntry>& realms) {
+    JS::RootedValueVector elems{cx};
+    JS::RootedObject elem{cx};
+    for (const RealmEntry& realm : realms) {
+        elem = JS_NewPlainObject(cx);
+        if (!elem || !gjs_define_string_property(cx, elem, "name", realm.name,
+                                                 JSPROP_ENUMERATE) ||
+            !define_size(cx, elem, "gcBytes", realm.gc_bytes) ||
+            !define_size(cx, elem, "objectBytes", realm.object_bytes) ||
+            !define_size(cx, elem, "scriptBytes", realm.script_bytes) ||
+            !define_size(cx, elem, "jitBytes", realm.jit_bytes) ||
+            !elems.append(JS::ObjectValue(*elem)))
+            return nullptr;
+    }
+    return JS::NewArrayObject(cx, elems);
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static JSObject* modules_to_js(JSContext* cx,
+                               const std::vector<Entry>& scripts) {
+    auto* gjs = GjsContextPrivate::from_cx(cx);
+    JS::RootedValueVector elems{cx};
+    JS::RootedObject elem{cx};
+    JS::RootedValue v_is_module{cx};
+    for (const Entry& script : scripts) {
+        bool is_module, is_internal_module;
+        if (!is_registered_module(cx, gjs->global(), script.name,
+                                  &is_module) ||
+            !is_registered_module(cx, gjs->internal_global(), script.name,
+                                  &is_internal_module))
+            return nullptr;
+        v_is_module.setBoolean(is_module || is_internal_module);
+
+        elem = JS_NewPlainObject(cx);
+        if (!elem || !gjs_define_string_property(cx, elem, "url", script.name,
+                                                 JSPROP_ENUMERATE) ||
+            !JS_DefineProperty(cx, elem, "isModule", v_is_module,
+                               JSPROP_ENUMERATE) ||
+            !define_size(cx, elem, "scripts", script.count) ||
+            !define_size(cx, elem, "bytes", script.bytes) ||
+            !elems.append(JS::ObjectValue(*elem)))
+            return nullptr;
+    }
+    return JS::NewArrayObject(cx, elems);
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static JSObject* classes_to_js(JSContext* cx,
+                               const std::vector<Entry>& classes) {
+    JS::RootedValueVector elems{cx};
+    JS::RootedObject elem{cx};
+    for (const Entry& klass : classes) {
+        elem = JS_NewPlainObject(cx);
+        if (!elem || !gjs_define_string_property(cx, elem, "name", klass.name,
+                                                 JSPROP_ENUMERATE) ||
+            !define_size(cx, elem, "count", klass.count) ||
+            !define_size(cx, elem, "bytes", klass.bytes) ||
+            !elems.append(JS::ObjectValue(*elem)))
+            return nullptr;
+    }
+    return JS::NewArrayObject(cx, elems);
+}
+
+static void add_profiler_marks(GjsProfiler* profiler,
+                               const std::vector<RealmEntry>& realms,
+                               const std::vector<Entry>& scripts,
+                               const std::vector<Entry>& classes) {
+    int64_t now = g_get_monotonic_time() * 1000L;
+    for (const RealmEntry& realm : realms) {
+        AutoChar message{g_strdup_printf(
+            "Realm %s: %zu bytes of GC things, %zu in objects, %zu in "
+            "scripts, %zu in JIT code",
+            realm.name.c_str(), realm.gc_bytes, realm.object_bytes,
+            realm.script_bytes, realm.jit_bytes)};
+        _gjs_profiler_add_mark(profiler, now, 0, "GJS", "Memory report",
+                               message);
+    }
+    for (const Entry& script : scripts) {
+        AutoChar message{g_strdup_printf("%s: %zu bytes in %zu scripts",
+                                         script.name.c_str(), script.bytes,
+                                         script.count)};
+        _gjs_profiler_add_mark(profiler, now, 0, "GJS", "Memory report",
+                               message);
+    }
+    for (const Entry& klass : classes) {
+        AutoChar message{g_strdup_printf("Class %s: %zu bytes in %zu objects",
+                                         klass.name.c_str(), klass.bytes,
+                                         klass.count)};
+        _gjs_profiler_add_mark(profiler, now, 0, "GJS", "Memory report",
+                               message);
+    }
+}
+
+JSObject* collect(JSContext* cx) {
+    JS_GC(cx);
+
+    NamedRuntimeStats stats;
+    if (!JS::CollectRuntimeStats(cx, &stats, /* opv = */ nullptr,
+                                 /* anonymize = */ false)) {
+        JS_ReportOutOfMemory(cx);
+        return nullptr;
+    }
+
+    std::vector<RealmEntry> realms;
+    size_t ix = 0;
+    for (const JS::RealmStats& realm : stats.realmStatsVector) {
+        realms.push_back(
+            {stats.realm_names[ix++], realm.sizeOfLiveGCThings(),
+             realm.classInfo.sizeOfAllThings(),
+             realm.scriptsGCHeap + realm.scriptsMallocHeapData,
+             realm.baselineData + realm.ionData + realm.jitScripts});
+    }
+    std::sort(realms.begin(), realms.end(),
+              [](const RealmEntry& a, const RealmEntry& b) {
+                  return a.gc_bytes > b.gc_bytes;
+              });
+
+    HeapCensus census;
+    {
+        JS::ubi::RootList roots{cx};
+        auto [ok, nogc] = roots.init();
+        JS::ubi::Node root{&roots};
+        HeapCensus::Traversal traversal{cx, census, nogc};
+        if (!ok || !traversal.addStartVisited(root) ||
+            !traversal.traverse()) {
+            JS_ReportOutOfMemory(cx);
+            return nullptr;
+        }
+    }
+
+    std::vector<Entry> scripts{sorted_entries(census.scripts)};
+    std::vector<Entry> classes{sorted_entries(census.classes)};
+
+    GjsProfiler* profiler = GjsContextPrivate::from_cx(cx)->profiler();
+    if (profiler && _gjs_profiler_is_running(profiler))
+        add_profiler_marks(profiler, realms, scripts, classes);
+
+    JS::RootedObject report{cx, JS_NewPlainObject(cx)};
+    if (!report)
+        return nullptr;
+
+    JS::RootedObject array{cx, realms_to_js(cx, realms)};
+    if (!array ||
+        !JS_DefineProperty(cx, report, "realms", array, JSPROP_ENUMERATE))
+        return nullptr;
+    array = modules_to_js(cx, scripts);
+    if (!array ||
+        !JS_DefineProperty(cx, report, "modules", array, JSPROP_ENUMERATE))
+        return nullptr;
+    array = classes_to_js(cx, classes);
+    if (!array ||
+        !JS_DefineProperty(cx, report, "classes", array, JSPROP_ENUMERATE))
+        return nullptr;
+
+    return report;
+}
+
+}  // namespace MemoryReport
+}  // namespace Gjs
@@ -0,0 +1,27 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#pragma once
+
+#include <config.h>
+
+#include <js/TypeDecls.h>
+
+#include "gjs/macros.h"
+
+namespace Gjs {
+namespace MemoryReport {
+
+// Measures the JS heap of @cx, after a full garbage collection, broken down
+// by realm (from SpiderMonkey's runtime statistics), by the URL of the script
+// or module that code was compiled from, and by the class of objects, which
+// shows the GI wrapper objects and closures separately.
+//
+// Returns an object with "realms", "modules", and "classes" arrays, each
+// ordered by size, largest first. If the profiler is running, the report is
+// also added to its capture as marks.
+GJS_JSAPI_RETURN_CONVENTION JSObject* collect(JSContext* cx);
+
+}  // namespace MemoryReport
+}  // namespace Gjs
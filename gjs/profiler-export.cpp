@@ -0,0 +1,540 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#include <config.h>  // for ENABLE_PROFILER
+
+#ifdef ENABLE_PROFILER
+
+#    include <errno.h>
+#    include <inttypes.h>  // for PRId64, PRIx64
+#    include <stdint.h>
+#    include <stdio.h>
+#    include <string.h>  // for memcpy, strcmp, strlen
+
+#    include <algorithm>  // for min
+#    include <memory>     // for unique_ptr
+#    include <string>
+#    include <unordered_map>
+#    include <vector>
+
+#    include <glib.h>
+#    include <glib/gstdio.h>  // for g_fopen
+
+#    include <sysprof-capture.h>
+
+#    include "gjs/auto.h"
+#    include "gjs/jsapi-util.h"
+#    include "gjs/profiler-export.h"
+
+// Must match the sampling rate of the profiler
+#    define SAMPLE_PERIOD_NS G_GINT64_CONSTANT(1000000)
+
+namespace Gjs {
+
+/*
+ * ChromeTraceExporter:
+ *
+ * Writes the Trace Event Format of chrome://tracing, which Perfetto can also
+ * load. The sampled stacks are turned into nested begin and end events, as if
+ * each stack was running from one sample to the next, which shows as a flame
+ * chart on a timeline. The marks and counters are written as they are.
+ *
+ * The output is a JSON array of events. A file that is cut short, because the
+ * process was killed before it could be finished, can still be loaded.
+ */
+class ChromeTraceExporter : public ProfileExporter {
+    // Fake thread IDs that tell the tracks apart
+    static constexpr int SAMPLES_TID = 1;
+    static constexpr int MARKS_TID = 2;
+
+    // The frames of the previous sample, outermost first, whose begin events
+    // have not been matched by end events yet
+    std::vector<std::string> m_stack;
+    int64_t m_last_sample_time = 0;
+    bool m_first_event = true;
+
+    void begin_event(const char* phase, int tid, int64_t time);
+    void write_string(const char* str);
+    void write_time(int64_t time_ns);
+    void end_frames(size_t depth, int64_t time);
+
+ public:
+    ChromeTraceExporter(FILE* file, GPid pid);
+
+ protected:
+    void add_sample(int64_t time,
+                    const std::vector<const char*>& frames) override;
+    void add_mark(int64_t time, int64_t duration, const char* group,
+                  const char* name, const char* message) override;
+    void add_counter(int64_t time, const char* name, double value) override;
+    void write_trailer() override;
+};
+
+/*
+ * PprofExporter:
+ *
+ * Writes an uncompressed protocol buffer of the Profile message of pprof.
+ * Concatenated protocol buffers are read as one message with the repeated
+ * fields of all of them, so each sample, and each string, function and
+ * location the first time that it is used, is written as a message of its
+ * own. The marks and counters have no equivalent in pprof, and are left out.
+ */
+class PprofExporter : public ProfileExporter {
+    // Field numbers of the Profile message, and of the messages in it
+    enum ProfileField : unsigned {
+        SAMPLE_TYPE = 1,
+        SAMPLE = 2,
+        LOCATION = 4,
+        FUNCTION = 5,
+        STRING_TABLE = 6,
+        TIME_NANOS = 9,
+        DURATION_NANOS = 10,
+        PERIOD_TYPE = 11,
+        PERIOD = 12,
+    };
+    enum ValueTypeField : unsigned { VALUE_TYPE_TYPE = 1, VALUE_TYPE_UNIT = 2 };
+    enum SampleField : unsigned { SAMPLE_LOCATION_ID = 1, SAMPLE_VALUE = 2 };
+    enum LocationField : unsigned { LOCATION_ID = 1, LOCATION_LINE = 4 };
+    enum LineField : unsigned { LINE_FUNCTION_ID = 1 };
+    enum FunctionField : unsigned {
+        FUNCTION_ID = 1,
+        FUNCTION_NAME = 2,
+        FUNCTION_SYSTEM_NAME = 3,
+    };
+
+    // Indices in the string table
+    std::unordered_map<std::string, uint64_t> m_strings;
+    // Each frame name has a function, and a location with the same ID
+    std::unordered_map<std::string, uint64_t> m_locations;
+    int64_t m_first_sample_time = 0;
+    int64_t m_last_sample_time = 0;
+
+    static void put_varint(std::string* out, uint64_t value);
+    static void put_uint(std::string* out, unsigned field, uint64_t value);
+    static void put_bytes(std::string* out, unsigned field,
+                          const std::string& bytes);
+
+    void write_field(unsigned field, const std::string& message);
+    [[nodiscard]] uint64_t string_index(const std::string& str);
+    [[nodiscard]] std::string value_type(const char* type, const char* unit);
+    [[nodiscard]] uint64_t location_id(const char* name);
+
+ public:
+    PprofExporter(FILE* file, GPid pid);
+
+ protected:
+    void add_sample(int64_t time,
+                    const std::vector<const char*>& frames) override;
+    void add_mark(int64_t, int64_t, const char*, const char*,
+                  const char*) override {}
+    void add_counter(int64_t, const char*, double) override {}
+    void write_trailer() override;
+};
+
+ProfileExporter::Format ProfileExporter::format_for(const char* path) {
+    const char* env = g_getenv("GJS_PROFILER_FORMAT");
+    if (env) {
+        if (strcmp(env, "sysprof") == 0)
+            return Format::SYSPROF;
+        if (strcmp(env, "chrome") == 0)
+            return Format::CHROME_TRACE;
+        if (strcmp(env, "pprof") == 0)
+            return Format::PPROF;
+        g_warning("Invalid GJS_PROFILER_FORMAT '%s', expected sysprof, chrome "
+                  "or pprof",
+                  env);
+    }
+
+    if (path && g_str_has_suffix(path, ".json"))
+        return Format::CHROME_TRACE;
+    if (path && (g_str_has_suffix(path, ".pprof") ||
+                 g_str_has_suffix(path, ".pb")))
+        return Format::PPROF;
+    return Format::SYSPROF;
+}
+
+const char* ProfileExporter::extension(Format format) {
+    switch (format) {
+        case Format::CHROME_TRACE:
+            return "json";
+        case Format::PPROF:
+            return "pprof";
+        default:
+            return "syscap";
+    }
+}
+
+std::unique_ptr<ProfileExporter> ProfileExporter::create(Format format,
+                                                         const char* path,
+                                                         GPid pid) {
+    g_assert(format != Format::SYSPROF &&
+             "Sysprof captures are written without an exporter");
+
+    FILE* file = g_fopen(path, "wb");
+    if (!file) {
+        g_warning("Failed to open %s: %s", path, g_strerror(errno));
+        return nullptr;
+    }
+
+    if (format == Format::CHROME_TRACE)
+        return std::make_unique<ChromeTraceExporter>(file, pid);
+    return std::make_unique<PprofExporter>(file, pid);
+}
+
+ProfileExporter::~ProfileExporter() {
+    if (m_file)
+        fclose(m_file);
+}
+
+void ProfileExporter::read_jitmap(const SysprofCaptureJitmap* jitmap) {
+    // Each entry is an address followed by a nul-terminated name
+    const uint8_t* pos = jitmap->data;
+    for (uint32_t ix = 0; ix < jitmap->n_jitmaps; ix++) {
+        SysprofCaptureAddress address;
+        memcpy(&address, pos, sizeof address);
+        pos += sizeof address;
+
+        const char* name = reinterpret_cast<const char*>(pos);
+        m_jitmap.insert_or_assign(address, name);
+        pos += strlen(name) + 1;
+    }
+}
+
+void ProfileExporter::read_counters(const SysprofCaptureCounterSet* set) {
+    constexpr size_t group_size = G_N_ELEMENTS(set->values[0].ids);
+    for (unsigned group = 0; group < set->n_values; group++) {
+        const SysprofCaptureCounterValues& values = set->values[group];
+        for (size_t ix = 0; ix < group_size; ix++) {
+            // Unused slots have ID 0
+            if (values.ids[ix] == 0)
+                continue;
+            auto it = m_counters.find(values.ids[ix]);
+            if (it == m_counters.end())
+                continue;
+
+            const Counter& counter = it->second;
+            add_counter(set->frame.time, counter.name.c_str(),
+                        counter.is_double ? values.values[ix].vdbl
+                                          : double(values.values[ix].v64));
+        }
+    }
+}
+
+// Returns the name of a JS frame, or the address of a native one
+const char* ProfileExporter::frame_name(SysprofCaptureAddress address) {
+    auto it = m_jitmap.find(address);
+    if (it != m_jitmap.end())
+        return it->second.c_str();
+
+    auto [addr_it, inserted] = m_addresses.try_emplace(address);
+    if (inserted) {
+        AutoChar name{g_strdup_printf("0x%" PRIx64, uint64_t(address))};
+        addr_it->second = name.get();
+    }
+    return addr_it->second.c_str();
+}
+
+bool ProfileExporter::add_capture(SysprofCaptureWriter* capture) {
+    SysprofCaptureReader* reader =
+        sysprof_capture_writer_create_reader(capture);
+    if (!reader)
+        return false;
+
+    // Each capture has its own jitmap addresses and counter IDs
+    m_jitmap.clear();
+    m_counters.clear();
+
+    std::vector<const char*> frames;
+    SysprofCaptureFrameType type;
+    bool ok = true;
+    while (ok && sysprof_capture_reader_peek_type(reader, &type)) {
+        switch (type) {
+            case SYSPROF_CAPTURE_FRAME_JITMAP: {
+                const SysprofCaptureJitmap* jitmap =
+                    sysprof_capture_reader_read_jitmap(reader);
+                ok = jitmap != nullptr;
+                if (jitmap)
+                    read_jitmap(jitmap);
+                break;
+            }
+            case SYSPROF_CAPTURE_FRAME_SAMPLE: {
+                const SysprofCaptureSample* sample =
+                    sysprof_capture_reader_read_sample(reader);
+                ok = sample != nullptr;
+                if (!sample)
+                    break;
+
+                // The addresses are innermost first
+                frames.clear();
+                for (unsigned ix = sample->n_addrs; ix-- > 0;)
+                    frames.push_back(frame_name(sample->addrs[ix]));
+                add_sample(sample->frame.time, frames);
+                break;
+            }
+            case SYSPROF_CAPTURE_FRAME_MARK: {
+                const SysprofCaptureMark* mark =
+                    sysprof_capture_reader_read_mark(reader);
+                ok = mark != nullptr;
+                if (mark)
+                    add_mark(mark->frame.time, mark->duration, mark->group,
+                             mark->name, mark->message);
+                break;
+            }
+            case SYSPROF_CAPTURE_FRAME_CTRDEF: {
+                const SysprofCaptureCounterDefine* define =
+                    sysprof_capture_reader_read_counter_define(reader);
+                ok = define != nullptr;
+                if (!define)
+                    break;
+
+                for (unsigned ix = 0; ix < define->n_counters; ix++) {
+                    const SysprofCaptureCounter& counter = define->counters[ix];
+                    bool is_double =
+                        counter.type == SYSPROF_CAPTURE_COUNTER_DOUBLE;
+                    m_counters.insert_or_assign(
+                        counter.id, Counter{counter.name, is_double});
+                }
+                break;
+            }
+            case SYSPROF_CAPTURE_FRAME_CTRSET: {
+                const SysprofCaptureCounterSet* set =
+                    sysprof_capture_reader_read_counter_set(reader);
+                ok = set != nullptr;
+                if (set)
+                    read_counters(set);
+                break;
+            }
+            default:
+                ok = sysprof_capture_reader_skip(reader);
+        }
+    }
+
+    sysprof_capture_reader_unref(reader);
+    return ok && fflush(m_file) == 0;
+}
+
+bool ProfileExporter::finish() {
+    write_trailer();
+    bool ok = !ferror(m_file);
+    if (fclose(m_file) != 0)
+        ok = false;
+    m_file = nullptr;
+    return ok;
+}
+
+ChromeTraceExporter::ChromeTraceExporter(FILE* file, GPid pid)
+    : ProfileExporter(file, pid) {
+    fputs("[", m_file);
+
+    begin_event("M", SAMPLES_TID, 0);
+    fputs(",\"name\":\"thread_name\",\"args\":{\"name\":\"JS stack\"}}",
+          m_file);
+    begin_event("M", MARKS_TID, 0);
+    fputs(",\"name\":\"thread_name\",\"args\":{\"name\":\"Marks\"}}", m_file);
+}
+
+void ChromeTraceExporter::begin_event(const char* phase, int tid,
+                                      int64_t time) {
+    fputs(m_first_event ? "\n" : ",\n", m_file);
+    m_first_event = false;
+
+    fprintf(m_file, "{\"ph\":\"%s\",\"pid\":%jd,\"tid\":%d,\"ts\":", phase,
+            intmax_t(m_pid), tid);
+    write_time(time);
+}
+
+void ChromeTraceExporter::write_string(const char* str) {
+    std::string quoted{gjs_json_quote(str)};
+    fwrite(quoted.data(), 1, quoted.size(), m_file);
+}
+
+// The timestamps are in microseconds
+void ChromeTraceExporter::write_time(int64_t time_ns) {
+    fprintf(m_file, "%" PRId64 ".%03d", time_ns / 1000, int(time_ns % 1000));
+}
+
+void ChromeTraceExporter::end_frames(size_t depth, int64_t time) {
+    while (m_stack.size() > depth) {
+        begin_event("E", SAMPLES_TID, time);
+        fputs(",\"name\":", m_file);
+        write_string(m_stack.back().c_str());
+        fputs("}", m_file);
+        m_stack.pop_back();
+    }
+}
+
+void ChromeTraceExporter::add_sample(int64_t time,
+                                     const std::vector<const char*>& frames) {
+    // No samples are taken while no JS code runs, so the last stack must not
+    // appear to run until the next sample
+    if (m_last_sample_time != 0 &&
+        time - m_last_sample_time > 2 * SAMPLE_PERIOD_NS)
+        end_frames(0, m_last_sample_time + SAMPLE_PERIOD_NS);
+    m_last_sample_time = time;
+
+    size_t common = 0;
+    size_t max_common = std::min(m_stack.size(), frames.size());
+    while (common < max_common && m_stack[common] == frames[common])
+        common++;
+
+    end_frames(common, time);
+    for (size_t ix = common; ix < frames.size(); ix++) {
+        begin_event("B", SAMPLES_TID, time);
+        fputs(",\"cat\":\"js\",\"name\":", m_file);
+        write_string(frames[ix]);
+        fputs("}", m_file);
+        m_stack.emplace_back(frames[ix]);
+    }
+}
+
+void ChromeTraceExporter::add_mark(int64_t time, int64_t duration,
+                                   const char* group, const char* name,
+                                   const char* message) {
+    if (duration > 0) {
+        begin_event("X", MARKS_TID, time);
+        fputs(",\"dur\":", m_file);
+        write_time(duration);
+    } else {
+        begin_event("i", MARKS_TID, time);
+        fputs(",\"s\":\"t\"", m_file);
+    }
+
+    fputs(",\"cat\":", m_file);
+    write_string(group);
+    fputs(",\"name\":", m_file);
+    write_string(name);
+    if (message && *message) {
+        fputs(",\"args\":{\"message\":", m_file);
+        write_string(message);
+        fputs("}", m_file);
+    }
+    fputs("}", m_file);
+}
+
+void ChromeTraceExporter::add_counter(int64_t time, const char* name,
+                                      double value) {
+    char buf[G_ASCII_DTOSTR_BUF_SIZE];
+    begin_event("C", SAMPLES_TID, time);
+    fputs(",\"name\":", m_file);
+    write_string(name);
+    fprintf(m_file, ",\"args\":{\"value\":%s}}",
+            g_ascii_dtostr(buf, sizeof buf, value));
+}
+
+void ChromeTraceExporter::write_trailer() {
+    end_frames(0, m_last_sample_time + SAMPLE_PERIOD_NS);
+    fputs("\n]\n", m_file);
+}
+
+void PprofExporter::put_varint(std::string* out, uint64_t value) {
+    while (value >= 0x80) {
+        out->push_back(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out->push_back(char(value));
+}
+
+void PprofExporter::put_uint(std::string* out, unsigned field,
+                             uint64_t value) {
+    put_varint(out, field << 3);  // wire type 0, varint
+    put_varint(out, value);
+}
+
+void PprofExporter::put_bytes(std::string* out, unsigned field,
+                              const std::string& bytes) {
+    put_varint(out, (field << 3) | 2);  // wire type 2, length-delimited
+    put_varint(out, bytes.size());
+    out->append(bytes);
+}
+
+void PprofExporter::write_field(unsigned field, const std::string& message) {
+    std::string out;
+    put_bytes(&out, field, message);
+    fwrite(out.data(), 1, out.size(), m_file);
+}
+
+uint64_t PprofExporter::string_index(const std::string& str) {
+    auto [it, inserted] = m_strings.try_emplace(str, m_strings.size());
+    if (inserted)
+        write_field(STRING_TABLE, str);
+    return it->second;
+}
+
+std::string PprofExporter::value_type(const char* type, const char* unit) {
+    std::string retval;
+    put_uint(&retval, VALUE_TYPE_TYPE, string_index(type));
+    put_uint(&retval, VALUE_TYPE_UNIT, string_index(unit));
+    return retval;
+}
+
+uint64_t PprofExporter::location_id(const char* name) {
+    auto [it, inserted] =
+        m_locations.try_emplace(name, m_locations.size() + 1);
+    uint64_t id = it->second;
+    if (!inserted)
+        return id;
+
+    uint64_t name_index = string_index(name);
+    std::string function;
+    put_uint(&function, FUNCTION_ID, id);
+    put_uint(&function, FUNCTION_NAME, name_index);
+    put_uint(&function, FUNCTION_SYSTEM_NAME, name_index);
+    write_field(FUNCTION, function);
+
+    std::string line;
+    put_uint(&line, LINE_FUNCTION_ID, id);
+    std::string location;
+    put_uint(&location, LOCATION_ID, id);
+    put_bytes(&location, LOCATION_LINE, line);
+    write_field(LOCATION, location);
+
+    return id;
+}
+
+PprofExporter::PprofExporter(FILE* file, GPid pid)
+    : ProfileExporter(file, pid) {
+    // The first string must be the empty string
+    (void)string_index("");
+
+    write_field(SAMPLE_TYPE, value_type("samples", "count"));
+    write_field(SAMPLE_TYPE, value_type("cpu", "nanoseconds"));
+    write_field(PERIOD_TYPE, value_type("cpu", "nanoseconds"));
+
+    std::string header;
+    put_uint(&header, PERIOD, SAMPLE_PERIOD_NS);
+    put_uint(&header, TIME_NANOS, g_get_real_time() * 1000);
+    fwrite(header.data(), 1, header.size(), m_file);
+}
+
+void PprofExporter::add_sample(int64_t time,
+                               const std::vector<const char*>& frames) {
+    if (m_first_sample_time == 0)
+        m_first_sample_time = time;
+    m_last_sample_time = time;
+
+    // The locations are innermost first
+    std::string location_ids;
+    for (size_t ix = frames.size(); ix-- > 0;)
+        put_varint(&location_ids, location_id(frames[ix]));
+
+    std::string values;
+    put_varint(&values, 1);
+    put_varint(&values, SAMPLE_PERIOD_NS);
+
+    std::string sample;
+    put_bytes(&sample, SAMPLE_LOCATION_ID, location_ids);
+    put_bytes(&sample, SAMPLE_VALUE, values);
+    write_field(SAMPLE, sample);
+}
+
+void PprofExporter::write_trailer() {
+    std::string trailer;
+    put_uint(&trailer, DURATION_NANOS,
+             m_last_sample_time - m_first_sample_time + SAMPLE_PERIOD_NS);
+    fwrite(trailer.data(), 1, trailer.size(), m_file);
+}
+
+}  // namespace Gjs
+
+#endif  // ENABLE_PROFILER
@@ -0,0 +1,88 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#pragma once
+
+#include <config.h>  // for ENABLE_PROFILER
+
+#ifdef ENABLE_PROFILER
+
+#    include <stdint.h>
+#    include <stdio.h>  // for FILE
+
+#    include <memory>  // for unique_ptr
+#    include <string>
+#    include <unordered_map>
+#    include <vector>
+
+#    include <glib.h>
+
+#    include <sysprof-capture.h>
+
+namespace Gjs {
+
+/*
+ * ProfileExporter:
+ *
+ * Converts the profiler's captures to a format that can be analyzed without
+ * the sysprof tools. The profiler still records into a sysprof capture, which
+ * is kept in memory and replaced every few seconds, and each replaced capture
+ * is converted and appended to the output file, so that the output is written
+ * as the profiler runs.
+ */
+class ProfileExporter {
+ public:
+    enum class Format { SYSPROF, CHROME_TRACE, PPROF };
+
+    // The format to write to @path: GJS_PROFILER_FORMAT if set, otherwise
+    // the one of the file extension
+    [[nodiscard]] static Format format_for(const char* path);
+    [[nodiscard]] static const char* extension(Format format);
+
+    // Returns nullptr if the output file could not be opened
+    [[nodiscard]] static std::unique_ptr<ProfileExporter> create(
+        Format format, const char* path, GPid pid);
+
+    virtual ~ProfileExporter();
+
+    // Appends the contents of @capture, which is not written to afterwards
+    [[nodiscard]] bool add_capture(SysprofCaptureWriter* capture);
+
+    // Writes what is left of the output and closes it
+    [[nodiscard]] bool finish();
+
+ protected:
+    FILE* m_file;
+    GPid m_pid;
+
+    ProfileExporter(FILE* file, GPid pid) : m_file(file), m_pid(pid) {}
+
+    // Frames are outermost first
+    virtual void add_sample(int64_t time,
+                            const std::vector<const char*>& frames) = 0;
+    virtual void add_mark(int64_t time, int64_t duration, const char* group,
+                          const char* name, const char* message) = 0;
+    virtual void add_counter(int64_t time, const char* name, double value) = 0;
+    virtual void write_trailer() = 0;
+
+ private:
+    struct Counter {
+        std::string name;
+        bool is_double;
+    };
+
+    // Valid for the capture being converted only
+    std::unordered_map<SysprofCaptureAddress, std::string> m_jitmap;
+    std::unordered_map<uint32_t, Counter> m_counters;
+    // Names of native frames
+    std::unordered_map<SysprofCaptureAddress, std::string> m_addresses;
+
+    void read_jitmap(const SysprofCaptureJitmap* jitmap);
+    void read_counters(const SysprofCaptureCounterSet* set);
+    [[nodiscard]] const char* frame_name(SysprofCaptureAddress address);
+};
+
+}  // namespace Gjs
+
+#endif  // ENABLE_PROFILER
@@ -8,8 +8,12 @@
 #include <config.h>
 
 #include <stdint.h>
+
+#include <atomic>
 #include <string>
 
+#include <glib.h>
+
 #include <js/GCAPI.h>  // for JSFinalizeStatus, JSGCStatus, GCReason
 #include <js/ProfilingCategory.h>
 #include <js/ProfilingStack.h>
@@ -46,6 +50,96 @@ class AutoProfilerLabel {
 
 namespace Gjs {
 enum GCCounters { GC_HEAP_BYTES, MALLOC_HEAP_BYTES, N_COUNTERS };
+
+[[nodiscard]] int64_t read_slow_call_threshold();
+
+// In nanoseconds, or -1 if slow calls are not traced. Set with the
+// GJS_SLOW_CALL_THRESHOLD environment variable, in milliseconds.
+[[nodiscard]] inline int64_t slow_call_threshold() {
+    static const int64_t threshold = read_slow_call_threshold();
+    return threshold;
+}
+
+void add_slow_call_mark(JSContext* cx, int64_t begin_time, int64_t duration,
+                        const char* name, const std::string& description);
+
+/*
+ * AutoSlowCallMark:
+ *
+ * Times the scope in which it lives, if slow call tracing is enabled. If the
+ * scope takes longer than the threshold, it adds a profiler mark, or logs a
+ * message if the profiler is not running. @describe is only called then, to
+ * build the message, so it can be costly.
+ */
+template <typename F>
+class AutoSlowCallMark {
+    JSContext* m_cx;
+    const char* m_name;
+    F m_describe;
+    int64_t m_begin_time;
+
+ public:
+    AutoSlowCallMark(JSContext* cx, const char* name, F describe)
+        : m_cx(cx),
+          m_name(name),
+          m_describe(describe),
+          m_begin_time(G_UNLIKELY(slow_call_threshold() >= 0)
+                           ? g_get_monotonic_time() * 1000L
+                           : 0) {}
+
+    ~AutoSlowCallMark() {
+        if (G_LIKELY(m_begin_time == 0))
+            return;
+        int64_t duration = g_get_monotonic_time() * 1000L - m_begin_time;
+        if (duration >= slow_call_threshold())
+            add_slow_call_mark(m_cx, m_begin_time, duration, m_name,
+                               m_describe());
+    }
+
+    AutoSlowCallMark(const AutoSlowCallMark&) = delete;
+    AutoSlowCallMark& operator=(const AutoSlowCallMark&) = delete;
+};
+
+// Set while the profiler traces main loop dispatches
+extern std::atomic_bool trace_source_dispatch;
+
+void add_source_dispatch_mark(GSource* source, int64_t begin_time,
+                              int64_t ready_time);
+
+/*
+ * AutoSourceDispatchMark:
+ *
+ * Put at the start of the dispatch function of a GSource, or of the callback
+ * of a GLib source, in which case @source defaults to the source being
+ * dispatched. While the profiler traces main loop dispatches, this adds a mark
+ * with the name of the source, how long it ran, and how late it was relative
+ * to its ready time.
+ */
+class AutoSourceDispatchMark {
+    GSource* m_source;
+    int64_t m_begin_time = 0;
+    int64_t m_ready_time = -1;
+
+ public:
+    explicit AutoSourceDispatchMark(GSource* source = nullptr)
+        : m_source(source) {
+        if (G_LIKELY(!trace_source_dispatch.load(std::memory_order_relaxed)))
+            return;
+        if (!m_source)
+            m_source = g_main_current_source();
+        if (m_source)
+            m_ready_time = g_source_get_ready_time(m_source);
+        m_begin_time = g_get_monotonic_time() * 1000L;
+    }
+
+    ~AutoSourceDispatchMark() {
+        if (G_UNLIKELY(m_begin_time != 0))
+            add_source_dispatch_mark(m_source, m_begin_time, m_ready_time);
+    }
+
+    AutoSourceDispatchMark(const AutoSourceDispatchMark&) = delete;
+    AutoSourceDispatchMark& operator=(const AutoSourceDispatchMark&) = delete;
+};
 }  // namespace Gjs
 
 GjsProfiler *_gjs_profiler_new(GjsContext *context);
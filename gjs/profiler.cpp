@@ -8,20 +8,26 @@
 #endif
 
 #ifdef ENABLE_PROFILER
-// IWYU has a weird loop where if this is present, it asks for it to be removed,
-// and if absent, asks for it to be added
-#    include <alloca.h>  // IWYU pragma: keep
 #    include <errno.h>
+#    include <pthread.h>  // for pthread_getattr_np
 #    include <stdint.h>
 #    include <stdio.h>        // for sscanf
 #    include <string.h>       // for memcpy, strlen
+#    include <sys/mman.h>     // for memfd_create
 #    include <sys/syscall.h>  // for __NR_gettid
 #    include <sys/types.h>    // for timer_t
 #    include <time.h>         // for size_t, CLOCK_MONOTONIC, itimerspec, ...
+#    include <ucontext.h>     // for ucontext_t
 #    ifdef HAVE_UNISTD_H
 #        include <unistd.h>  // for getpid, syscall
 #    endif
+#    include <algorithm>  // for fill_n, min
 #    include <array>
+#    include <atomic>
+#    include <memory>  // for unique_ptr
+#    include <string>
+#    include <unordered_map>
+#    include <vector>
 #endif
 
 #include <glib-object.h>
@@ -40,9 +46,11 @@
 #include <mozilla/Atomics.h>  // for ProfilingStack operators
 
 #include "gjs/auto.h"
+#include "gjs/context-private.h"
 #include "gjs/context.h"
 #include "gjs/jsapi-util.h"  // for gjs_explain_gc_reason
 #include "gjs/mem-private.h"
+#include "gjs/profiler-export.h"
 #include "gjs/profiler-private.h"
 #include "gjs/profiler.h"
 
@@ -66,8 +74,10 @@
  *
  * From within the signal handler, we process the current stack as
  * delivered to us from the JSContext. Any pointer data that comes from
- * the runtime has to be copied, so we keep our own dedup'd string
- * pointers for JavaScript file/line information. Non-JS instruction
+ * the runtime has to be copied, so we intern the JavaScript file/line
+ * information of each frame once in a table of our own, and record the
+ * sample as an array of frame IDs. The samples and the frame names are
+ * written to the capture later, from the main loop. Non-JS instruction
  * pointers are just fine, as they can be resolved by parsing the ELF for
  * the file mapped on disk containing that address.
  *
@@ -81,6 +91,379 @@
 
 G_DEFINE_POINTER_TYPE(GjsProfiler, gjs_profiler)
 
+#ifdef ENABLE_PROFILER
+
+namespace Gjs {
+
+// A frame of the native stack: the frame address, and the return address
+struct NativeFrame {
+    uintptr_t frame_address;
+    SysprofCaptureAddress address;
+};
+
+/*
+ * SampleBuffer:
+ *
+ * Stores the samples taken by the SIGPROF handler until the main loop writes
+ * them to the capture, or until a mark is added while the ring buffer is half
+ * full, in case JS code keeps the main loop blocked. Each distinct frame name
+ * is interned once in a fixed size hash table, and a sample is stored in a
+ * ring buffer as the array of the IDs of its frames. The SIGPROF handler is
+ * the only producer. It runs on the JS thread, so it can interrupt the
+ * consumer, but not the other way around.
+ *
+ * Nothing here allocates or locks after construction. When the table or the
+ * ring buffer is full, samples are dropped and counted.
+ */
+class SampleBuffer {
+ public:
+    static constexpr size_t MAX_NAME_LENGTH = 511;
+
+ private:
+    static constexpr uint32_t N_FRAMES = 1 << 13;
+    static constexpr uint32_t NAMES_SIZE = 1 << 20;
+    static constexpr uint32_t RING_SIZE = 1 << 20;  // in words
+    // Frame ID for frames without a name, followed by their stack address
+    static constexpr uint32_t NO_FRAME = 0;
+
+    struct Frame {
+        std::atomic_bool ready;
+        uint32_t hash;
+        uint32_t name_offset;
+        uint32_t name_length;
+    };
+
+    // The name of a frame is its label and its dynamic string, separated by a
+    // space, truncated to MAX_NAME_LENGTH
+    struct FrameName {
+        const char* parts[3];
+        size_t lengths[3];
+        size_t length = 0;
+
+        FrameName(const char* label, const char* dynamic_string);
+        [[nodiscard]] uint32_t hash() const;
+        [[nodiscard]] bool equals(const char* name, size_t length) const;
+        void copy_to(char* dest) const;
+    };
+
+    std::unique_ptr<Frame[]> m_frames;
+    std::unique_ptr<char[]> m_names;
+    uint32_t m_names_used = 0;
+    // Only accessed by the consumer
+    std::unique_ptr<SysprofCaptureAddress[]> m_addresses;
+
+    std::unique_ptr<uint32_t[]> m_ring;
+    std::atomic_uint32_t m_head = 0;  // written by the producer
+    std::atomic_uint32_t m_tail = 0;  // written by the consumer
+    std::atomic_uint32_t m_dropped = 0;
+
+    [[nodiscard]] uint32_t intern(const char* label,
+                                  const char* dynamic_string);
+    [[nodiscard]] SysprofCaptureAddress address(SysprofCaptureWriter* capture,
+                                                uint32_t frame_id);
+    [[nodiscard]] uint32_t& word(uint32_t pos) {
+        return m_ring[pos & (RING_SIZE - 1)];
+    }
+    void add_address(uint32_t* head, SysprofCaptureAddress address) {
+        word((*head)++) = NO_FRAME;
+        word((*head)++) = uint32_t(uint64_t(address));
+        word((*head)++) = uint32_t(uint64_t(address) >> 32);
+    }
+
+ public:
+    SampleBuffer()
+        : m_frames(new Frame[N_FRAMES]),
+          m_names(new char[NAMES_SIZE]),
+          m_addresses(new SysprofCaptureAddress[N_FRAMES]()),
+          m_ring(new uint32_t[RING_SIZE]) {
+        for (uint32_t ix = 0; ix < N_FRAMES; ix++)
+            m_frames[ix].ready = false;
+    }
+
+    // Called from the SIGPROF handler. @native_frames, if any, are merged
+    // with the frames of @stack.
+    void add_sample(int64_t time, ProfilingStack* stack, uint32_t depth,
+                    const NativeFrame* native_frames = nullptr,
+                    unsigned n_native_frames = 0);
+
+    // Called from the main loop
+    [[nodiscard]] bool write_samples(SysprofCaptureWriter* capture, GPid pid);
+
+    [[nodiscard]] bool half_full() const {
+        return m_head.load(std::memory_order_relaxed) -
+                   m_tail.load(std::memory_order_relaxed) >=
+               RING_SIZE / 2;
+    }
+
+    // Called from the main loop when switching to another capture, which does
+    // not contain the jitmap entries written to the previous one
+    void forget_addresses() {
+        std::fill_n(m_addresses.get(), N_FRAMES, SysprofCaptureAddress(0));
+    }
+};
+
+SampleBuffer::FrameName::FrameName(const char* label,
+                                   const char* dynamic_string)
+    : parts{label, " ", dynamic_string ? dynamic_string : ""} {
+    size_t available = MAX_NAME_LENGTH;
+    lengths[0] = std::min(strlen(parts[0]), available);
+    available -= lengths[0];
+
+    size_t dynamic_length = strlen(parts[2]);
+    lengths[1] = lengths[0] > 0 && dynamic_length > 0 && available > 0 ? 1 : 0;
+    available -= lengths[1];
+
+    lengths[2] = std::min(dynamic_length, available);
+    length = lengths[0] + lengths[1] + lengths[2];
+}
+
+// FNV-1a
+uint32_t SampleBuffer::FrameName::hash() const {
+    uint32_t hash = 2166136261u;
+    for (size_t part = 0; part < 3; part++) {
+        for (size_t ix = 0; ix < lengths[part]; ix++) {
+            hash ^= static_cast<unsigned char>(parts[part][ix]);
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+bool SampleBuffer::FrameName::equals(const char* name, size_t len) const {
+    if (len != length)
+        return false;
+    for (size_t part = 0; part < 3; part++) {
+        if (memcmp(name, parts[part], lengths[part]) != 0)
+            return false;
+        name += lengths[part];
+    }
+    return true;
+}
+
+void SampleBuffer::FrameName::copy_to(char* dest) const {
+    for (size_t part = 0; part < 3; part++) {
+        memcpy(dest, parts[part], lengths[part]);
+        dest += lengths[part];
+    }
+    *dest = '\0';
+}
+
+// Returns the ID of the frame, or NO_FRAME if it has no name or if there is no
+// more room to intern it
+uint32_t SampleBuffer::intern(const char* label, const char* dynamic_string) {
+    FrameName name{label, dynamic_string};
+    if (name.length == 0)
+        return NO_FRAME;
+
+    uint32_t hash = name.hash();
+    for (uint32_t probe = 0; probe < N_FRAMES; probe++) {
+        uint32_t ix = (hash + probe) & (N_FRAMES - 1);
+        Frame& frame = m_frames[ix];
+
+        if (!frame.ready.load(std::memory_order_acquire)) {
+            if (m_names_used + name.length + 1 > NAMES_SIZE)
+                return NO_FRAME;
+            frame.hash = hash;
+            frame.name_offset = m_names_used;
+            frame.name_length = name.length;
+            name.copy_to(&m_names[m_names_used]);
+            m_names_used += name.length + 1;
+            frame.ready.store(true, std::memory_order_release);
+            return ix + 1;
+        }
+
+        if (frame.hash == hash &&
+            name.equals(&m_names[frame.name_offset], frame.name_length))
+            return ix + 1;
+    }
+    return NO_FRAME;
+}
+
+void SampleBuffer::add_sample(int64_t time, ProfilingStack* stack,
+                              uint32_t depth, const NativeFrame* native_frames,
+                              unsigned n_native_frames) {
+    uint32_t head = m_head.load(std::memory_order_relaxed);
+    uint32_t tail = m_tail.load(std::memory_order_acquire);
+
+    // Header, and at most 3 words per frame
+    uint32_t n_frames = depth + n_native_frames;
+    if (RING_SIZE - (head - tail) < 3 + 3 * n_frames) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    word(head++) = n_frames;
+    word(head++) = uint32_t(uint64_t(time));
+    word(head++) = uint32_t(uint64_t(time) >> 32);
+
+    // Innermost frame first. The stack grows down, so the native frames that
+    // run inside a label frame are the ones below the label's stack address.
+    unsigned native_ix = 0;
+    for (uint32_t ix = depth; ix-- > 0;) {
+        js::ProfilingStackFrame& entry = stack->frames[ix];
+
+        if (!entry.isJsFrame()) {
+            auto boundary = uintptr_t(entry.stackAddress());
+            for (; native_ix < n_native_frames &&
+                   native_frames[native_ix].frame_address < boundary;
+                 native_ix++)
+                add_address(&head, native_frames[native_ix].address);
+        }
+
+        uint32_t frame_id = intern(entry.label(), entry.dynamicString());
+        if (frame_id != NO_FRAME) {
+            word(head++) = frame_id;
+            continue;
+        }
+
+        /*
+         * GeckoProfiler will put "js::RunScript" on the stack, but it has
+         * a stack address of "this", which is not terribly useful since
+         * everything will show up as [stack] when building callgraphs.
+         */
+        add_address(&head, SysprofCaptureAddress(entry.stackAddress()));
+    }
+
+    // The native frames that called into the outermost label frame
+    for (; native_ix < n_native_frames; native_ix++)
+        add_address(&head, native_frames[native_ix].address);
+
+    m_head.store(head, std::memory_order_release);
+}
+
+SysprofCaptureAddress SampleBuffer::address(SysprofCaptureWriter* capture,
+                                            uint32_t frame_id) {
+    SysprofCaptureAddress& address = m_addresses[frame_id - 1];
+    if (address == 0) {
+        const Frame& frame = m_frames[frame_id - 1];
+        address = sysprof_capture_writer_add_jitmap(
+            capture, &m_names[frame.name_offset]);
+    }
+    return address;
+}
+
+bool SampleBuffer::write_samples(SysprofCaptureWriter* capture, GPid pid) {
+    uint32_t head = m_head.load(std::memory_order_acquire);
+    uint32_t tail = m_tail.load(std::memory_order_relaxed);
+    std::vector<SysprofCaptureAddress> addrs;
+
+    while (tail != head) {
+        uint32_t n_frames = word(tail++);
+        uint64_t time = word(tail++);
+        time |= uint64_t(word(tail++)) << 32;
+
+        addrs.resize(n_frames);
+        for (uint32_t ix = 0; ix < n_frames; ix++) {
+            uint32_t frame_id = word(tail++);
+            if (frame_id != NO_FRAME) {
+                addrs[ix] = address(capture, frame_id);
+                continue;
+            }
+            uint64_t stack_address = word(tail++);
+            stack_address |= uint64_t(word(tail++)) << 32;
+            addrs[ix] = SysprofCaptureAddress(stack_address);
+        }
+
+        if (!sysprof_capture_writer_add_sample(capture, int64_t(time), -1, pid,
+                                               -1, addrs.data(), n_frames))
+            return false;
+
+        // Make room for the SIGPROF handler as soon as possible
+        m_tail.store(tail, std::memory_order_release);
+    }
+
+    uint32_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        Gjs::AutoChar message{g_strdup_printf("%u samples", dropped)};
+        return sysprof_capture_writer_add_mark(
+            capture, g_get_monotonic_time() * 1000L, -1, pid, 0, "GJS",
+            "Samples dropped", message);
+    }
+    return true;
+}
+
+/*
+ * DispatchStats:
+ *
+ * Histograms of the dispatch durations and of the lateness of one kind of
+ * main loop source. The buckets are powers of two of microseconds.
+ */
+struct DispatchStats {
+    static constexpr unsigned N_BUCKETS = 32;
+
+    uint64_t count = 0;
+    uint64_t n_late = 0;
+    int64_t total_duration = 0;
+    int64_t max_duration = 0;
+    std::array<uint64_t, N_BUCKETS> durations{};
+    std::array<uint64_t, N_BUCKETS> latenesses{};
+
+    [[nodiscard]] static unsigned bucket(int64_t time_ns) {
+        return std::min(g_bit_storage(uint64_t(time_ns / 1000)),
+                        N_BUCKETS - 1);
+    }
+
+    // Upper bound of the bucket containing the quantile @q, in milliseconds
+    [[nodiscard]] static double quantile(
+        const std::array<uint64_t, N_BUCKETS>& buckets, uint64_t n, double q) {
+        uint64_t rank = uint64_t(q * n);
+        uint64_t seen = 0;
+        for (unsigned ix = 0; ix < N_BUCKETS; ix++) {
+            seen += buckets[ix];
+            if (seen > rank)
+                return (uint64_t(1) << ix) / 1000.0;
+        }
+        return (uint64_t(1) << (N_BUCKETS - 1)) / 1000.0;
+    }
+
+    void add(int64_t duration, int64_t lateness) {
+        count++;
+        total_duration += duration;
+        max_duration = std::max(max_duration, duration);
+        durations[bucket(duration)]++;
+        if (lateness >= 0) {
+            n_late++;
+            latenesses[bucket(lateness)]++;
+        }
+    }
+
+    [[nodiscard]] std::string summary(const std::string& name) const {
+        Gjs::AutoChar text{g_strdup_printf(
+            "%s: %" G_GUINT64_FORMAT
+            " dispatches, %.3f ms total, %.3f ms max, p50 <= %.3f ms, "
+            "p99 <= %.3f ms",
+            name.c_str(), count, total_duration / 1e6, max_duration / 1e6,
+            quantile(durations, count, 0.5), quantile(durations, count, 0.99))};
+        std::string retval{text.get()};
+        if (n_late > 0) {
+            text = g_strdup_printf("; late p50 <= %.3f ms, p99 <= %.3f ms",
+                                   quantile(latenesses, n_late, 0.5),
+                                   quantile(latenesses, n_late, 0.99));
+            retval += text.get();
+        }
+        return retval;
+    }
+};
+
+// Defers SIGPROF while the main loop replaces the capture that the SIGPROF
+// handler writes counters to
+class AutoBlockSigprof {
+    sigset_t m_old_mask;
+
+ public:
+    AutoBlockSigprof() {
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGPROF);
+        pthread_sigmask(SIG_BLOCK, &mask, &m_old_mask);
+    }
+    ~AutoBlockSigprof() { pthread_sigmask(SIG_SETMASK, &m_old_mask, nullptr); }
+};
+
+}  // namespace Gjs
+
+#endif  // ENABLE_PROFILER
+
 struct _GjsProfiler {
 #ifdef ENABLE_PROFILER
     /* The stack for the JSContext profiler to use for current stack
@@ -95,12 +478,22 @@ struct _GjsProfiler {
     /* Buffers and writes our sampled stacks */
     SysprofCaptureWriter* capture;
     GSource* periodic_flush;
+    Gjs::SampleBuffer* samples;
+
+    // Converts the capture to another format, if not writing a sysprof
+    // capture; the capture is then kept in memory
+    Gjs::ProfileExporter* exporter;
 
     SysprofCaptureWriter* target_capture;
 
     // Cache previous values of counters so that we don't overrun the output
     // with counters that don't change very often
     uint64_t last_counter_values[GJS_N_COUNTERS];
+    uint64_t last_stat_counter_values[GJS_N_STAT_COUNTERS];
+
+    // Totals and time at which the rate counters were last computed
+    uint64_t last_rate_totals[GJS_N_RATE_COUNTERS];
+    int64_t last_rate_time;
 #endif  /* ENABLE_PROFILER */
 
     /* The filename to write to */
@@ -116,6 +509,11 @@ struct _GjsProfiler {
     /* Cached copy of our pid */
     GPid pid;
 
+    // Whether to sample the native stack along with the JS stack, and the
+    // upper bound of the native stack of the JS thread
+    bool native_stacks;
+    uintptr_t stack_end;
+
     /* Timing information */
     int64_t gc_begin_time;
     int64_t sweep_begin_time;
@@ -124,8 +522,32 @@ struct _GjsProfiler {
 
     /* GLib signal handler ID for SIGUSR2 */
     unsigned sigusr2_id;
+
+    // Main loop dispatch tracing, with GJS_PROFILER_TRACE_DISPATCH
+    GMainContext* traced_main_context;
+    GPollFunc original_poll;
+    int64_t last_poll_end;
+    std::unordered_map<std::string, Gjs::DispatchStats>* dispatch_stats;
+
+    // Flight recorder mode, with GJS_PROFILER_RING: the capture is an
+    // in-memory segment that is replaced by a new one every ring_duration
+    // seconds, keeping only the previous one
+    unsigned ring_duration;  // 0 to write the capture directly
+    SysprofCaptureWriter* ring_previous;
+    SysprofCaptureWriter* ring_output;  // nullptr to dump to new files
+    int64_t ring_segment_begin;
+    int64_t last_dump_time;
+    unsigned n_dumps;
+
+    // Dumps the ring after main loop stalls, with GJS_PROFILER_RING_STALL
+    int64_t stall_threshold;  // 0 not to watch for stalls
+    GSource* stall_watchdog;
+    int64_t last_watchdog_tick;
+
     unsigned counter_base;  // index of first GObject memory counter
     unsigned gc_counter_base;  // index of first GC stats counter
+    unsigned stat_counter_base;  // index of first runtime stats counter
+    unsigned rate_counter_base;  // index of first runtime rate counter
 #endif  /* ENABLE_PROFILER */
 
     /* If we are currently sampling */
@@ -188,11 +610,12 @@ static GjsContext *profiling_context;
 
 static void setup_counter_helper(SysprofCaptureCounter* counter,
                                  const char* counter_name,
+                                 const char* description,
                                  unsigned counter_base, size_t ix) {
     g_snprintf(counter->category, sizeof counter->category, "GJS");
     g_snprintf(counter->name, sizeof counter->name, "%s", counter_name);
     g_snprintf(counter->description, sizeof counter->description, "%s",
-               GJS_COUNTER_DESCRIPTIONS[ix]);
+               description);
     counter->id = uint32_t(counter_base + ix);
     counter->type = SYSPROF_CAPTURE_COUNTER_INT64;
     counter->value.v64 = 0;
@@ -207,9 +630,10 @@ static void setup_counter_helper(SysprofCaptureCounter* counter,
     self->counter_base =
         sysprof_capture_writer_request_counter(self->capture, GJS_N_COUNTERS);
 
-#    define SETUP_COUNTER(counter_name, ix)                                    \
-        setup_counter_helper(&counters[ix], #counter_name, self->counter_base, \
-                             ix);
+#    define SETUP_COUNTER(counter_name, ix)                         \
+        setup_counter_helper(&counters[ix], #counter_name,          \
+                             GJS_COUNTER_DESCRIPTIONS[ix],          \
+                             self->counter_base, ix);
     GJS_FOR_EACH_COUNTER(SETUP_COUNTER);
 #    undef SETUP_COUNTER
 
@@ -217,6 +641,38 @@ static void setup_counter_helper(SysprofCaptureCounter* counter,
             self->capture, now, -1, self->pid, counters.data(), GJS_N_COUNTERS))
         return false;
 
+    std::array<SysprofCaptureCounter, GJS_N_STAT_COUNTERS> stat_counters;
+    self->stat_counter_base = sysprof_capture_writer_request_counter(
+        self->capture, GJS_N_STAT_COUNTERS);
+
+#    define SETUP_STAT_COUNTER(counter_name, ix)                      \
+        setup_counter_helper(&stat_counters[ix], #counter_name,       \
+                             GJS_STAT_COUNTER_DESCRIPTIONS[ix],       \
+                             self->stat_counter_base, ix);
+    GJS_FOR_EACH_STAT_COUNTER(SETUP_STAT_COUNTER);
+#    undef SETUP_STAT_COUNTER
+
+    if (!sysprof_capture_writer_define_counters(self->capture, now, -1,
+                                                self->pid, stat_counters.data(),
+                                                GJS_N_STAT_COUNTERS))
+        return false;
+
+    std::array<SysprofCaptureCounter, GJS_N_RATE_COUNTERS> rate_counters;
+    self->rate_counter_base = sysprof_capture_writer_request_counter(
+        self->capture, GJS_N_RATE_COUNTERS);
+
+#    define SETUP_RATE_COUNTER(counter_name, ix, total)               \
+        setup_counter_helper(&rate_counters[ix], #counter_name,       \
+                             GJS_RATE_COUNTER_DESCRIPTIONS[ix],       \
+                             self->rate_counter_base, ix);
+    GJS_FOR_EACH_RATE_COUNTER(SETUP_RATE_COUNTER);
+#    undef SETUP_RATE_COUNTER
+
+    if (!sysprof_capture_writer_define_counters(self->capture, now, -1,
+                                                self->pid, rate_counters.data(),
+                                                GJS_N_RATE_COUNTERS))
+        return false;
+
     std::array<SysprofCaptureCounter, Gjs::GCCounters::N_COUNTERS> gc_counters;
     self->gc_counter_base = sysprof_capture_writer_request_counter(
         self->capture, Gjs::GCCounters::N_COUNTERS);
@@ -245,6 +701,40 @@ static void setup_counter_helper(SysprofCaptureCounter* counter,
                                                   Gjs::GCCounters::N_COUNTERS);
 }
 
+[[nodiscard]] static unsigned read_env_number(const char* variable,
+                                              const char* unit) {
+    const char* env = g_getenv(variable);
+    if (!env)
+        return 0;
+
+    char* end;
+    uint64_t value = g_ascii_strtoull(env, &end, 10);
+    if (end == env || *end != '\0' || value > G_MAXUINT) {
+        g_warning("Invalid %s '%s', expected a number of %s", variable, env,
+                  unit);
+        return 0;
+    }
+    return value;
+}
+
+// A capture that is only kept in memory, for the flight recorder and for the
+// exporters to other formats
+[[nodiscard]] static SysprofCaptureWriter* gjs_profiler_new_memory_capture() {
+    int fd = memfd_create("gjs-profiler", MFD_CLOEXEC);
+    if (fd == -1)
+        return nullptr;
+
+    SysprofCaptureWriter* capture = sysprof_capture_writer_new_from_fd(fd, 0);
+    if (!capture)
+        close(fd);
+    return capture;
+}
+
+static void gjs_profiler_clear_exporter(GjsProfiler* self) {
+    delete self->exporter;
+    self->exporter = nullptr;
+}
+
 #endif  /* ENABLE_PROFILER */
 
 /*
@@ -290,6 +780,10 @@ _gjs_profiler_new(GjsContext *context)
 #ifdef ENABLE_PROFILER
     self->cx = static_cast<JSContext *>(gjs_context_get_native_context(context));
     self->pid = getpid();
+    self->ring_duration = read_env_number("GJS_PROFILER_RING", "seconds");
+    self->stall_threshold =
+        int64_t(read_env_number("GJS_PROFILER_RING_STALL", "milliseconds")) *
+        1000000;
 #endif
     self->fd = -1;
 
@@ -323,6 +817,7 @@ _gjs_profiler_free(GjsProfiler *self)
     g_clear_pointer(&self->capture, sysprof_capture_writer_unref);
     g_clear_pointer(&self->periodic_flush, g_source_destroy);
     g_clear_pointer(&self->target_capture, sysprof_capture_writer_unref);
+    g_clear_pointer(&self->ring_output, sysprof_capture_writer_unref);
 
     if (self->fd != -1)
         close(self->fd);
@@ -351,8 +846,62 @@ _gjs_profiler_is_running(GjsProfiler *self)
 
 #ifdef ENABLE_PROFILER
 
+#    define MAX_NATIVE_FRAMES 128
+
+/*
+ * unwind_native_stack:
+ *
+ * Walks the chain of frame pointers of the code interrupted by SIGPROF. This
+ * only finds the frames of code built with frame pointers; the walk stops at
+ * the first frame that was not. Every frame address is checked to be inside
+ * the stack of the JS thread before it is read, so this is signal-safe.
+ *
+ * Returns: the number of frames stored in @frames, innermost first.
+ */
+#    if defined(__x86_64__) || defined(__aarch64__)
+static unsigned unwind_native_stack(GjsProfiler* self, void* context,
+                                    Gjs::NativeFrame* frames) {
+    auto* uc = static_cast<ucontext_t*>(context);
+#        if defined(__x86_64__)
+    uintptr_t pc = uc->uc_mcontext.gregs[REG_RIP];
+    uintptr_t fp = uc->uc_mcontext.gregs[REG_RBP];
+    uintptr_t sp = uc->uc_mcontext.gregs[REG_RSP];
+#        else
+    uintptr_t pc = uc->uc_mcontext.pc;
+    uintptr_t fp = uc->uc_mcontext.regs[29];
+    uintptr_t sp = uc->uc_mcontext.sp;
+#        endif
+
+    unsigned n_frames = 0;
+    frames[n_frames++] = {sp, pc};
+
+    // Each frame starts with the caller's frame pointer, followed by the
+    // return address
+    while (n_frames < MAX_NATIVE_FRAMES && fp >= sp &&
+           fp + 2 * sizeof(uintptr_t) <= self->stack_end &&
+           fp % sizeof(uintptr_t) == 0) {
+        auto* frame = reinterpret_cast<uintptr_t*>(fp);
+        uintptr_t return_address = frame[1];
+        if (return_address == 0)
+            break;
+        frames[n_frames++] = {fp, return_address};
+
+        uintptr_t caller_fp = frame[0];
+        if (caller_fp <= fp)
+            break;
+        fp = caller_fp;
+    }
+
+    return n_frames;
+}
+#    else
+static unsigned unwind_native_stack(GjsProfiler*, void*, Gjs::NativeFrame*) {
+    return 0;
+}
+#    endif
+
 static void gjs_profiler_sigprof(int signum [[maybe_unused]], siginfo_t* info,
-                                 void*) {
+                                 void* context) {
     GjsProfiler *self = gjs_context_get_profiler(profiling_context);
 
     g_assert(((void) "SIGPROF handler called with invalid signal info", info));
@@ -367,7 +916,7 @@ static void gjs_profiler_sigprof(int signum [[maybe_unused]], siginfo_t* info,
      * that is not okay to do, is *malloc*.
      */
 
-    if (!self || info->si_code != SI_TIMER)
+    if (!self || !self->samples || info->si_code != SI_TIMER)
         return;
 
     uint32_t depth = self->stack.stackSize();
@@ -376,82 +925,21 @@ static void gjs_profiler_sigprof(int signum [[maybe_unused]], siginfo_t* info,
 
     int64_t now = g_get_monotonic_time() * 1000L;
 
-    /* NOTE: cppcheck warns that alloca() is not recommended since it can
-     * easily overflow the stack; however, dynamic allocation is not an option
-     * here since we are in a signal handler.
-     */
-    SysprofCaptureAddress* addrs =
-        // cppcheck-suppress allocaCalled
-        static_cast<SysprofCaptureAddress*>(alloca(sizeof *addrs * depth));
-
-    for (uint32_t ix = 0; ix < depth; ix++) {
-        js::ProfilingStackFrame& entry = self->stack.frames[ix];
-        const char *label = entry.label();
-        const char *dynamic_string = entry.dynamicString();
-        uint32_t flipped = depth - 1 - ix;
-        size_t label_length = strlen(label);
-
-        /*
-         * 512 is an arbitrarily large size, very likely to be enough to
-         * hold the final string.
-         */
-        char final_string[512];
-        char *position = final_string;
-        size_t available_length = sizeof (final_string) - 1;
-
-        if (label_length > 0) {
-            label_length = MIN(label_length, available_length);
-
-            /* Start copying the label to the final string */
-            memcpy(position, label, label_length);
-            available_length -= label_length;
-            position += label_length;
-
-            /*
-             * Add a space in between the label and the dynamic string,
-             * if there is one.
-             */
-            if (dynamic_string && available_length > 0) {
-                *position++ = ' ';
-                available_length--;
-            }
-        }
-
-        /* Now append the dynamic string at the end of the final string.
-         * The string is cut in case it doesn't fit the remaining space.
-         */
-        if (dynamic_string) {
-            size_t dynamic_string_length = strlen(dynamic_string);
-
-            if (dynamic_string_length > 0) {
-                size_t remaining_length = MIN(available_length, dynamic_string_length);
-                memcpy(position, dynamic_string, remaining_length);
-                position += remaining_length;
-            }
-        }
-
-        *position = 0;
-
-        /*
-         * GeckoProfiler will put "js::RunScript" on the stack, but it has
-         * a stack address of "this", which is not terribly useful since
-         * everything will show up as [stack] when building callgraphs.
-         */
-        if (final_string[0] != '\0')
-            addrs[flipped] =
-                sysprof_capture_writer_add_jitmap(self->capture, final_string);
-        else
-            addrs[flipped] = SysprofCaptureAddress(entry.stackAddress());
-    }
-
-    if (!sysprof_capture_writer_add_sample(self->capture, now, -1, self->pid,
-                                           -1, addrs, depth)) {
-        gjs_profiler_stop(self);
-        return;
+    // Not available when called through gjs_profiler_chain_signal()
+    if (self->native_stacks && context) {
+        Gjs::NativeFrame native_frames[MAX_NATIVE_FRAMES];
+        unsigned n_native_frames =
+            unwind_native_stack(self, context, native_frames);
+        self->samples->add_sample(now, &self->stack, depth, native_frames,
+                                  n_native_frames);
+    } else {
+        self->samples->add_sample(now, &self->stack, depth);
     }
 
-    unsigned ids[GJS_N_COUNTERS];
-    SysprofCaptureCounterValue values[GJS_N_COUNTERS];
+    constexpr size_t max_counts =
+        GJS_N_COUNTERS + GJS_N_STAT_COUNTERS + GJS_N_RATE_COUNTERS;
+    unsigned ids[max_counts];
+    SysprofCaptureCounterValue values[max_counts];
     size_t new_counts = 0;
 
 #    define FETCH_COUNTERS(name, ix)                       \
@@ -467,23 +955,250 @@ static void gjs_profiler_sigprof(int signum [[maybe_unused]], siginfo_t* info,
     GJS_FOR_EACH_COUNTER(FETCH_COUNTERS);
 #    undef FETCH_COUNTERS
 
+#    define FETCH_STAT_COUNTERS(name, ix)                       \
+        {                                                       \
+            uint64_t count = GJS_GET_COUNTER(name);             \
+            if (count != self->last_stat_counter_values[ix]) {  \
+                ids[new_counts] = self->stat_counter_base + ix; \
+                values[new_counts].v64 = count;                 \
+                new_counts++;                                   \
+            }                                                   \
+            self->last_stat_counter_values[ix] = count;         \
+        }
+    GJS_FOR_EACH_STAT_COUNTER(FETCH_STAT_COUNTERS);
+#    undef FETCH_STAT_COUNTERS
+
+    // Rates are averaged over at least a second, since most samples would
+    // otherwise see only zero or one event
+    int64_t elapsed = now - self->last_rate_time;
+    if (self->last_rate_time == 0 || elapsed >= G_GINT64_CONSTANT(1000000000)) {
+#    define FETCH_RATE_COUNTERS(name, ix, total)                           \
+        {                                                                  \
+            uint64_t count = GJS_GET_COUNTER(total);                       \
+            if (self->last_rate_time != 0) {                               \
+                ids[new_counts] = self->rate_counter_base + ix;            \
+                values[new_counts].v64 =                                   \
+                    (count - self->last_rate_totals[ix]) * 1000000000 /    \
+                    elapsed;                                               \
+                new_counts++;                                              \
+            }                                                              \
+            self->last_rate_totals[ix] = count;                            \
+        }
+        GJS_FOR_EACH_RATE_COUNTER(FETCH_RATE_COUNTERS);
+#    undef FETCH_RATE_COUNTERS
+        self->last_rate_time = now;
+    }
+
     if (new_counts > 0 &&
         !sysprof_capture_writer_set_counters(self->capture, now, -1, self->pid,
                                              ids, values, new_counts))
         gjs_profiler_stop(self);
 }
 
+// Main loop iterations longer than this get a mark of their own
+#    define LONG_ITERATION_NS (G_GINT64_CONSTANT(1000000))
+
+static void record_dispatch(GjsProfiler* self, const char* name,
+                            int64_t duration, int64_t lateness) {
+    (*self->dispatch_stats)[name].add(duration, lateness);
+}
+
+/*
+ * gjs_profiler_traced_poll:
+ *
+ * Replaces the poll function of the main context while dispatches are traced.
+ * Everything that happens between two polls is one iteration of the main
+ * loop: preparing, checking and dispatching the sources.
+ */
+static int gjs_profiler_traced_poll(GPollFD* fds, unsigned n_fds,
+                                    int timeout) {
+    GjsProfiler* self = gjs_context_get_profiler(profiling_context);
+    int64_t now = g_get_monotonic_time() * 1000L;
+
+    if (self->last_poll_end != 0) {
+        int64_t duration = now - self->last_poll_end;
+        record_dispatch(self, "[main loop iteration]", duration, -1);
+        if (duration >= LONG_ITERATION_NS)
+            _gjs_profiler_add_mark(self, self->last_poll_end, duration, "GJS",
+                                   "Long main loop iteration", nullptr);
+    }
+
+    int retval = self->original_poll(fds, n_fds, timeout);
+    self->last_poll_end = g_get_monotonic_time() * 1000L;
+    return retval;
+}
+
+static void gjs_profiler_start_dispatch_tracing(GjsProfiler* self) {
+    self->dispatch_stats =
+        new std::unordered_map<std::string, Gjs::DispatchStats>();
+    self->last_poll_end = 0;
+
+    self->traced_main_context = g_main_context_ref_thread_default();
+    self->original_poll =
+        g_main_context_get_poll_func(self->traced_main_context);
+    g_main_context_set_poll_func(self->traced_main_context,
+                                 gjs_profiler_traced_poll);
+
+    Gjs::trace_source_dispatch = true;
+}
+
+static void gjs_profiler_stop_dispatch_tracing(GjsProfiler* self) {
+    Gjs::trace_source_dispatch = false;
+
+    g_main_context_set_poll_func(self->traced_main_context,
+                                 self->original_poll);
+    g_clear_pointer(&self->traced_main_context, g_main_context_unref);
+
+    int64_t now = g_get_monotonic_time() * 1000L;
+    for (const auto& [name, stats] : *self->dispatch_stats) {
+        std::string summary{stats.summary(name)};
+        _gjs_profiler_add_mark(self, now, 0, "GJS", "Dispatch statistics",
+                               summary.c_str());
+    }
+
+    delete self->dispatch_stats;
+    self->dispatch_stats = nullptr;
+}
+
+/*
+ * gjs_profiler_rotate_capture:
+ *
+ * Replaces the in-memory capture with a new one, and returns the old one in
+ * @old_capture, to which nothing is written anymore. Each capture is complete
+ * on its own, so the memory maps, counters and jitmap entries are written
+ * again to the new one.
+ */
+[[nodiscard]] static bool gjs_profiler_rotate_capture(
+    GjsProfiler* self, SysprofCaptureWriter** old_capture) {
+    SysprofCaptureWriter* capture = gjs_profiler_new_memory_capture();
+    if (!capture)
+        return false;
+
+    Gjs::AutoBlockSigprof block;
+
+    if (!self->samples->write_samples(self->capture, self->pid)) {
+        sysprof_capture_writer_unref(capture);
+        return false;
+    }
+
+    *old_capture = self->capture;
+    self->capture = capture;
+    self->ring_segment_begin = g_get_monotonic_time() * 1000L;
+
+    // Write the current value of every counter to the new segment
+    self->samples->forget_addresses();
+    memset(self->last_counter_values, 0, sizeof self->last_counter_values);
+    memset(self->last_stat_counter_values, 0,
+           sizeof self->last_stat_counter_values);
+
+    return gjs_profiler_extract_maps(self) &&
+           gjs_profiler_define_counters(self);
+}
+
+[[nodiscard]] static bool gjs_profiler_cat_segment(
+    SysprofCaptureWriter* output, SysprofCaptureWriter* segment) {
+    if (!segment)
+        return true;
+
+    SysprofCaptureReader* reader =
+        sysprof_capture_writer_create_reader(segment);
+    if (!reader)
+        return false;
+
+    bool ok = sysprof_capture_writer_cat(output, reader);
+    sysprof_capture_reader_unref(reader);
+    return ok;
+}
+
 static gboolean profiler_auto_flush_cb(void* user_data) {
     auto* self = static_cast<GjsProfiler*>(user_data);
 
     if (!self->running)
         return G_SOURCE_REMOVE;
 
+    if (!self->samples->write_samples(self->capture, self->pid)) {
+        gjs_profiler_stop(self);
+        return G_SOURCE_REMOVE;
+    }
+
+    // Convert what was recorded since the last time, so that the in-memory
+    // capture does not grow
+    if (self->exporter) {
+        SysprofCaptureWriter* old_capture = nullptr;
+        bool ok = gjs_profiler_rotate_capture(self, &old_capture);
+        if (old_capture) {
+            ok = self->exporter->add_capture(old_capture) && ok;
+            sysprof_capture_writer_unref(old_capture);
+        }
+        if (!ok) {
+            g_warning("Failed to export profile");
+            gjs_profiler_stop(self);
+            return G_SOURCE_REMOVE;
+        }
+        return G_SOURCE_CONTINUE;
+    }
+
+    int64_t now = g_get_monotonic_time() * 1000L;
+    if (self->ring_duration > 0 &&
+        now - self->ring_segment_begin >=
+            int64_t(self->ring_duration * NSEC_PER_SEC)) {
+        SysprofCaptureWriter* old_capture = nullptr;
+        bool ok = gjs_profiler_rotate_capture(self, &old_capture);
+        if (old_capture) {
+            g_clear_pointer(&self->ring_previous, sysprof_capture_writer_unref);
+            self->ring_previous = old_capture;
+        }
+        if (!ok) {
+            g_warning("Failed to start a new flight recorder segment");
+            gjs_profiler_stop(self);
+            return G_SOURCE_REMOVE;
+        }
+        return G_SOURCE_CONTINUE;
+    }
+
     sysprof_capture_writer_flush(self->capture);
 
     return G_SOURCE_CONTINUE;
 }
 
+#    define STALL_WATCHDOG_INTERVAL_MS 100
+
+/*
+ * profiler_stall_watchdog_cb:
+ *
+ * Runs every STALL_WATCHDOG_INTERVAL_MS. When it runs much later than that,
+ * the main loop was blocked, and the samples taken meanwhile are still in the
+ * flight recorder, so it is dumped.
+ */
+static gboolean profiler_stall_watchdog_cb(void* user_data) {
+    auto* self = static_cast<GjsProfiler*>(user_data);
+
+    if (!self->running)
+        return G_SOURCE_REMOVE;
+
+    int64_t now = g_get_monotonic_time() * 1000L;
+    int64_t stall = now - self->last_watchdog_tick -
+                    STALL_WATCHDOG_INTERVAL_MS * G_GINT64_CONSTANT(1000000);
+    self->last_watchdog_tick = now;
+    if (stall < self->stall_threshold)
+        return G_SOURCE_CONTINUE;
+
+    _gjs_profiler_add_mark(self, now - stall, stall, "GJS", "Main loop stall",
+                           nullptr);
+
+    // A dump already contains the whole ring, so don't repeat it for every
+    // stall of a series
+    if (self->last_dump_time != 0 &&
+        now - self->last_dump_time <
+            int64_t(self->ring_duration * NSEC_PER_SEC))
+        return G_SOURCE_CONTINUE;
+
+    if (!gjs_profiler_dump_ring(self))
+        g_warning("Failed to dump the profiler flight recorder");
+
+    return G_SOURCE_CONTINUE;
+}
+
 #endif  /* ENABLE_PROFILER */
 
 /**
@@ -517,21 +1232,35 @@ gjs_profiler_start(GjsProfiler *self)
     struct itimerspec its = {{0}};
     struct itimerspec old_its;
 
-    if (self->target_capture) {
+    if (self->ring_duration > 0) {
+        self->capture = gjs_profiler_new_memory_capture();
+        self->ring_segment_begin = g_get_monotonic_time() * 1000L;
+    } else if (self->target_capture) {
         self->capture = sysprof_capture_writer_ref(self->target_capture);
     } else if (self->fd != -1) {
         self->capture = sysprof_capture_writer_new_from_fd(self->fd, 0);
         self->fd = -1;
     } else {
         Gjs::AutoChar path{g_strdup(self->filename)};
+        auto format = Gjs::ProfileExporter::format_for(path);
         if (!path)
-            path = g_strdup_printf("gjs-%jd.syscap", intmax_t(self->pid));
-
-        self->capture = sysprof_capture_writer_new(path, 0);
+            path = g_strdup_printf("gjs-%jd.%s", intmax_t(self->pid),
+                                   Gjs::ProfileExporter::extension(format));
+
+        if (format == Gjs::ProfileExporter::Format::SYSPROF) {
+            self->capture = sysprof_capture_writer_new(path, 0);
+        } else {
+            // Record in memory, and convert to the output file as we go
+            self->exporter =
+                Gjs::ProfileExporter::create(format, path, self->pid).release();
+            if (self->exporter)
+                self->capture = gjs_profiler_new_memory_capture();
+        }
     }
 
     if (!self->capture) {
         g_warning("Failed to open profile capture");
+        gjs_profiler_clear_exporter(self);
         return;
     }
 
@@ -553,6 +1282,7 @@ gjs_profiler_start(GjsProfiler *self)
         g_warning("Failed to extract proc maps");
         g_clear_pointer(&self->capture, sysprof_capture_writer_unref);
         g_clear_pointer(&self->periodic_flush, g_source_destroy);
+        gjs_profiler_clear_exporter(self);
         return;
     }
 
@@ -560,9 +1290,34 @@ gjs_profiler_start(GjsProfiler *self)
         g_warning("Failed to define sysprof counters");
         g_clear_pointer(&self->capture, sysprof_capture_writer_unref);
         g_clear_pointer(&self->periodic_flush, g_source_destroy);
+        gjs_profiler_clear_exporter(self);
         return;
     }
 
+    self->samples = new Gjs::SampleBuffer();
+
+    // The signal is delivered to this thread, so its stack is the one that
+    // will be unwound
+    const char* env_native_stacks = g_getenv("GJS_PROFILER_NATIVE_STACKS");
+    self->native_stacks =
+        env_native_stacks && strcmp(env_native_stacks, "0") != 0;
+    self->stack_end = 0;
+    if (self->native_stacks) {
+        pthread_attr_t attr;
+        void* stack_addr;
+        size_t stack_size;
+        if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+            if (pthread_attr_getstack(&attr, &stack_addr, &stack_size) == 0)
+                self->stack_end = uintptr_t(stack_addr) + stack_size;
+            pthread_attr_destroy(&attr);
+        }
+        if (self->stack_end == 0) {
+            g_warning("Could not find the stack bounds; not sampling native "
+                      "stacks");
+            self->native_stacks = false;
+        }
+    }
+
     /* Setup our signal handler for SIGPROF delivery */
     sa.sa_flags = SA_RESTART | SA_SIGINFO;
     sa.sa_sigaction = gjs_profiler_sigprof;
@@ -572,6 +1327,9 @@ gjs_profiler_start(GjsProfiler *self)
         g_warning("Failed to register sigaction handler: %s", g_strerror(errno));
         g_clear_pointer(&self->capture, sysprof_capture_writer_unref);
         g_clear_pointer(&self->periodic_flush, g_source_destroy);
+        gjs_profiler_clear_exporter(self);
+        delete self->samples;
+        self->samples = nullptr;
         return;
     }
 
@@ -593,6 +1351,9 @@ gjs_profiler_start(GjsProfiler *self)
         g_warning("Failed to create profiler timer: %s", g_strerror(errno));
         g_clear_pointer(&self->capture, sysprof_capture_writer_unref);
         g_clear_pointer(&self->periodic_flush, g_source_destroy);
+        gjs_profiler_clear_exporter(self);
+        delete self->samples;
+        self->samples = nullptr;
         return;
     }
 
@@ -608,10 +1369,45 @@ gjs_profiler_start(GjsProfiler *self)
         timer_delete(self->timer);
         g_clear_pointer(&self->capture, sysprof_capture_writer_unref);
         g_clear_pointer(&self->periodic_flush, g_source_destroy);
+        gjs_profiler_clear_exporter(self);
+        delete self->samples;
+        self->samples = nullptr;
         return;
     }
 
+    if (self->ring_duration > 0) {
+        // Dumps go to the capture writer or file descriptor, if one was given
+        if (self->target_capture) {
+            self->ring_output =
+                sysprof_capture_writer_ref(self->target_capture);
+        } else if (self->fd != -1) {
+            self->ring_output =
+                sysprof_capture_writer_new_from_fd(self->fd, 0);
+            self->fd = -1;
+        }
+        self->last_dump_time = 0;
+
+        if (self->stall_threshold > 0) {
+            self->last_watchdog_tick = g_get_monotonic_time() * 1000L;
+            self->stall_watchdog =
+                g_timeout_source_new(STALL_WATCHDOG_INTERVAL_MS);
+            g_source_set_name(self->stall_watchdog,
+                              "[gjs-profiler-stall-watchdog]");
+            // Run first after a stall, so as not to measure other sources
+            g_source_set_priority(self->stall_watchdog, G_PRIORITY_HIGH);
+            g_source_set_callback(self->stall_watchdog,
+                                  profiler_stall_watchdog_cb, self, nullptr);
+            g_source_attach(self->stall_watchdog,
+                            g_main_context_get_thread_default());
+        }
+    }
+
     self->running = true;
+    self->last_rate_time = 0;
+
+    const char* env_trace_dispatch = g_getenv("GJS_PROFILER_TRACE_DISPATCH");
+    if (env_trace_dispatch && strcmp(env_trace_dispatch, "0") != 0)
+        gjs_profiler_start_dispatch_tracing(self);
 
     /* Notify the JS runtime of where to put stack info */
     js::SetContextProfilingStack(self->cx, &self->stack);
@@ -662,11 +1458,36 @@ gjs_profiler_stop(GjsProfiler *self)
     js::EnableContextProfilingStack(self->cx, false);
     js::SetContextProfilingStack(self->cx, nullptr);
 
+    // Detach the buffer first, in case a signal is still pending
+    Gjs::SampleBuffer* samples = self->samples;
+    self->samples = nullptr;
+    if (!samples->write_samples(self->capture, self->pid))
+        g_warning("Failed to write profiler samples");
+    delete samples;
+
+    if (self->dispatch_stats)
+        gjs_profiler_stop_dispatch_tracing(self);
+
     sysprof_capture_writer_flush(self->capture);
 
+    if (self->exporter) {
+        if (!self->exporter->add_capture(self->capture) ||
+            !self->exporter->finish())
+            g_warning("Failed to export profile");
+        gjs_profiler_clear_exporter(self);
+    }
+
     g_clear_pointer(&self->capture, sysprof_capture_writer_unref);
     g_clear_pointer(&self->periodic_flush, g_source_destroy);
 
+    // What is left in the flight recorder is dropped
+    g_clear_pointer(&self->ring_previous, sysprof_capture_writer_unref);
+    g_clear_pointer(&self->ring_output, sysprof_capture_writer_unref);
+    if (self->stall_watchdog) {
+        g_source_destroy(self->stall_watchdog);
+        g_clear_pointer(&self->stall_watchdog, g_source_unref);
+    }
+
     g_message("Profiler stopped");
 
 #endif  /* ENABLE_PROFILER */
@@ -683,10 +1504,12 @@ gjs_profiler_sigusr2(void *data)
     GjsProfiler *current_profiler = gjs_context_get_profiler(context);
 
     if (current_profiler) {
-        if (_gjs_profiler_is_running(current_profiler))
-            gjs_profiler_stop(current_profiler);
-        else
+        if (!_gjs_profiler_is_running(current_profiler))
             gjs_profiler_start(current_profiler);
+        else if (current_profiler->ring_duration == 0)
+            gjs_profiler_stop(current_profiler);
+        else if (!gjs_profiler_dump_ring(current_profiler))
+            g_warning("Failed to dump the profiler flight recorder");
     }
 
     return G_SOURCE_CONTINUE;
@@ -800,6 +1623,10 @@ void gjs_profiler_set_capture_writer(GjsProfiler* self, gpointer capture) {
  *
  * Set the file to which profiling data is written when the @self is stopped.
  * By default, this is `gjs-$PID.syscap` in the current directory.
+ *
+ * A file name ending in `.json` gets a Chrome trace instead of a sysprof
+ * capture, and one ending in `.pprof` or `.pb` gets a pprof profile, unless
+ * the `GJS_PROFILER_FORMAT` environment variable says otherwise.
  */
 void
 gjs_profiler_set_filename(GjsProfiler *self,
@@ -812,6 +1639,110 @@ gjs_profiler_set_filename(GjsProfiler *self,
     self->filename = g_strdup(filename);
 }
 
+/**
+ * gjs_profiler_set_ring_duration:
+ * @self: A #GjsProfiler
+ * @seconds: how many seconds of profiling data to keep, or 0
+ *
+ * Puts @self in flight recorder mode, or takes it out of it if @seconds is 0.
+ * In this mode, the profiling data is kept in memory instead of being written
+ * out, and everything older than the last @seconds, or at most about twice
+ * that, is thrown away. Call gjs_profiler_dump_ring() to write it out.
+ *
+ * This overrides the `GJS_PROFILER_RING` environment variable.
+ */
+void gjs_profiler_set_ring_duration(GjsProfiler* self, unsigned seconds) {
+    g_return_if_fail(self);
+    g_return_if_fail(!self->running);
+
+#ifdef ENABLE_PROFILER
+    self->ring_duration = seconds;
+#else
+    (void)seconds;  // Unused in the no-profiler case
+#endif
+}
+
+/**
+ * gjs_profiler_dump_ring:
+ * @self: A #GjsProfiler
+ *
+ * Writes the contents of the flight recorder out, if @self is running in
+ * flight recorder mode (see gjs_profiler_set_ring_duration().)
+ *
+ * The contents are appended to the capture writer or file descriptor that
+ * was set before starting @self, if any. Otherwise, each dump is written to a
+ * new file, named after the one set with gjs_profiler_set_filename() with a
+ * number appended, or `gjs-$PID-$N.syscap` in the current directory by
+ * default.
+ *
+ * This must be called from the JS thread, and not from a signal handler.
+ *
+ * Returns: %TRUE if the contents were written.
+ */
+bool gjs_profiler_dump_ring(GjsProfiler* self) {
+    g_return_val_if_fail(self, false);
+
+#ifdef ENABLE_PROFILER
+    if (!self->running || self->ring_duration == 0)
+        return false;
+
+    int64_t now = g_get_monotonic_time() * 1000L;
+    self->last_dump_time = now;
+
+    Gjs::AutoChar path;
+    SysprofCaptureWriter* output;
+    if (self->ring_output) {
+        output = sysprof_capture_writer_ref(self->ring_output);
+    } else {
+        Gjs::AutoChar base{
+            self->filename ? g_strdup(self->filename)
+                           : g_strdup_printf("gjs-%jd", intmax_t(self->pid))};
+        if (g_str_has_suffix(base, ".syscap"))
+            base.get()[strlen(base) - strlen(".syscap")] = '\0';
+        path = g_strdup_printf("%s-%u.syscap", base.get(), ++self->n_dumps);
+
+        output = sysprof_capture_writer_new(path, 0);
+        if (!output) {
+            g_warning("Failed to open profile capture %s", path.get());
+            return false;
+        }
+    }
+
+    bool ok;
+    {
+        Gjs::AutoBlockSigprof block;
+        ok = self->samples->write_samples(self->capture, self->pid) &&
+             sysprof_capture_writer_add_mark(self->capture, now, -1, self->pid,
+                                             0, "GJS", "Flight recorder dump",
+                                             nullptr) &&
+             gjs_profiler_cat_segment(output, self->ring_previous) &&
+             gjs_profiler_cat_segment(output, self->capture);
+    }
+    ok = ok && sysprof_capture_writer_flush(output);
+    sysprof_capture_writer_unref(output);
+
+    if (ok && path)
+        g_message("Profiler flight recorder written to %s", path.get());
+    return ok;
+#else
+    return false;
+#endif
+}
+
+#ifdef ENABLE_PROFILER
+// The main loop only writes the samples every few seconds, but marks are also
+// added while JS code runs, for instance by the GC callbacks, so a long
+// synchronous run can write them from here before the ring buffer overflows
+static void gjs_profiler_write_samples_if_half_full(GjsProfiler* self) {
+    if (!self->samples || !self->samples->half_full())
+        return;
+
+    Gjs::AutoBlockSigprof block;
+    if (!self->samples->write_samples(self->capture, self->pid))
+        g_warning("Failed to write profiler samples");
+}
+#endif
+
 void _gjs_profiler_add_mark(GjsProfiler* self, int64_t time_nsec,
                             int64_t duration_nsec, const char* group,
                             const char* name, const char* message) {
@@ -823,6 +1754,7 @@ void _gjs_profiler_add_mark(GjsProfiler* self, int64_t time_nsec,
     if (self->running && self->capture != nullptr) {
         sysprof_capture_writer_add_mark(self->capture, time_nsec, -1, self->pid,
                                         duration_nsec, group, name, message);
+        gjs_profiler_write_samples_if_half_full(self);
     }
 #else
     // Unused in the no-profiler case
@@ -958,3 +1890,71 @@ void _gjs_profiler_set_gc_status(GjsProfiler* self, JSGCStatus status,
     (void)reason;
 #endif
 }
+
+int64_t Gjs::read_slow_call_threshold() {
+    const char* env = g_getenv("GJS_SLOW_CALL_THRESHOLD");
+    if (!env)
+        return -1;
+
+    char* end;
+    double threshold_ms = g_ascii_strtod(env, &end);
+    if (end == env || *end != '\0' || threshold_ms < 0) {
+        g_warning("Invalid GJS_SLOW_CALL_THRESHOLD '%s', expected a number "
+                  "of milliseconds",
+                  env);
+        return -1;
+    }
+    return int64_t(threshold_ms * 1000000);
+}
+
+void Gjs::add_slow_call_mark(JSContext* cx, int64_t begin_time,
+                             int64_t duration, const char* name,
+                             const std::string& description) {
+    GjsProfiler* profiler = GjsContextPrivate::from_cx(cx)->profiler();
+    if (profiler && profiler->running) {
+        _gjs_profiler_add_mark(profiler, begin_time, duration, "GJS", name,
+                               description.c_str());
+        return;
+    }
+
+    g_message("%s: %s took %.1f ms", name, description.c_str(),
+              duration / 1e6);
+}
+
+std::atomic_bool Gjs::trace_source_dispatch = false;
+
+void Gjs::add_source_dispatch_mark(GSource* source, int64_t begin_time,
+                                   int64_t ready_time) {
+#ifdef ENABLE_PROFILER
+    // Only the thread of the profiled context may write to the capture
+    if (!profiling_context ||
+        !GjsContextPrivate::from_object(profiling_context)->is_owner_thread())
+        return;
+
+    GjsProfiler* self = gjs_context_get_profiler(profiling_context);
+    if (!self || !self->running || !self->dispatch_stats)
+        return;
+
+    int64_t duration = g_get_monotonic_time() * 1000L - begin_time;
+    // A ready time of 0 means "as soon as possible"
+    int64_t lateness =
+        ready_time > 0 ? std::max(begin_time - ready_time * 1000L, int64_t(0))
+                       : -1;
+
+    const char* name = source ? g_source_get_name(source) : nullptr;
+    if (!name)
+        name = "[unnamed source]";
+
+    Gjs::AutoChar message{
+        lateness >= 0
+            ? g_strdup_printf("%s, %.3f ms late", name, lateness / 1e6)
+            : g_strdup(name)};
+    _gjs_profiler_add_mark(self, begin_time, duration, "GJS", "Source dispatch",
+                           message);
+    record_dispatch(self, name, duration, lateness);
+#else
+    (void)source;
+    (void)begin_time;
+    (void)ready_time;
+#endif
+}
@@ -33,12 +33,18 @@ void gjs_profiler_set_filename(GjsProfiler *self,
 GJS_EXPORT
 void gjs_profiler_set_fd(GjsProfiler* self, int fd);
 
+GJS_EXPORT
+void gjs_profiler_set_ring_duration(GjsProfiler* self, unsigned seconds);
+
 GJS_EXPORT
 void gjs_profiler_start(GjsProfiler *self);
 
 GJS_EXPORT
 void gjs_profiler_stop(GjsProfiler *self);
 
+GJS_EXPORT
+bool gjs_profiler_dump_ring(GjsProfiler* self);
+
 G_END_DECLS
 
 #endif  // GJS_PROFILER_H_
@@ -23,6 +23,7 @@
 #include "gjs/jsapi-util-args.h"
 #include "gjs/jsapi-util.h"
 #include "gjs/macros.h"
+#include "gjs/profiler-private.h"
 #include "gjs/promise.h"
 #include "util/log.h"
 
@@ -76,6 +77,8 @@ class PromiseJobDispatcher::Source : public GSource {
     gboolean prepare(int* timeout [[maybe_unused]]) { return !m_gjs->empty(); }
 
     gboolean dispatch() {
+        Gjs::AutoSourceDispatchMark mark{this};
+
         if (g_cancellable_is_cancelled(m_cancellable))
             return G_SOURCE_REMOVE;
 
@@ -0,0 +1,334 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#include <config.h>
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>
+
+#include <algorithm>  // for make_heap, pop_heap, push_heap, remove_if
+#include <cmath>      // for trunc
+
+#include <glib.h>
+
+#include <js/Array.h>  // for GetArrayLength
+#include <js/CallAndConstruct.h>
+#include <js/CallArgs.h>
+#include <js/ErrorReport.h>  // for JSEXN_TYPEERR
+#include <js/GCVector.h>     // for RootedVector
+#include <js/PropertyAndElement.h>  // for JS_DefineFunctions, JS_GetElement
+#include <js/PropertySpec.h>
+#include <js/Realm.h>
+#include <js/RootingAPI.h>
+#include <js/TracingAPI.h>
+#include <js/TypeDecls.h>
+#include <js/Value.h>
+#include <jsapi.h>        // for JS_NewPlainObject, CurrentGlobalOrNull
+#include <jsfriendapi.h>  // for RunJobs
+
+#include "gjs/context-private.h"
+#include "gjs/jsapi-util-args.h"
+#include "gjs/jsapi-util.h"
+#include "gjs/macros.h"
+#include "gjs/profiler-private.h"
+#include "gjs/timers.h"
+#include "util/log.h"
+
+/**
+ * timers.cpp - This file implements the event loop side of setTimeout() and
+ * setInterval(). Instead of attaching one GLib timeout source per timer, which
+ * makes every main loop iteration scan all outstanding timers, pending timers
+ * are kept in a heap and a single GSource is woken up at the earliest deadline
+ * using g_source_set_ready_time().
+ *
+ * Timers with equal deadlines fire in the order in which they were scheduled,
+ * and the microtask queue is drained after each callback, as required by the
+ * WHATWG timers specification. Timers scheduled from within a callback never
+ * fire in the same dispatch, even with a zero delay, so that a chain of
+ * timers cannot starve the other sources of the main loop.
+ *
+ * A callback may run a nested main loop, for example with GLib.MainLoop.run().
+ * Other timers must keep firing in it, as they did when each timer had a GLib
+ * source of its own, so the source may recurse and dispatch() is re-entrant:
+ * each timer is taken off the heap, and the ready time updated, before its
+ * callback runs.
+ */
+
+namespace Gjs {
+
+/**
+ * TimerQueue::Source:
+ *
+ * A custom GSource which dispatches all timers whose deadline has passed.
+ */
+class TimerQueue::Source : public GSource {
+    TimerQueue* m_queue;
+
+    static GSourceFuncs source_funcs;
+
+ public:
+    explicit Source(TimerQueue* queue) : m_queue(queue) {
+        // Same priority that GLib timeout sources have by default
+        g_source_set_priority(this, G_PRIORITY_DEFAULT);
+        // Dispatch the other timers from main loops nested in a callback
+        g_source_set_can_recurse(this, TRUE);
+#if GLIB_CHECK_VERSION(2, 70, 0)
+        g_source_set_static_name(this, "GjsTimerSource");
+#else
+        g_source_set_name(this, "GjsTimerSource");
+#endif
+    }
+
+    void* operator new(size_t size) {
+        return g_source_new(&source_funcs, size);
+    }
+    void operator delete(void* p) { g_source_unref(static_cast<GSource*>(p)); }
+
+    gboolean dispatch() {
+        Gjs::AutoSourceDispatchMark mark{this};
+        m_queue->dispatch();
+        return G_SOURCE_CONTINUE;
+    }
+};
+
+GSourceFuncs TimerQueue::Source::source_funcs = {
+    nullptr,  // prepare, the ready time takes care of waking us up
+    nullptr,  // check
+    [](GSource* source, GSourceFunc, void*) {
+        return static_cast<Source*>(source)->dispatch();
+    },
+    nullptr,  // finalize
+};
+
+TimerQueue::TimerQueue(GjsContextPrivate* gjs)
+    : m_gjs(gjs),
+      m_main_context(g_main_context_ref_thread_default()),
+      m_source(new Source(this)) {}
+
+TimerQueue::~TimerQueue() { g_source_destroy(m_source.get()); }
+
+bool TimerQueue::is_live(const Entry& entry) const {
+    auto it = m_timers.find(entry.id);
+    return it != m_timers.end() && it->second.seq == entry.seq;
+}
+
+uint64_t TimerQueue::next_id() {
+    // IDs must not be handed out twice even after wrapping around
+    do {
+        if (m_last_id < MIN_ID || m_last_id == MAX_ID)
+            m_last_id = MIN_ID - 1;
+        m_last_id++;
+    } while (m_timers.count(m_last_id));
+    return m_last_id;
+}
+
+void TimerQueue::push(uint64_t id, int64_t deadline, uint64_t seq) {
+    m_heap.push_back({deadline, seq, id});
+    std::push_heap(m_heap.begin(), m_heap.end());
+
+    if (m_ready_time < 0 || deadline < m_ready_time) {
+        m_ready_time = deadline;
+        g_source_set_ready_time(m_source.get(), deadline);
+    }
+}
+
+// Cancelled timers are left in the heap and skipped when they come up, which
+// keeps remove() cheap. Once they outnumber the live ones, drop them all in one
+// pass.
+void TimerQueue::compact() {
+    m_heap.erase(std::remove_if(m_heap.begin(), m_heap.end(),
+                                [this](const Entry& e) { return !is_live(e); }),
+                 m_heap.end());
+    std::make_heap(m_heap.begin(), m_heap.end());
+}
+
+void TimerQueue::update_ready_time() {
+    while (!m_heap.empty() && !is_live(m_heap.front())) {
+        std::pop_heap(m_heap.begin(), m_heap.end());
+        m_heap.pop_back();
+    }
+
+    int64_t ready_time = m_heap.empty() ? -1 : m_heap.front().deadline;
+    if (ready_time == m_ready_time)
+        return;
+
+    m_ready_time = ready_time;
+    g_source_set_ready_time(m_source.get(), ready_time);
+}
+
+uint64_t TimerQueue::add(JSObject* callback, JSObject* args,
+                         unsigned delay_ms, bool repeat) {
+    int64_t delay = int64_t{delay_ms} * G_TIME_SPAN_MILLISECOND;
+    uint64_t id = next_id();
+    uint64_t seq = m_next_seq++;
+
+    m_timers.try_emplace(id, callback, args, repeat ? delay : -1, seq);
+    push(id, g_get_monotonic_time() + delay, seq);
+
+    if (!g_source_get_context(m_source.get())) {
+        gjs_debug(GJS_DEBUG_MAINLOOP, "Starting timer source");
+        g_source_attach(m_source.get(), m_main_context);
+    }
+
+    return id;
+}
+
+void TimerQueue::remove(uint64_t id) {
+    if (!m_timers.erase(id))
+        return;
+
+    if (m_timers.empty()) {
+        m_heap.clear();
+        update_ready_time();
+    } else if (m_heap.size() > 2 * m_timers.size() + 64) {
+        compact();
+    }
+}
+
+void TimerQueue::clear() {
+    m_timers.clear();
+    m_heap.clear();
+    update_ready_time();
+}
+
+void TimerQueue::trace(JSTracer* trc) {
+    for (auto& it : m_timers) {
+        JS::TraceEdge(trc, &it.second.callback, "timer callback");
+        JS::TraceEdge(trc, &it.second.args, "timer callback arguments");
+    }
+}
+
+bool TimerQueue::call(JS::HandleObject callback, JS::HandleObject args) {
+    JSContext* cx = m_gjs->context();
+    JSAutoRealm ar{cx, callback};
+
+    JS::RootedValueVector argv{cx};
+    if (args) {
+        uint32_t len;
+        if (!JS::GetArrayLength(cx, args, &len))
+            return false;
+        if (!argv.resize(len)) {
+            JS_ReportOutOfMemory(cx);
+            return false;
+        }
+        for (uint32_t ix = 0; ix < len; ix++) {
+            if (!JS_GetElement(cx, args, ix, argv[ix]))
+                return false;
+        }
+    }
+
+    JS::RootedValue this_value{cx,
+                               JS::ObjectValue(*JS::CurrentGlobalOrNull(cx))};
+    JS::RootedValue v_callback{cx, JS::ObjectValue(*callback)};
+    JS::RootedValue ignored{cx};
+    return JS::Call(cx, this_value, v_callback, argv, &ignored);
+}
+
+void TimerQueue::dispatch() {
+    JSContext* cx = m_gjs->context();
+    int64_t now = g_source_get_time(m_source.get());
+    uint64_t seq_limit = m_next_seq;
+
+    JS::RootedObject callback{cx}, args{cx};
+    while (!m_heap.empty()) {
+        Entry entry = m_heap.front();
+        if (entry.deadline > now || entry.seq >= seq_limit)
+            break;
+
+        std::pop_heap(m_heap.begin(), m_heap.end());
+        m_heap.pop_back();
+
+        auto it = m_timers.find(entry.id);
+        if (it == m_timers.end() || it->second.seq != entry.seq)
+            continue;
+
+        // The callback may cancel any timer including this one, so don't hold
+        // on to the entry while it runs
+        Timer& timer = it->second;
+        callback = timer.callback;
+        args = timer.args;
+        if (timer.interval < 0) {
+            m_timers.erase(it);
+        } else {
+            timer.seq = m_next_seq++;
+            push(entry.id, now + timer.interval, timer.seq);
+        }
+        // Otherwise a main loop nested in the callback would see the deadline
+        // of the timer being dispatched, and spin
+        update_ready_time();
+
+        if (!call(callback, args) && !gjs_log_exception_uncaught(cx)) {
+            // "Uncatchable" exception thrown, we have to exit. This matches
+            // the closure exit handling in function.cpp
+            uint8_t code;
+            if (m_gjs->should_exit(&code))
+                m_gjs->exit_immediately(code);
+
+            // Some other uncatchable exception, e.g. out of memory
+            g_error("Timer callback %s terminated with uncatchable exception",
+                    gjs_debug_object(callback).c_str());
+        }
+
+        js::RunJobs(cx);
+    }
+
+    update_ready_time();
+    m_gjs->schedule_gc_if_needed();
+}
+
+};  // namespace Gjs
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool add_timer(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    JS::RootedObject callback{cx}, callback_args{cx};
+    uint32_t delay;
+    bool repeat;
+    if (!gjs_parse_call_args(cx, "add", args, "oub?o", "callback", &callback,
+                             "delay", &delay, "repeat", &repeat, "args",
+                             &callback_args)) {
+        return false;
+    }
+
+    if (!JS::IsCallable(callback)) {
+        gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr,
+                         "Timer callback must be a function");
+        return false;
+    }
+
+    GjsContextPrivate* gjs = GjsContextPrivate::from_cx(cx);
+    args.rval().setNumber(static_cast<double>(
+        gjs->timers().add(callback, callback_args, delay, repeat)));
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool remove_timer(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    double id;
+    if (!gjs_parse_call_args(cx, "remove", args, "f", "id", &id))
+        return false;
+
+    // Other numbers were never handed out as timer IDs
+    if (id >= Gjs::TimerQueue::MIN_ID && id <= Gjs::TimerQueue::MAX_ID &&
+        id == std::trunc(id))
+        GjsContextPrivate::from_cx(cx)->timers().remove(id);
+
+    args.rval().setUndefined();
+    return true;
+}
+
+static JSFunctionSpec gjs_timers_module_funcs[] = {
+    JS_FN("add", &add_timer, 4, 0),
+    JS_FN("remove", &remove_timer, 1, 0),
+    JS_FS_END};
+
+bool gjs_define_timers_stuff(JSContext* cx, JS::MutableHandleObject module) {
+    module.set(JS_NewPlainObject(cx));
+    if (!module)
+        return false;
+    return JS_DefineFunctions(cx, module, gjs_timers_module_funcs);
+}
@@ -0,0 +1,138 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#pragma once
+
+#include <config.h>
+
+#include <stdint.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <glib.h>
+
+#include <js/RootingAPI.h>
+#include <js/TypeDecls.h>
+
+#include "gjs/macros.h"
+#include "gjs/promise.h"  // for AutoMainContext
+
+class GjsContextPrivate;
+class JSTracer;
+
+namespace Gjs {
+
+/**
+ * TimerQueue:
+ *
+ * Backs setTimeout() and setInterval(). All pending timers of a GJS context
+ * are kept in a binary min-heap ordered by deadline, and a single custom
+ * GSource, whose ready time tracks the earliest deadline, dispatches them.
+ * This avoids creating (and having GMainContext scan) one GSource per timer.
+ */
+class TimerQueue {
+    class Source;
+
+    struct Timer {
+        JS::Heap<JSObject*> callback;
+        // Array of extra arguments for the callback, or null if there are none
+        JS::Heap<JSObject*> args;
+        // Repeat interval in µs, or -1 for one-shot timers
+        int64_t interval;
+        // Sequence number of the heap entry that is currently live for this
+        // timer; other entries with the same ID are stale
+        uint64_t seq;
+
+        Timer(JSObject* callback_, JSObject* args_, int64_t interval_,
+              uint64_t seq_)
+            : callback(callback_),
+              args(args_),
+              interval(interval_),
+              seq(seq_) {}
+    };
+
+    struct Entry {
+        // Monotonic time in µs
+        int64_t deadline;
+        // Breaks ties between equal deadlines so that timers fire in the order
+        // in which they were scheduled
+        uint64_t seq;
+        uint64_t id;
+
+        // Inverted, so that the std heap algorithms build a min-heap
+        bool operator<(const Entry& other) const {
+            if (deadline != other.deadline)
+                return deadline > other.deadline;
+            return seq > other.seq;
+        }
+    };
+
+    GjsContextPrivate* m_gjs;
+    AutoMainContext m_main_context;
+    std::unique_ptr<Source> m_source;
+
+    std::vector<Entry> m_heap;
+    std::unordered_map<uint64_t, Timer> m_timers;
+    uint64_t m_last_id = 0;
+    uint64_t m_next_seq = 0;
+    int64_t m_ready_time = -1;
+
+    [[nodiscard]] bool is_live(const Entry& entry) const;
+    [[nodiscard]] uint64_t next_id();
+    void push(uint64_t id, int64_t deadline, uint64_t seq);
+    void compact();
+    void update_ready_time();
+    GJS_JSAPI_RETURN_CONVENTION
+    bool call(JS::HandleObject callback, JS::HandleObject args);
+    void dispatch();
+
+ public:
+    // Timer IDs are above G_MAXUINT, so that they are never mistaken for GLib
+    // source IDs; GLib.source_remove() throws on them instead of removing an
+    // unrelated source. They are also exactly representable as JS Numbers.
+    static constexpr uint64_t MIN_ID = uint64_t{G_MAXUINT} + 1;
+    static constexpr uint64_t MAX_ID = (uint64_t{1} << 53) - 1;
+
+    explicit TimerQueue(GjsContextPrivate*);
+    ~TimerQueue();
+
+    /**
+     * TimerQueue::add:
+     * @callback: the function to call
+     * @args: (nullable): array of arguments to pass to @callback
+     * @delay_ms: the delay in milliseconds before the first call
+     * @repeat: whether to call @callback every @delay_ms milliseconds
+     *
+     * Returns: an ID between MIN_ID and MAX_ID for the timer, to be passed to
+     *   remove().
+     */
+    [[nodiscard]] uint64_t add(JSObject* callback, JSObject* args,
+                               unsigned delay_ms, bool repeat);
+
+    /**
+     * TimerQueue::remove:
+     *
+     * Cancels the timer with ID @id. Does nothing if there is no such timer.
+     */
+    void remove(uint64_t id);
+
+    /**
+     * TimerQueue::clear:
+     *
+     * Cancels all pending timers. Called when the context is disposed, so that
+     * no JS things are kept alive past the destruction of the JSContext.
+     */
+    void clear();
+
+    [[nodiscard]] size_t size() const { return m_timers.size(); }
+
+    void trace(JSTracer* trc);
+};
+
+};  // namespace Gjs
+
+GJS_JSAPI_RETURN_CONVENTION
+bool gjs_define_timers_stuff(JSContext* cx, JS::MutableHandleObject module);
@@ -0,0 +1,700 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#include <config.h>
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>
+
+#include <algorithm>  // for find
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <utility>  // for exchange, move
+
+#include <gio/gio.h>
+#include <glib-object.h>
+#include <glib.h>
+
+#include <js/CallAndConstruct.h>  // for IsCallable
+#include <js/CallArgs.h>
+#include <js/ErrorReport.h>  // for JSEXN_TYPEERR
+#include <js/PropertyAndElement.h>  // for JS_DefineFunctions
+#include <js/PropertySpec.h>
+#include <js/Realm.h>
+#include <js/RootingAPI.h>
+#include <js/StructuredClone.h>
+#include <js/TypeDecls.h>
+#include <js/Value.h>
+#include <js/ValueArray.h>
+#include <jsapi.h>        // for JS_NewPlainObject, JS_NewStringCopyZ
+#include <jsfriendapi.h>  // for RunJobs
+
+#include "gi/boxed.h"
+#include "gi/closure.h"
+#include "gjs/auto.h"
+#include "gjs/context-private.h"
+#include "gjs/context.h"
+#include "gjs/error-types.h"
+#include "gjs/jsapi-simple-wrapper.h"
+#include "gjs/jsapi-util-args.h"
+#include "gjs/jsapi-util.h"
+#include "gjs/macros.h"
+#include "gjs/profiler-private.h"
+#include "gjs/worker.h"
+#include "util/log.h"
+
+/**
+ * worker.cpp - This file implements the native side of the Worker API. A
+ * worker is a separate GjsContext, created on a new thread that pushes a
+ * GMainContext of its own as the thread-default one. Since the promise job
+ * dispatcher, the timers, and the main loop of a context all use the
+ * thread-default main context, the worker gets its own event loop without any
+ * further setup.
+ *
+ * JS values never cross threads. Messages are written with the structured
+ * clone algorithm into a buffer, which is handed over to the other thread and
+ * read back into a value in its own context. ArrayBuffers listed as
+ * transferable are detached on the sending side, and their contents moved
+ * into the buffer instead of being copied.
+ */
+
+namespace Gjs {
+
+// The worker that the current thread is running, if any
+static thread_local Worker* current_worker = nullptr;
+// The workers started from the current thread that have not exited yet. Each
+// one holds a reference, which is dropped in Worker::finish().
+static thread_local std::unordered_set<Worker*> running_workers;
+
+/**
+ * Worker::Port::Source:
+ *
+ * A custom GSource which delivers the messages queued on a port. It is woken
+ * up from the sending thread with g_source_set_ready_time().
+ */
+class Worker::Port::Source : public GSource {
+    Port* m_port;
+
+    static GSourceFuncs source_funcs;
+
+ public:
+    explicit Source(Port* port) : m_port(port) {
+        // Same priority as other events coming into the main loop
+        g_source_set_priority(this, G_PRIORITY_DEFAULT);
+#if GLIB_CHECK_VERSION(2, 70, 0)
+        g_source_set_static_name(this, "GjsWorkerMessageSource");
+#else
+        g_source_set_name(this, "GjsWorkerMessageSource");
+#endif
+    }
+
+    void* operator new(size_t size) {
+        return g_source_new(&source_funcs, size);
+    }
+    void operator delete(void* p) { g_source_unref(static_cast<GSource*>(p)); }
+
+    gboolean dispatch() {
+        Gjs::AutoSourceDispatchMark mark{this};
+        m_port->dispatch();
+        return G_SOURCE_CONTINUE;
+    }
+};
+
+GSourceFuncs Worker::Port::Source::source_funcs = {
+    nullptr,  // prepare, the ready time takes care of waking us up
+    nullptr,  // check
+    [](GSource* source, GSourceFunc, void*) {
+        return static_cast<Source*>(source)->dispatch();
+    },
+    nullptr,  // finalize
+};
+
+Worker::Port::Port(Worker* worker, Receiver receive,
+                   GMainContext* main_context)
+    : m_worker(worker), m_receive(receive), m_source(new Source(this)) {
+    g_source_attach(m_source.get(), main_context);
+}
+
+Worker::Port::~Port() { g_source_destroy(m_source.get()); }
+
+bool Worker::Port::post(Message&& message) {
+    std::lock_guard<std::mutex> lock{m_lock};
+    if (m_closed)
+        return false;
+
+    m_queue.push_back(std::move(message));
+    // Thread-safe; wakes up the main context of the receiving thread
+    g_source_set_ready_time(m_source.get(), 0);
+    return true;
+}
+
+void Worker::Port::close() {
+    std::deque<Message> dropped;
+    {
+        std::lock_guard<std::mutex> lock{m_lock};
+        m_closed = true;
+        dropped.swap(m_queue);
+    }
+    g_source_destroy(m_source.get());
+}
+
+void Worker::Port::dispatch() {
+    g_source_set_ready_time(m_source.get(), -1);
+
+    // Only deliver the messages that are already there, so that a steady
+    // stream of messages cannot starve the other sources of the main loop
+    std::deque<Message> messages;
+    {
+        std::lock_guard<std::mutex> lock{m_lock};
+        messages.swap(m_queue);
+    }
+
+    // The receiver may drop the last reference to the worker, and with it this
+    // port
+    Worker* worker = m_worker;
+    worker->ref();
+    for (Message& message : messages) {
+        if (m_closed)
+            break;
+        (worker->*m_receive)(&message);
+    }
+    messages.clear();
+    worker->unref();
+}
+
+Worker::Worker(GjsContextPrivate* parent, const char* uri)
+    : m_uri(g_strdup(uri)),
+      m_main_context(g_main_context_new()),
+      m_parent(parent),
+      m_to_worker(this, &Worker::receive_in_worker, m_main_context),
+      m_to_parent(this, &Worker::receive_in_parent,
+                  AutoMainContext{g_main_context_ref_thread_default()}) {}
+
+Worker::~Worker() {
+    g_assert(!m_thread && "Worker thread should have been joined");
+    g_assert(!m_parent_handler && !m_worker_handler);
+}
+
+Worker* Worker::for_current_thread() { return current_worker; }
+
+Worker* Worker::create(JSContext* cx, const char* uri,
+                       JS::HandleObject handler) {
+    GjsContextPrivate* gjs = GjsContextPrivate::from_cx(cx);
+
+    auto* worker = new Worker(gjs, uri);
+
+    // Owned by the worker until it exits, see finish()
+    worker->m_parent_handler =
+        Closure::create(cx, handler, "worker event handler", true);
+    g_closure_ref(worker->m_parent_handler);
+    g_closure_sink(worker->m_parent_handler);
+
+    // The running thread holds a reference
+    worker->ref();
+
+    AutoError error;
+    worker->m_thread =
+        g_thread_try_new("gjs-worker", &Worker::thread_main, worker,
+                         error.out());
+    if (!worker->m_thread) {
+        gjs_throw(cx, "Could not start worker thread: %s", error->message);
+        g_closure_unref(std::exchange(worker->m_parent_handler, nullptr));
+        worker->unref();
+        worker->unref();
+        return nullptr;
+    }
+
+    gjs_debug(GJS_DEBUG_CONTEXT, "Started worker %p for %s", worker, uri);
+
+    running_workers.insert(worker);
+    gjs->main_loop_hold();
+    return worker;
+}
+
+void* Worker::thread_main(void* data) {
+    static_cast<Worker*>(data)->run();
+    return nullptr;
+}
+
+void Worker::run() {
+    g_main_context_push_thread_default(m_main_context);
+    current_worker = this;
+
+    uint8_t code = 0;
+    AutoError error;
+    {
+        AutoUnref<GjsContext> js_context{gjs_context_new()};
+        JSContext* cx = GjsContextPrivate::from_object(js_context)->context();
+        JS_AddInterruptCallback(cx, &Worker::interrupt_callback);
+        {
+            std::lock_guard<std::mutex> lock{m_cx_lock};
+            m_cx = cx;
+        }
+        // The parent may have interrupted the worker before it had a context
+        if (m_interrupted)
+            JS_RequestInterruptCallback(cx);
+
+        if (!gjs_context_register_module(js_context, m_uri, m_uri,
+                                         error.out())) {
+            code = 1;
+        } else {
+            // Spins the main loop of the worker until nothing holds it
+            // anymore, so this only returns once the worker is done
+            [[maybe_unused]] bool ok = gjs_context_eval_module(
+                js_context, m_uri, &code, error.out());
+        }
+
+        // Drop the message handler while its context is still alive
+        close();
+
+        std::lock_guard<std::mutex> lock{m_cx_lock};
+        m_cx = nullptr;
+    }
+
+    // Loops whose run() threw before unregistering them
+    for (GMainLoop* loop : m_running_loops)
+        g_main_loop_unref(loop);
+    m_running_loops.clear();
+
+    current_worker = nullptr;
+    g_main_context_pop_thread_default(m_main_context);
+
+    if (error && !g_error_matches(error, GJS_ERROR, GJS_ERROR_SYSTEM_EXIT))
+        m_to_parent.post({Message::ERROR, nullptr, error->message});
+    m_to_parent.post({Message::EXIT, nullptr, {}, code});
+}
+
+bool Worker::call_handler(Closure* handler, const char* type,
+                          JS::HandleValue value) {
+    JSContext* cx = handler->context();
+    JS::RootedValueArray<2> args{cx};
+
+    JSString* type_str = JS_NewStringCopyZ(cx, type);
+    if (!type_str)
+        return false;
+    args[0].setString(type_str);
+    args[1].set(value);
+
+    JS::RootedValue ignored{cx};
+    return handler->invoke(nullptr, args, &ignored);
+}
+
+void Worker::receive_in_parent(Message* message) {
+    if (message->type == Message::EXIT) {
+        gjs_debug(GJS_DEBUG_CONTEXT, "Worker %p for %s exited with code %u",
+                  this, m_uri.get(), message->exit_code);
+        finish();
+        return;
+    }
+
+    g_assert(message->type == Message::DATA || message->type == Message::ERROR);
+    if (!m_parent_handler || !m_parent_handler->is_valid())
+        return;
+
+    JSContext* cx = m_parent_handler->context();
+    GjsContextPrivate* gjs = GjsContextPrivate::from_cx(cx);
+    bool ok;
+    {
+        JSAutoRealm ar{cx, m_parent_handler->callable()};
+        JS::RootedValue value{cx};
+        if (message->type == Message::DATA) {
+            ok = message->data->read(cx, &value) &&
+                 call_handler(m_parent_handler, "message", value);
+        } else {
+            ok = gjs_string_from_utf8(cx, message->error.c_str(), &value) &&
+                 call_handler(m_parent_handler, "error", value);
+        }
+    }
+
+    if (!ok && !gjs_log_exception_uncaught(cx)) {
+        // Same as the closure exit handling in function.cpp
+        uint8_t code;
+        if (gjs->should_exit(&code))
+            gjs->exit_immediately(code);
+        g_error("Worker event handler terminated with uncatchable exception");
+    }
+
+    // Run the microtasks queued by the handler before the next event
+    js::RunJobs(cx);
+}
+
+void Worker::receive_in_worker(Message* message) {
+    if (message->type == Message::TERMINATE) {
+        gjs_debug(GJS_DEBUG_CONTEXT, "Worker %p for %s terminated", this,
+                  m_uri.get());
+        close();
+        // The worker may be idle in a GLib main loop, where the interrupt
+        // callback doesn't run
+        if (m_interrupted)
+            stop_running();
+        return;
+    }
+
+    g_assert(message->type == Message::DATA);
+    if (!m_worker_handler || !m_worker_handler->is_valid())
+        return;
+
+    JSContext* cx = m_worker_handler->context();
+    GjsContextPrivate* gjs = GjsContextPrivate::from_cx(cx);
+    bool ok;
+    {
+        JSAutoRealm ar{cx, m_worker_handler->callable()};
+        JS::RootedValue value{cx};
+        ok = message->data->read(cx, &value) &&
+             call_handler(m_worker_handler, "message", value);
+    }
+
+    if (!ok && !gjs_log_exception_uncaught(cx)) {
+        uint8_t code;
+        if (gjs->should_exit(&code))
+            gjs->exit_immediately(code);
+        g_error("Worker message handler terminated with uncatchable exception");
+    }
+
+    js::RunJobs(cx);
+}
+
+void Worker::finish() {
+    g_thread_join(std::exchange(m_thread, nullptr));
+
+    m_to_parent.close();
+    if (m_parent_handler)
+        g_closure_unref(std::exchange(m_parent_handler, nullptr));
+    m_parent->main_loop_release();
+
+    running_workers.erase(this);
+    unref();
+}
+
+bool Worker::post_message(JSContext* cx, JS::HandleValue message,
+                          JS::HandleValue transfer) {
+    auto buffer = std::make_unique<JSAutoStructuredCloneBuffer>(
+        JS::StructuredCloneScope::SameProcess, nullptr, nullptr);
+    if (!buffer->write(cx, message, transfer, JS::CloneDataPolicy{}))
+        return false;
+
+    // As on the web, messages posted to a worker that has already exited are
+    // silently dropped
+    Port& port = current_worker == this ? m_to_parent : m_to_worker;
+    port.post({Message::DATA, std::move(buffer)});
+    return true;
+}
+
+void Worker::terminate() { m_to_worker.post({Message::TERMINATE}); }
+
+// Parent thread. Stops the JS code running in the worker the next time it
+// checks for interrupts, and the TERMINATE message wakes up the worker's main
+// context in case it is waiting for events.
+void Worker::interrupt() {
+    m_interrupted = true;
+    {
+        std::lock_guard<std::mutex> lock{m_cx_lock};
+        if (m_cx)
+            JS_RequestInterruptCallback(m_cx);
+    }
+    terminate();
+}
+
+// Worker thread. Makes the context's main loop and the GLib main loops run
+// from JS return, as after System.exit().
+void Worker::stop_running() {
+    g_assert(current_worker == this);
+
+    GjsContextPrivate* gjs = GjsContextPrivate::from_cx(m_cx);
+    if (!gjs->should_exit(nullptr))
+        gjs->exit(0);
+    for (GMainLoop* loop : m_running_loops)
+        g_main_loop_quit(loop);
+}
+
+bool Worker::interrupt_callback(JSContext* cx) {
+    Worker* worker = current_worker;
+    if (!worker || !worker->m_interrupted)
+        return true;
+
+    worker->stop_running();
+
+    // Throw an ordinary exception, so that the callbacks of the worker's main
+    // loop return normally, instead of treating it as a request to exit the
+    // process. Ask to be called again, in case the exception is caught.
+    JS_RequestInterruptCallback(cx);
+    gjs_throw(cx, "Worker was terminated because its parent is exiting");
+    return false;
+}
+
+void Worker::add_running_loop(GMainLoop* loop) {
+    g_assert(current_worker == this);
+    m_running_loops.push_back(g_main_loop_ref(loop));
+    if (m_interrupted)
+        g_main_loop_quit(loop);
+}
+
+void Worker::remove_running_loop(GMainLoop* loop) {
+    g_assert(current_worker == this);
+    auto it = std::find(m_running_loops.begin(), m_running_loops.end(), loop);
+    if (it == m_running_loops.end())
+        return;
+    m_running_loops.erase(it);
+    g_main_loop_unref(loop);
+}
+
+bool Worker::set_worker_handler(JSContext* cx, JS::HandleObject handler) {
+    g_assert(current_worker == this);
+
+    if (!handler) {
+        if (m_worker_handler) {
+            GjsContextPrivate::from_cx(cx)->main_loop_release();
+            g_closure_unref(std::exchange(m_worker_handler, nullptr));
+        }
+        return true;
+    }
+
+    if (!JS::IsCallable(handler)) {
+        gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr,
+                         "The message handler must be a function");
+        return false;
+    }
+
+    auto* closure =
+        Closure::create(cx, handler, "worker message handler", true);
+    g_closure_ref(closure);
+    g_closure_sink(closure);
+
+    if (m_worker_handler)
+        g_closure_unref(m_worker_handler);
+    else
+        GjsContextPrivate::from_cx(cx)->main_loop_hold();
+    m_worker_handler = closure;
+    return true;
+}
+
+void Worker::close() {
+    g_assert(current_worker == this);
+
+    m_to_worker.close();
+    if (m_worker_handler) {
+        if (m_worker_handler->is_valid()) {
+            GjsContextPrivate::from_cx(m_worker_handler->context())
+                ->main_loop_release();
+        }
+        g_closure_unref(std::exchange(m_worker_handler, nullptr));
+    }
+}
+
+void Worker::terminate_all() {
+    while (!running_workers.empty()) {
+        Worker* worker = *running_workers.begin();
+        gjs_debug(GJS_DEBUG_CONTEXT, "Waiting for worker %p for %s to exit",
+                  worker, worker->m_uri.get());
+        worker->interrupt();
+        // Removes the worker from the set
+        worker->finish();
+    }
+}
+
+};  // namespace Gjs
+
+GJS_JSAPI_RETURN_CONVENTION
+static Gjs::Worker* worker_from_object(JSContext* cx, JS::HandleObject obj) {
+    auto* worker = Gjs::SimpleWrapper::get<Gjs::Worker>(cx, obj);
+    if (!worker)
+        gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr, "Object is not a worker");
+    return worker;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static Gjs::Worker* current_worker_or_throw(JSContext* cx) {
+    Gjs::Worker* worker = Gjs::Worker::for_current_thread();
+    if (!worker)
+        gjs_throw(cx, "Not running in a worker");
+    return worker;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool create_worker(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    Gjs::AutoChar path;
+    JS::RootedObject handler{cx};
+    if (!gjs_parse_call_args(cx, "create", args, "so", "uri", &path,
+                             "handler", &handler)) {
+        return false;
+    }
+
+    if (!JS::IsCallable(handler)) {
+        gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr,
+                         "The event handler must be a function");
+        return false;
+    }
+
+    // Plain paths are resolved relative to the current directory
+    Gjs::AutoChar uri;
+    if (g_uri_peek_scheme(path)) {
+        uri = path.release();
+    } else {
+        Gjs::AutoUnref<GFile> file{g_file_new_for_commandline_arg(path)};
+        uri = g_file_get_uri(file);
+    }
+
+    Gjs::Worker* worker = Gjs::Worker::create(cx, uri, handler);
+    if (!worker)
+        return false;
+
+    JSObject* wrapper = Gjs::SimpleWrapper::new_for_ptr(
+        cx, worker, [](Gjs::Worker* w) { w->unref(); });
+    if (!wrapper) {
+        worker->terminate();
+        worker->unref();
+        return false;
+    }
+
+    args.rval().setObject(*wrapper);
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool post_message(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+    if (!args.requireAtLeast(cx, "postMessage", 2))
+        return false;
+
+    if (!args[0].isObject()) {
+        gjs_throw_custom(cx, JSEXN_TYPEERR, nullptr, "Object is not a worker");
+        return false;
+    }
+    JS::RootedObject worker_obj{cx, &args[0].toObject()};
+    Gjs::Worker* worker = worker_from_object(cx, worker_obj);
+    if (!worker)
+        return false;
+
+    args.rval().setUndefined();
+    return worker->post_message(cx, args[1], args.get(2));
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool terminate_worker(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    JS::RootedObject worker_obj{cx};
+    if (!gjs_parse_call_args(cx, "terminate", args, "o", "worker",
+                             &worker_obj))
+        return false;
+
+    Gjs::Worker* worker = worker_from_object(cx, worker_obj);
+    if (!worker)
+        return false;
+
+    worker->terminate();
+    args.rval().setUndefined();
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool is_worker_thread(JSContext*, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+    args.rval().setBoolean(!!Gjs::Worker::for_current_thread());
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool set_message_handler(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    JS::RootedObject handler{cx};
+    if (!gjs_parse_call_args(cx, "setMessageHandler", args, "?o", "handler",
+                             &handler))
+        return false;
+
+    Gjs::Worker* worker = current_worker_or_throw(cx);
+    if (!worker)
+        return false;
+
+    args.rval().setUndefined();
+    return worker->set_worker_handler(cx, handler);
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool post_message_to_parent(JSContext* cx, unsigned argc,
+                                   JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+    if (!args.requireAtLeast(cx, "postMessageToParent", 1))
+        return false;
+
+    Gjs::Worker* worker = current_worker_or_throw(cx);
+    if (!worker)
+        return false;
+
+    args.rval().setUndefined();
+    return worker->post_message(cx, args[0], args.get(1));
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool close_worker(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    Gjs::Worker* worker = current_worker_or_throw(cx);
+    if (!worker)
+        return false;
+
+    worker->close();
+    args.rval().setUndefined();
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool running_loop_func(JSContext* cx, unsigned argc, JS::Value* vp,
+                              bool add) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    JS::RootedObject loop_obj{cx};
+    if (!gjs_parse_call_args(cx, add ? "addRunningLoop" : "removeRunningLoop",
+                             args, "o", "loop", &loop_obj))
+        return false;
+
+    Gjs::Worker* worker = current_worker_or_throw(cx);
+    if (!worker || !BoxedBase::typecheck(cx, loop_obj, G_TYPE_MAIN_LOOP))
+        return false;
+
+    auto* loop = BoxedBase::to_c_ptr<GMainLoop>(cx, loop_obj);
+    if (!loop)
+        return false;
+
+    if (add)
+        worker->add_running_loop(loop);
+    else
+        worker->remove_running_loop(loop);
+    args.rval().setUndefined();
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool add_running_loop(JSContext* cx, unsigned argc, JS::Value* vp) {
+    return running_loop_func(cx, argc, vp, true);
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool remove_running_loop(JSContext* cx, unsigned argc, JS::Value* vp) {
+    return running_loop_func(cx, argc, vp, false);
+}
+
+static JSFunctionSpec gjs_worker_module_funcs[] = {
+    JS_FN("create", &create_worker, 2, 0),
+    JS_FN("postMessage", &post_message, 3, 0),
+    JS_FN("terminate", &terminate_worker, 1, 0),
+    JS_FN("isWorkerThread", &is_worker_thread, 0, 0),
+    JS_FN("setMessageHandler", &set_message_handler, 1, 0),
+    JS_FN("postMessageToParent", &post_message_to_parent, 2, 0),
+    JS_FN("close", &close_worker, 0, 0),
+    JS_FN("addRunningLoop", &add_running_loop, 1, 0),
+    JS_FN("removeRunningLoop", &remove_running_loop, 1, 0),
+    JS_FS_END};
+
+bool gjs_define_worker_stuff(JSContext* cx, JS::MutableHandleObject module) {
+    module.set(JS_NewPlainObject(cx));
+    if (!module)
+        return false;
+    return JS_DefineFunctions(cx, module, gjs_worker_module_funcs);
+}
@@ -0,0 +1,215 @@
+/* -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; -*- */
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+#pragma once
+
+#include <config.h>
+
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glib.h>
+
+#include <js/StructuredClone.h>
+#include <js/TypeDecls.h>
+
+#include "gjs/auto.h"
+#include "gjs/macros.h"
+#include "gjs/promise.h"  // for AutoMainContext
+
+class GjsContextPrivate;
+
+namespace Gjs {
+
+class Closure;
+
+/**
+ * Worker:
+ *
+ * A GjsContext running an ES module on a thread of its own, with its own main
+ * context, main loop, and promise job queue. The parent context and the worker
+ * exchange messages, serialized with the structured clone algorithm, through
+ * two ports. Each port queues messages from any thread and delivers them from
+ * a GSource attached to the main context of the receiving thread.
+ *
+ * The object is shared between the parent thread and the worker thread, and
+ * is reference counted. Everything else, such as the JS message handlers, is
+ * only touched from the thread that owns it.
+ */
+class Worker {
+ public:
+    struct Message {
+        enum Type : uint8_t { DATA, ERROR, EXIT, TERMINATE };
+
+        Type type;
+        std::unique_ptr<JSAutoStructuredCloneBuffer> data;
+        std::string error;
+        uint8_t exit_code = 0;
+    };
+
+ private:
+    class Port {
+        class Source;
+        using Receiver = void (Worker::*)(Message*);
+
+        Worker* m_worker;
+        Receiver m_receive;
+        std::mutex m_lock;
+        std::deque<Message> m_queue;
+        bool m_closed = false;
+        std::unique_ptr<Source> m_source;
+
+     public:
+        Port(Worker* worker, Receiver receive, GMainContext* main_context);
+        ~Port();
+
+        // Any thread. Returns false if the port was already closed.
+        bool post(Message&& message);
+        // Receiving thread only. Drops the pending messages.
+        void close();
+        void dispatch();
+    };
+
+    std::atomic_int m_refcount = 1;
+    AutoChar m_uri;
+    // The main context of the worker thread
+    AutoMainContext m_main_context;
+    GThread* m_thread = nullptr;
+
+    // Only accessed from the parent thread
+    GjsContextPrivate* m_parent;
+    Closure* m_parent_handler = nullptr;
+
+    // Only accessed from the worker thread
+    Closure* m_worker_handler = nullptr;
+    // GLib main loops that JS code in the worker is running
+    std::vector<GMainLoop*> m_running_loops;
+
+    // Set by the worker thread while its context exists, so that the parent
+    // can interrupt the JS code running in it
+    std::mutex m_cx_lock;
+    JSContext* m_cx = nullptr;
+    std::atomic_bool m_interrupted = false;
+
+    Port m_to_worker;
+    Port m_to_parent;
+
+    Worker(GjsContextPrivate* parent, const char* uri);
+    ~Worker();
+
+    static void* thread_main(void* data);
+    void run();
+
+    GJS_JSAPI_RETURN_CONVENTION
+    bool call_handler(Closure* handler, const char* type,
+                      JS::HandleValue value);
+    void receive_in_parent(Message* message);
+    void receive_in_worker(Message* message);
+    void finish();
+    void interrupt();
+    void stop_running();
+    static bool interrupt_callback(JSContext* cx);
+
+ public:
+    void ref() { m_refcount++; }
+    void unref() {
+        if (--m_refcount == 0)
+            delete this;
+    }
+
+    /**
+     * Worker::create:
+     * @cx: the parent context
+     * @uri: the URI of the ES module to run in the worker
+     * @handler: function called in the parent with the type of each event
+     *   ('message' or 'error') and its value
+     *
+     * Starts a new worker thread. The main loop of the parent context is held
+     * until the worker has exited.
+     *
+     * Returns: (transfer full): the worker, or null with an exception pending.
+     */
+    GJS_JSAPI_RETURN_CONVENTION
+    static Worker* create(JSContext* cx, const char* uri,
+                          JS::HandleObject handler);
+
+    /**
+     * Worker::for_current_thread:
+     *
+     * Returns: (transfer none): the worker that the calling thread is running,
+     *   or null if called from a thread that is not a worker.
+     */
+    [[nodiscard]] static Worker* for_current_thread();
+
+    /**
+     * Worker::post_message:
+     * @cx: the context of the calling thread, either the parent or the worker
+     * @message: the value to clone
+     * @transfer: undefined, or an array of ArrayBuffers whose contents are
+     *   moved to the receiving side instead of copied
+     *
+     * Serializes @message and queues it for delivery on the other side.
+     */
+    GJS_JSAPI_RETURN_CONVENTION
+    bool post_message(JSContext* cx, JS::HandleValue message,
+                      JS::HandleValue transfer);
+
+    /**
+     * Worker::terminate:
+     *
+     * Asks the worker to stop, from the parent thread. The worker closes its
+     * port the next time its main loop runs, and exits once nothing else holds
+     * its main loop. Running JS code is not interrupted.
+     */
+    void terminate();
+
+    /**
+     * Worker::add_running_loop:
+     * Worker::remove_running_loop:
+     *
+     * Called in the worker around running a GLib main loop from JS, so that
+     * the loop can be quit when the worker is forced to stop.
+     */
+    void add_running_loop(GMainLoop* loop);
+    void remove_running_loop(GMainLoop* loop);
+
+    /**
+     * Worker::set_worker_handler:
+     *
+     * Sets the function, called in the worker, that receives the messages
+     * from the parent. The main loop of the worker is held while a handler is
+     * set, so that the worker keeps waiting for messages.
+     */
+    GJS_JSAPI_RETURN_CONVENTION
+    bool set_worker_handler(JSContext* cx, JS::HandleObject handler);
+
+    /**
+     * Worker::close:
+     *
+     * Stops receiving messages, from the worker thread.
+     */
+    void close();
+
+    /**
+     * Worker::terminate_all:
+     *
+     * Terminates and joins all workers started from the calling thread. Called
+     * when the parent context is disposed, since workers must not outlive it.
+     * Unlike terminate(), this doesn't wait for the workers to finish what
+     * they are doing: the JS code running in them is interrupted, and the GLib
+     * main loops that they run are quit.
+     */
+    static void terminate_all();
+};
+
+};  // namespace Gjs
+
+GJS_JSAPI_RETURN_CONVENTION
+bool gjs_define_worker_stuff(JSContext* cx, JS::MutableHandleObject module);
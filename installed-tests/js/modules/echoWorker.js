@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+import {parentPort} from 'worker';
+
+parentPort.onmessage = ({data}) => {
+    switch (data.command) {
+    case 'echo':
+        parentPort.postMessage(data.value);
+        break;
+    case 'transfer': {
+        const bytes = new Uint8Array(data.buffer);
+        bytes.reverse();
+        parentPort.postMessage(data.buffer, [data.buffer]);
+        break;
+    }
+    }
+};
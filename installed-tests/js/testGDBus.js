@@ -405,6 +405,20 @@ describe('Exported DBus object', function () {
         await expectAsync(proxy.alwaysThrowExceptionAsync({})).toBeRejected();
     });
 
+    it('replies with an error when a method throws a value that is not an Error', async function () {
+        GLib.test_expect_message('Gjs', GLib.LogLevelFlags.LEVEL_WARNING,
+            'JS ERROR: Exception in method call: alwaysThrowException: *');
+
+        test.alwaysThrowException = () => {
+            throw 'Not an Error';  // eslint-disable-line no-throw-literal
+        };
+        try {
+            await expectAsync(proxy.alwaysThrowExceptionAsync({})).toBeRejected();
+        } finally {
+            delete test.alwaysThrowException;
+        }
+    });
+
     it('can still destructure the return value when an exception is thrown', function () {
         GLib.test_expect_message('Gjs', GLib.LogLevelFlags.LEVEL_WARNING,
             'JS ERROR: Exception in method call: alwaysThrowException: *');
@@ -524,6 +538,23 @@ describe('Exported DBus object', function () {
             jasmine.anything(), ['foobar']);
     });
 
+    it('passes the DBus signal arguments as an array', async function () {
+        const handler = jasmine.createSpy('signalFoo');
+        const id = proxy.connectSignal('signalFoo', handler);
+        handler.and.callFake((proxy_, sender, args) => {
+            proxy.disconnectSignal(id);
+            const [arg] = args;
+            expect(arg).toEqual('foobar');
+            expect(Array.isArray(args)).toBeTrue();
+            expect(args.length).toEqual(1);
+            expect(Object.keys(args)).toEqual(['0']);
+            expect(args.map(a => a.toUpperCase())).toEqual(['FOOBAR']);
+        });
+
+        await proxy.emitSignalAsync();
+        expect(handler).toHaveBeenCalledTimes(1);
+    });
+
     it('can call a remote method with multiple return values', function () {
         proxy.multipleOutValuesRemote(function (result, excp) {
             expect(result).toEqual(['Hello', 'World', '!']);
@@ -692,6 +723,15 @@ describe('Exported DBus object', function () {
         expect(result['aDouble'].deepUnpack()).toBe(10.0);
     });
 
+    it('throws when the arguments do not match the input signature', function () {
+        expect(() => proxy.dictEchoSync(42)).toThrowError(TypeError);
+        expect(() => proxy.dictEchoRemote({aDouble: 10}, () => {})).toThrowError(TypeError);
+    });
+
+    it('rejects the promise when the arguments do not match the input signature', async function () {
+        await expectAsync(proxy.dictEchoAsync(42)).toBeRejectedWithError(TypeError);
+    });
+
     it('can call a remote method with a Unix FD', function (done) {
         const fd = GjsTestTools.open_bytes(expectedBytes);
         const fdList = Gio.UnixFDList.new_from_array([fd]);
@@ -774,6 +814,14 @@ describe('Exported DBus object', function () {
         await expectAsync(proxy.fdInAsync(0)).toBeRejected();
     });
 
+    it('checks the type of the fd list in the native call', function () {
+        const DBusNative = imports._dbusNative;
+        const methodInfo = Gio.DBusNodeInfo.new_for_xml(TestIface)
+            .interfaces[0].lookup_method('fdIn');
+        expect(() => DBusNative.proxyCall(proxy, methodInfo, true, [0], 0,
+            new Gio.Cancellable(), 1, null, null)).toThrowError(TypeError);
+    });
+
     it('throws an exception when passing a handle out of range of a Gio.UnixFDList', function () {
         const fdList = new Gio.UnixFDList();
         expect(() => proxy.fdInRemote(0, fdList, () => {})).toThrow();
@@ -855,6 +903,46 @@ describe('Exported DBus object', function () {
         expect(changedProps).not.toContain('PropReadOnly');
         expect(invalidatedProps).toContain('PropReadOnly');
     });
+
+    it('coalesces property changes within the minimum interval', function () {
+        const changes = [];
+        const times = [];
+        const id = proxy.connect('g-properties-changed', (proxy_, changed) => {
+            changes.push(changed.deepUnpack().PropReadOnly?.deepUnpack());
+            times.push(GLib.get_monotonic_time());
+            loop.quit();
+        });
+        test._impl.set_property_changed_interval(100);
+
+        test.emitPropertyChanged('PropReadOnly', GLib.Variant.new_double(1));
+        loop.run();
+        test.emitPropertyChanged('PropReadOnly', GLib.Variant.new_double(2));
+        test.emitPropertyChanged('PropReadOnly', GLib.Variant.new_double(3));
+        loop.run();
+
+        proxy.disconnect(id);
+        test._impl.set_property_changed_interval(0);
+        test.emitPropertyChanged('PropReadOnly', null);
+
+        expect(changes).toEqual([1, 3]);
+        expect(times[1] - times[0]).toBeGreaterThanOrEqual(50 * 1000);
+    });
+
+    it('serves property values that were pushed from the cache', function () {
+        let value;
+        test.emitPropertyChanged('PropReadOnly', GLib.Variant.new_double(42));
+        Gio.DBus.session.call('org.gnome.gjs.Test', '/org/gnome/gjs/Test',
+            'org.freedesktop.DBus.Properties', 'Get',
+            new GLib.Variant('(ss)', ['org.gnome.gjs.Test', 'PropReadOnly']),
+            null, Gio.DBusCallFlags.NONE, -1, null, (conn, res) => {
+                [value] = conn.call_finish(res).deepUnpack();
+                loop.quit();
+            });
+        loop.run();
+        test.emitPropertyChanged('PropReadOnly', null);
+
+        expect(value.deepUnpack()).toEqual(42);
+    });
 });
 
 
@@ -2535,6 +2535,16 @@ describe('GObject properties', function () {
         expect(() => (obj.some_readonly = 35)).toThrow();
     });
 
+    it('sets and gets properties in a batch by any of their names', function () {
+        // The first access defines the accessor, with which the param spec is
+        // then found
+        expect(obj.some_int).toBe(0);
+        obj.setProperties({some_int: 1, 'some-string': 'one', someDouble: 1.5});
+        expect(obj.getProperties(['someInt', 'some_string', 'some-double']))
+            .toEqual({someInt: 1, some_string: 'one', 'some-double': 1.5});
+        expect(() => obj.setProperties({some_readonly: 35})).toThrow();
+    });
+
     xit('allows to set/get deprecated properties', function () {
         GLib.test_expect_message('Gjs', GLib.LogLevelFlags.LEVEL_WARNING,
             '*GObject property*.some-deprecated-int is deprecated*');
@@ -72,6 +72,41 @@ describe('GVariant constructor', function () {
         [112, 105, 122, 122, 97].forEach((val, ix) =>
             expect(a[ix]).toEqual(val));
     });
+
+    it('constructs arrays of fixed-size types', function () {
+        expect(new GLib.Variant('ai', [1, -2, 3]).deepUnpack()).toEqual([1, -2, 3]);
+        expect(new GLib.Variant('ad', [0.5, -1.5]).deepUnpack()).toEqual([0.5, -1.5]);
+        expect(new GLib.Variant('ab', [true, 0, 'x']).deepUnpack())
+            .toEqual([true, false, true]);
+        expect(new GLib.Variant('aq', []).deepUnpack()).toEqual([]);
+    });
+
+    it('does not deep unpack arrays when unpacking', function () {
+        const unpacked = new GLib.Variant('ai', [1, 2]).unpack();
+        expect(unpacked.length).toEqual(2);
+        expect(unpacked[0] instanceof GLib.Variant).toBeTruthy();
+        expect(unpacked[0].unpack()).toEqual(1);
+    });
+
+    it('rejects values out of range for the type', function () {
+        expect(() => new GLib.Variant('y', 256)).toThrowError(/out of range/);
+        expect(() => new GLib.Variant('an', [1, 40000])).toThrowError(/out of range/);
+    });
+
+    it('rejects invalid signatures', function () {
+        expect(() => new GLib.Variant('', 1)).toThrowError(TypeError);
+        expect(() => new GLib.Variant('a', [])).toThrowError(TypeError);
+        expect(() => new GLib.Variant('ss', 'a')).toThrowError(TypeError);
+        expect(() => new GLib.Variant('a{vs}', {})).toThrowError(TypeError);
+        expect(() => new GLib.Variant('a*', [])).toThrowError(TypeError);
+    });
+
+    it('rejects values of the wrong type', function () {
+        expect(() => new GLib.Variant('s', 5)).toThrowError(TypeError);
+        expect(() => new GLib.Variant('o', 'not a path')).toThrowError(TypeError);
+        expect(() => new GLib.Variant('v', 'string')).toThrowError(TypeError);
+        expect(() => new GLib.Variant('(si)', ['only one'])).toThrowError(TypeError);
+    });
 });
 
 describe('GVariant unpack', function () {
@@ -394,3 +429,84 @@ describe('GLib.MatchInfo', function () {
         });
     });
 });
+
+describe('GLib source callbacks', function () {
+    let loop;
+    beforeEach(function () {
+        loop = new GLib.MainLoop(null, false);
+    });
+
+    it('keeps calling an idle callback while it returns true', function () {
+        let count = 0;
+        GLib.idle_add(GLib.PRIORITY_DEFAULT, (...args) => {
+            expect(args).toEqual([]);
+            if (++count < 3)
+                return true;
+            loop.quit();
+            return false;
+        });
+        loop.run();
+        expect(count).toBe(3);
+    });
+
+    it('calls a timeout callback with a truthy return value again', function () {
+        let count = 0;
+        GLib.timeout_add(GLib.PRIORITY_DEFAULT, 1, () => {
+            if (++count < 2)
+                return 'yes';
+            loop.quit();
+            return undefined;
+        });
+        loop.run();
+        expect(count).toBe(2);
+    });
+
+    it('removes the source if the callback throws', function () {
+        GLib.test_expect_message('Gjs', GLib.LogLevelFlags.LEVEL_CRITICAL,
+            'JS ERROR: Error: oops*');
+        const callback = jasmine.createSpy('callback').and.throwError('oops');
+        GLib.idle_add(GLib.PRIORITY_HIGH, callback);
+        GLib.idle_add(GLib.PRIORITY_LOW, () => loop.quit());
+        loop.run();
+        GLib.test_assert_expected_messages_internal('Gjs', 'testGLib.js', 0,
+            'removes the source if the callback throws');
+        expect(callback).toHaveBeenCalledTimes(1);
+    });
+
+    it('supports Source.set_callback()', function () {
+        const source = GLib.idle_source_new();
+        const callback = jasmine.createSpy('callback').and.callFake(() => {
+            loop.quit();
+            return GLib.SOURCE_REMOVE;
+        });
+        source.set_callback(callback);
+        source.attach(null);
+        loop.run();
+        expect(callback).toHaveBeenCalledTimes(1);
+        expect(source.is_destroyed()).toBeTrue();
+    });
+
+    it('supports Source.set_callback() on a pollable stream source', function () {
+        const {Gio} = imports.gi;
+        const stream = Gio.MemoryInputStream.new_from_bytes(
+            new GLib.Bytes(Uint8Array.of(1, 2, 3)));
+        const source = stream.create_source(null);
+        const callback = jasmine.createSpy('callback').and.callFake(() => {
+            loop.quit();
+            return GLib.SOURCE_REMOVE;
+        });
+        source.set_callback(callback);
+        source.attach(null);
+        loop.run();
+        expect(callback).toHaveBeenCalledTimes(1);
+        expect(source.is_destroyed()).toBeTrue();
+    });
+
+    it('throws on a callback that is not a function', function () {
+        expect(() => GLib.idle_add(GLib.PRIORITY_DEFAULT, {}))
+            .toThrowError(TypeError);
+        expect(() => GLib.idle_source_new().set_callback({}))
+            .toThrowError(TypeError);
+        expect(() => GLib.timeout_add(GLib.PRIORITY_DEFAULT, 1, 42)).toThrow();
+    });
+});
@@ -29,6 +29,35 @@ describe('GObject overrides', function () {
         expect(o.int).toBe(42);
     });
 
+    it('setProperties() sets all properties with one notification each', function () {
+        const o = new TestObj();
+        const notify = jasmine.createSpy('notify');
+        o.connect('notify', (obj, pspec) => {
+            notify(pspec.name, obj.int, obj.string);
+        });
+        o.setProperties({string: 'Answer', int: 42});
+        expect(o.string).toBe('Answer');
+        expect(o.int).toBe(42);
+        expect(notify).toHaveBeenCalledTimes(2);
+        // Notifications are emitted only after both properties have been set
+        expect(notify).toHaveBeenCalledWith('int', 42, 'Answer');
+        expect(notify).toHaveBeenCalledWith('string', 42, 'Answer');
+    });
+
+    it('setProperties() throws on nonexistent properties', function () {
+        const o = new TestObj();
+        expect(() => o.setProperties({int: 5, nonexistent: 1})).toThrow();
+        expect(o.int).toBe(0);
+    });
+
+    it('getProperties() returns values keyed by the requested names', function () {
+        const o = new TestObj({string: 'Answer', int: 42});
+        expect(o.getProperties(['int', 'string'])).toEqual({int: 42, string: 'Answer'});
+        expect(o.getProperties([])).toEqual({});
+        expect(() => o.getProperties(['nonexistent'])).toThrow();
+        expect(() => o.getProperties('int')).toThrow();
+    });
+
     describe('Signal alternative syntax', function () {
         let o, handler;
         beforeEach(function () {
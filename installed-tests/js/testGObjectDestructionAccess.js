@@ -413,6 +413,30 @@ describe('Disposed or finalized GObject', function () {
             'generates a warn on object garbage collection if has expando property');
     });
 
+    it('is not read when its wrapper is in a heap snapshot', function () {
+        let file = Gio.File.new_for_path('/');
+        file.toggleReferenced = true;
+        file.run_dispose();
+        GjsTestTools.unref(file);
+        expect(file.toString()).toMatch(
+            /\[object \(FINALIZED\) instance wrapper GType:GLocalFile jsobj@0x[a-f0-9]+ native@0x[a-f0-9]+\]/);
+
+        System.dumpHeapSnapshot('finalized.heapsnapshot');
+        const snapshotFile = Gio.File.new_for_path('finalized.heapsnapshot');
+        const [, contents] = snapshotFile.load_contents(null);
+        const snapshot = JSON.parse(new TextDecoder().decode(contents));
+        snapshotFile.delete(null);
+        expect(snapshot.strings).toContain('[GObject] GLocalFile (finalized)');
+        expect(snapshot.strings).toContain('gobject (finalized)');
+
+        file = null;
+        GLib.test_expect_message('Gjs', GLib.LogLevelFlags.LEVEL_CRITICAL,
+            '*Object 0x* has been finalized *');
+        System.gc();
+        GLib.test_assert_expected_messages_internal('Gjs', 'testGObjectDestructionAccess.js', 0,
+            'is not read when its wrapper is in a heap snapshot');
+    });
+
     it('generates a warn if already disposed at garbage collection', function () {
         const loop = new GLib.MainLoop(null, false);
 
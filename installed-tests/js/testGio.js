@@ -99,6 +99,48 @@ describe('Promisify function', function () {
     });
 });
 
+describe('Async functions called without a callback', function () {
+    it('return a promise', async function () {
+        const file = Gio.File.new_for_path('.');
+        const promise = file.enumerate_children_async(Gio.FILE_ATTRIBUTE_STANDARD_NAME,
+            Gio.FileQueryInfoFlags.NONE, GLib.PRIORITY_DEFAULT, null);
+        expect(promise).toBeInstanceOf(Promise);
+        const enumerator = await promise;
+        expect(enumerator).toBeInstanceOf(Gio.FileEnumerator);
+        enumerator.close(null);
+    });
+
+    it('strip the success value from the result', async function () {
+        const file = Gio.File.new_for_uri('resource:///org/gjs/jsunit/modules/data.txt');
+        const [contents] = await file.load_contents_async(null);
+        expect(new TextDecoder().decode(contents).trim()).toEqual('test data');
+    });
+
+    it('reject with the stack of the call that created the promise', async function () {
+        const file = Gio.File.new_for_path('/does/not/exist');
+        const error = await file.query_info_async(Gio.FILE_ATTRIBUTE_STANDARD_TYPE,
+            Gio.FileQueryInfoFlags.NONE, GLib.PRIORITY_DEFAULT, null).catch(e => e);
+        expect(error.matches(Gio.IOErrorEnum, Gio.IOErrorEnum.NOT_FOUND)).toBeTrue();
+        expect(error.stack).toMatch(/### Promise created here: ###/);
+    });
+
+    it('settle with the finish function they started with', async function () {
+        const file = Gio.File.new_for_path('.');
+        const promise = file.query_filesystem_info_async(
+            Gio.FILE_ATTRIBUTE_FILESYSTEM_TYPE, GLib.PRIORITY_DEFAULT, null);
+        // Replaces the finish function while the operation is running
+        Gio._promisify(Gio.File.prototype, 'query_filesystem_info_async');
+        const info = await promise;
+        expect(info).toBeInstanceOf(Gio.FileInfo);
+    });
+
+    it('reject when the arguments are invalid', async function () {
+        const file = Gio.File.new_for_path('.');
+        await expectAsync(file.query_info_async(Gio.FILE_ATTRIBUTE_STANDARD_TYPE,
+            'not flags', GLib.PRIORITY_DEFAULT, null)).toBeRejected();
+    });
+});
+
 describe('Gio.Settings overrides', function () {
     it("doesn't crash when forgetting to specify a schema ID", function () {
         expect(() => new Gio.Settings()).toThrowError(/schema/);
@@ -257,3 +257,54 @@ describe('Backwards compatibility for GLib/Gio platform specific GIRs', function
         expect(socketAddress.toString()).toContain('GIName:Gio.UnixSocketAddress');
     });
 });
+
+describe('Calling functions asynchronously', function () {
+    let file, path;
+
+    beforeAll(function () {
+        [file, path] = Gio.File.new_tmp('gjs-call-async-XXXXXX');
+        file.replace_contents('contents', null, false,
+            Gio.FileCreateFlags.NONE, null);
+    });
+
+    afterAll(function () {
+        file.delete(null);
+    });
+
+    it('resolves to the return value and out arguments', async function () {
+        const [ok, contents] =
+            await GLib.file_get_contents.callAsync(null, path);
+        expect(ok).toBeTrue();
+        expect(new TextDecoder().decode(contents)).toEqual('contents');
+    });
+
+    it('calls methods on the given instance', async function () {
+        const [, contents] = await file.load_contents.callAsync(file, null);
+        expect(new TextDecoder().decode(contents)).toEqual('contents');
+    });
+
+    it('rejects with the GError thrown by the function', async function () {
+        const missing = Gio.File.new_for_path(`${path}-nonexistent`);
+        await expectAsync(missing.load_contents.callAsync(missing, null))
+            .toBeRejectedWithError(Gio.IOErrorEnum, /No such file/);
+    });
+
+    it('rejects arguments that cannot be marshalled', async function () {
+        await expectAsync(GLib.file_get_contents.callAsync(null, {}))
+            .toBeRejected();
+    });
+
+    it('refuses functions that take callbacks', async function () {
+        await expectAsync(GLib.child_watch_add.callAsync(null,
+            GLib.PRIORITY_DEFAULT, 0, () => {}))
+            .toBeRejectedWithError(/callback/);
+    });
+
+    it('refuses objects implemented in JS', async function () {
+        const JSObject = GObject.registerClass(
+            class JSObject extends GObject.Object {});
+        const obj = new JSObject();
+        await expectAsync(obj.notify.callAsync(obj, 'ignored'))
+            .toBeRejectedWithError(/implemented in JS/);
+    });
+});
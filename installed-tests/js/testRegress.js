@@ -606,6 +606,15 @@ describe('Life, the Universe and Everything', function () {
             expect(struct.some_enum).toEqual(Regress.TestEnum.VALUE3);
         });
 
+        it('rejects values that are not members of the enum', function () {
+            expect(() => (struct.some_enum = 2))
+                .toThrowError(/not a valid value for enumeration/);
+            expect(() => (struct.some_enum = -2))
+                .toThrowError(/not a valid value for enumeration/);
+            struct.some_enum = Regress.TestEnum.VALUE2;
+            expect(struct.some_enum).toEqual(Regress.TestEnum.VALUE2);
+        });
+
         it('can clone', function () {
             const b = struct.clone();
             expect(b.some_int).toEqual(42);
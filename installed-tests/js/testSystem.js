@@ -56,6 +56,28 @@ describe('System.dumpHeap()', function () {
     });
 });
 
+describe('System.dumpHeapSnapshot()', function () {
+    it('writes the heap with the GObjects of wrappers', function () {
+        const object = new GObject.Object();
+        System.dumpHeapSnapshot('heap.heapsnapshot');
+
+        const file = Gio.File.new_for_path('heap.heapsnapshot');
+        const [, contents] = file.load_contents(null);
+        const snapshot = JSON.parse(new TextDecoder().decode(contents));
+        file.delete(null);
+
+        expect(snapshot.snapshot.meta.node_fields.length).toEqual(7);
+        expect(snapshot.snapshot.node_count).toBeGreaterThan(0);
+        expect(snapshot.nodes.length).toEqual(snapshot.snapshot.node_count * 7);
+        expect(snapshot.strings).toContain('[GObject] GObject');
+        expect(object).toBeDefined();
+    });
+
+    it('throws but does not crash when given a nonexistent path', function () {
+        expect(() => System.dumpHeapSnapshot('/does/not/exist')).toThrow();
+    });
+});
+
 describe('System.dumpMemoryInfo()', function () {
     it('', function () {
         expect(() => System.dumpMemoryInfo('memory.md')).not.toThrow();
@@ -67,6 +89,58 @@ describe('System.dumpMemoryInfo()', function () {
     });
 });
 
+describe('System.getCounters()', function () {
+    it('counts wrapper objects and calls', function () {
+        const before = System.getCounters();
+        const objects = [new GObject.Object(), new GObject.Object()];
+        GObject.type_from_name('GObject');
+        const after = System.getCounters();
+
+        expect(after.object_instance).toBeGreaterThanOrEqual(objects.length);
+        expect(after.wrappers_created - before.wrappers_created)
+            .toBeGreaterThanOrEqual(objects.length);
+        expect(after.gi_calls).toBeGreaterThan(before.gi_calls);
+        expect(after.microtask_queue_length).toBeGreaterThanOrEqual(0);
+    });
+});
+
+describe('System.memoryReport()', function () {
+    it('breaks down memory by realm, script, and class', function () {
+        const objects = [new GObject.Object(), new GObject.Object()];
+        const report = System.memoryReport();
+
+        const realm = report.realms.find(({name}) => name === 'GjsGlobal');
+        expect(realm.gcBytes).toBeGreaterThan(0);
+
+        const script = report.modules.find(({url}) => url.endsWith('testSystem.js'));
+        expect(script.scripts).toBeGreaterThan(0);
+        expect(script.bytes).toBeGreaterThan(0);
+
+        const wrappers = report.classes.find(({name}) => name === 'GObject_Object');
+        expect(wrappers.count).toBeGreaterThanOrEqual(objects.length);
+        expect(report.classes[0].bytes)
+            .toBeGreaterThanOrEqual(report.classes[1].bytes);
+    });
+});
+
+describe('System.wrapperStats()', function () {
+    it('counts live wrapper objects per type', function () {
+        const objects = [new GObject.Object(), new GObject.Object()];
+        const stats = System.wrapperStats();
+        const entry = stats.find(({name}) => name === 'GObject');
+
+        expect(entry.live).toBeGreaterThanOrEqual(objects.length);
+        expect(entry.peak).toBeGreaterThanOrEqual(entry.live);
+        expect(entry.created - entry.finalized).toEqual(entry.live);
+        expect(entry.estimatedBytes).toBeGreaterThan(0);
+    });
+
+    it('is ordered by number of live wrapper objects', function () {
+        const live = System.wrapperStats().map(entry => entry.live);
+        expect(live).toEqual([...live].sort((a, b) => b - a));
+    });
+});
+
 describe('System.programPath', function () {
     it('is null when executed from minijasmine', function () {
         expect(System.programPath).toBe(null);
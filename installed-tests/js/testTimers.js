@@ -105,6 +105,74 @@ describe('Timers', () => {
         expect(count).toBe(0);
     });
 
+    it('returns distinct positive integer IDs', function () {
+        const t1 = setTimeout(() => {}, 10);
+        const t2 = setInterval(() => {}, 10);
+        clearTimeout(t1);
+        clearInterval(t2);
+
+        expect(Number.isInteger(t1)).toBeTrue();
+        expect(t1).toBeGreaterThan(0);
+        expect(t2).not.toBe(t1);
+    });
+
+    it('returns IDs that are not GLib source IDs', function () {
+        const id = setTimeout(() => {}, 10);
+        const source = GLib.timeout_add(GLib.PRIORITY_DEFAULT, 10,
+            () => GLib.SOURCE_REMOVE);
+
+        expect(id).toBeGreaterThan(2 ** 32 - 1);
+        expect(() => GLib.source_remove(id)).toThrow();
+        expect(GLib.MainContext.default().find_source_by_id(source))
+            .not.toBeNull();
+
+        clearTimeout(id);
+        GLib.source_remove(source);
+    });
+
+    it('fires many timers in deadline order', async function () {
+        const order = [];
+        setTimeout(() => order.push('late'), 60);
+        setTimeout(() => order.push('middle'), 40);
+
+        const ids = [];
+        for (let i = 0; i < 1000; i++)
+            ids.push(setTimeout(() => order.push(i), 20));
+        // Cancel every other timer
+        for (let i = 0; i < ids.length; i += 2)
+            clearTimeout(ids[i]);
+
+        await waitFor(150);
+
+        const expected = [];
+        for (let i = 1; i < 1000; i += 2)
+            expected.push(i);
+        expect(order).toEqual([...expected, 'middle', 'late']);
+    });
+
+    it('fires other timers in a main loop nested in a callback', async function () {
+        const order = [];
+        await expectPromise(resolve => {
+            setTimeout(() => order.push('scheduled before'), 20);
+            setTimeout(() => {
+                const loop = new GLib.MainLoop(null, false);
+                setTimeout(() => {
+                    order.push('scheduled inside');
+                    loop.quit();
+                }, 50);
+                loop.run();
+                resolve();
+            }, 0);
+        }).toBeResolved();
+
+        expect(order).toEqual(['scheduled before', 'scheduled inside']);
+    });
+
+    it('throws on a callback that is not a function', function () {
+        expect(() => setTimeout('code', 1)).toThrowError(TypeError);
+        expect(() => setInterval({}, 1)).toThrowError(TypeError);
+    });
+
     it('cancels multiple correctly', async function () {
         const uncalled = jasmine.createSpy('uncalled');
 
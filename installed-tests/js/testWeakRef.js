@@ -62,6 +62,22 @@ describe('FinalizationRegistry', function () {
         expect(callback).toHaveBeenCalled();
     });
 
+    it('runs all callbacks when many registries are collected in a microtask', async function () {
+        // More registries than cleanup tasks run in one batch, so that they
+        // are split over several batches
+        const registries = Array.from({length: 80},
+            () => new FinalizationRegistry(callback));
+        let objects = Array.from({length: 400}, () => ({}));
+        objects.forEach((obj, ix) => registries[ix % 80].register(obj, ix));
+        objects = null;
+        await Promise.resolve();
+        System.gc();
+        // Keep the microtask queue busy while the callbacks are pending
+        for (let i = 0; i < 50; i++)
+            await Promise.resolve();
+        expect(callback).toHaveBeenCalledTimes(400);
+    });
+
     it('works if another collection is queued from the callback', function () {
         let obj = {};
         let obj2 = {};
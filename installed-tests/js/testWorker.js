@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+import {Worker, parentPort} from 'worker';
+
+const ECHO_WORKER = 'resource:///org/gjs/jsunit/modules/echoWorker.js';
+
+function nextMessage(worker) {
+    return new Promise((resolve, reject) => {
+        worker.onmessage = ({data}) => resolve(data);
+        worker.onerror = reject;
+    });
+}
+
+describe('Worker', function () {
+    let worker;
+
+    beforeEach(function () {
+        worker = new Worker(ECHO_WORKER);
+    });
+
+    afterEach(function () {
+        worker.terminate();
+    });
+
+    it('is not a worker in the main thread', function () {
+        expect(parentPort).toBeNull();
+    });
+
+    it('copies messages with the structured clone algorithm', async function () {
+        const value = {
+            string: 'hello',
+            array: [1, 2.5, null],
+            map: new Map([['key', new Set([1, 2])]]),
+            date: new Date(0),
+        };
+        worker.postMessage({command: 'echo', value});
+        const reply = await nextMessage(worker);
+
+        expect(reply).not.toBe(value);
+        expect(reply.string).toEqual('hello');
+        expect(reply.array).toEqual([1, 2.5, null]);
+        expect(reply.map.get('key').has(2)).toBeTrue();
+        expect(reply.date.getTime()).toEqual(0);
+    });
+
+    it('delivers messages in order', async function () {
+        const received = [];
+        const done = new Promise(resolve => {
+            worker.onmessage = ({data}) => {
+                received.push(data);
+                if (received.length === 100)
+                    resolve();
+            };
+        });
+        for (let value = 0; value < 100; value++)
+            worker.postMessage({command: 'echo', value});
+        await done;
+
+        expect(received).toEqual([...Array(100).keys()]);
+    });
+
+    it('moves transferred ArrayBuffers', async function () {
+        const buffer = new Uint8Array([1, 2, 3]).buffer;
+        worker.postMessage({command: 'transfer', buffer}, [buffer]);
+        expect(buffer.byteLength).toEqual(0);
+
+        const reply = await nextMessage(worker);
+        expect(new Uint8Array(reply)).toEqual(new Uint8Array([3, 2, 1]));
+    });
+
+    it('throws on values that cannot be cloned', function () {
+        expect(() => worker.postMessage({command: 'echo', value: () => {}}))
+            .toThrow();
+    });
+
+    it('rejects a transfer list that is not an array', function () {
+        const buffer = new ArrayBuffer(1);
+        expect(() => worker.postMessage(buffer, buffer))
+            .toThrowError(TypeError);
+    });
+
+    it('reports errors while loading the module', async function () {
+        const broken =
+            new Worker('resource:///org/gjs/jsunit/modules/nonexistent.js');
+        const error = await new Promise(resolve => (broken.onerror = resolve));
+        expect(error).toBeInstanceOf(Error);
+    });
+});
@@ -35,7 +35,19 @@ struct _GjsDBusImplementationPrivate {
 
     // from gchar* to GVariant*
     GHashTable           *outstanding_properties;
-    guint                 idle_id;
+    guint                 flush_id;
+
+    // Values pushed with gjs_dbus_implementation_emit_property_changed(),
+    // from gchar* to GVariant*
+    GHashTable           *property_cache;
+
+    // Minimum time between two PropertiesChanged signals, in microseconds
+    gint64                flush_interval;
+    gint64                last_flush_time;
+
+    GjsDBusMethodCallFunc method_call_func;
+    void                 *method_call_data;
+    GDestroyNotify        method_call_data_destroy;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE(GjsDBusImplementation, gjs_dbus_implementation,
@@ -100,6 +112,7 @@ static void gjs_dbus_implementation_method_call(
     const char* method_name, GVariant* parameters,
     GDBusMethodInvocation* invocation, void* user_data) {
     GjsDBusImplementation *self = GJS_DBUS_IMPLEMENTATION (user_data);
+    GDBusMethodInfo* method_info;
     GError* error = NULL;
 
     if (!gjs_dbus_implementation_check_interface(self, connection, object_path,
@@ -107,14 +120,21 @@ static void gjs_dbus_implementation_method_call(
         g_dbus_method_invocation_take_error(invocation, error);
         return;
     }
-    if (!g_dbus_interface_info_lookup_method(self->priv->ifaceinfo,
-                                             method_name)) {
+    method_info = g_dbus_interface_info_lookup_method(self->priv->ifaceinfo,
+                                                      method_name);
+    if (!method_info) {
         g_dbus_method_invocation_return_error(
             invocation, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD,
             "Unknown method %s on %s", method_name, interface_name);
         return;
     }
 
+    if (self->priv->method_call_func) {
+        self->priv->method_call_func(self, method_info, parameters, invocation,
+                                     self->priv->method_call_data);
+        return;
+    }
+
     g_signal_emit(self, signals[SIGNAL_HANDLE_METHOD], 0, method_name, parameters, invocation);
     g_object_unref (invocation);
 }
@@ -132,6 +152,12 @@ static GVariant* gjs_dbus_implementation_property_get(
                                                 property_name, error))
         return NULL;
 
+    /* Values pushed from JS are served without calling back into it */
+    value = (GVariant*) g_hash_table_lookup(self->priv->property_cache,
+                                            property_name);
+    if (value)
+        return g_variant_ref(value);
+
     g_signal_emit(self, signals[SIGNAL_HANDLE_PROPERTY_GET], 0, property_name, &value);
 
     /* Marshaling GErrors is not supported, so this is the best we can do
@@ -155,6 +181,9 @@ static gboolean gjs_dbus_implementation_property_set(
                                                 property_name, error))
         return FALSE;
 
+    /* The setter may not store the value as it is, so ask for it next time */
+    g_hash_table_remove(self->priv->property_cache, property_name);
+
     g_signal_emit(self, signals[SIGNAL_HANDLE_PROPERTY_SET], 0, property_name, value);
 
     return TRUE;
@@ -175,12 +204,29 @@ gjs_dbus_implementation_init(GjsDBusImplementation *self) {
                                                          g_str_equal,
                                                          g_free,
                                                          _g_variant_unref0);
+    priv->property_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                 g_free, _g_variant_unref0);
+}
+
+static void gjs_dbus_implementation_clear_method_call_func(
+    GjsDBusImplementation* self) {
+    GjsDBusImplementationPrivate* priv = self->priv;
+    void* data = priv->method_call_data;
+    GDestroyNotify destroy = priv->method_call_data_destroy;
+
+    priv->method_call_func = NULL;
+    priv->method_call_data = NULL;
+    priv->method_call_data_destroy = NULL;
+
+    if (destroy)
+        destroy(data);
 }
 
 static void gjs_dbus_implementation_dispose(GObject* object) {
     GjsDBusImplementation* self = GJS_DBUS_IMPLEMENTATION(object);
 
-    g_clear_handle_id(&self->priv->idle_id, g_source_remove);
+    g_clear_handle_id(&self->priv->flush_id, g_source_remove);
+    gjs_dbus_implementation_clear_method_call_func(self);
 
     G_OBJECT_CLASS(gjs_dbus_implementation_parent_class)->dispose(object);
 }
@@ -191,6 +237,7 @@ gjs_dbus_implementation_finalize(GObject *object) {
 
     g_dbus_interface_info_unref (self->priv->ifaceinfo);
     g_hash_table_destroy(self->priv->outstanding_properties);
+    g_hash_table_destroy(self->priv->property_cache);
 
     G_OBJECT_CLASS(gjs_dbus_implementation_parent_class)->finalize(object);
 }
@@ -237,14 +284,20 @@ gjs_dbus_implementation_get_properties (GDBusInterfaceSkeleton *skeleton) {
         GDBusPropertyInfo *prop = *props;
         GVariant *value;
 
+        if (!(prop->flags & G_DBUS_PROPERTY_INFO_FLAGS_READABLE))
+            continue;
+
         /* If we have a cached value, we use that instead of querying again */
-        if ((value = (GVariant*) g_hash_table_lookup(self->priv->outstanding_properties, prop->name))) {
+        if ((value = (GVariant*) g_hash_table_lookup(self->priv->property_cache, prop->name))) {
             g_variant_builder_add(&builder, "{sv}", prop->name, value);
             continue;
         }
 
         g_signal_emit(self, signals[SIGNAL_HANDLE_PROPERTY_GET], 0, prop->name, &value);
-        g_variant_builder_add(&builder, "{sv}", prop->name, value);
+        if (value) {
+            g_variant_builder_add(&builder, "{sv}", prop->name, value);
+            g_variant_unref(value);
+        }
     }
 
     return g_variant_builder_end(&builder);
@@ -260,6 +313,12 @@ gjs_dbus_implementation_flush (GDBusInterfaceSkeleton *skeleton) {
     GVariant *val;
     gchar *prop_name;
 
+    g_clear_handle_id(&self->priv->flush_id, g_source_remove);
+    self->priv->last_flush_time = g_get_monotonic_time();
+
+    if (g_hash_table_size(self->priv->outstanding_properties) == 0)
+        return;
+
     g_variant_builder_init(&changed_props, G_VARIANT_TYPE_VARDICT);
     g_variant_builder_init(&invalidated_props, G_VARIANT_TYPE_STRING_ARRAY);
 
@@ -294,7 +353,6 @@ gjs_dbus_implementation_flush (GDBusInterfaceSkeleton *skeleton) {
     g_list_free(connections);
 
     g_hash_table_remove_all(self->priv->outstanding_properties);
-    g_clear_handle_id(&self->priv->idle_id, g_source_remove);
 }
 
 void
@@ -357,13 +415,39 @@ gjs_dbus_implementation_class_init(GjsDBusImplementationClass *klass) {
 }
 
 static gboolean
-idle_cb (gpointer data) {
-    GDBusInterfaceSkeleton *skeleton = G_DBUS_INTERFACE_SKELETON (data);
+flush_cb (gpointer data) {
+    GjsDBusImplementation *self = GJS_DBUS_IMPLEMENTATION (data);
 
-    g_dbus_interface_skeleton_flush(skeleton);
+    self->priv->flush_id = 0;
+    g_dbus_interface_skeleton_flush(G_DBUS_INTERFACE_SKELETON(self));
     return G_SOURCE_REMOVE;
 }
 
+/**
+ * gjs_dbus_implementation_set_method_call_func: (skip)
+ * @self: a #GjsDBusImplementation
+ * @func: (nullable): function to dispatch method calls to
+ * @user_data: data to pass to @func
+ * @destroy: (nullable): called on @user_data when it is no longer needed
+ *
+ * Dispatches method calls on @self to @func, instead of emitting
+ * #GjsDBusImplementation::handle-method-call. This is used by the D-Bus
+ * convenience API in the Gio overrides, which looks up the JS handler of each
+ * method from a table built once when the object is wrapped.
+ *
+ * @func takes over the reference to the invocation.
+ */
+void gjs_dbus_implementation_set_method_call_func(GjsDBusImplementation* self,
+                                                  GjsDBusMethodCallFunc func,
+                                                  void* user_data,
+                                                  GDestroyNotify destroy) {
+    gjs_dbus_implementation_clear_method_call_func(self);
+
+    self->priv->method_call_func = func;
+    self->priv->method_call_data = user_data;
+    self->priv->method_call_data_destroy = destroy;
+}
+
 /**
  * gjs_dbus_implementation_emit_property_changed:
  * @self: a #GjsDBusImplementation
@@ -371,19 +455,58 @@ idle_cb (gpointer data) {
  * @newvalue: (allow-none): the new value, or %NULL to just invalidate it
  *
  * Queue a PropertyChanged signal for emission, or update the one queued
- * adding @property
+ * adding @property. If the last one was emitted less than the interval set
+ * with gjs_dbus_implementation_set_property_changed_interval() ago, it is
+ * emitted once the interval has passed, and carries only the latest value of
+ * each property that changed in the meantime.
+ *
+ * @newvalue is also cached, and used to reply to requests for the value of
+ * @property until it is invalidated or set by a client.
  */
 void
 gjs_dbus_implementation_emit_property_changed (GjsDBusImplementation *self,
                                                gchar                 *property,
                                                GVariant              *newvalue)
 {
-    g_hash_table_replace(self->priv->outstanding_properties,
-                         g_strdup(property),
-                         _g_variant_ref_sink0(newvalue));
+    GjsDBusImplementationPrivate *priv = self->priv;
+    gint64 elapsed;
+
+    _g_variant_ref_sink0(newvalue);
+    if (newvalue)
+        g_hash_table_replace(priv->property_cache, g_strdup(property),
+                             g_variant_ref(newvalue));
+    else
+        g_hash_table_remove(priv->property_cache, property);
 
-    if (!self->priv->idle_id)
-        self->priv->idle_id = g_idle_add(idle_cb, self);
+    g_hash_table_replace(priv->outstanding_properties, g_strdup(property),
+                         newvalue);
+
+    if (priv->flush_id)
+        return;
+
+    elapsed = g_get_monotonic_time() - priv->last_flush_time;
+    if (elapsed >= priv->flush_interval)
+        priv->flush_id = g_idle_add(flush_cb, self);
+    else
+        priv->flush_id = g_timeout_add(
+            (unsigned)((priv->flush_interval - elapsed) / 1000) + 1, flush_cb,
+            self);
+}
+
+/**
+ * gjs_dbus_implementation_set_property_changed_interval:
+ * @self: a #GjsDBusImplementation
+ * @interval_ms: minimum time between two PropertiesChanged signals, in
+ *   milliseconds
+ *
+ * Limits the rate at which PropertiesChanged signals are emitted for the
+ * interface, for properties that change more often than clients need to know
+ * about. Changes queued in between are coalesced. The default is 0, in which
+ * case the changes are emitted as soon as the main loop is idle.
+ */
+void gjs_dbus_implementation_set_property_changed_interval(
+    GjsDBusImplementation* self, unsigned interval_ms) {
+    self->priv->flush_interval = (gint64) interval_ms * G_TIME_SPAN_MILLISECOND;
 }
 
 /**
@@ -436,7 +559,7 @@ gjs_dbus_implementation_unexport(GjsDBusImplementation *self) {
     GDBusInterfaceSkeleton *skeleton = G_DBUS_INTERFACE_SKELETON(self);
 
     g_hash_table_remove_all(self->priv->outstanding_properties);
-    g_clear_handle_id(&self->priv->idle_id, g_source_remove);
+    g_clear_handle_id(&self->priv->flush_id, g_source_remove);
 
     g_dbus_interface_skeleton_unexport(skeleton);
 }
@@ -459,7 +582,7 @@ gjs_dbus_implementation_unexport_from_connection(GjsDBusImplementation *self,
 
     if (g_list_length(connections) <= 1) {
         g_hash_table_remove_all(self->priv->outstanding_properties);
-        g_clear_handle_id(&self->priv->idle_id, g_source_remove);
+        g_clear_handle_id(&self->priv->flush_id, g_source_remove);
     }
 
     g_list_free_full(connections, g_object_unref);
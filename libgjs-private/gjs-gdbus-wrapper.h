@@ -39,9 +39,31 @@ typedef struct _GjsDBusImplementationClass GjsDBusImplementationClass;
 GJS_EXPORT
 GType                  gjs_dbus_implementation_get_type (void);
 
+/**
+ * GjsDBusMethodCallFunc: (skip)
+ * @self: the #GjsDBusImplementation the method was called on
+ * @method_info: introspection data of the called method
+ * @parameters: the method call parameters
+ * @invocation: (transfer full): the invocation to reply to
+ * @user_data: data passed to gjs_dbus_implementation_set_method_call_func()
+ */
+typedef void (*GjsDBusMethodCallFunc)(GjsDBusImplementation* self,
+                                      GDBusMethodInfo* method_info,
+                                      GVariant* parameters,
+                                      GDBusMethodInvocation* invocation,
+                                      void* user_data);
+
+void gjs_dbus_implementation_set_method_call_func(GjsDBusImplementation* self,
+                                                  GjsDBusMethodCallFunc func,
+                                                  void* user_data,
+                                                  GDestroyNotify destroy);
+
 GJS_EXPORT
 void                   gjs_dbus_implementation_emit_property_changed (GjsDBusImplementation *self, gchar *property, GVariant *newvalue);
 GJS_EXPORT
+void gjs_dbus_implementation_set_property_changed_interval(
+    GjsDBusImplementation* self, unsigned interval_ms);
+GJS_EXPORT
 void                   gjs_dbus_implementation_emit_signal           (GjsDBusImplementation *self, gchar *signal_name, GVariant *parameters);
 
 GJS_EXPORT
@@ -3,240 +3,11 @@
 // SPDX-FileCopyrightText: 2023 Philip Chimento <philip.chimento@gmail.com>
 
 const {setMainLoopHook} = imports._promiseNative;
+const {unpack: _unpackVariant} = imports._variantNative;
+const SourceNative = imports._sourceNative;
 
 let GLib;
 
-const SIMPLE_TYPES = ['b', 'y', 'n', 'q', 'i', 'u', 'x', 't', 'h', 'd', 's', 'o', 'g'];
-
-function _readSingleType(signature, forceSimple) {
-    let char = signature.shift();
-    let isSimple = false;
-
-    if (!SIMPLE_TYPES.includes(char)) {
-        if (forceSimple)
-            throw new TypeError('Invalid GVariant signature (a simple type was expected)');
-    } else {
-        isSimple = true;
-    }
-
-    if (char === 'm' || char === 'a')
-        return [char].concat(_readSingleType(signature, false));
-    if (char === '{') {
-        let key = _readSingleType(signature, true);
-        let val = _readSingleType(signature, false);
-        let close = signature.shift();
-        if (close !== '}')
-            throw new TypeError('Invalid GVariant signature for type DICT_ENTRY (expected "}"');
-        return [char].concat(key, val, close);
-    }
-    if (char === '(') {
-        let res = [char];
-        while (true) {
-            if (signature.length === 0)
-                throw new TypeError('Invalid GVariant signature for type TUPLE (expected ")")');
-            let next = signature[0];
-            if (next === ')') {
-                signature.shift();
-                return res.concat(next);
-            }
-            let el = _readSingleType(signature);
-            res = res.concat(el);
-        }
-    }
-
-    // Valid types are simple types, arrays, maybes, tuples, dictionary entries and variants
-    if (!isSimple && char !== 'v')
-        throw new TypeError(`Invalid GVariant signature (${char} is not a valid type)`);
-
-    return [char];
-}
-
-function _packVariant(signature, value) {
-    if (signature.length === 0)
-        throw new TypeError('GVariant signature cannot be empty');
-
-    let char = signature.shift();
-    switch (char) {
-    case 'b':
-        return GLib.Variant.new_boolean(value);
-    case 'y':
-        return GLib.Variant.new_byte(value);
-    case 'n':
-        return GLib.Variant.new_int16(value);
-    case 'q':
-        return GLib.Variant.new_uint16(value);
-    case 'i':
-        return GLib.Variant.new_int32(value);
-    case 'u':
-        return GLib.Variant.new_uint32(value);
-    case 'x':
-        return GLib.Variant.new_int64(value);
-    case 't':
-        return GLib.Variant.new_uint64(value);
-    case 'h':
-        return GLib.Variant.new_handle(value);
-    case 'd':
-        return GLib.Variant.new_double(value);
-    case 's':
-        return GLib.Variant.new_string(value);
-    case 'o':
-        return GLib.Variant.new_object_path(value);
-    case 'g':
-        return GLib.Variant.new_signature(value);
-    case 'v':
-        return GLib.Variant.new_variant(value);
-    case 'm':
-        if (value !== null) {
-            return GLib.Variant.new_maybe(null, _packVariant(signature, value));
-        } else {
-            return GLib.Variant.new_maybe(new GLib.VariantType(
-                _readSingleType(signature, false).join('')), null);
-        }
-    case 'a': {
-        let arrayType = _readSingleType(signature, false);
-        if (arrayType[0] === 's') {
-            // special case for array of strings
-            return GLib.Variant.new_strv(value);
-        }
-        if (arrayType[0] === 'y') {
-            // special case for array of bytes
-            if (typeof value === 'string')
-                value = Uint8Array.of(...new TextEncoder().encode(value), 0);
-            const bytes = new GLib.Bytes(value);
-            return GLib.Variant.new_from_bytes(new GLib.VariantType('ay'),
-                bytes, true);
-        }
-
-        let arrayValue = [];
-        if (arrayType[0] === '{') {
-            // special case for dictionaries
-            for (let key in value) {
-                let copy = [].concat(arrayType);
-                let child = _packVariant(copy, [key, value[key]]);
-                arrayValue.push(child);
-            }
-        } else {
-            for (let i = 0; i < value.length; i++) {
-                let copy = [].concat(arrayType);
-                let child = _packVariant(copy, value[i]);
-                arrayValue.push(child);
-            }
-        }
-        return GLib.Variant.new_array(new GLib.VariantType(arrayType.join('')), arrayValue);
-    }
-
-    case '(': {
-        let children = [];
-        for (let i = 0; i < value.length; i++) {
-            let next = signature[0];
-            if (next === ')')
-                break;
-            children.push(_packVariant(signature, value[i]));
-        }
-
-        if (signature[0] !== ')')
-            throw new TypeError('Invalid GVariant signature for type TUPLE (expected ")")');
-        signature.shift();
-        return GLib.Variant.new_tuple(children);
-    }
-    case '{': {
-        let key = _packVariant(signature, value[0]);
-        let child = _packVariant(signature, value[1]);
-
-        if (signature[0] !== '}')
-            throw new TypeError('Invalid GVariant signature for type DICT_ENTRY (expected "}")');
-        signature.shift();
-
-        return GLib.Variant.new_dict_entry(key, child);
-    }
-    default:
-        throw new TypeError(`Invalid GVariant signature (unexpected character ${char})`);
-    }
-}
-
-function _unpackVariant(variant, deep, recursive = false) {
-    switch (String.fromCharCode(variant.classify())) {
-    case 'b':
-        return variant.get_boolean();
-    case 'y':
-        return variant.get_byte();
-    case 'n':
-        return variant.get_int16();
-    case 'q':
-        return variant.get_uint16();
-    case 'i':
-        return variant.get_int32();
-    case 'u':
-        return variant.get_uint32();
-    case 'x':
-        return variant.get_int64();
-    case 't':
-        return variant.get_uint64();
-    case 'h':
-        return variant.get_handle();
-    case 'd':
-        return variant.get_double();
-    case 'o':
-    case 'g':
-    case 's':
-        // g_variant_get_string has length as out argument
-        return variant.get_string()[0];
-    case 'v': {
-        const ret = variant.get_variant();
-        if (deep && recursive && ret instanceof GLib.Variant)
-            return _unpackVariant(ret, deep, recursive);
-        return ret;
-    }
-    case 'm': {
-        let val = variant.get_maybe();
-        if (deep && val)
-            return _unpackVariant(val, deep, recursive);
-        else
-            return val;
-    }
-    case 'a':
-        if (variant.is_of_type(new GLib.VariantType('a{?*}'))) {
-            // special case containers
-            let ret = { };
-            let nElements = variant.n_children();
-            for (let i = 0; i < nElements; i++) {
-                // always unpack the dictionary entry, and always unpack
-                // the key (or it cannot be added as a key)
-                let val = _unpackVariant(variant.get_child_value(i), deep,
-                    recursive);
-                let key;
-                if (!deep)
-                    key = _unpackVariant(val[0], true);
-                else
-                    key = val[0];
-                ret[key] = val[1];
-            }
-            return ret;
-        }
-        if (variant.is_of_type(new GLib.VariantType('ay'))) {
-            // special case byte arrays
-            return variant.get_data_as_bytes().toArray();
-        }
-
-        // fall through
-    case '(':
-    case '{': {
-        let ret = [];
-        let nElements = variant.n_children();
-        for (let i = 0; i < nElements; i++) {
-            let val = variant.get_child_value(i);
-            if (deep)
-                ret.push(_unpackVariant(val, deep, recursive));
-            else
-                ret.push(val);
-        }
-        return ret;
-    }
-    }
-
-    throw new Error('Assertion failure: this code should not be reached');
-}
-
 function _notIntrospectableError(funcName, replacement) {
     return new Error(`${funcName} is not introspectable. Use ${replacement} instead.`);
 }
@@ -268,6 +39,36 @@ function _init() {
         });
     };
 
+    // Let a worker quit the loops run from its JS code when its parent exits
+    if (imports._workerNative.isWorkerThread()) {
+        const WorkerNative = imports._workerNative;
+        const {run} = GLib.MainLoop.prototype;
+        GLib.MainLoop.prototype.run = function () {
+            WorkerNative.addRunningLoop(this);
+            try {
+                return run.call(this);
+            } finally {
+                WorkerNative.removeRunningLoop(this);
+            }
+        };
+    }
+
+    // Dispatch source callbacks directly, without a libffi closure for each
+    this.idle_add = function (priority, func) {
+        return SourceNative.idleAdd(priority, func);
+    };
+    this.timeout_add = function (priority, interval, func) {
+        return SourceNative.timeoutAdd(priority, interval, func);
+    };
+    this.timeout_add_seconds = function (priority, interval, func) {
+        return SourceNative.timeoutAddSeconds(priority, interval, func);
+    };
+    const introspectedSetCallback = this.Source.prototype.set_callback;
+    this.Source.prototype.set_callback = function (func) {
+        if (!SourceNative.setCallback(this, func))
+            introspectedSetCallback.call(this, func);
+    };
+
     // For convenience in property min or max values, since GLib.MAXINT64 and
     // friends will log a warning when used
     this.MAXINT64_BIGINT = 0x7fff_ffff_ffff_ffffn;
@@ -291,25 +92,15 @@ function _init() {
         return realNewLiteral(domain, code, message);
     };
 
-    this.Variant._new_internal = function (sig, value) {
-        let signature = Array.prototype.slice.call(sig);
-
-        let variant = _packVariant(signature, value);
-        if (signature.length !== 0)
-            throw new TypeError('Invalid GVariant signature (more than one single complete type)');
-
-        return variant;
-    };
-
     // Deprecate version of new GLib.Variant()
     this.Variant.new = function (sig, value) {
         return new GLib.Variant(sig, value);
     };
     this.Variant.prototype.unpack = function () {
-        return _unpackVariant(this, false);
+        return _unpackVariant(this, false, false);
     };
     this.Variant.prototype.deepUnpack = function () {
-        return _unpackVariant(this, true);
+        return _unpackVariant(this, true, false);
     };
     // backwards compatibility alias
     this.Variant.prototype.deep_unpack = this.Variant.prototype.deepUnpack;
@@ -395,7 +186,7 @@ function _init() {
         const variant = this.lookup_value(key, variantType);
         if (variant === null)
             return null;
-        return _unpackVariant(variant, deep);
+        return _unpackVariant(variant, deep, false);
     };
 
     // Prevent user code from calling GLib string manipulation functions that
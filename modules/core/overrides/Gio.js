@@ -3,79 +3,29 @@
 
 var GLib = imports.gi.GLib;
 var GjsPrivate = imports.gi.GjsPrivate;
+const Gi = imports._gi;
 var Signals = imports.signals;
+const DBusNative = imports._dbusNative;
 var Gio;
 
-// Ensures that a Gio.UnixFDList being passed into or out of a DBus method with
-// a parameter type that includes 'h' somewhere, actually has entries in it for
-// each of the indices being passed as an 'h' parameter.
-function _validateFDVariant(variant, fdList) {
-    switch (String.fromCharCode(variant.classify())) {
-    case 'b':
-    case 'y':
-    case 'n':
-    case 'q':
-    case 'i':
-    case 'u':
-    case 'x':
-    case 't':
-    case 'd':
-    case 'o':
-    case 'g':
-    case 's':
-        return;
-    case 'h': {
-        const val = variant.get_handle();
-        const numFds = fdList.get_length();
-        if (val >= numFds) {
-            throw new Error(`handle ${val} is out of range of Gio.UnixFDList ` +
-                `containing ${numFds} FDs`);
-        }
-        return;
-    }
-    case 'v':
-        _validateFDVariant(variant.get_variant(), fdList);
-        return;
-    case 'm': {
-        let val = variant.get_maybe();
-        if (val)
-            _validateFDVariant(val, fdList);
-        return;
-    }
-    case 'a':
-    case '(':
-    case '{': {
-        let nElements = variant.n_children();
-        for (let ix = 0; ix < nElements; ix++)
-            _validateFDVariant(variant.get_child_value(ix), fdList);
-        return;
-    }
-    }
-
-    throw new Error('Assertion failure: this code should not be reached');
-}
-
-function _proxyInvoker(methodName, sync, inSignature, argArray) {
+function _proxyInvoker(methodInfo, sync, usePromise, argArray) {
     var replyFunc;
     var flags = 0;
     var cancellable = null;
     let fdList = null;
 
-    /* Convert argArray to a *real* array */
-    argArray = Array.prototype.slice.call(argArray);
-
     /* The default replyFunc only logs the responses */
-    replyFunc = _logReply;
+    replyFunc = usePromise ? null : _logReply;
 
-    var signatureLength = inSignature.length;
+    var signatureLength = methodInfo.in_args.length;
     var minNumberArgs = signatureLength;
     var maxNumberArgs = signatureLength + 4;
 
     if (argArray.length < minNumberArgs) {
         throw new Error(`Not enough arguments passed for method: ${
-            methodName}. Expected ${minNumberArgs}, got ${argArray.length}`);
+            methodInfo.name}. Expected ${minNumberArgs}, got ${argArray.length}`);
     } else if (argArray.length > maxNumberArgs) {
-        throw new Error(`Too many arguments passed for method ${methodName}. ` +
+        throw new Error(`Too many arguments passed for method ${methodInfo.name}. ` +
             `Maximum is ${maxNumberArgs} including one callback, ` +
             'Gio.Cancellable, Gio.UnixFDList, and/or flags');
     }
@@ -83,7 +33,7 @@ function _proxyInvoker(methodName, sync, inSignature, argArray) {
     while (argArray.length > signatureLength) {
         var argNum = argArray.length - 1;
         var arg = argArray.pop();
-        if (typeof arg === 'function' && !sync) {
+        if (typeof arg === 'function' && !sync && !usePromise) {
             replyFunc = arg;
         } else if (typeof arg === 'number') {
             flags = arg;
@@ -92,42 +42,16 @@ function _proxyInvoker(methodName, sync, inSignature, argArray) {
         } else if (arg instanceof Gio.UnixFDList) {
             fdList = arg;
         } else {
-            throw new Error(`Argument ${argNum} of method ${methodName} is ` +
+            throw new Error(`Argument ${argNum} of method ${methodInfo.name} is ` +
                 `${typeof arg}. It should be a callback, flags, ` +
                 'Gio.UnixFDList, or a Gio.Cancellable');
         }
     }
 
-    const inTypeString = `(${inSignature.join('')})`;
-    const inVariant = new GLib.Variant(inTypeString, argArray);
-    if (inTypeString.includes('h')) {
-        if (!fdList) {
-            throw new Error(`Method ${methodName} with input type containing ` +
-                '\'h\' must have a Gio.UnixFDList as an argument');
-        }
-        _validateFDVariant(inVariant, fdList);
-    }
-
-    var asyncCallback = (proxy, result) => {
-        try {
-            const [outVariant, outFdList] =
-                proxy.call_with_unix_fd_list_finish(result);
-            replyFunc(outVariant.deepUnpack(), null, outFdList);
-        } catch (e) {
-            replyFunc([], e, null);
-        }
-    };
-
-    if (sync) {
-        const [outVariant, outFdList] = this.call_with_unix_fd_list_sync(
-            methodName, inVariant, flags, -1, fdList, cancellable);
-        if (fdList)
-            return [outVariant.deepUnpack(), outFdList];
-        return outVariant.deepUnpack();
-    }
-
-    return this.call_with_unix_fd_list(methodName, inVariant, flags, -1, fdList,
-        cancellable, asyncCallback);
+    // Packing the arguments, checking the handles against fdList, making the
+    // call and unpacking the reply are done natively
+    return DBusNative.proxyCall(this, methodInfo, sync, argArray, flags,
+        fdList, fdList?.get_length() ?? 0, cancellable, replyFunc);
 }
 
 function _logReply(result, exc) {
@@ -136,20 +60,89 @@ function _logReply(result, exc) {
 }
 
 function _makeProxyMethod(method, sync) {
-    var i;
-    var name = method.name;
-    var inArgs = method.in_args;
-    var inSignature = [];
-    for (i = 0; i < inArgs.length; i++)
-        inSignature.push(inArgs[i].signature);
-
     return function (...args) {
-        return _proxyInvoker.call(this, name, sync, inSignature, args);
+        return _proxyInvoker.call(this, method, sync, false, args);
     };
 }
 
+function _makeProxyAsyncMethod(method) {
+    // Errors in the arguments reject the returned promise, rather than throwing
+    return async function (...args) {
+        return _proxyInvoker.call(this, method, false, true, args);
+    };
+}
+
+// Returns an array of the unpacked children of the tuple @parameters, which
+// only unpacks each child when it is first read. Indexing, destructuring and
+// iterating the array unpack one child at a time; anything else that inspects
+// or modifies the array unpacks all of them first.
+function _lazyUnpackedArgs(parameters) {
+    const nArgs = parameters.n_children();
+    const args = new Array(nArgs);
+    const unpacked = new Array(nArgs).fill(false);
+
+    function unpack(ix) {
+        if (unpacked[ix])
+            return;
+        args[ix] = parameters.get_child_value(ix).deepUnpack();
+        unpacked[ix] = true;
+    }
+
+    function unpackAll() {
+        for (let ix = 0; ix < nArgs; ix++)
+            unpack(ix);
+    }
+
+    return new Proxy(args, {
+        get(target, key, receiver) {
+            if (typeof key === 'string') {
+                const ix = Number(key);
+                if (Number.isInteger(ix) && ix >= 0 && ix < nArgs && String(ix) === key)
+                    unpack(ix);
+            }
+            return Reflect.get(target, key, receiver);
+        },
+        has(target, key) {
+            unpackAll();
+            return Reflect.has(target, key);
+        },
+        ownKeys(target) {
+            unpackAll();
+            return Reflect.ownKeys(target);
+        },
+        getOwnPropertyDescriptor(target, key) {
+            unpackAll();
+            return Reflect.getOwnPropertyDescriptor(target, key);
+        },
+        set(target, key, value, receiver) {
+            unpackAll();
+            return Reflect.set(target, key, value, receiver);
+        },
+        defineProperty(target, key, descriptor) {
+            unpackAll();
+            return Reflect.defineProperty(target, key, descriptor);
+        },
+        deleteProperty(target, key) {
+            unpackAll();
+            return Reflect.deleteProperty(target, key);
+        },
+    });
+}
+
 function _convertToNativeSignal(proxy, senderName, signalName, parameters) {
-    Signals._emit.call(proxy, signalName, senderName, parameters.deepUnpack());
+    // Most signals of chatty interfaces have no handlers, don't unpack those
+    if (!proxy._signalConnectionsByName?.[signalName])
+        return;
+    Signals._emit.call(proxy, signalName, senderName,
+        _lazyUnpackedArgs(parameters));
+}
+
+function _connectSignal(name, callback) {
+    // Only start converting g-signal emissions once there is a handler
+    if (this._signalConversionId === undefined &&
+        this.g_interface_info?.signals.length > 0)
+        this._signalConversionId = this.connect('g-signal', _convertToNativeSignal);
+    return Signals._connect.call(this, name, callback);
 }
 
 function _propertyGetter(name) {
@@ -179,28 +172,12 @@ function _addDBusConvenience() {
     if (!info)
         return;
 
-    if (info.signals.length > 0)
-        this.connect('g-signal', _convertToNativeSignal);
-
     let i, methods = info.methods;
     for (i = 0; i < methods.length; i++) {
         var method = methods[i];
-        let remoteMethod = _makeProxyMethod(methods[i], false);
-        this[`${method.name}Remote`] = remoteMethod;
+        this[`${method.name}Remote`] = _makeProxyMethod(methods[i], false);
         this[`${method.name}Sync`] = _makeProxyMethod(methods[i], true);
-        this[`${method.name}Async`] = function (...args) {
-            return new Promise((resolve, reject) => {
-                args.push((result, error, fdList) => {
-                    if (error)
-                        reject(error);
-                    else if (fdList)
-                        resolve([result, fdList]);
-                    else
-                        resolve(result);
-                });
-                remoteMethod.call(this, ...args);
-            });
-        };
+        this[`${method.name}Async`] = _makeProxyAsyncMethod(methods[i]);
     }
 
     let properties = info.properties;
@@ -312,74 +289,6 @@ function _wrapFunction(klass, method, addition) {
     };
 }
 
-function _makeOutSignature(args) {
-    var ret = '(';
-    for (var i = 0; i < args.length; i++)
-        ret += args[i].signature;
-
-    return `${ret})`;
-}
-
-function _handleMethodCall(info, impl, methodName, parameters, invocation) {
-    // prefer a sync version if available
-    if (this[methodName]) {
-        let retval;
-        try {
-            const fdList = invocation.get_message().get_unix_fd_list();
-            retval = this[methodName](...parameters.deepUnpack(), fdList);
-        } catch (e) {
-            if (e instanceof GLib.Error) {
-                invocation.return_gerror(e);
-            } else {
-                let name = e.name;
-                if (!name.includes('.')) {
-                    // likely to be a normal JS error
-                    name = `org.gnome.gjs.JSError.${name}`;
-                }
-                logError(e, `Exception in method call: ${methodName}`);
-                invocation.return_dbus_error(name, e.message);
-            }
-            return;
-        }
-        if (retval === undefined) {
-            // undefined (no return value) is the empty tuple
-            retval = new GLib.Variant('()', []);
-        }
-        try {
-            let outFdList = null;
-            if (!(retval instanceof GLib.Variant)) {
-                // attempt packing according to out signature
-                let methodInfo = info.lookup_method(methodName);
-                let outArgs = methodInfo.out_args;
-                let outSignature = _makeOutSignature(outArgs);
-                if (outSignature.includes('h') &&
-                    retval[retval.length - 1] instanceof Gio.UnixFDList) {
-                    outFdList = retval.pop();
-                } else if (outArgs.length === 1) {
-                    // if one arg, we don't require the handler wrapping it
-                    // into an Array
-                    retval = [retval];
-                }
-                retval = new GLib.Variant(outSignature, retval);
-            }
-            invocation.return_value_with_unix_fd_list(retval, outFdList);
-        } catch (e) {
-            // if we don't do this, the other side will never see a reply
-            invocation.return_dbus_error('org.gnome.gjs.JSError.ValueError',
-                'Service implementation returned an incorrect value type');
-        }
-    } else if (this[`${methodName}Async`]) {
-        const fdList = invocation.get_message().get_unix_fd_list();
-        this[`${methodName}Async`](parameters.deepUnpack(), invocation, fdList);
-    } else {
-        log(`Missing handler for DBus method ${methodName}`);
-        invocation.return_gerror(new Gio.DBusError({
-            code: Gio.DBusError.UNKNOWN_METHOD,
-            message: `Method ${methodName} is not implemented`,
-        }));
-    }
-}
-
 function _handlePropertyGet(info, impl, propertyName) {
     let propInfo = info.lookup_property(propertyName);
     let jsval = this[propertyName];
@@ -404,9 +313,9 @@ function _wrapJSObject(interfaceInfo, jsObj) {
     info.cache_build();
 
     var impl = new GjsPrivate.DBusImplementation({g_interface_info: info});
-    impl.connect('handle-method-call', function (self, methodName, parameters, invocation) {
-        return _handleMethodCall.call(jsObj, info, self, methodName, parameters, invocation);
-    });
+    // Method calls are dispatched natively to jsObj[methodName], or else to
+    // jsObj[`${methodName}Async`]
+    DBusNative.setMethodDispatch(impl, jsObj);
     impl.connect('handle-property-get', function (self, propertyName) {
         return _handlePropertyGet.call(jsObj, info, self, propertyName);
     });
@@ -442,6 +351,12 @@ function _promisify(proto, asyncFunc, finishFunc = undefined) {
     if (proto[originalFuncName] !== undefined)
         return;
     proto[originalFuncName] = proto[asyncFunc];
+
+    // Introspected async functions return a promise by themselves when they
+    // are called without a callback, once they know their finish function
+    if (Gi.setFinishFunction(proto[asyncFunc], proto[finishFunc]))
+        return;
+
     proto[asyncFunc] = function (...args) {
         if (args.length === this[originalFuncName].length)
             return this[originalFuncName](...args);
@@ -532,7 +447,7 @@ function _init() {
     _injectToStaticMethod(Gio.DBusProxy, 'new_finish', _addDBusConvenience);
     _injectToStaticMethod(Gio.DBusProxy, 'new_for_bus_sync', _addDBusConvenience);
     _injectToStaticMethod(Gio.DBusProxy, 'new_for_bus_finish', _addDBusConvenience);
-    Gio.DBusProxy.prototype.connectSignal = Signals._connect;
+    Gio.DBusProxy.prototype.connectSignal = _connectSignal;
     Gio.DBusProxy.prototype.disconnectSignal = Signals._disconnect;
 
     Gio.DBusProxy.makeProxyWrapper = _makeProxyWrapper;
@@ -14,23 +14,7 @@ function validateDelay(delay) {
     return Math.max(0, +delay | 0);
 }
 
-/** @type {Map<GLib.Source, number>} */
-const timeouts = new Map();
-
-/**
- * @param {GLib.Source} source the source to add to our map
- */
-function addSource(source) {
-    const id = source.attach(null);
-    timeouts.set(source, id);
-}
-
-/**
- * @param {GLib.Source} source the source object to remove from our map
- */
-function releaseSource(source) {
-    timeouts.delete(source);
-}
+const TimersNative = import.meta.importSync('_timersNative');
 
 /**
  * @param {unknown} thisArg 'this' argument
@@ -42,16 +26,19 @@ function checkThis(thisArg) {
 }
 
 /**
- * @param {number} timeout a timeout in milliseconds
- * @param {(...args) => any} handler a callback
- * @returns {GLib.Source}
+ * @param {(...args) => any} callback a callback function
+ * @param {number} delay the delay in milliseconds
+ * @param {boolean} repeat whether to keep calling callback every delay ms
+ * @param {any[]} args arguments to pass to callback
+ * @returns {number}
  */
-function createTimeoutSource(timeout, handler) {
-    const source = imports.gi.GLib.timeout_source_new(timeout);
-    source.set_priority(imports.gi.GLib.PRIORITY_DEFAULT);
-    imports.gi.GObject.source_set_closure(source, handler);
+function addTimer(callback, delay, repeat, args) {
+    delay = validateDelay(delay);
+    if (typeof callback !== 'function')
+        throw new TypeError('The callback must be a function');
 
-    return source;
+    return TimersNative.add(callback, delay, repeat,
+        args.length > 0 ? args : null);
 }
 
 /**
@@ -59,25 +46,12 @@ function createTimeoutSource(timeout, handler) {
  * @param {(...args) => any} callback a callback function
  * @param {number} delay the duration in milliseconds to wait before running callback
  * @param {...any} args arguments to pass to callback
+ * @returns {number}
  */
 function setTimeout(callback, delay = 0, ...args) {
     checkThis(this);
 
-    delay = validateDelay(delay);
-    const boundCallback = callback.bind(globalThis, ...args);
-    const source = createTimeoutSource(delay, () => {
-        if (!timeouts.has(source))
-            return imports.gi.GLib.SOURCE_REMOVE;
-
-        boundCallback();
-        releaseSource(source);
-        import.meta.importSync('_promiseNative').drainMicrotaskQueue();
-
-        return imports.gi.GLib.SOURCE_REMOVE;
-    });
-
-    addSource(source);
-    return source;
+    return addTimer(callback, delay, false, args);
 }
 
 /**
@@ -85,48 +59,31 @@ function setTimeout(callback, delay = 0, ...args) {
  * @param {(...args) => any} callback a callback function
  * @param {number} delay the duration in milliseconds to wait between calling callback
  * @param {...any} args arguments to pass to callback
+ * @returns {number}
  */
 function setInterval(callback, delay = 0, ...args) {
     checkThis(this);
 
-    delay = validateDelay(delay);
-    const boundCallback = callback.bind(globalThis, ...args);
-    const source = createTimeoutSource(delay, () => {
-        if (!timeouts.has(source))
-            return imports.gi.GLib.SOURCE_REMOVE;
-
-        boundCallback();
-        import.meta.importSync('_promiseNative').drainMicrotaskQueue();
-
-        return imports.gi.GLib.SOURCE_CONTINUE;
-    });
-
-    addSource(source);
-    return source;
+    return addTimer(callback, delay, true, args);
 }
 
 /**
- * @param {GLib.Source} source the timeout to clear
+ * @param {number} id the timer to clear
  */
-function _clearTimer(source) {
-    if (!timeouts.has(source))
-        return;
-
-    if (source) {
-        source.destroy();
-        releaseSource(source);
-    }
+function _clearTimer(id) {
+    if (typeof id === 'number')
+        TimersNative.remove(id);
 }
 
 /**
- * @param {GLib.Source} timeout the timeout to clear
+ * @param {number} timeout the timeout to clear
  */
 function clearTimeout(timeout = null) {
     _clearTimer(timeout);
 }
 
 /**
- * @param {Glib.Source} timeout the timeout to clear
+ * @param {number} timeout the timeout to clear
  */
 function clearInterval(timeout = null) {
     _clearTimer(timeout);
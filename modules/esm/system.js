@@ -9,14 +9,18 @@ export let {
     breakpoint,
     clearDateCaches,
     dumpHeap,
+    dumpHeapSnapshot,
     dumpMemoryInfo,
     exit,
     gc,
+    getCounters,
+    memoryReport,
     programArgs,
     programInvocationName,
     programPath,
     refcount,
     version,
+    wrapperStats,
 } = system;
 
 export default {
@@ -25,12 +29,16 @@ export default {
     breakpoint,
     clearDateCaches,
     dumpHeap,
+    dumpHeapSnapshot,
     dumpMemoryInfo,
     exit,
     gc,
+    getCounters,
+    memoryReport,
     programArgs,
     programInvocationName,
     programPath,
     refcount,
     version,
+    wrapperStats,
 };
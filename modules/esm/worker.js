@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+const WorkerNative = import.meta.importSync('_workerNative');
+
+/**
+ * @param {unknown} transfer the transfer list passed to postMessage()
+ * @returns {ArrayBuffer[] | undefined}
+ */
+function validateTransfer(transfer) {
+    if (transfer === undefined || transfer === null)
+        return undefined;
+    if (!Array.isArray(transfer))
+        throw new TypeError('The transfer list must be an array');
+    return transfer;
+}
+
+/**
+ * @param {Function | null} handler an event handler, or null
+ * @param {object} event the event to pass to the handler
+ */
+function callHandler(handler, event) {
+    if (typeof handler === 'function')
+        handler(event);
+}
+
+/**
+ * A module running in a GjsContext of its own, on a separate thread.
+ *
+ * Messages are copied with the structured clone algorithm. ArrayBuffers listed
+ * in the transfer list are moved to the worker instead of being copied, and
+ * become detached in the sender.
+ */
+export class Worker {
+    #native;
+
+    /**
+     * @param {string} url the URI of the ES module to run, or a path relative
+     *   to the current directory
+     */
+    constructor(url) {
+        /** @type {((event: {data: unknown}) => void) | null} */
+        this.onmessage = null;
+        /** @type {((error: Error) => void) | null} */
+        this.onerror = null;
+
+        this.#native = WorkerNative.create(`${url}`, (type, value) => {
+            if (type === 'message')
+                callHandler(this.onmessage, {data: value});
+            else
+                callHandler(this.onerror, new Error(value));
+        });
+    }
+
+    /**
+     * @param {unknown} message the value to send to the worker
+     * @param {ArrayBuffer[]} [transfer] ArrayBuffers to move instead of copy
+     */
+    postMessage(message, transfer) {
+        WorkerNative.postMessage(this.#native, message,
+            validateTransfer(transfer));
+    }
+
+    /**
+     * Asks the worker to stop listening for messages and exit. Code that is
+     * already running in the worker is not interrupted.
+     */
+    terminate() {
+        WorkerNative.terminate(this.#native);
+    }
+}
+
+class ParentPort {
+    #onmessage = null;
+
+    get onmessage() {
+        return this.#onmessage;
+    }
+
+    // While a handler is set, the worker keeps running to wait for messages
+    set onmessage(handler) {
+        if (handler !== null && typeof handler !== 'function')
+            throw new TypeError('The message handler must be a function');
+        this.#onmessage = handler;
+        WorkerNative.setMessageHandler(handler
+            ? (type, value) => handler({data: value})
+            : null);
+    }
+
+    /**
+     * @param {unknown} message the value to send to the parent
+     * @param {ArrayBuffer[]} [transfer] ArrayBuffers to move instead of copy
+     */
+    postMessage(message, transfer) {
+        WorkerNative.postMessageToParent(message, validateTransfer(transfer));
+    }
+
+    /**
+     * Stops receiving messages, so that the worker exits once it has nothing
+     * else to do.
+     */
+    close() {
+        this.#onmessage = null;
+        WorkerNative.close();
+    }
+}
+
+/**
+ * In a worker, the port to communicate with the context that started it.
+ * Null in any other context.
+ */
+export const parentPort = WorkerNative.isWorkerThread()
+    ? Object.freeze(new ParentPort()) : null;
+
+export default {
+    Worker,
+    parentPort,
+};
@@ -8,7 +8,6 @@ timeout_add_seconds, timeout_seconds_source, timeout_source */
 // A layer of convenience and backwards-compatibility over GLib MainLoop facilities
 
 const GLib = imports.gi.GLib;
-const GObject = imports.gi.GObject;
 
 var _mainLoops = {};
 
@@ -35,7 +34,7 @@ function quit(name) {
 // eslint-disable-next-line camelcase
 function idle_source(handler, priority) {
     let s = GLib.idle_source_new();
-    GObject.source_set_closure(s, handler);
+    s.set_callback(handler);
     if (priority !== undefined)
         s.set_priority(priority);
     return s;
@@ -49,7 +48,7 @@ function idle_add(handler, priority) {
 // eslint-disable-next-line camelcase
 function timeout_source(timeout, handler, priority) {
     let s = GLib.timeout_source_new(timeout);
-    GObject.source_set_closure(s, handler);
+    s.set_callback(handler);
     if (priority !== undefined)
         s.set_priority(priority);
     return s;
@@ -58,7 +57,7 @@ function timeout_source(timeout, handler, priority) {
 // eslint-disable-next-line camelcase
 function timeout_seconds_source(timeout, handler, priority) {
     let s = GLib.timeout_source_new_seconds(timeout);
-    GObject.source_set_closure(s, handler);
+    s.set_callback(handler);
     if (priority !== undefined)
         s.set_priority(priority);
     return s;
@@ -29,12 +29,16 @@
 #include <jsfriendapi.h>  // for GetFunctionNativeReserved, NewFunctionByIdW...
 
 #include "gi/object.h"
+#include "gi/wrapper-stats.h"
 #include "gjs/atoms.h"
 #include "gjs/auto.h"
 #include "gjs/context-private.h"
+#include "gjs/heap-snapshot.h"
 #include "gjs/jsapi-util-args.h"
 #include "gjs/jsapi-util.h"
 #include "gjs/macros.h"
+#include "gjs/mem-private.h"
+#include "gjs/memory-report.h"
 #include "gjs/profiler-private.h"
 #include "modules/system.h"
 #include "util/log.h"
@@ -147,6 +151,38 @@ gjs_dump_heap(JSContext *cx,
     return true;
 }
 
+// Like dumpHeap(), but in the .heapsnapshot format, which is much smaller, and
+// can be loaded in the Chrome DevTools or compared with
+// tools/heapsnapshot-diff.py
+GJS_JSAPI_RETURN_CONVENTION
+static bool gjs_dump_heap_snapshot(JSContext* cx, unsigned argc,
+                                   JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+    Gjs::AutoChar filename;
+
+    if (!gjs_parse_call_args(cx, "dumpHeapSnapshot", args, "F", "filename",
+                             &filename))
+        return false;
+
+    LogFile file(filename);
+    if (file.has_error()) {
+        gjs_throw(cx, "Cannot dump heap snapshot to %s: %s", filename.get(),
+                  file.errmsg());
+        return false;
+    }
+    if (!Gjs::write_heap_snapshot(cx, file.fp())) {
+        if (!JS_IsExceptionPending(cx))
+            gjs_throw(cx, "Cannot write heap snapshot to %s", filename.get());
+        return false;
+    }
+
+    gjs_debug(GJS_DEBUG_CONTEXT, "Heap snapshot written to %s",
+              filename.get());
+
+    args.rval().setUndefined();
+    return true;
+}
+
 static bool
 gjs_gc(JSContext *context,
        unsigned   argc,
@@ -275,16 +311,68 @@ static bool gjs_dump_memory_info(JSContext* cx, unsigned argc, JS::Value* vp) {
     return true;
 }
 
+// Returns the current values of the counters that the profiler exports, as an
+// object keyed by counter name. These are process-wide, shared by all contexts.
+GJS_JSAPI_RETURN_CONVENTION
+static bool gjs_get_counters(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    JS::RootedObject counters{cx, JS_NewPlainObject(cx)};
+    if (!counters)
+        return false;
+
+#define DEFINE_COUNTER_PROPERTY(name, ix)                                    \
+    if (!JS_DefineProperty(cx, counters, #name, double(GJS_GET_COUNTER(name)), \
+                           JSPROP_ENUMERATE))                                \
+        return false;
+    GJS_FOR_EACH_COUNTER(DEFINE_COUNTER_PROPERTY)
+    GJS_FOR_EACH_STAT_COUNTER(DEFINE_COUNTER_PROPERTY)
+#undef DEFINE_COUNTER_PROPERTY
+
+    args.rval().setObject(*counters);
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool gjs_memory_report_func(JSContext* cx, unsigned argc,
+                                   JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    JSObject* report = Gjs::MemoryReport::collect(cx);
+    if (!report)
+        return false;
+
+    args.rval().setObject(*report);
+    return true;
+}
+
+GJS_JSAPI_RETURN_CONVENTION
+static bool gjs_wrapper_stats(JSContext* cx, unsigned argc, JS::Value* vp) {
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    JSObject* stats = Gjs::WrapperStats::to_js(cx);
+    if (!stats)
+        return false;
+
+    args.rval().setObject(*stats);
+    return true;
+}
+
 static JSFunctionSpec module_funcs[] = {
     JS_FN("addressOf", gjs_address_of, 1, GJS_MODULE_PROP_FLAGS),
     JS_FN("addressOfGObject", gjs_address_of_gobject, 1, GJS_MODULE_PROP_FLAGS),
     JS_FN("refcount", gjs_refcount, 1, GJS_MODULE_PROP_FLAGS),
     JS_FN("breakpoint", gjs_breakpoint, 0, GJS_MODULE_PROP_FLAGS),
     JS_FN("dumpHeap", gjs_dump_heap, 1, GJS_MODULE_PROP_FLAGS),
+    JS_FN("dumpHeapSnapshot", gjs_dump_heap_snapshot, 1,
+          GJS_MODULE_PROP_FLAGS),
     JS_FN("dumpMemoryInfo", gjs_dump_memory_info, 0, GJS_MODULE_PROP_FLAGS),
     JS_FN("gc", gjs_gc, 0, GJS_MODULE_PROP_FLAGS),
     JS_FN("exit", gjs_exit, 0, GJS_MODULE_PROP_FLAGS),
     JS_FN("clearDateCaches", gjs_clear_date_caches, 0, GJS_MODULE_PROP_FLAGS),
+    JS_FN("getCounters", gjs_get_counters, 0, GJS_MODULE_PROP_FLAGS),
+    JS_FN("wrapperStats", gjs_wrapper_stats, 0, GJS_MODULE_PROP_FLAGS),
+    JS_FN("memoryReport", gjs_memory_report_func, 0, GJS_MODULE_PROP_FLAGS),
     JS_FS_END};
 
 static bool get_program_args(JSContext* cx, unsigned argc, JS::Value* vp) {
@@ -7,10 +7,13 @@
 #include <stdint.h>
 #include <string.h>  // for size_t, strlen
 
+#include <algorithm>  // for find
 #include <limits>
 #include <random>
 #include <string>  // for u16string, u32string
 #include <type_traits>
+#include <unordered_set>
+#include <vector>
 
 #include <girepository.h>
 #include <glib-object.h>
@@ -311,6 +314,24 @@ static void gjstest_test_func_gjs_context_eval_module_file_exit() {
     g_assert_cmpuint(exit_status, ==, 42);
 }
 
+// Disposing the context must stop workers that never look at their messages
+static void gjstest_test_func_gjs_context_dispose_stops_workers() {
+    GjsContext* gjs = gjs_context_new();
+    AutoError error;
+    uint8_t exit_status;
+
+    bool ok = gjs_context_eval_module_file(
+        gjs, "resource:///org/gnome/gjs/mock/test/modules/startWorkers.js",
+        &exit_status, &error);
+
+    g_assert_false(ok);
+    g_assert_error(error, GJS_ERROR, GJS_ERROR_SYSTEM_EXIT);
+    g_assert_cmpuint(exit_status, ==, 0);
+
+    // Hangs if the workers aren't interrupted
+    g_object_unref(gjs);
+}
+
 static void gjstest_test_func_gjs_context_eval_module_file_fail_instantiate() {
     AutoUnref<GjsContext> gjs{gjs_context_new()};
     AutoError error;
@@ -851,6 +872,21 @@ static void test_gjs_debug_string_quotes(GjsUnitTestFixture* fx, const void*) {
     g_assert_cmpstr(debug_output.c_str(), ==, "\"a string\"");
 }
 
+static void gjstest_test_func_gjs_json_quote() {
+    using namespace std::string_literals;
+
+    g_assert_cmpstr(gjs_json_quote("").c_str(), ==, "\"\"");
+    g_assert_cmpstr(gjs_json_quote("a \"quoted\" \\ path\n").c_str(), ==,
+                    "\"a \\\"quoted\\\" \\\\ path\\n\"");
+    g_assert_cmpstr(gjs_json_quote("tab\there").c_str(), ==,
+                    "\"tab\\u0009here\"");
+    // Embedded NULs are escaped too, instead of ending the string
+    g_assert_cmpstr(gjs_json_quote("a\0b"s).c_str(), ==, "\"a\\u0000b\"");
+    // UTF-8 is left alone
+    g_assert_cmpstr(gjs_json_quote("caf\xc3\xa9").c_str(), ==,
+                    "\"caf\xc3\xa9\"");
+}
+
 static void test_gjs_debug_value_bigint(GjsUnitTestFixture* fx, const void*) {
     JS::BigInt* bi = JS::NumberToBigInt(fx->cx, 42);
     std::string debug_output = gjs_debug_bigint(bi);
@@ -967,6 +1003,194 @@ gjstest_test_profiler_start_stop(void)
         g_message("Temp profiler file not deleted");
 }
 
+static void gjstest_test_profiler_dump_ring() {
+    AutoUnref<GjsContext> context{GJS_CONTEXT(
+        g_object_new(GJS_TYPE_CONTEXT, "profiler-enabled", TRUE, nullptr))};
+    GjsProfiler* profiler = gjs_context_get_profiler(context);
+
+    g_assert_false(gjs_profiler_dump_ring(profiler));
+
+    gjs_profiler_set_filename(profiler, "dont-conflict-with-ring-test.syscap");
+    gjs_profiler_set_ring_duration(profiler, 1);
+    gjs_profiler_start(profiler);
+
+    AutoError error;
+    int estatus;
+    if (!gjs_context_eval(context, "[1,5,7,1,2,3,67,8].sort()", -1, "<input>",
+                          &estatus, &error))
+        g_printerr("ERROR: %s", error->message);
+
+    // Only written if the profiler is enabled in this build
+    if (gjs_profiler_dump_ring(profiler)) {
+        g_assert_true(
+            g_file_test("dont-conflict-with-ring-test-1.syscap",
+                        G_FILE_TEST_EXISTS));
+        if (g_unlink("dont-conflict-with-ring-test-1.syscap") != 0)
+            g_message("Temp profiler file not deleted");
+    }
+
+    gjs_profiler_stop(profiler);
+    g_assert_false(gjs_profiler_dump_ring(profiler));
+}
+
+// Runs JS code for long enough to be sampled, with a garbage collection for
+// the profiler to add a mark for
+#define PROFILED_JS                                           \
+    "const end = Date.now() + 100;"                           \
+    "function spin() { while (Date.now() < end) {} }"         \
+    "spin(); imports.system.gc();"
+
+static void profile_to_file(const char* filename) {
+    AutoUnref<GjsContext> context{GJS_CONTEXT(
+        g_object_new(GJS_TYPE_CONTEXT, "profiler-enabled", TRUE, nullptr))};
+    GjsProfiler* profiler = gjs_context_get_profiler(context);
+
+    gjs_profiler_set_filename(profiler, filename);
+    gjs_profiler_start(profiler);
+
+    AutoError error;
+    int estatus;
+    if (!gjs_context_eval(context, PROFILED_JS, -1, "<input>", &estatus,
+                          &error))
+        g_printerr("ERROR: %s", error->message);
+
+    gjs_profiler_stop(profiler);
+}
+
+#undef PROFILED_JS
+
+static void gjstest_test_profiler_export_chrome_trace() {
+    profile_to_file("dont-conflict-with-other-test.json");
+
+    // Only written if the profiler is enabled in this build
+    if (!g_file_test("dont-conflict-with-other-test.json",
+                     G_FILE_TEST_EXISTS))
+        return;
+
+    AutoUnref<GjsContext> checker{gjs_context_new()};
+    AutoError error;
+    int estatus;
+    bool ok = gjs_context_eval(checker, R"js(
+        const {GLib} = imports.gi;
+        const [, bytes] =
+            GLib.file_get_contents('dont-conflict-with-other-test.json');
+        const events = JSON.parse(new TextDecoder().decode(bytes));
+
+        const stack = [];
+        for (const {ph, name} of events) {
+            if (ph === 'B')
+                stack.push(name);
+            else if (ph === 'E' && stack.pop() !== name)
+                throw new Error(`E event for ${name} does not match a B event`);
+        }
+        if (stack.length > 0)
+            throw new Error(`No E events for ${stack}`);
+
+        if (!events.some(({ph}) => ph === 'B'))
+            throw new Error('No samples');
+        if (!events.some(({ph}) => ph === 'C'))
+            throw new Error('No counters');
+        if (!events.some(({ph, name}) => (ph === 'X' || ph === 'i') &&
+            name === 'Garbage collection'))
+            throw new Error('No garbage collection mark');
+    )js",
+                               -1, "<check>", &estatus, &error);
+    g_assert_no_error(error);
+    g_assert_true(ok);
+
+    if (g_unlink("dont-conflict-with-other-test.json") != 0)
+        g_message("Temp profiler file not deleted");
+}
+
+[[nodiscard]] static uint64_t read_varint(const uint8_t** pos,
+                                          const uint8_t* end) {
+    uint64_t value = 0;
+    for (unsigned shift = 0; *pos < end && shift < 64; shift += 7) {
+        uint8_t byte = *(*pos)++;
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+    g_error("Truncated or overlong varint");
+}
+
+// Calls @func with the number, wire type, and contents of each field of the
+// protocol buffer message from @pos to @end. The contents of a varint field
+// are its value, those of a length-delimited field are its bytes.
+template <typename F>
+static void read_fields(const uint8_t* pos, const uint8_t* end, F func) {
+    while (pos < end) {
+        uint64_t key = read_varint(&pos, end);
+        unsigned field = key >> 3;
+        unsigned wire_type = key & 7;
+        if (wire_type == 0) {
+            uint64_t value = read_varint(&pos, end);
+            func(field, wire_type, value, nullptr, nullptr);
+        } else {
+            g_assert_cmpuint(wire_type, ==, 2);
+            uint64_t size = read_varint(&pos, end);
+            g_assert_cmpuint(size, <=, uint64_t(end - pos));
+            func(field, wire_type, 0, pos, pos + size);
+            pos += size;
+        }
+    }
+}
+
+static void gjstest_test_profiler_export_pprof() {
+    profile_to_file("dont-conflict-with-other-test.pprof");
+
+    // Only written if the profiler is enabled in this build
+    Gjs::AutoChar contents;
+    size_t length;
+    if (!g_file_get_contents("dont-conflict-with-other-test.pprof",
+                             contents.out(), &length, nullptr))
+        return;
+
+    // Field numbers from profile.proto
+    constexpr unsigned SAMPLE = 2, LOCATION = 4, STRING_TABLE = 6;
+
+    std::vector<std::string> strings;
+    std::unordered_set<uint64_t> location_ids;
+    std::vector<uint64_t> sample_location_ids;
+
+    auto read_location = [&](unsigned field, unsigned, uint64_t value,
+                             const uint8_t*, const uint8_t*) {
+        if (field == 1)  // id
+            location_ids.insert(value);
+    };
+    auto read_sample = [&](unsigned field, unsigned, uint64_t,
+                           const uint8_t* pos, const uint8_t* end) {
+        if (field != 1)  // packed location_id
+            return;
+        while (pos < end)
+            sample_location_ids.push_back(read_varint(&pos, end));
+    };
+    auto read_profile = [&](unsigned field, unsigned, uint64_t,
+                            const uint8_t* pos, const uint8_t* end) {
+        if (field == STRING_TABLE)
+            strings.emplace_back(reinterpret_cast<const char*>(pos), end - pos);
+        else if (field == LOCATION)
+            read_fields(pos, end, read_location);
+        else if (field == SAMPLE)
+            read_fields(pos, end, read_sample);
+    };
+
+    auto* start = reinterpret_cast<const uint8_t*>(contents.get());
+    read_fields(start, start + length, read_profile);
+
+    g_assert_cmpuint(strings.size(), >, 0);
+    g_assert_cmpstr(strings[0].c_str(), ==, "");
+    g_assert_true(std::find(strings.begin(), strings.end(), "samples") !=
+                  strings.end());
+
+    g_assert_cmpuint(sample_location_ids.size(), >, 0);
+    for (uint64_t id : sample_location_ids)
+        g_assert_true(location_ids.count(id));
+
+    if (g_unlink("dont-conflict-with-other-test.pprof") != 0)
+        g_message("Temp profiler file not deleted");
+}
+
 static void gjstest_test_safe_integer_max(GjsUnitTestFixture* fx, const void*) {
     JS::RootedObject number_class_object(fx->cx);
     JS::RootedValue safe_value(fx->cx);
@@ -1287,6 +1511,8 @@ main(int    argc,
                     gjstest_test_func_gjs_context_eval_module_file_throw);
     g_test_add_func("/gjs/context/eval-module-file/exit",
                     gjstest_test_func_gjs_context_eval_module_file_exit);
+    g_test_add_func("/gjs/context/dispose/stops-workers",
+                    gjstest_test_func_gjs_context_dispose_stops_workers);
     g_test_add_func(
         "/gjs/context/eval-module-file/fail-instantiate",
         gjstest_test_func_gjs_context_eval_module_file_fail_instantiate);
@@ -1311,6 +1537,14 @@ main(int    argc,
     g_test_add_func("/gjs/gobject/without_introspection",
                     gjstest_test_func_gjs_gobject_without_introspection);
     g_test_add_func("/gjs/profiler/start_stop", gjstest_test_profiler_start_stop);
+    g_test_add_func("/gjs/profiler/dump_ring",
+                    gjstest_test_profiler_dump_ring);
+    g_test_add_func("/gjs/profiler/export/chrome_trace",
+                    gjstest_test_profiler_export_chrome_trace);
+    g_test_add_func("/gjs/profiler/export/pprof",
+                    gjstest_test_profiler_export_pprof);
+    g_test_add_func("/gjs/jsapi-util/json-quote",
+                    gjstest_test_func_gjs_json_quote);
     g_test_add_func("/util/misc/strv/concat/null",
                     gjstest_test_func_util_misc_strv_concat_null);
     g_test_add_func("/util/misc/strv/concat/pointers",
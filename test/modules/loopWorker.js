@@ -0,0 +1,7 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+import GLib from 'gi://GLib';
+
+// Never returns from a GLib main loop of its own
+new GLib.MainLoop(null, false).run();
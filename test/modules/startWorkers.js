@@ -0,0 +1,9 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+import System from 'system';
+import {Worker} from 'worker';
+
+new Worker('resource:///org/gnome/gjs/mock/test/modules/busyWorker.js');
+new Worker('resource:///org/gnome/gjs/mock/test/modules/loopWorker.js');
+System.exit(0);
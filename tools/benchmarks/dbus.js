@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+// Benchmark for method calls on an exported D-Bus object, through a proxy on
+// a second connection so that every call goes through the bus daemon.
+// Run with: dbus-run-session --config-file=test/test-bus.conf -- \
+//     gjs -m tools/benchmarks/dbus.js [number of calls]
+
+import Gio from 'gi://Gio';
+import GLib from 'gi://GLib';
+import System from 'system';
+
+const N_CALLS = Number(System.programArgs[0] ?? 100000);
+const N_CALLS_IN_FLIGHT = 100;
+const OBJECT_PATH = '/org/gnome/gjs/Benchmark';
+const INTERFACE = `<node>
+  <interface name="org.gnome.gjs.Benchmark">
+    <method name="Add">
+      <arg type="i" direction="in"/>
+      <arg type="i" direction="in"/>
+      <arg type="i" direction="out"/>
+    </method>
+  </interface>
+</node>`;
+
+/**
+ * @param {number} start a time from GLib.get_monotonic_time()
+ * @returns {number} the elapsed time in seconds
+ */
+function secondsSince(start) {
+    return (GLib.get_monotonic_time() - start) / GLib.USEC_PER_SEC;
+}
+
+const service = Gio.DBusExportedObject.wrapJSObject(INTERFACE, {
+    Add(a, b) {
+        return a + b;
+    },
+});
+service.export(Gio.DBus.session, OBJECT_PATH);
+
+const address = Gio.dbus_address_get_for_bus_sync(Gio.BusType.SESSION, null);
+const connection = Gio.DBusConnection.new_for_address_sync(address,
+    Gio.DBusConnectionFlags.AUTHENTICATION_CLIENT |
+    Gio.DBusConnectionFlags.MESSAGE_BUS_CONNECTION, null, null);
+const BenchmarkProxy = Gio.DBusProxy.makeProxyWrapper(INTERFACE);
+const proxy = new BenchmarkProxy(connection,
+    Gio.DBus.session.get_unique_name(), OBJECT_PATH);
+
+const loop = GLib.MainLoop.new(null, false);
+let started = 0;
+let finished = 0;
+
+/** Starts the next call, keeping N_CALLS_IN_FLIGHT calls pending. */
+function callNext() {
+    if (started === N_CALLS)
+        return;
+    const a = started++;
+    proxy.AddAsync(a, 1).then(([sum]) => {
+        if (sum !== a + 1)
+            throw new Error(`Add(${a}, 1) returned ${sum}`);
+        if (++finished === N_CALLS)
+            loop.quit();
+        else
+            callNext();
+    }).catch(e => {
+        logError(e);
+        loop.quit();
+    });
+}
+
+const start = GLib.get_monotonic_time();
+for (let i = 0; i < N_CALLS_IN_FLIGHT; i++)
+    callNext();
+loop.run();
+const elapsed = secondsSince(start);
+
+print(`${finished} calls in ${elapsed.toFixed(2)} s: ${
+    Math.round(finished / elapsed)} calls/s`);
+
+service.unexport();
+connection.close_sync(null);
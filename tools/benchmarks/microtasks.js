@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+// Benchmark for the throughput of the promise job (microtask) queue.
+// Run with: gjs -m tools/benchmarks/microtasks.js [number of jobs]
+
+import GLib from 'gi://GLib';
+import System from 'system';
+
+const N_JOBS = Number(System.programArgs[0] ?? 1000000);
+
+/**
+ * @param {string} name a description of the benchmark
+ * @param {() => Promise<void>} func the benchmark, resolving when done
+ */
+async function measure(name, func) {
+    System.gc();
+    const start = GLib.get_monotonic_time();
+    await func();
+    const elapsed = (GLib.get_monotonic_time() - start) / 1e6;
+    const rate = Math.round(N_JOBS / elapsed);
+    print(`${name}: ${elapsed.toFixed(3)} s, ${rate} jobs/s`);
+}
+
+// One long chain, where each job enqueues the next one while the queue is being
+// drained
+await measure('chained awaits', async () => {
+    for (let i = 0; i < N_JOBS; i++)
+        await null;
+});
+
+// Many jobs enqueued up front
+await measure('fan-out', () => {
+    const promises = [];
+    for (let i = 0; i < N_JOBS; i++)
+        promises.push(Promise.resolve(i).then(x => x + 1));
+    return Promise.all(promises);
+});
+
+// Interleaved with FinalizationRegistry cleanup tasks
+await measure('chained awaits with finalization', async () => {
+    let finalized = 0;
+    const registry = new FinalizationRegistry(() => finalized++);
+    for (let i = 0; i < N_JOBS; i++) {
+        registry.register({}, i);
+        if (i % 10000 === 0)
+            System.gc();
+        await null;
+    }
+    print(`  (${finalized} objects finalized)`);
+});
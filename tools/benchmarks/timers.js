@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+
+// Benchmark for setTimeout() and clearTimeout() with many concurrent timers.
+// Run with: gjs -m tools/benchmarks/timers.js [number of timers]
+
+import GLib from 'gi://GLib';
+import System from 'system';
+
+const N_TIMERS = Number(System.programArgs[0] ?? 100000);
+const MIN_DELAY_MS = 100;
+const MAX_DELAY_MS = 1100;
+const N_IDLE_ITERATIONS = 1000;
+
+/**
+ * @param {number} start a time from GLib.get_monotonic_time()
+ * @returns {string} the elapsed time in milliseconds
+ */
+function msSince(start) {
+    return ((GLib.get_monotonic_time() - start) / 1000).toFixed(1);
+}
+
+const loop = GLib.MainLoop.new(null, false);
+const context = loop.get_context();
+
+// Cost of scheduling
+let start = GLib.get_monotonic_time();
+const ids = [];
+let fired = 0;
+const onTimeout = () => {
+    fired++;
+};
+for (let i = 0; i < N_TIMERS; i++) {
+    const delay = MIN_DELAY_MS + Math.random() * (MAX_DELAY_MS - MIN_DELAY_MS);
+    ids.push(setTimeout(onTimeout, delay));
+}
+print(`schedule ${N_TIMERS} timers: ${msSince(start)} ms`);
+
+// Cost of an unrelated main loop iteration while the timers are pending
+start = GLib.get_monotonic_time();
+for (let i = 0; i < N_IDLE_ITERATIONS; i++) {
+    GLib.idle_add(GLib.PRIORITY_HIGH, () => GLib.SOURCE_REMOVE);
+    context.iteration(false);
+}
+print(`${N_IDLE_ITERATIONS} main loop iterations: ${msSince(start)} ms`);
+
+// Cost of cancelling
+start = GLib.get_monotonic_time();
+for (let i = 0; i < N_TIMERS; i += 2)
+    clearTimeout(ids[i]);
+print(`cancel ${Math.ceil(N_TIMERS / 2)} timers: ${msSince(start)} ms`);
+
+// Cost of dispatching, beyond the time spent waiting for the deadlines
+start = GLib.get_monotonic_time();
+const expected = Math.floor(N_TIMERS / 2);
+const check = setInterval(() => {
+    if (fired < expected)
+        return;
+    clearInterval(check);
+    loop.quit();
+}, 10);
+loop.run();
+const elapsed = msSince(start);
+print(`fire ${fired} timers: ${elapsed} ms (at least ${MAX_DELAY_MS} ms ` +
+    'of which are spent waiting)');
@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+
+# SPDX-License-Identifier: MIT OR LGPL-2.0-or-later
+# SPDX-FileCopyrightText: 2026 GNOME Foundation, Inc.
+#
+# heapsnapshot-diff.py - Compare two heap snapshots from
+# System.dumpHeapSnapshot(), to find out what grew between them
+
+import argparse
+from collections import defaultdict
+import json
+import sys
+
+parser = argparse.ArgumentParser(description='Compare two heap snapshots written by System.dumpHeapSnapshot() and show, for each type of object, how many more objects there are and how much more memory they retain.')
+
+parser.add_argument('old_file', metavar='OLD',
+                    help='Heap snapshot taken before the suspected leak')
+
+parser.add_argument('new_file', metavar='NEW',
+                    help='Heap snapshot taken after the suspected leak')
+
+parser.add_argument('--top', '-t', dest='top', type=int, default=30,
+                    help='Show at most TOP types (default: 30, 0 for all)')
+
+parser.add_argument('--min-delta', '-m', dest='min_delta', type=int,
+                    default=0,
+                    help='Hide types whose retained size changed by less than MIN_DELTA bytes')
+
+
+class Snapshot:
+    """The nodes of a .heapsnapshot file, with their dominators"""
+
+    def __init__(self, path):
+        with open(path, encoding='utf-8') as f:
+            data = json.load(f)
+
+        meta = data['snapshot']['meta']
+        node_fields = meta['node_fields']
+        edge_fields = meta['edge_fields']
+        n_node_fields = len(node_fields)
+        n_edge_fields = len(edge_fields)
+        node_type_names = meta['node_types'][0]
+        edge_type_names = meta['edge_types'][0]
+        weak_edge = edge_type_names.index('weak')
+
+        strings = data['strings']
+        nodes = data['nodes']
+        edges = data['edges']
+
+        TYPE = node_fields.index('type')
+        NAME = node_fields.index('name')
+        ID = node_fields.index('id')
+        SELF_SIZE = node_fields.index('self_size')
+        EDGE_COUNT = node_fields.index('edge_count')
+        EDGE_TYPE = edge_fields.index('type')
+        TO_NODE = edge_fields.index('to_node')
+
+        count = len(nodes) // n_node_fields
+        self.names = [None] * count
+        self.ids = [0] * count
+        self.self_sizes = [0] * count
+        self.children = [None] * count
+
+        edge = 0
+        for ix in range(count):
+            base = ix * n_node_fields
+            name = strings[nodes[base + NAME]]
+            if node_type_names[nodes[base + TYPE]] == 'string':
+                name = '(string)'
+            self.names[ix] = name
+            self.ids[ix] = nodes[base + ID]
+            self.self_sizes[ix] = nodes[base + SELF_SIZE]
+
+            children = []
+            for _ in range(nodes[base + EDGE_COUNT]):
+                if edges[edge + EDGE_TYPE] != weak_edge:
+                    children.append(edges[edge + TO_NODE] // n_node_fields)
+                edge += n_edge_fields
+            self.children[ix] = children
+
+        self._compute_dominators()
+        self._compute_retained_sizes()
+
+    def _compute_dominators(self):
+        # "A Simple, Fast Dominance Algorithm", by Cooper, Harvey and Kennedy,
+        # over the nodes reachable from the root, which is the first node
+        count = len(self.names)
+        postorder = []
+        visited = [False] * count
+        visited[0] = True
+        stack = [(0, iter(self.children[0]))]
+        while stack:
+            node, children = stack[-1]
+            for child in children:
+                if not visited[child]:
+                    visited[child] = True
+                    stack.append((child, iter(self.children[child])))
+                    break
+            else:
+                stack.pop()
+                postorder.append(node)
+
+        order = [-1] * count
+        for ix, node in enumerate(postorder):
+            order[node] = ix
+        self.reverse_postorder = postorder[::-1]
+
+        predecessors = [[] for _ in range(count)]
+        for node in self.reverse_postorder:
+            for child in self.children[node]:
+                predecessors[child].append(node)
+
+        idom = [-1] * count
+        idom[0] = 0
+
+        def intersect(a, b):
+            while a != b:
+                while order[a] < order[b]:
+                    a = idom[a]
+                while order[b] < order[a]:
+                    b = idom[b]
+            return a
+
+        changed = True
+        while changed:
+            changed = False
+            for node in self.reverse_postorder[1:]:
+                new_idom = -1
+                for pred in predecessors[node]:
+                    if idom[pred] == -1:
+                        continue
+                    new_idom = pred if new_idom == -1 else intersect(pred,
+                                                                     new_idom)
+                if idom[node] != new_idom:
+                    idom[node] = new_idom
+                    changed = True
+
+        self.idom = idom
+
+    def _compute_retained_sizes(self):
+        self.retained_sizes = list(self.self_sizes)
+        for node in reversed(self.reverse_postorder[1:]):
+            self.retained_sizes[self.idom[node]] += self.retained_sizes[node]
+
+    def summary(self):
+        """Count, self size and retained size of the reachable nodes, by name.
+
+        The retained size of a name only includes the nodes that are not
+        dominated by another node with the same name, so that an object isn't
+        counted again in the size of the objects of the same type that it
+        retains."""
+        dominated = defaultdict(list)
+        for node in self.reverse_postorder[1:]:
+            dominated[self.idom[node]].append(node)
+
+        stats = defaultdict(lambda: [0, 0, 0])
+        names_on_path = defaultdict(int)
+        # The root is not an object, so it is not counted
+        stack = [(node, False) for node in dominated[0]]
+        while stack:
+            node, leaving = stack.pop()
+            name = self.names[node]
+            if leaving:
+                names_on_path[name] -= 1
+                continue
+
+            entry = stats[name]
+            entry[0] += 1
+            entry[1] += self.self_sizes[node]
+            if not names_on_path[name]:
+                entry[2] += self.retained_sizes[node]
+
+            names_on_path[name] += 1
+            stack.append((node, True))
+            stack.extend((child, False) for child in dominated[node])
+
+        return stats
+
+    def reachable_ids(self):
+        return {self.ids[node]: node for node in self.reverse_postorder[1:]}
+
+
+def format_delta(value):
+    return f'{value:+,}' if value else '0'
+
+
+def main():
+    args = parser.parse_args()
+
+    sys.stderr.write(f'Parsing {args.old_file}...')
+    sys.stderr.flush()
+    old = Snapshot(args.old_file)
+    sys.stderr.write(f'done\nParsing {args.new_file}...')
+    sys.stderr.flush()
+    new = Snapshot(args.new_file)
+    sys.stderr.write('done\n')
+
+    old_stats = old.summary()
+    new_stats = new.summary()
+
+    # Only GObjects keep their address: the GC moves JS objects, so some of
+    # the JS objects counted as new may just have been moved
+    old_ids = old.reachable_ids()
+    new_objects = defaultdict(int)
+    for node_id, node in new.reachable_ids().items():
+        if node_id not in old_ids:
+            new_objects[new.names[node]] += 1
+
+    rows = []
+    for name in set(old_stats) | set(new_stats):
+        old_count, old_self, old_retained = old_stats.get(name, (0, 0, 0))
+        new_count, new_self, new_retained = new_stats.get(name, (0, 0, 0))
+        delta = new_retained - old_retained
+        if abs(delta) < args.min_delta:
+            continue
+        rows.append((delta, new_count - old_count, new_objects[name],
+                     new_self - old_self, new_count, new_retained, name))
+
+    rows.sort(key=lambda row: (-row[0], -row[1], row[6]))
+    if args.top:
+        rows = rows[:args.top]
+
+    header = ('Retained Δ', 'Count Δ', 'New', 'Self Δ', 'Count',
+              'Retained', 'Name')
+    print('{:>14} {:>10} {:>8} {:>14} {:>10} {:>14}  {}'.format(*header))
+    for delta, count_delta, n_new, self_delta, count, retained, name in rows:
+        print(f'{format_delta(delta):>14} {format_delta(count_delta):>10} '
+              f'{n_new:>8,} {format_delta(self_delta):>14} {count:>10,} '
+              f'{retained:>14,}  {name}')
+
+
+if __name__ == '__main__':
+    main()